@@ -117,6 +117,11 @@ do
   cmake --build . --config $config
   if [ "$ARCH" = "$(uname -m)" ]; then
     echo "Test KTX-Software (Linux $ARCH $config)"
+    if [ "$FEATURE_VK_UPLOAD" = "ON" -a "$FEATURE_TESTS" = "ON" ]; then
+      # install_linux.sh installs lavapipe so fail rather than skip the
+      # Vulkan upload tests if no device is found.
+      export KTX_VKUPLOADTESTS_REQUIRE_DEVICE=1
+    fi
     ctest --output-on-failure -C $config #--verbose
   fi
   if [ "$config" = "Release" -a "$PACKAGE" = "YES" ]; then
@@ -114,6 +114,7 @@ function( CreateDocLibKTX )
         libktx.doc
         lib/libktx_mainpage.md
         include
+        lib/allocator.c
         lib/astc_encode.cpp
         lib/basis_encode.cpp
         lib/basis_transcode.cpp
@@ -121,8 +122,10 @@ function( CreateDocLibKTX )
         lib/strings.c
         lib/glloader.c
         lib/hashlist.c
+        lib/decodecontext.c
         lib/filestream.c
         lib/memstream.c
+        lib/probe.c
         lib/texture.c
         lib/texture1.c
         lib/texture2.c
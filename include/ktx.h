@@ -772,9 +772,28 @@ enum ktxTextureCreateFlagBits {
     KTX_TEXTURE_CREATE_SKIP_KVDATA_BIT = 0x04,
                                    /*!< Skip any key-value data. This overrides
                                         the RAW_KVDATA_BIT. */
-    KTX_TEXTURE_CREATE_CHECK_GLTF_BASISU_BIT = 0x08
+    KTX_TEXTURE_CREATE_CHECK_GLTF_BASISU_BIT = 0x08,
                                    /*!< Load texture compatible with the rules
                                         of KHR_texture_basisu glTF extension */
+    KTX_TEXTURE_CREATE_MAP_FILE_BIT = 0x10,
+                                   /*!< Memory map the file instead of reading
+                                        it through stdio. Only affects the
+                                        CreateFromNamedFile functions. When
+                                        used with KTX2 files that are not
+                                        supercompressed, @c pData points into
+                                        the mapping. */
+    KTX_TEXTURE_CREATE_BORROW_DATA_BIT = 0x20,
+                                   /*!< Do not copy the image data of KTX2
+                                        textures that are not supercompressed.
+                                        @c pData points into the caller's
+                                        memory, which must remain valid until
+                                        the texture is destroyed. Only affects
+                                        the CreateFromMemory functions. */
+    KTX_TEXTURE_CREATE_MAX_BASE_DIMENSION_MASK = 0x1f000000
+                                   /*!< Bits holding the log2 of the largest
+                                        base dimension to create. Set them with
+                                        KTX_TEXTURE_CREATE_MAX_BASE_DIMENSION().
+                                        Only affects KTX2 sources. */
 };
 /**
  * @memberof ktxTexture
@@ -785,6 +804,21 @@ enum ktxTextureCreateFlagBits {
  */
 typedef ktx_uint32_t ktxTextureCreateFlags;
 
+/**
+ * @memberof ktxTexture
+ * @~English
+ * @brief Create flag limiting the base level of a KTX2 texture to
+ *        2^@p log2 texels in every dimension.
+ *
+ * Mip levels larger than this are skipped. Their data is never read and the
+ * created texture has correspondingly smaller baseWidth, baseHeight,
+ * baseDepth and numLevels. At least the smallest level is always kept.
+ * 0 means no limit. E.g. OR-ing KTX_TEXTURE_CREATE_MAX_BASE_DIMENSION(11)
+ * into the create flags loads at most 2048x2048 of a 4096x4096 texture.
+ */
+#define KTX_TEXTURE_CREATE_MAX_BASE_DIMENSION(log2) \
+    ((ktxTextureCreateFlags)((log2) & 0x1f) << 24)
+
 /*===========================================================*
 * ktxStream
 *===========================================================*/
@@ -811,7 +845,8 @@ typedef ktx_uint32_t ktxTextureCreateFlags;
 typedef struct ktxMem ktxMem;
 typedef struct ktxStream ktxStream;
 
-enum streamType { eStreamTypeFile = 1, eStreamTypeMemory = 2, eStreamTypeCustom = 3 };
+enum streamType { eStreamTypeFile = 1, eStreamTypeMemory = 2, eStreamTypeCustom = 3,
+                  eStreamTypeMappedFile = 4 };
 
 /**
  * @~English
@@ -887,6 +922,11 @@ struct ktxStream
             void* allocatorAddress;  /**< pointer to a memory allocator. */
             ktx_size_t size;         /**< size of the data. */
         } custom_ptr;      /**< pointer to a struct for custom streams. */
+        struct
+        {
+            ktx_uint8_t* base;       /**< start of the mapping. */
+            ktx_size_t size;         /**< size of the mapping. */
+        } map;             /**< file mapping for a ktxMappedFileStream. */
     } data;                /**< pointer to the stream data. */
     ktx_off_t readpos;     /**< used by FileStream for stdin. */
     ktx_bool_t closeOnDestruct; /**< Close FILE* or dispose of memory on destruct. */
@@ -921,6 +961,121 @@ ktxTexture_CreateFromStream(ktxStream* stream,
                             ktxTextureCreateFlags createFlags,
                             ktxTexture** newTex);
 
+/**
+ * @~English
+ * @brief Maximum number of levels reported by ktxProbeHeader*().
+ *
+ * Enough for any texture whose dimensions fit in 32 bits.
+ */
+#define KTX_PROBE_MAX_LEVELS 32
+
+/**
+ * @~English
+ * @brief A metadata key to look up with ktxProbeHeader*().
+ */
+typedef struct ktxProbeKey {
+    const char* key;
+        /*!< [in] NUL-terminated key to look for. */
+    const ktx_uint8_t* value;
+        /*!< [out] Pointer to the value or @c NULL if the key was not found
+             or the metadata could not be read into
+             ktxTextureInfo::kvdBuffer. */
+    ktx_uint32_t valueLen;
+        /*!< [out] Number of bytes in the value. */
+} ktxProbeKey;
+
+/**
+ * @~English
+ * @brief Information about a KTX or KTX2 file returned by ktxProbeHeader*().
+ *
+ * Set @c structSize and the input fields before calling. The rest are
+ * filled in.
+ */
+typedef struct ktxTextureInfo {
+    ktx_uint32_t structSize;
+        /*!< [in] Must be set to sizeof(ktxTextureInfo). */
+    ktxProbeKey* keys;
+        /*!< [in] Array of metadata keys to look up. May be @c NULL. */
+    ktx_uint32_t numKeys;
+        /*!< [in] Number of entries in @c keys. */
+    ktx_uint8_t* kvdBuffer;
+        /*!< [in] Buffer into which to read the key/value data when probing
+             a stream. Unused when probing memory, where values point into
+             the source data. May be @c NULL if @c numKeys is 0. */
+    ktx_uint32_t kvdBufferSize;
+        /*!< [in] Size of @c kvdBuffer in bytes. */
+    class_id classId;
+        /*!< ktxTexture1_c for KTX files, ktxTexture2_c for KTX2. */
+    ktx_uint32_t vkFormat;
+        /*!< VkFormat. 0 for KTX files. */
+    ktx_uint32_t glInternalformat;
+        /*!< glInternalformat. 0 for KTX2 files. */
+    ktx_uint32_t glFormat;
+        /*!< glFormat. 0 for KTX2 files. */
+    ktx_uint32_t glType;
+        /*!< glType. 0 for KTX2 files. */
+    ktx_uint32_t typeSize;
+        /*!< Size of the data type in bytes. */
+    ktx_uint32_t baseWidth;
+        /*!< Width of the base level. */
+    ktx_uint32_t baseHeight;
+        /*!< Height of the base level. */
+    ktx_uint32_t baseDepth;
+        /*!< Depth of the base level. */
+    ktx_uint32_t numDimensions;
+        /*!< Number of dimensions in the texture, 1, 2 or 3. */
+    ktx_uint32_t numLevels;
+        /*!< Number of mip levels in the file. */
+    ktx_uint32_t numLayers;
+        /*!< Number of array layers. 1 if not an array. */
+    ktx_uint32_t numFaces;
+        /*!< Number of faces, 6 for a cube map, otherwise 1. */
+    ktx_bool_t isArray;
+        /*!< KTX_TRUE if the texture is an array texture. */
+    ktx_bool_t isCubemap;
+        /*!< KTX_TRUE if the texture is a cube map. */
+    ktx_bool_t generateMipmaps;
+        /*!< KTX_TRUE if mipmaps should be generated on upload. */
+    ktxSupercmpScheme supercompressionScheme;
+        /*!< Supercompression scheme. KTX_SS_NONE for KTX files. */
+    khr_df_model_e colorModel;
+        /*!< DFD color model. KHR_DF_MODEL_UNSPECIFIED for KTX files. */
+    khr_df_primaries_e colorPrimaries;
+        /*!< DFD color primaries. KHR_DF_PRIMARIES_UNSPECIFIED for KTX
+             files. */
+    khr_df_transfer_e transferFunction;
+        /*!< DFD transfer function. KHR_DF_TRANSFER_UNSPECIFIED for KTX
+             files. */
+    ktx_bool_t premultipliedAlpha;
+        /*!< KTX_TRUE if the DFD says alpha is premultiplied. */
+    ktx_uint32_t kvdByteLength;
+        /*!< Size of the key/value data in the file. */
+    ktx_uint64_t sgdByteLength;
+        /*!< Size of the supercompression global data in the file. */
+    struct {
+        ktx_uint64_t byteOffset;
+            /*!< Offset of the level from the start of the file. */
+        ktx_uint64_t byteLength;
+            /*!< Number of bytes of possibly supercompressed data. */
+        ktx_uint64_t uncompressedByteLength;
+            /*!< Number of bytes of data after inflation. */
+    } levels[KTX_PROBE_MAX_LEVELS];
+        /*!< The level index of a KTX2 file. All 0 for KTX files. */
+} ktxTextureInfo;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxProbeHeaderFromStdioStream(FILE* stdioStream, ktxTextureInfo* info);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxProbeHeaderFromNamedFile(const char* const filename, ktxTextureInfo* info);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxProbeHeaderFromMemory(const ktx_uint8_t* bytes, ktx_size_t size,
+                         ktxTextureInfo* info);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxProbeHeaderFromStream(ktxStream* stream, ktxTextureInfo* info);
+
 /*
  * Returns a pointer to the image data of a ktxTexture object.
  */
@@ -1030,6 +1185,13 @@ ktxTexture2_Create(ktxTextureCreateInfo* createInfo,
 KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_CreateCopy(ktxTexture2* orig, ktxTexture2** newTex);
 
+/*
+ * Create a new ktxTexture2 as a copy of an existing texture, sharing the
+ * image data until either texture replaces or modifies it.
+ */
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_CreateSharedCopy(ktxTexture2* orig, ktxTexture2** newTex);
+
  /*
   * These four create a ktxTexture2 provided the data is in KTX2 format.
   */
@@ -1059,9 +1221,160 @@ ktxTexture2_CompressBasis(ktxTexture2* This, ktx_uint32_t quality);
 KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_DeflateZstd(ktxTexture2* This, ktx_uint32_t level);
 
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Structure for passing extended parameters to
+ *        ktxTexture2_DeflateZstdEx().
+ *
+ * At a minimum you must initialize the structure as follows:
+ * @code
+ *  ktxZstdParams params = {0};
+ *  params.structSize = sizeof(params);
+ *  params.compressionLevel = 19;
+ * @endcode
+ */
+typedef struct ktxZstdParams {
+    ktx_uint32_t structSize;
+        /*!< Size of this struct. Used so library can tell which version
+             of struct is being passed.
+         */
+    ktx_uint32_t compressionLevel;
+        /*!< Speed vs compression ratio trade-off, 1 to 22. */
+    ktx_uint32_t threadCount;
+        /*!< Number of threads to use. 0 or 1 compresses on the calling
+             thread. With more, large levels are each compressed by that
+             many Zstandard workers and the remaining levels are
+             compressed in parallel with each other.
+         */
+    ktx_uint32_t windowLog;
+        /*!< Log2 of the maximum back-reference distance, 10 to 27. 27 is
+             the largest window Zstandard decoders accept by default. 0
+             selects the default for @c compressionLevel.
+         */
+    ktx_bool_t longDistanceMatching;
+        /*!< Enable Zstandard long distance matching. Helps levels with
+             repetition further apart than the normal window.
+         */
+    ktx_uint32_t strategy;
+        /*!< Zstandard strategy, 1 (fast) to 9 (btultra2). 0 selects the
+             default for @c compressionLevel.
+         */
+} ktxZstdParams;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_DeflateZstdEx(ktxTexture2* This, const ktxZstdParams* params);
+
 KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_DeflateZLIB(ktxTexture2* This, ktx_uint32_t level);
 
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Structure for passing parameters to ktxTexture2_DeflateAuto().
+ *
+ * At a minimum you must initialize the structure as follows:
+ * @code
+ *  ktxDeflateAutoParams params = {0};
+ *  params.structSize = sizeof(params);
+ *  params.minInflateMBps = 500;
+ * @endcode
+ */
+typedef struct ktxDeflateAutoParams {
+    ktx_uint32_t structSize;
+        /*!< Size of this struct. Used so library can tell which version
+             of struct is being passed.
+         */
+    float minInflateMBps;
+        /*!< Slowest acceptable inflate rate on this host, in millions of
+             inflated bytes per second. 0 means no limit.
+         */
+    float maxInflateMs;
+        /*!< Longest acceptable time, in milliseconds, to inflate the
+             whole texture on this host. 0 means no limit.
+         */
+    ktx_uint32_t threadCount;
+        /*!< Number of candidates to compress in parallel. 0 or 1
+             compresses them one after the other on the calling thread.
+         */
+} ktxDeflateAutoParams;
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Structure for returning the choice made by
+ *        ktxTexture2_DeflateAuto().
+ */
+typedef struct ktxDeflateAutoResult {
+    ktxSupercmpScheme scheme;      /*!< Supercompression scheme chosen. */
+    ktx_uint32_t compressionLevel; /*!< Compression level chosen. */
+    ktx_size_t dataSize;           /*!< Size of the deflated data. */
+    float inflateMBps;             /*!< Measured inflate rate. */
+    float inflateMs;               /*!< Measured inflate time. */
+    ktx_bool_t withinBudget;
+        /*!< KTX_FALSE if no candidate met the budget, in which case the
+             fastest to inflate was chosen.
+         */
+} ktxDeflateAutoResult;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_DeflateAuto(ktxTexture2* This, const ktxDeflateAutoParams* params,
+                        ktxDeflateAutoResult* pResult);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_WriteDeflatedToStdioStream(ktxTexture2* This, FILE* dstsstr,
+                                       ktxSupercmpScheme scheme,
+                                       ktx_uint32_t compressionLevel);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_WriteDeflatedToNamedFile(ktxTexture2* This,
+                                     const char* const dstname,
+                                     ktxSupercmpScheme scheme,
+                                     ktx_uint32_t compressionLevel);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_WriteDeflatedToStream(ktxTexture2* This, ktxStream* dststr,
+                                  ktxSupercmpScheme scheme,
+                                  ktx_uint32_t compressionLevel);
+
+/**
+ * @class ktxTexture2Writer
+ * @~English
+ * @brief Opaque handle to a KTX 2 file being written one image at a time.
+ *
+ * Unlike writing a ktxTexture2, the whole texture never has to be in
+ * memory. Create one with ktxTexture2Writer_CreateForStream() or
+ * ktxTexture2Writer_CreateForStdioStream().
+ */
+typedef struct ktxTexture2Writer ktxTexture2Writer;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2Writer_CreateForStream(ktxTextureCreateInfo* createInfo,
+                                  ktxStream* dststr,
+                                  ktxTexture2Writer** newWriter);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2Writer_CreateForStdioStream(ktxTextureCreateInfo* createInfo,
+                                       FILE* dstsstr,
+                                       ktxTexture2Writer** newWriter);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2Writer_AddKVPair(ktxTexture2Writer* This, const char* key,
+                            unsigned int valueLen, const void* value);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2Writer_SetImageFromMemory(ktxTexture2Writer* This,
+                                     ktx_uint32_t level, ktx_uint32_t layer,
+                                     ktx_uint32_t faceSlice,
+                                     const ktx_uint8_t* src,
+                                     ktx_size_t srcSize);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2Writer_Finish(ktxTexture2Writer* This);
+
+KTX_API void KTX_APIENTRY
+ktxTexture2Writer_Destroy(ktxTexture2Writer* This);
+
 KTX_API void KTX_APIENTRY
 ktxTexture2_GetComponentInfo(ktxTexture2* This, ktx_uint32_t* numComponents,
                              ktx_uint32_t* componentByteLength);
@@ -1085,6 +1398,87 @@ ktxTexture2_GetPremultipliedAlpha(ktxTexture2* This);
 KTX_API ktx_bool_t KTX_APIENTRY
 ktxTexture2_NeedsTranscoding(ktxTexture2* This);
 
+/**
+ * @~English
+ * @brief Opaque handle to state cached between decoding calls.
+ *
+ * @sa ktxDecodeContext_Create()
+ */
+typedef struct ktxDecodeContext ktxDecodeContext;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxDecodeContext_Create(ktxDecodeContext** newCtx);
+
+KTX_API void KTX_APIENTRY
+ktxDecodeContext_Destroy(ktxDecodeContext* ctx);
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Structure for passing extended parameters to
+ *        ktxTexture2_LoadImageDataEx() and
+ *        ktxTexture2_IterateLoadLevelFacesEx().
+ *
+ * At a minimum you must initialize the structure as follows:
+ * @code
+ *  ktxLoadParams params = {0};
+ *  params.structSize = sizeof(params);
+ * @endcode
+ */
+typedef struct ktxLoadParams {
+    ktx_uint32_t structSize;
+        /*!< Size of this struct. Used so library can tell which version
+             of struct is being passed.
+         */
+    ktx_uint32_t threadCount;
+        /*!< Number of threads used for inflating Zstd or ZLIB supercompressed
+             data. 0 or 1 inflates on the calling thread while reading the
+             source in small chunks. More threads need the whole deflated
+             data in memory at once, unless the source is a mapped file or
+             borrowed memory.
+         */
+    ktx_bool_t readAhead;
+        /*!< Used by ktxTexture2_IterateLoadLevelFacesEx(). Read and inflate
+             the next level on a second thread while the callback consumes
+             the current one. Needs memory for a second level. Ignored
+             for textures created from a custom ktxStream, whose callbacks
+             are only called on the calling thread.
+         */
+    ktxDecodeContext* decodeContext;
+        /*!< Optional context whose decompression state and temporary
+             buffers are reused instead of being created for this call.
+             NULL to create them for this call only.
+         */
+    ktx_bool_t transcode;
+        /*!< Used by ktxTexture2_IterateLoadLevelFacesEx(). Transcode
+             BasisLZ/ETC1S and UASTC textures a level at a time, using
+             @c threadCount threads per level, before passing each level
+             to the callback. Required to iterate BasisLZ textures.
+             Ignored for other textures.
+         */
+    ktx_uint32_t transcodeFormat;
+        /*!< The ktx_transcode_fmt_e to transcode to when @c transcode is
+             set.
+         */
+    ktx_uint32_t transcodeFlags;
+        /*!< The ktx_transcode_flags to transcode with when @c transcode is
+             set.
+         */
+} ktxLoadParams;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_LoadImageDataEx(ktxTexture2* This,
+                            ktx_uint8_t* pBuffer, ktx_size_t bufSize,
+                            ktxLoadParams* params);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_IterateLoadLevelFacesEx(ktxTexture2* This, PFNKTXITERCB iterCb,
+                                    void* userdata, ktxLoadParams* params);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_LoadLevel(ktxTexture2* This, ktx_uint32_t level,
+                      ktx_uint8_t* pBuffer, ktx_size_t bufSize);
+
 /**
  * @~English
  * @brief Flags specifiying UASTC encoding options.
@@ -1582,6 +1976,143 @@ KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_TranscodeBasis(ktxTexture2* This, ktx_transcode_fmt_e fmt,
                            ktx_transcode_flags transcodeFlags);
 
+/**
+ * @~English
+ * @brief Signature of a job passed to a ktxTranscodeParams job runner.
+ *
+ * @param[in] pJobData   the @p pJobData passed to the runner.
+ * @param[in] jobIndex   index of the job to run, in [0, jobCount).
+ */
+typedef void (KTX_APIENTRY* PFNKTXJOB)(void* pJobData, ktx_uint32_t jobIndex);
+
+/**
+ * @~English
+ * @brief Signature of an application function that runs libktx jobs.
+ *
+ * Must call @p pfnJob once for each index in [0, @p jobCount), on any
+ * threads and in any order, and return only when all calls have returned.
+ *
+ * @param[in] pUserData  the @c pUserData of the ktxTranscodeParams.
+ * @param[in] jobCount   number of jobs to run.
+ * @param[in] pfnJob     function to call for each job.
+ * @param[in] pJobData   first argument to pass to @p pfnJob.
+ */
+typedef void (KTX_APIENTRY* PFNKTXRUNJOBS)(void* pUserData,
+                                           ktx_uint32_t jobCount,
+                                           PFNKTXJOB pfnJob, void* pJobData);
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Structure for passing extended parameters to
+ *        ktxTexture2_TranscodeBasisEx().
+ *
+ * At a minimum you must initialize the structure as follows:
+ * @code
+ *  ktxTranscodeParams params = {0};
+ *  params.structSize = sizeof(params);
+ * @endcode
+ */
+typedef struct ktxTranscodeParams {
+    ktx_uint32_t structSize;
+        /*!< Size of this struct. Used so library can tell which version
+             of struct is being passed.
+         */
+    ktx_uint32_t threadCount;
+        /*!< Number of threads to transcode with when @c pfnRunJobs is
+             @c NULL. 0 or 1 transcodes on the calling thread.
+         */
+    PFNKTXRUNJOBS pfnRunJobs;
+        /*!< Optional application function, e.g. a job system's submit and
+             wait, used instead of libktx's own threads.
+         */
+    void* pUserData;
+        /*!< Passed to @c pfnRunJobs. */
+    ktx_uint32_t firstLevel;
+        /*!< First mip level to transcode. It becomes the base level of the
+             transcoded texture. Larger levels are dropped.
+         */
+    ktx_uint32_t numLevels;
+        /*!< Number of levels to transcode starting at @c firstLevel.
+             0 means all levels from @c firstLevel to the end of the chain.
+         */
+    const char* cacheDir;
+        /*!< Optional directory holding a cache of transcoded textures.
+             If it has the result of transcoding the same data to the same
+             format, with the same flags and levels, that is used instead
+             of transcoding. Otherwise the result is added to it. libktx
+             never removes entries. Only used when transcoding into the
+             texture.
+         */
+} ktxTranscodeParams;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_TranscodeBasisEx(ktxTexture2* This, ktx_transcode_fmt_e fmt,
+                             ktx_transcode_flags transcodeFlags,
+                             const ktxTranscodeParams* params);
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Where ktxTexture2_TranscodeBasisToMemory() writes the images of
+ *        a mip level.
+ *
+ * Rows are rows of blocks for block-compressed formats and rows of pixels
+ * for uncompressed formats. Offsets and pitches must be multiples of the
+ * size of a block or pixel of the transcoded format.
+ */
+typedef struct ktxTranscodeLevelDest {
+    ktx_size_t byteOffset;
+        /*!< Offset from the start of the destination of the level's
+             first image.
+         */
+    ktx_uint32_t rowPitch;
+        /*!< Bytes from the start of one row to the start of the next.
+             0 for tightly packed rows.
+         */
+    ktx_size_t imagePitch;
+        /*!< Bytes from the start of one image of the level to the start
+             of the next. 0 for tightly packed images.
+         */
+} ktxTranscodeLevelDest;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_TranscodeBasisToMemory(ktxTexture2* This,
+                                   ktx_transcode_fmt_e fmt,
+                                   ktx_transcode_flags transcodeFlags,
+                                   const ktxTranscodeParams* params,
+                                   ktx_uint8_t* pDest, ktx_size_t destSize,
+                                   const ktxTranscodeLevelDest* pLevelDests,
+                                   ktx_uint32_t* pVkFormat);
+
+/**
+ * @class ktxVideoTranscoder
+ * @~English
+ * @brief Opaque handle for transcoding the frames of a video texture
+ *        one at a time.
+ */
+typedef struct ktxVideoTranscoder ktxVideoTranscoder;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxVideoTranscoder_Create(ktxTexture2* texture, ktx_transcode_fmt_e fmt,
+                          ktx_transcode_flags transcodeFlags,
+                          ktxVideoTranscoder** newXcoder);
+
+KTX_API void KTX_APIENTRY
+ktxVideoTranscoder_Destroy(ktxVideoTranscoder* xcoder);
+
+KTX_API ktx_uint32_t KTX_APIENTRY
+ktxVideoTranscoder_GetVkFormat(ktxVideoTranscoder* xcoder);
+
+KTX_API ktx_size_t KTX_APIENTRY
+ktxVideoTranscoder_GetFrameSize(ktxVideoTranscoder* xcoder,
+                                ktx_uint32_t level);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxVideoTranscoder_TranscodeFrame(ktxVideoTranscoder* xcoder,
+                                  ktx_uint32_t level, ktx_uint32_t frame,
+                                  ktx_uint8_t* pDest, ktx_size_t destSize);
+
 /*
  * Returns a string corresponding to a KTX error code.
  */
@@ -1600,6 +2131,27 @@ ktxSupercompressionSchemeString(ktxSupercmpScheme scheme);
 KTX_API const char* KTX_APIENTRY
 ktxTranscodeFormatString(ktx_transcode_fmt_e format);
 
+/**
+ * @~English
+ * @brief Memory allocation functions used by libktx.
+ *
+ * @sa ktxSetAllocator()
+ */
+typedef struct ktxAllocator {
+    void* (*pfnMalloc)(void* pUserData, ktx_size_t size);
+        /*!< Allocate @p size bytes. Return @c NULL on failure. */
+    void* (*pfnRealloc)(void* pUserData, void* ptr, ktx_size_t size);
+        /*!< Resize the allocation @p ptr, which may be @c NULL, to
+             @p size bytes. Return @c NULL on failure. */
+    void (*pfnFree)(void* pUserData, void* ptr);
+        /*!< Free @p ptr, which may be @c NULL. */
+    void* pUserData;
+        /*!< Passed unchanged to each of the functions. */
+} ktxAllocator;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxSetAllocator(const ktxAllocator* newAllocator);
+
 KTX_API KTX_error_code KTX_APIENTRY ktxHashList_Create(ktxHashList** ppHl);
 KTX_API KTX_error_code KTX_APIENTRY
 ktxHashList_CreateCopy(ktxHashList** ppHl, ktxHashList orig);
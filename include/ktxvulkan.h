@@ -234,6 +234,18 @@ ktxTexture2_VkUploadEx(ktxTexture2* This, ktxVulkanDeviceInfo* vdi,
 KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_VkUpload(ktxTexture2* texture, ktxVulkanDeviceInfo* vdi,
                      ktxVulkanTexture *vkTexture);
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_VkUploadTranscodedEx(ktxTexture2* This, ktxVulkanDeviceInfo* vdi,
+                                 ktxVulkanTexture* vkTexture,
+                                 ktx_transcode_fmt_e fmt,
+                                 ktx_transcode_flags transcodeFlags,
+                                 VkImageUsageFlags usageFlags,
+                                 VkImageLayout finalLayout);
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_VkUploadTranscoded(ktxTexture2* texture, ktxVulkanDeviceInfo* vdi,
+                               ktxVulkanTexture* vkTexture,
+                               ktx_transcode_fmt_e fmt,
+                               ktx_transcode_flags transcodeFlags);
 
 KTX_API VkFormat KTX_APIENTRY
 ktxTexture_GetVkFormat(ktxTexture* This);
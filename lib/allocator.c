@@ -0,0 +1,140 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file allocator.c
+ * @~English
+ *
+ * @brief Routing of all libktx memory allocations through a replaceable
+ *        allocator.
+ */
+
+#include <stdlib.h>
+
+#define ZSTD_STATIC_LINKING_ONLY
+#include <zstd.h>
+
+#include "ktx.h"
+#include "ktxint.h"
+
+static void*
+defaultMalloc(void* pUserData, ktx_size_t size)
+{
+    (void)pUserData;
+    return malloc(size);
+}
+
+static void*
+defaultRealloc(void* pUserData, void* ptr, ktx_size_t size)
+{
+    (void)pUserData;
+    return realloc(ptr, size);
+}
+
+static void
+defaultFree(void* pUserData, void* ptr)
+{
+    (void)pUserData;
+    free(ptr);
+}
+
+static ktxAllocator allocator = {
+    defaultMalloc, defaultRealloc, defaultFree, NULL
+};
+
+/**
+ * @~English
+ * @brief Set the functions libktx uses to allocate and free memory.
+ *
+ * Every allocation made by libktx itself, including texture images,
+ * level indices, DFDs, metadata, the buffers returned by the
+ * @c WriteToMemory functions and ktxHashList_Serialize() and the
+ * Zstandard contexts used for (de)compression, goes through these
+ * functions. Memory libktx returns to the application must be freed with
+ * @c pfnFree of the allocator that was current when it was returned.
+ * Allocations made inside the Basis Universal and ASTC encoders are not
+ * included.
+ *
+ * The allocator is global. Set it before calling any other libktx
+ * function and do not change it while any libktx object exists, or
+ * memory may be freed with a different allocator than the one that
+ * allocated it.
+ *
+ * @param[in] newAllocator pointer to the allocator to use. Its contents
+ *                         are copied. Pass @c NULL to restore the default
+ *                         allocator which uses @c malloc, @c realloc and
+ *                         @c free.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE One of the functions in @p newAllocator is
+ *                              @c NULL.
+ */
+KTX_error_code
+ktxSetAllocator(const ktxAllocator* newAllocator)
+{
+    if (newAllocator == NULL) {
+        allocator.pfnMalloc = defaultMalloc;
+        allocator.pfnRealloc = defaultRealloc;
+        allocator.pfnFree = defaultFree;
+        allocator.pUserData = NULL;
+        return KTX_SUCCESS;
+    }
+    if (newAllocator->pfnMalloc == NULL || newAllocator->pfnRealloc == NULL
+        || newAllocator->pfnFree == NULL)
+        return KTX_INVALID_VALUE;
+    allocator = *newAllocator;
+    return KTX_SUCCESS;
+}
+
+void*
+ktxMalloc(size_t size)
+{
+    return allocator.pfnMalloc(allocator.pUserData, size);
+}
+
+void*
+ktxRealloc(void* ptr, size_t size)
+{
+    return allocator.pfnRealloc(allocator.pUserData, ptr, size);
+}
+
+void
+ktxFree(void* ptr)
+{
+    allocator.pfnFree(allocator.pUserData, ptr);
+}
+
+static void*
+zstdAlloc(void* opaque, size_t size)
+{
+    (void)opaque;
+    return ktxMalloc(size);
+}
+
+static void
+zstdFree(void* opaque, void* ptr)
+{
+    (void)opaque;
+    ktxFree(ptr);
+}
+
+static const ZSTD_customMem zstdMem = { zstdAlloc, zstdFree, NULL };
+
+ZSTD_DCtx*
+ktxZSTD_createDCtx(void)
+{
+    return ZSTD_createDCtx_advanced(zstdMem);
+}
+
+ZSTD_CCtx*
+ktxZSTD_createCCtx(void)
+{
+    return ZSTD_createCCtx_advanced(zstdMem);
+}
@@ -734,10 +734,10 @@ ktxTexture2_CompressAstcEx(ktxTexture2* This, ktxAstcParams* params) {
     memcpy(This->_private->_levelIndex, protoPriv._levelIndex,
            This->numLevels * sizeof(ktxLevelIndexEntry));
     // Move the DFD and data from the prototype to This.
-    free(This->pDfd);
+    ktxFree(This->pDfd);
     This->pDfd = prototype->pDfd;
     prototype->pDfd = 0;
-    free(This->pData);
+    ktxTexture2_freeData(This);
     This->pData = prototype->pData;
     This->dataSize = prototype->dataSize;
     prototype->pData = 0;
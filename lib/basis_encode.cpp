@@ -246,7 +246,7 @@ ktxTexture2_rewriteDfd4BasisLzETC1S(ktxTexture2* This,
                        + newSampleCount * KHR_DF_WORD_SAMPLEWORDS;
     ndbSize *= sizeof(uint32_t);
     uint32_t ndfdSize = ndbSize + 1 * sizeof(uint32_t);
-    uint32_t* ndfd = (uint32_t *)malloc(ndfdSize);
+    uint32_t* ndfd = (uint32_t *)ktxMalloc(ndfdSize);
     uint32_t* nbdb = ndfd + 1;
 
     if (!ndfd)
@@ -298,7 +298,7 @@ ktxTexture2_rewriteDfd4BasisLzETC1S(ktxTexture2* This,
     }
 
     This->pDfd = ndfd;
-    free(cdfd);
+    ktxFree(cdfd);
     return KTX_SUCCESS;
 }
 
@@ -315,7 +315,7 @@ ktxTexture2_rewriteDfd4Uastc(ktxTexture2* This,
                        + 1 * KHR_DF_WORD_SAMPLEWORDS;
     ndbSize *= sizeof(uint32_t);
     uint32_t ndfdSize = ndbSize + 1 * sizeof(uint32_t);
-    uint32_t* ndfd = (uint32_t *)malloc(ndfdSize);
+    uint32_t* ndfd = (uint32_t *)ktxMalloc(ndfdSize);
     uint32_t* nbdb = ndfd + 1;
 
     if (!ndfd)
@@ -359,7 +359,7 @@ ktxTexture2_rewriteDfd4Uastc(ktxTexture2* This,
     KHR_DFDSETSVAL(nbdb, 0, SAMPLEUPPER, UINT32_MAX);
 
     This->pDfd = ndfd;
-    free(cdfd);
+    ktxFree(cdfd);
     return KTX_SUCCESS;
 }
 
@@ -605,7 +605,7 @@ ktxTexture2_CompressBasisEx(ktxTexture2* This, ktxBasisParams* params)
         }
     }
 
-    free(This->pData); // No longer needed. Reduce memory footprint.
+    ktxTexture2_freeData(This); // No longer needed. Reduce memory footprint.
     This->pData = NULL;
     This->dataSize = 0;
 
@@ -861,7 +861,7 @@ ktxTexture2_CompressBasisEx(ktxTexture2* This, ktxBasisParams* params)
                  + image_desc_size * num_images
                  + bfh.m_endpoint_cb_file_size + bfh.m_selector_cb_file_size
                  + bfh.m_tables_file_size;
-        bgd = new ktx_uint8_t[bgd_size];
+        bgd = (ktx_uint8_t*)ktxMalloc(bgd_size);
         ktxBasisLzGlobalHeader& bgdh = *reinterpret_cast<ktxBasisLzGlobalHeader*>(bgd);
         bgdh.endpointCount = (uint16_t)bfh.m_total_endpoints;
         bgdh.endpointsByteLength = bfh.m_endpoint_cb_file_size;
@@ -987,7 +987,7 @@ ktxTexture2_CompressBasisEx(ktxTexture2* This, ktxBasisParams* params)
         alphaContent = eNone;
     }
 
-    new_data = (uint8_t*) malloc(image_data_size);
+    new_data = (uint8_t*) ktxMalloc(image_data_size);
     if (!new_data) {
         result = KTX_OUT_OF_MEMORY;
         goto cleanup;
@@ -1043,11 +1043,11 @@ ktxTexture2_CompressBasisEx(ktxTexture2* This, ktxBasisParams* params)
 
 cleanup:
     if (bgd) {
-        delete bgd;
+        ktxFree(bgd);
         priv._supercompressionGlobalData = 0;
         priv._sgdByteLength = 0;
     }
-    if (new_data) free(new_data);
+    if (new_data) ktxFree(new_data);
     return result;
 }
 
@@ -18,13 +18,27 @@
  * @author Mark Callow, www.edgewise-consulting.com
  */
 
+#include <atomic>
 #include <inttypes.h>
+#include <new>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#if defined(_WIN32)
+  #include <process.h>
+  #define getpid _getpid
+#else
+  #include <unistd.h>
+#endif
 #include <KHR/khr_df.h>
 
 #include "dfdutils/dfd.h"
+#include "filestream.h"
 #include "ktx.h"
 #include "ktxint.h"
+#include "ktxthread.h"
 #include "texture2.h"
 #include "vkformat_enum.h"
 #include "vk_format.h"
@@ -41,22 +55,341 @@
 using namespace basisu;
 using namespace basist;
 
+/*
+ * Standard allocator that goes through ktxMalloc and ktxFree so that the
+ * transcoders' containers honour the allocator set with ktxSetAllocator().
+ */
+template<class T>
+struct ktxStdAllocator {
+    typedef T value_type;
+
+    ktxStdAllocator() noexcept { }
+    template<class U>
+    ktxStdAllocator(const ktxStdAllocator<U>&) noexcept { }
+
+    T* allocate(size_t n) {
+        void* p = ktxMalloc(n * sizeof(T));
+        if (!p)
+            throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t) noexcept { ktxFree(p); }
+};
+
+template<class T, class U>
+inline bool operator==(const ktxStdAllocator<T>&, const ktxStdAllocator<U>&)
+{ return true; }
+template<class T, class U>
+inline bool operator!=(const ktxStdAllocator<T>&, const ktxStdAllocator<U>&)
+{ return false; }
+
+template<class T>
+using ktxVector = std::vector<T, ktxStdAllocator<T>>;
+typedef std::basic_string<char, std::char_traits<char>,
+                          ktxStdAllocator<char>> ktxString;
+
+/*
+ * Construct a T in memory from ktxMalloc. Returns nullptr when the
+ * allocation fails. Objects from ktxNew must be freed with ktxDelete.
+ */
+template<class T>
+static T* ktxNew()
+{
+    void* p = ktxMalloc(sizeof(T));
+    return p ? new (p) T() : nullptr;
+}
+
+template<class T>
+static void ktxDelete(T* p)
+{
+    p->~T();
+    ktxFree(p);
+}
+
 inline bool isPow2(uint32_t x) { return x && ((x & (x - 1U)) == 0U); }
 
 inline bool isPow2(uint64_t x) { return x && ((x & (x - 1U)) == 0U); }
 
+/*
+ * Where transcoded images are written: the prototype's storage or
+ * application memory laid out as described by @c levels.
+ */
+struct ktxXcodeDest {
+    ktx_uint8_t* pData;
+    ktx_size_t dataSize;
+    const ktxTranscodeLevelDest* levels; // nullptr for the prototype.
+};
+
 KTX_error_code
 ktxTexture2_transcodeLzEtc1s(ktxTexture2* This,
                            alpha_content_e alphaContent,
                            ktxTexture2* prototype,
+                           ktx_uint32_t firstLevel,
                            ktx_transcode_fmt_e outputFormat,
-                           ktx_transcode_flags transcodeFlags);
+                           ktx_transcode_flags transcodeFlags,
+                           const ktxXcodeDest& dest,
+                           const ktxTranscodeParams* params);
 KTX_error_code
 ktxTexture2_transcodeUastc(ktxTexture2* This,
                            alpha_content_e alphaContent,
                            ktxTexture2* prototype,
+                           ktx_uint32_t firstLevel,
                            ktx_transcode_fmt_e outputFormat,
-                           ktx_transcode_flags transcodeFlags);
+                           ktx_transcode_flags transcodeFlags,
+                           const ktxXcodeDest& dest,
+                           const ktxTranscodeParams* params);
+static KTX_error_code
+transcodeBasis(ktxTexture2* This, ktx_transcode_fmt_e outputFormat,
+               ktx_transcode_flags transcodeFlags,
+               const ktxTranscodeParams* params,
+               ktx_uint8_t* pDest, ktx_size_t destSize,
+               const ktxTranscodeLevelDest* pLevelDests,
+               ktx_uint32_t* pVkFormat);
+
+/*
+ * One image to be transcoded. For ETC1S the alpha slice follows the RGB
+ * slice. For UASTC only the RGB fields are used.
+ */
+struct ktxXcodeImage {
+    uint32_t level;
+    uint32_t stateIndex; // Which transcoder state to use for video.
+    uint64_t writeOffset;
+    uint32_t rowPitch;   // In blocks or pixels. 0 for tightly packed.
+    uint32_t rgbOffset;
+    uint32_t rgbLength;
+    uint32_t alphaOffset;
+    uint32_t alphaLength;
+};
+
+/*
+ * The images of a texture and what is needed to transcode any of them.
+ * Images are independent, except video frames, so are run as jobs.
+ */
+struct ktxXcodeJobs {
+    ktxTexture2* This;
+    ktxTexture2* prototype;
+    const ktx_uint8_t* pSrc; // Data to transcode from.
+    ktx_size_t srcSize;
+    ktxXcodeDest dest;
+    ktx_uint32_t firstLevel;
+    ktx_transcode_fmt_e outputFormat;
+    ktx_transcode_flags transcodeFlags;
+    bool hasAlpha;
+    basisu_lowlevel_etc1s_transcoder* etc1s; // nullptr for UASTC.
+    basisu_lowlevel_uastc_transcoder* uastc;
+    ktxVector<ktxXcodeImage> images;
+    ktx_uint32_t nextImage;
+    std::atomic<bool> failed;
+};
+
+static bool
+transcodeImage(ktxXcodeJobs& jobs, const ktxXcodeImage& image,
+               basisu_transcoder_state& xcoderState)
+{
+    ktxTexture2* This = jobs.This;
+    ktxTexture2* prototype = jobs.prototype;
+    uint32_t levelWidth = MAX(1, This->baseWidth >> image.level);
+    uint32_t levelHeight = MAX(1, This->baseHeight >> image.level);
+    // ETC1S and UASTC texel block dimensions
+    const uint32_t bw = 4, bh = 4;
+    uint32_t levelBlocksX = (levelWidth + (bw - 1)) / bw;
+    uint32_t levelBlocksY = (levelHeight + (bh - 1)) / bh;
+    // Inconveniently, the output buffer size parameter of transcode_image
+    // has to be in pixels for uncompressed output and in blocks for
+    // compressed output. The only reason for humouring the API is so
+    // its buffer size tests provide a real check. An alternative is to
+    // always provide the size in bytes which will always pass.
+    ktx_uint32_t outputBlockByteLength
+                      = prototype->_protected->_formatSize.blockSizeInBits / 8;
+    ktx_size_t xcodedDataLength = jobs.dest.dataSize / outputBlockByteLength;
+    uint64_t writeOffsetBlocks = image.writeOffset / outputBlockByteLength;
+
+    if (jobs.etc1s) {
+        return jobs.etc1s->transcode_image(
+                      (transcoder_texture_format)jobs.outputFormat,
+                      jobs.dest.pData + image.writeOffset,
+                      (uint32_t)(xcodedDataLength - writeOffsetBlocks),
+                      jobs.pSrc,
+                      (uint32_t)jobs.srcSize,
+                      levelBlocksX,
+                      levelBlocksY,
+                      levelWidth,
+                      levelHeight,
+                      image.level,
+                      image.rgbOffset,
+                      image.rgbLength,
+                      image.alphaOffset,
+                      image.alphaLength,
+                      jobs.transcodeFlags,
+                      jobs.hasAlpha,
+                      This->isVideo,
+                      // Our P-Frame flag is in the same bit as
+                      // cSliceDescFlagsFrameIsIFrame. We have to
+                      // invert it to make it an I-Frame flag.
+                      //
+                      // API currently doesn't have any way to pass
+                      // the I-Frame flag.
+                      //imageDesc.imageFlags ^ cSliceDescFlagsFrameIsIFrame,
+                      image.rowPitch, // output_row_pitch_in_blocks_or_pixels
+                      &xcoderState,
+                      0  // output_rows_in_pixels
+                      );
+    } else {
+        return jobs.uastc->transcode_image(
+                      (transcoder_texture_format)jobs.outputFormat,
+                      jobs.dest.pData + image.writeOffset,
+                      (uint32_t)(xcodedDataLength - writeOffsetBlocks),
+                      jobs.pSrc,
+                      (uint32_t)jobs.srcSize,
+                      levelBlocksX,
+                      levelBlocksY,
+                      levelWidth,
+                      levelHeight,
+                      image.level,
+                      image.rgbOffset,
+                      image.rgbLength,
+                      jobs.transcodeFlags,
+                      jobs.hasAlpha,
+                      This->isVideo, // is_video
+                      //imageDesc.imageFlags ^ cSliceDescFlagsFrameIsIFrame,
+                      image.rowPitch, // output_row_pitch_in_blocks_or_pixels
+                      &xcoderState, // pState
+                      0, // output_rows_in_pixels,
+                      -1, // channel0
+                      -1  // channel1
+                      );
+    }
+}
+
+/*
+ * Place each image in the application's memory according to its
+ * ktxTranscodeLevelDest. The images of a level are consecutive in
+ * @p jobs.images in the order they are to be written.
+ */
+static KTX_error_code
+layoutImages(ktxXcodeJobs& jobs)
+{
+    ktxTexture2* This = jobs.This;
+    const ktxFormatSize& formatSize = jobs.prototype->_protected->_formatSize;
+    ktx_uint32_t blockByteLength = formatSize.blockSizeInBits / 8;
+    // PVRTC1 blocks are twiddled so the rows cannot be spread out.
+    bool twiddled = jobs.outputFormat == KTX_TTF_PVRTC1_4_RGB
+                    || jobs.outputFormat == KTX_TTF_PVRTC1_4_RGBA;
+    uint32_t level = UINT32_MAX;
+    ktx_size_t imageInLevel = 0;
+
+    for (ktxXcodeImage& image : jobs.images) {
+        if (image.level != level) {
+            level = image.level;
+            imageInLevel = 0;
+        }
+        const ktxTranscodeLevelDest& levelDest
+                                = jobs.dest.levels[level - jobs.firstLevel];
+        uint32_t width = MAX(1, This->baseWidth >> level);
+        uint32_t height = MAX(1, This->baseHeight >> level);
+        uint32_t blocksX = MAX(formatSize.minBlocksX,
+                   (width + formatSize.blockWidth - 1) / formatSize.blockWidth);
+        uint32_t blocksY = MAX(formatSize.minBlocksY,
+                 (height + formatSize.blockHeight - 1) / formatSize.blockHeight);
+        ktx_size_t rowByteLength = (ktx_size_t)blocksX * blockByteLength;
+        ktx_size_t rowPitch = levelDest.rowPitch ? levelDest.rowPitch
+                                                 : rowByteLength;
+        // The transcoder requires room for full rows, including the last.
+        ktx_size_t imageByteLength = rowPitch * blocksY;
+        ktx_size_t imagePitch = levelDest.imagePitch ? levelDest.imagePitch
+                                                     : imageByteLength;
+
+        if (rowPitch < rowByteLength || (twiddled && rowPitch != rowByteLength)
+            || imagePitch < imageByteLength
+            || rowPitch % blockByteLength || imagePitch % blockByteLength
+            || levelDest.byteOffset % blockByteLength)
+            return KTX_INVALID_VALUE;
+        image.writeOffset = levelDest.byteOffset + imageInLevel * imagePitch;
+        if (image.writeOffset > jobs.dest.dataSize
+            || jobs.dest.dataSize - image.writeOffset < imageByteLength)
+            return KTX_INVALID_VALUE;
+        image.rowPitch = (uint32_t)(rowPitch / blockByteLength);
+        imageInLevel++;
+    }
+    return KTX_SUCCESS;
+}
+
+/*
+ * Job for an application's job runner. The transcoder state only holds
+ * scratch data for non-video images so each job can have its own.
+ */
+static void KTX_APIENTRY
+transcodeImageJob(void* pJobData, ktx_uint32_t jobIndex)
+{
+    ktxXcodeJobs& jobs = *static_cast<ktxXcodeJobs*>(pJobData);
+    basisu_transcoder_state xcoderState;
+
+    if (!transcodeImage(jobs, jobs.images[jobIndex], xcoderState))
+        jobs.failed = true;
+}
+
+/*
+ * Worker for ktxLaunchThreads. Takes the next untranscoded image until
+ * none are left so threads given small images pick up more of them.
+ */
+static void
+transcodeImagesWorker(ktx_uint32_t, ktx_uint32_t, void* payload)
+{
+    ktxXcodeJobs& jobs = *static_cast<ktxXcodeJobs*>(payload);
+    basisu_transcoder_state xcoderState;
+
+    for (;;) {
+        ktx_uint32_t i = ktxAtomicIncrement(&jobs.nextImage) - 1;
+        if (i >= jobs.images.size())
+            break;
+        if (!transcodeImage(jobs, jobs.images[i], xcoderState))
+            jobs.failed = true;
+    }
+}
+
+/*
+ * Transcode all of @p jobs.images, with the application's job runner or
+ * libktx threads if @p params asks for them. Video is always transcoded
+ * in order on the calling thread as P-frames depend on earlier frames.
+ */
+static KTX_error_code
+transcodeImages(ktxXcodeJobs& jobs, const ktxTranscodeParams* params)
+{
+    ktx_uint32_t imageCount = (ktx_uint32_t)jobs.images.size();
+
+    if (jobs.dest.levels) {
+        KTX_error_code result = layoutImages(jobs);
+        if (result != KTX_SUCCESS)
+            return result;
+    }
+
+    jobs.nextImage = 0;
+    jobs.failed = false;
+    if (jobs.This->isVideo) {
+        // basisu_transcoder_state is used to find the previous frame when
+        // decoding a video P-Frame. It tracks the previous frame for each
+        // mip level. For cube map array textures we need to find the
+        // previous frame for each face so we a state per face.
+        ktxVector<basisu_transcoder_state> xcoderStates;
+        xcoderStates.resize(jobs.This->numFaces);
+        for (const ktxXcodeImage& image : jobs.images) {
+            if (!transcodeImage(jobs, image, xcoderStates[image.stateIndex]))
+                return KTX_TRANSCODE_FAILED;
+        }
+        return KTX_SUCCESS;
+    }
+
+    if (params && params->pfnRunJobs) {
+        params->pfnRunJobs(params->pUserData, imageCount,
+                           transcodeImageJob, &jobs);
+    } else if (params && params->threadCount > 1 && imageCount > 1) {
+        ktxLaunchThreads(MIN(params->threadCount, imageCount),
+                         transcodeImagesWorker, &jobs);
+    } else {
+        transcodeImagesWorker(1, 0, &jobs);
+    }
+    return jobs.failed ? KTX_TRANSCODE_FAILED : KTX_SUCCESS;
+}
 
 /**
  * @memberof ktxTexture2
@@ -134,6 +467,309 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
  ktxTexture2_TranscodeBasis(ktxTexture2* This,
                             ktx_transcode_fmt_e outputFormat,
                             ktx_transcode_flags transcodeFlags)
+{
+    return ktxTexture2_TranscodeBasisEx(This, outputFormat, transcodeFlags,
+                                        nullptr);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup reader
+ * @~English
+ * @brief Transcode a KTX2 texture with BasisLZ/ETC1S or UASTC images using
+ *        multiple threads.
+ *
+ * The same as ktxTexture2_TranscodeBasis() except that the images of all
+ * levels, layers, faces and depth slices are transcoded in parallel, either
+ * on @c params->threadCount threads started by libktx or by the
+ * application's @c params->pfnRunJobs. Each image is a separate job.
+ * Video frames are always transcoded in order on the calling thread as
+ * P-frames depend on the preceding frame.
+ *
+ * @c params->firstLevel and @c params->numLevels restrict transcoding to a
+ * range of mip levels, e.g. the small levels at the end of the chain for a
+ * quick first display while streaming. Only those levels are transcoded
+ * and allocated. The texture is left holding just that range, with
+ * @c firstLevel as its new base level.
+ *
+ * When @c params->cacheDir is set, the transcoded data is saved there, in a
+ * file named for a hash of the texture's supercompressed data and
+ * description, the target format, the flags and the level range. Later
+ * transcodes of the same texture to the same target map that file, where
+ * the platform supports it, instead of transcoding. The mapping is private
+ * so changes to the image data never reach the cache. Failure to read or
+ * write the cache is not an error; the texture is transcoded as normal.
+ * The directory must exist.
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   outputFormat a value from the ktx_texture_transcode_fmt_e enum
+ *                           specifying the target format.
+ * @param[in]   transcodeFlags  bitfield of flags modifying the transcode
+ *                           operation. @sa ktx_texture_decode_flags_e.
+ * @param[in]   params       pointer to the threading parameters. If @c NULL
+ *                           transcoding is done on the calling thread.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p params' @c structSize is wrong.
+ * @exception KTX_INVALID_VALUE @c params->firstLevel or @c params->numLevels
+ *                              is outside the texture's levels.
+ * @exception KTX_TRANSCODE_FAILED
+ *                              Something went wrong transcoding an image.
+ *
+ * The other errors are as for ktxTexture2_TranscodeBasis().
+ */
+ KTX_error_code
+ ktxTexture2_TranscodeBasisEx(ktxTexture2* This,
+                              ktx_transcode_fmt_e outputFormat,
+                              ktx_transcode_flags transcodeFlags,
+                              const ktxTranscodeParams* params)
+{
+    return transcodeBasis(This, outputFormat, transcodeFlags, params,
+                          nullptr, 0, nullptr, nullptr);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup reader
+ * @~English
+ * @brief Transcode a KTX2 texture with BasisLZ/ETC1S or UASTC images into
+ *        application memory.
+ *
+ * The same as ktxTexture2_TranscodeBasisEx() except that the transcoded
+ * images are written directly to @p pDest, e.g. a mapped staging buffer,
+ * instead of to a new allocation owned by the texture. The texture itself
+ * is not modified, apart from its image data being loaded if that is still
+ * pending, so it can be transcoded again.
+ *
+ * The images of each level are written in the order they appear in a KTX2
+ * level: layer by layer and within a layer face by face or depth slice by
+ * depth slice. Where the images of each level and their rows go is given
+ * by @p pLevelDests.
+ *
+ * @param[in]   This         pointer to the ktxTexture2 object of interest.
+ * @param[in]   outputFormat a value from the ktx_texture_transcode_fmt_e enum
+ *                           specifying the target format.
+ * @param[in]   transcodeFlags  bitfield of flags modifying the transcode
+ *                           operation. @sa ktx_texture_decode_flags_e.
+ * @param[in]   params       pointer to the threading and level range
+ *                           parameters. May be @c NULL.
+ * @param[in]   pDest        pointer to the memory to write to.
+ * @param[in]   destSize     size in bytes of the memory at @p pDest.
+ * @param[in]   pLevelDests  pointer to an array with an entry for each
+ *                           transcoded level, starting with
+ *                           @c params->firstLevel. If @c NULL the levels
+ *                           are tightly packed as in the texture data
+ *                           ktxTexture2_TranscodeBasisEx() would produce.
+ * @param[out]  pVkFormat    pointer to where to write the VkFormat of the
+ *                           transcoded images. May be @c NULL.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p pDest is @c NULL.
+ * @exception KTX_INVALID_VALUE An image does not fit in @p destSize bytes,
+ *                              or an offset or pitch in @p pLevelDests is
+ *                              too small or not a multiple of the size of a
+ *                              block or pixel. PVRTC1 images must have
+ *                              tightly packed rows.
+ *
+ * The other errors are as for ktxTexture2_TranscodeBasisEx().
+ */
+KTX_error_code
+ktxTexture2_TranscodeBasisToMemory(ktxTexture2* This,
+                                   ktx_transcode_fmt_e outputFormat,
+                                   ktx_transcode_flags transcodeFlags,
+                                   const ktxTranscodeParams* params,
+                                   ktx_uint8_t* pDest, ktx_size_t destSize,
+                                   const ktxTranscodeLevelDest* pLevelDests,
+                                   ktx_uint32_t* pVkFormat)
+{
+    if (pDest == nullptr)
+        return KTX_INVALID_VALUE;
+
+    return transcodeBasis(This, outputFormat, transcodeFlags, params,
+                          pDest, destSize, pLevelDests, pVkFormat);
+}
+
+/*
+ * Decode the ETC1S codebooks and Huffman tables in the supercompression
+ * global data of @p This into @p bit and find the index of the first image
+ * of each level in the image descriptions.
+ */
+static KTX_error_code
+prepareEtc1s(ktxTexture2* This, basisu_lowlevel_etc1s_transcoder& bit,
+             ktxVector<uint32_t>& firstImages)
+{
+    DECLARE_PRIVATE(priv, This);
+
+    uint8_t* bgd = priv._supercompressionGlobalData;
+    ktxBasisLzGlobalHeader& bgdh = *reinterpret_cast<ktxBasisLzGlobalHeader*>(bgd);
+    if (!(bgdh.endpointsByteLength && bgdh.selectorsByteLength && bgdh.tablesByteLength)) {
+        debug_printf("ktxTexture_TranscodeBasis: missing endpoints, selectors or tables");
+        return KTX_FILE_DATA_ERROR;
+    }
+
+    // Compute some helpful numbers.
+    //
+    // firstImages contains the indices of the first images for each level to
+    // ease finding the correct slice description when iterating from smallest
+    // level to largest or when randomly accessing them (t.b.c). The last array
+    // entry contains the total number of images, for calculating the offsets
+    // of the endpoints, etc.
+    firstImages.resize(This->numLevels + 1);
+
+    // Temporary invariant value
+    uint32_t layersFaces = This->numLayers * This->numFaces;
+    firstImages[0] = 0;
+    for (uint32_t level = 1; level <= This->numLevels; level++) {
+        // NOTA BENE: numFaces * depth is only reasonable because they can't
+        // both be > 1. I.e there are no 3d cubemaps.
+        firstImages[level] = firstImages[level - 1]
+                           + layersFaces * MAX(This->baseDepth >> (level - 1), 1);
+    }
+    uint32_t& imageCount = firstImages[This->numLevels];
+
+    if (BGD_TABLES_ADDR(0, bgdh, imageCount) + bgdh.tablesByteLength > priv._sgdByteLength) {
+        return KTX_FILE_DATA_ERROR;
+    }
+    // FIXME: Do more validation.
+
+    // Prepare low-level transcoder for transcoding slices.
+    bit.decode_palettes(bgdh.endpointCount, BGD_ENDPOINTS_ADDR(bgd, imageCount),
+                        bgdh.endpointsByteLength,
+                        bgdh.selectorCount, BGD_SELECTORS_ADDR(bgd, bgdh, imageCount),
+                        bgdh.selectorsByteLength);
+
+    bit.decode_tables(BGD_TABLES_ADDR(bgd, bgdh, imageCount),
+                      bgdh.tablesByteLength);
+    return KTX_SUCCESS;
+}
+
+/*
+ * Add the images of an ETC1S @p level to @p jobs. The level's data starts
+ * at @p levelOffset in @p jobs.pSrc and its transcoded images are written
+ * from @p writeOffset on. @p protoLevel is the level's index in the
+ * prototype. The total size of the transcoded images is returned in
+ * @p levelSizeOut.
+ */
+static KTX_error_code
+addEtc1sLevelImages(ktxXcodeJobs& jobs, const ktxVector<uint32_t>& firstImages,
+                    uint32_t level, uint64_t levelOffset, uint64_t writeOffset,
+                    uint32_t protoLevel, ktx_size_t& levelSizeOut)
+{
+    ktxTexture2* This = jobs.This;
+    const ktxBasisLzEtc1sImageDesc* imageDescs
+                    = BGD_ETC1S_IMAGE_DESCS(This->_private->_supercompressionGlobalData);
+    uint32_t depth = MAX(1, This->baseDepth >> level);
+    //uint32_t faceSlices = This->numFaces == 1 ? depth : This->numFaces;
+    uint32_t faceSlices = This->numFaces * depth;
+    uint32_t numImages = This->numLayers * faceSlices;
+    uint32_t image = firstImages[level];
+    uint32_t endImage = image + numImages;
+    ktx_size_t levelImageSizeOut;
+    uint32_t stateIndex = 0;
+
+    // FIXME: Iframe flag needs to be queryable by the application. In Basis
+    // the app can query file_info and image_info from the transcoder which
+    // returns a structure with lots of info about the image.
+
+    levelSizeOut = 0;
+    // FIXME: Figure out a way to get the size out of the transcoder.
+    levelImageSizeOut = ktxTexture2_GetImageSize(jobs.prototype, protoLevel);
+    for (; image < endImage; image++) {
+        const ktxBasisLzEtc1sImageDesc& imageDesc = imageDescs[image];
+        ktxXcodeImage xcodeImage;
+
+        if (jobs.hasAlpha)
+        {
+            // The slice descriptions should have alpha information.
+            if (imageDesc.alphaSliceByteOffset == 0
+                || imageDesc.alphaSliceByteLength == 0)
+                return KTX_FILE_DATA_ERROR;
+        }
+
+        xcodeImage.level = level;
+        // We have face0 [face1 ...] within each layer. Use `stateIndex`
+        // rather than a double loop of layers and faceSlices as this
+        // works for 3d texture and non-array cube maps as well as
+        // cube map arrays without special casing.
+        xcodeImage.stateIndex = This->isVideo ? stateIndex : 0;
+        if (++stateIndex == This->numFaces)
+            stateIndex = 0;
+        xcodeImage.writeOffset = writeOffset;
+        xcodeImage.rowPitch = 0;
+        xcodeImage.rgbOffset
+            = (uint32_t)(levelOffset + imageDesc.rgbSliceByteOffset);
+        xcodeImage.rgbLength = imageDesc.rgbSliceByteLength;
+        xcodeImage.alphaOffset
+            = (uint32_t)(levelOffset + imageDesc.alphaSliceByteOffset);
+        xcodeImage.alphaLength = imageDesc.alphaSliceByteLength;
+        jobs.images.push_back(xcodeImage);
+
+        writeOffset += levelImageSizeOut;
+        levelSizeOut += levelImageSizeOut;
+    } // end images loop
+    return KTX_SUCCESS;
+}
+
+/*
+ * Add the images of a UASTC @p level to @p jobs. Parameters are as for
+ * addEtc1sLevelImages.
+ */
+static void
+addUastcLevelImages(ktxXcodeJobs& jobs, uint32_t level, uint64_t levelOffset,
+                    uint64_t writeOffset, uint32_t protoLevel,
+                    ktx_size_t& levelSizeOut)
+{
+    ktxTexture2* This = jobs.This;
+    ktx_uint32_t depth;
+    ktx_size_t levelImageSizeIn, levelImageOffsetIn;
+    ktx_size_t levelImageSizeOut;
+    ktx_uint32_t levelImageCount;
+    uint32_t stateIndex = 0;
+
+    depth = MAX(1, This->baseDepth  >> level);
+
+    levelImageCount = This->numLayers * This->numFaces * depth;
+    levelImageSizeIn = ktxTexture_calcImageSize(ktxTexture(This), level,
+                                                KTX_FORMAT_VERSION_TWO);
+    levelImageSizeOut = ktxTexture_calcImageSize(ktxTexture(jobs.prototype),
+                                                 protoLevel,
+                                                 KTX_FORMAT_VERSION_TWO);
+
+    levelImageOffsetIn = levelOffset;
+    levelSizeOut = 0;
+    for (uint32_t image = 0; image < levelImageCount; image++) {
+        ktxXcodeImage xcodeImage;
+
+        xcodeImage.level = level;
+        // See comment before same lines in addEtc1sLevelImages.
+        xcodeImage.stateIndex = This->isVideo ? stateIndex : 0;
+        if (++stateIndex == This->numFaces)
+            stateIndex = 0;
+        xcodeImage.writeOffset = writeOffset;
+        xcodeImage.rowPitch = 0;
+        xcodeImage.rgbOffset = (uint32_t)levelImageOffsetIn;
+        xcodeImage.rgbLength = (uint32_t)levelImageSizeIn;
+        xcodeImage.alphaOffset = xcodeImage.alphaLength = 0;
+        jobs.images.push_back(xcodeImage);
+
+        writeOffset += levelImageSizeOut;
+        levelSizeOut += levelImageSizeOut;
+        levelImageOffsetIn += levelImageSizeIn;
+    }
+}
+
+/*
+ * Check @p This can be transcoded to @p outputFormat. On success
+ * @p outputFormat is the format the transcoder will write, the choices
+ * that depend on alpha having been resolved, and @p vkFormat is the
+ * matching VkFormat.
+ */
+static KTX_error_code
+selectTranscodeTarget(ktxTexture2* This, ktx_transcode_fmt_e& outputFormat,
+                      ktx_transcode_flags transcodeFlags,
+                      alpha_content_e& alphaContent, VkFormat& vkFormat)
 {
     uint32_t* BDB = This->pDfd + 1;
     khr_df_model_e colorModel = (khr_df_model_e)KHR_DFDVAL(BDB, MODEL);
@@ -164,7 +800,7 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
     }
 
     const bool srgb = (KHR_DFDVAL(BDB, TRANSFER) == KHR_DF_TRANSFER_SRGB);
-    alpha_content_e alphaContent = eNone;
+    alphaContent = eNone;
     if (colorModel == KHR_DF_MODEL_ETC1S) {
         if (KHR_DFDSAMPLECOUNT(BDB) == 2) {
             uint32_t channelId = KHR_DFDSVAL(BDB, 1, CHANNELID);
@@ -184,8 +820,6 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
             alphaContent = eGreen;
     }
 
-    VkFormat vkFormat;
-
     // Do some format mapping.
     switch (outputFormat) {
       case KTX_TTF_BC1_OR_3:
@@ -285,104 +919,947 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
                                     textureFormat)) {
         return KTX_UNSUPPORTED_FEATURE;
     }
+    return KTX_SUCCESS;
+}
 
-
-    // Create a prototype texture to use for calculating sizes in the target
-    // format and, as useful side effects, provide us with a properly sized
-    // data allocation and the DFD for the target format.
+/*
+ * Create a texture in the target format with @p levelCount levels, the
+ * first being @p firstLevel of @p This, to use for calculating sizes in
+ * that format and for its DFD.
+ */
+static KTX_error_code
+createPrototype(ktxTexture2* This, VkFormat vkFormat,
+                ktx_uint32_t firstLevel, ktx_uint32_t levelCount,
+                ktxTextureCreateStorageEnum storageAllocation,
+                ktxTexture2** pPrototype)
+{
     ktxTextureCreateInfo createInfo;
     createInfo.glInternalformat = 0;
     createInfo.vkFormat = vkFormat;
-    createInfo.baseWidth = This->baseWidth;
-    createInfo.baseHeight = This->baseHeight;
-    createInfo.baseDepth = This->baseDepth;
+    createInfo.baseWidth = MAX(1, This->baseWidth >> firstLevel);
+    createInfo.baseHeight = MAX(1, This->baseHeight >> firstLevel);
+    createInfo.baseDepth = MAX(1, This->baseDepth >> firstLevel);
     createInfo.generateMipmaps = This->generateMipmaps;
     createInfo.isArray = This->isArray;
     createInfo.numDimensions = This->numDimensions;
     createInfo.numFaces = This->numFaces;
     createInfo.numLayers = This->numLayers;
-    createInfo.numLevels = This->numLevels;
+    createInfo.numLevels = levelCount;
     createInfo.pDfd = nullptr;
 
     KTX_error_code result;
-    ktxTexture2* prototype;
-    result = ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
-                                &prototype);
+    result = ktxTexture2_Create(&createInfo, storageAllocation, pPrototype);
+    // The only run time error
+    assert(result == KTX_SUCCESS || result == KTX_OUT_OF_MEMORY);
+    return result;
+}
 
-    if (result != KTX_SUCCESS) {
-        assert(result == KTX_OUT_OF_MEMORY); // The only run time error
-        return result;
+/*
+ * Change the format description of @p This, including its levels and
+ * DFD, to that of @p prototype. The image data is not touched.
+ */
+static void
+adoptPrototypeFormat(ktxTexture2* This, ktxTexture2* prototype)
+{
+    DECLARE_PRIVATE(priv, This);
+    DECLARE_PROTECTED(thisPrtctd, This);
+    DECLARE_PRIVATE(protoPriv, prototype);
+    DECLARE_PROTECTED(protoPrtctd, prototype);
+    memcpy(&thisPrtctd._formatSize, &protoPrtctd._formatSize,
+           sizeof(ktxFormatSize));
+    This->vkFormat = prototype->vkFormat;
+    This->isCompressed = prototype->isCompressed;
+    This->supercompressionScheme = KTX_SS_NONE;
+    priv._requiredLevelAlignment = protoPriv._requiredLevelAlignment;
+    // Drop any levels outside the transcoded range.
+    This->numLevels = prototype->numLevels;
+    This->baseWidth = prototype->baseWidth;
+    This->baseHeight = prototype->baseHeight;
+    This->baseDepth = prototype->baseDepth;
+    // Copy the levelIndex from the prototype to This.
+    memcpy(priv._levelIndex, protoPriv._levelIndex,
+           This->numLevels * sizeof(ktxLevelIndexEntry));
+    // Move the DFD from the prototype to This.
+    ktxFree(This->pDfd);
+    This->pDfd = prototype->pDfd;
+    prototype->pDfd = 0;
+    // Free SGD data
+    priv._sgdByteLength = 0;
+    if (priv._supercompressionGlobalData) {
+        ktxFree(priv._supercompressionGlobalData);
+        priv._supercompressionGlobalData = NULL;
     }
+}
 
-    if (!This->pData) {
-        if (ktxTexture_isActiveStream((ktxTexture*)This)) {
-             // Load pending. Complete it.
-            result = ktxTexture2_LoadImageData(This, NULL, 0);
-            if (result != KTX_SUCCESS)
-            {
-                ktxTexture2_Destroy(prototype);
-                return result;
-            }
-        } else {
-            // No data to transcode.
-            ktxTexture2_Destroy(prototype);
-            return KTX_INVALID_OPERATION;
-        }
-    }
-
-    // Transcoder global initialization. Requires ~9 milliseconds when compiled
-    // and executed natively on a Core i7 2.2 GHz. If this is too slow, the
-    // tables it computes can easily be moved to be compiled in.
+/*
+ * Transcoder global initialization. Requires ~9 milliseconds when compiled
+ * and executed natively on a Core i7 2.2 GHz. If this is too slow, the
+ * tables it computes can easily be moved to be compiled in.
+ */
+static void
+initTranscoder()
+{
     static bool transcoderInitialized;
     if (!transcoderInitialized) {
         basisu_transcoder_init();
         transcoderInitialized = true;
     }
+}
+
+/*
+ * Transcode cache
+ *
+ * An entry is a file, named for the key of a transcode, holding a
+ * ktxXcodeCacheHeader followed by the transcoded data laid out as in the
+ * prototype. Entries are written to a temporary file that is then renamed
+ * so a reader never sees a partial entry.
+ */
+
+// Change this when the transcoder's output or the entry layout changes so
+// stale entries are no longer found.
+static const char ktxXcodeCacheMagic[8] = {
+    'K', 'T', 'X', 'X', 'C', '0', '0', '1'
+};
+
+struct ktxXcodeCacheHeader {
+    char magic[8];
+    uint64_t key[2];
+    uint64_t dataSize;
+    uint32_t vkFormat;
+    uint8_t reserved[12]; // Aligns the data to 16 bytes.
+};
+
+/*
+ * 128-bit hash for keying cache entries. Not cryptographic. It only needs
+ * to make accidental collisions vanishingly unlikely while being much
+ * faster than the transcode it saves.
+ */
+class ktxXcodeHash {
+  public:
+    void update(const void* pData, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(pData);
+        length += size;
+        for (; size >= 8; p += 8, size -= 8) {
+            uint64_t word;
+            memcpy(&word, p, 8);
+            mix(word);
+        }
+        if (size) {
+            uint64_t word = 0;
+            memcpy(&word, p, size);
+            mix(word);
+        }
+    }
+
+    void digest(uint64_t key[2]) {
+        key[0] = fmix(h0 ^ length);
+        key[1] = fmix(h1 ^ key[0]);
+    }
+
+  private:
+    static uint64_t rotl(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    // MurmurHash3's finalizer.
+    static uint64_t fmix(uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xFF51AFD7ED558CCDULL;
+        k ^= k >> 33;
+        k *= 0xC4CEB9FE1A85EC53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    // Two independent lanes so the CPU can overlap their multiplies.
+    void mix(uint64_t word) {
+        h0 = rotl(h0 ^ (word * 0x87C37B91114253D5ULL), 31)
+             * 0x4CF5AD432745937FULL;
+        h1 = rotl(h1 ^ (word * 0x9E3779B97F4A7C15ULL), 29)
+             * 0xC2B2AE3D27D4EB4FULL;
+    }
+
+    uint64_t h0 = 0x6A09E667F3BCC908ULL;
+    uint64_t h1 = 0xBB67AE8584CAA73BULL;
+    uint64_t length = 0;
+};
+
+/*
+ * Hash everything that affects the result of a transcode: the target, the
+ * texture's description and its supercompressed data, including the SGD.
+ */
+static void
+calcCacheKey(ktxTexture2* This, ktx_transcode_fmt_e outputFormat,
+             ktx_transcode_flags transcodeFlags, ktx_uint32_t firstLevel,
+             ktx_uint32_t levelCount, uint64_t key[2])
+{
+    DECLARE_PRIVATE(priv, This);
+    const uint32_t desc[] = {
+        (uint32_t)outputFormat, transcodeFlags, firstLevel, levelCount,
+        This->vkFormat, This->supercompressionScheme,
+        This->baseWidth, This->baseHeight, This->baseDepth,
+        This->numDimensions, This->numLevels, This->numLayers,
+        This->numFaces, (uint32_t)This->isArray, (uint32_t)This->isVideo
+    };
+    ktxXcodeHash hash;
+
+    hash.update(ktxXcodeCacheMagic, sizeof(ktxXcodeCacheMagic));
+    hash.update(desc, sizeof(desc));
+    hash.update(This->pDfd, *This->pDfd);
+    hash.update(priv._levelIndex,
+                This->numLevels * sizeof(ktxLevelIndexEntry));
+    if (priv._supercompressionGlobalData)
+        hash.update(priv._supercompressionGlobalData,
+                    (size_t)priv._sgdByteLength);
+    hash.update(This->pData, This->dataSize);
+    hash.digest(key);
+}
+
+static ktxString
+cacheEntryPath(const char* cacheDir, const uint64_t key[2])
+{
+    char name[40];
+    snprintf(name, sizeof(name), "/%016" PRIx64 "%016" PRIx64 ".ktxc",
+             key[0], key[1]);
+    return ktxString(cacheDir) + name;
+}
+
+/*
+ * Give @p This the cached result of its transcode, if there is an entry
+ * for @p key. When the entry can be mapped, @c pData becomes a view of the
+ * mapping, held by the texture's stream. Otherwise the data is read into
+ * a new allocation. @p prototype has no storage but its @c dataSize must
+ * be set.
+ */
+static bool
+loadCachedTranscode(ktxTexture2* This, ktxTexture2* prototype,
+                    const ktxString& path, const uint64_t key[2])
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+        return false;
+
+    ktxStream stream;
+    ktxXcodeCacheHeader header;
+    ktx_size_t size;
+    if (ktxMappedFileStream_construct(&stream, file, KTX_TRUE)
+        != KTX_SUCCESS) {
+        fclose(file);
+        return false;
+    }
+    if (stream.getsize(&stream, &size) != KTX_SUCCESS
+        || size != sizeof(header) + prototype->dataSize
+        || stream.read(&stream, &header, sizeof(header)) != KTX_SUCCESS
+        || memcmp(header.magic, ktxXcodeCacheMagic, sizeof(header.magic))
+        || header.key[0] != key[0] || header.key[1] != key[1]
+        || header.dataSize != prototype->dataSize
+        || header.vkFormat != (uint32_t)prototype->vkFormat) {
+        stream.destruct(&stream);
+        return false;
+    }
+
+    ktx_uint8_t* pData;
+    bool isView = stream.type == eStreamTypeMappedFile;
+    KTX_error_code result;
+    if (isView) {
+        result = ktxMappedFileStream_getview(&stream, sizeof(header),
+                                             prototype->dataSize, &pData);
+    } else {
+        pData = (ktx_uint8_t*)ktxMalloc(prototype->dataSize);
+        if (pData == NULL) {
+            stream.destruct(&stream);
+            return false;
+        }
+        result = stream.read(&stream, pData, prototype->dataSize);
+    }
+    if (result != KTX_SUCCESS || !isView)
+        stream.destruct(&stream);
+    if (result != KTX_SUCCESS) {
+        if (!isView)
+            ktxFree(pData);
+        return false;
+    }
+
+    DECLARE_PRIVATE(priv, This);
+    DECLARE_PROTECTED(prtctd, This);
+    adoptPrototypeFormat(This, prototype);
+    ktxTexture2_freeData(This);
+    if (prtctd._stream.data.file != NULL)
+        prtctd._stream.destruct(&prtctd._stream);
+    if (isView) {
+        prtctd._stream = stream;
+        priv._pDataIsView = KTX_TRUE;
+    }
+    This->pData = pData;
+    This->dataSize = prototype->dataSize;
+    prototype->dataSize = 0;
+    return true;
+}
+
+/*
+ * Add the transcoded data of @p This to the cache. Failure, e.g. because
+ * the cache directory does not exist, only means the next transcode is not
+ * saved.
+ */
+static void
+storeCachedTranscode(ktxTexture2* This, const ktxString& path,
+                     const uint64_t key[2])
+{
+    // Each writer has its own temporary file so concurrent writers of an
+    // entry cannot interleave and one left behind by a writer that died
+    // cannot block later ones. The entry is replaced atomically by rename.
+    static std::atomic<uint32_t> tmpSerial(0);
+    char suffix[48];
+    snprintf(suffix, sizeof(suffix), ".%lu.%08x%08x.tmp",
+             (unsigned long)getpid(), (uint32_t)time(NULL),
+             (uint32_t)tmpSerial++);
+    ktxString tmpPath = path + suffix;
+    FILE* file = fopen(tmpPath.c_str(), "wbx");
+    if (file == NULL)
+        return;
+
+    ktxXcodeCacheHeader header = { };
+    memcpy(header.magic, ktxXcodeCacheMagic, sizeof(header.magic));
+    header.key[0] = key[0];
+    header.key[1] = key[1];
+    header.dataSize = This->dataSize;
+    header.vkFormat = This->vkFormat;
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1
+                   && fwrite(This->pData, 1, This->dataSize, file)
+                      == This->dataSize;
+    written = fclose(file) == 0 && written;
+    if (!written || rename(tmpPath.c_str(), path.c_str()) != 0)
+        remove(tmpPath.c_str());
+}
+
+/*
+ * Common part of ktxTexture2_TranscodeBasisEx and
+ * ktxTexture2_TranscodeBasisToMemory. Transcodes into the texture when
+ * @p pDest is nullptr.
+ */
+static KTX_error_code
+transcodeBasis(ktxTexture2* This, ktx_transcode_fmt_e outputFormat,
+               ktx_transcode_flags transcodeFlags,
+               const ktxTranscodeParams* params,
+               ktx_uint8_t* pDest, ktx_size_t destSize,
+               const ktxTranscodeLevelDest* pLevelDests,
+               ktx_uint32_t* pVkFormat)
+{
+    if (params && params->structSize != sizeof(ktxTranscodeParams))
+        return KTX_INVALID_VALUE;
+
+    ktx_uint32_t firstLevel = params ? params->firstLevel : 0;
+    ktx_uint32_t levelCount = params ? params->numLevels : 0;
+    if (firstLevel >= This->numLevels)
+        return KTX_INVALID_VALUE;
+    if (levelCount == 0)
+        levelCount = This->numLevels - firstLevel;
+    else if (levelCount > This->numLevels - firstLevel)
+        return KTX_INVALID_VALUE;
+
+    KTX_error_code result;
+    alpha_content_e alphaContent;
+    VkFormat vkFormat;
+    result = selectTranscodeTarget(This, outputFormat, transcodeFlags,
+                                   alphaContent, vkFormat);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    // Create a prototype texture to use for calculating sizes in the target
+    // format and, as a useful side effect, provide us with the DFD for the
+    // target format. It holds only the requested levels, firstLevel
+    // becoming its base. Its storage is allocated only when the transcode
+    // is into the texture and there is no cached result.
+    ktxTexture2* prototype;
+    result = createPrototype(This, vkFormat, firstLevel, levelCount,
+                             KTX_TEXTURE_CREATE_NO_STORAGE, &prototype);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    if (!This->pData) {
+        if (ktxTexture_isActiveStream((ktxTexture*)This)) {
+             // Load pending. Complete it.
+            result = ktxTexture2_LoadImageData(This, NULL, 0);
+            if (result != KTX_SUCCESS)
+            {
+                ktxTexture2_Destroy(prototype);
+                return result;
+            }
+        } else {
+            // No data to transcode.
+            ktxTexture2_Destroy(prototype);
+            return KTX_INVALID_OPERATION;
+        }
+    }
+
+    // The cache holds whole textures so is only used when transcoding into
+    // the texture.
+    const char* cacheDir = params && !pDest ? params->cacheDir : nullptr;
+    uint64_t cacheKey[2] = { 0, 0 };
+    ktxString cachePath;
+    if (cacheDir) {
+        calcCacheKey(This, outputFormat, transcodeFlags, firstLevel,
+                     levelCount, cacheKey);
+        cachePath = cacheEntryPath(cacheDir, cacheKey);
+    }
+    if (!pDest) {
+        prototype->dataSize
+                = ktxTexture_calcDataSizeTexture(ktxTexture(prototype));
+        if (cacheDir
+            && loadCachedTranscode(This, prototype, cachePath, cacheKey)) {
+            ktxTexture2_Destroy(prototype);
+            return KTX_SUCCESS;
+        }
+        prototype->pData = (ktx_uint8_t*)ktxMalloc(prototype->dataSize);
+        if (prototype->pData == NULL) {
+            ktxTexture2_Destroy(prototype);
+            return KTX_OUT_OF_MEMORY;
+        }
+    }
+
+    initTranscoder();
 
-    if (textureFormat == basis_tex_format::cETC1S) {
+    ktxXcodeDest dest;
+    ktxVector<ktxTranscodeLevelDest> packedLevels;
+    if (pDest) {
+        if (!pLevelDests) {
+            // Pack the levels the same way as the prototype.
+            DECLARE_PRIVATE(protoPriv, prototype);
+            packedLevels.resize(levelCount);
+            for (uint32_t level = 0; level < levelCount; level++) {
+                packedLevels[level].byteOffset
+                                    = protoPriv._levelIndex[level].byteOffset;
+                packedLevels[level].rowPitch = 0;
+                packedLevels[level].imagePitch = 0;
+            }
+            pLevelDests = packedLevels.data();
+        }
+        dest.pData = pDest;
+        dest.dataSize = destSize;
+        dest.levels = pLevelDests;
+    } else {
+        dest.pData = prototype->pData;
+        dest.dataSize = prototype->dataSize;
+        dest.levels = nullptr;
+    }
+
+    if (This->supercompressionScheme == KTX_SS_BASIS_LZ) {
         result = ktxTexture2_transcodeLzEtc1s(This, alphaContent,
-                                            prototype, outputFormat,
-                                            transcodeFlags);
+                                            prototype, firstLevel,
+                                            outputFormat, transcodeFlags,
+                                            dest, params);
     } else {
         result = ktxTexture2_transcodeUastc(This, alphaContent,
-                                            prototype, outputFormat,
-                                            transcodeFlags);
+                                            prototype, firstLevel,
+                                            outputFormat, transcodeFlags,
+                                            dest, params);
     }
 
-    if (result == KTX_SUCCESS) {
+    if (result == KTX_SUCCESS && pVkFormat)
+        *pVkFormat = vkFormat;
+    if (result == KTX_SUCCESS && !pDest) {
         // Fix up the current texture
-        DECLARE_PROTECTED(thisPrtctd, This);
-        DECLARE_PRIVATE(protoPriv, prototype);
-        DECLARE_PROTECTED(protoPrtctd, prototype);
-        memcpy(&thisPrtctd._formatSize, &protoPrtctd._formatSize,
-               sizeof(ktxFormatSize));
-        This->vkFormat = vkFormat;
-        This->isCompressed = prototype->isCompressed;
-        This->supercompressionScheme = KTX_SS_NONE;
-        priv._requiredLevelAlignment = protoPriv._requiredLevelAlignment;
-        // Copy the levelIndex from the prototype to This.
-        memcpy(priv._levelIndex, protoPriv._levelIndex,
-               This->numLevels * sizeof(ktxLevelIndexEntry));
-        // Move the DFD and data from the prototype to This.
-        free(This->pDfd);
-        This->pDfd = prototype->pDfd;
-        prototype->pDfd = 0;
-        free(This->pData);
+        adoptPrototypeFormat(This, prototype);
+        // Move the data from the prototype to This.
+        ktxTexture2_freeData(This);
         This->pData = prototype->pData;
         This->dataSize = prototype->dataSize;
         prototype->pData = 0;
         prototype->dataSize = 0;
-        // Free SGD data
-        This->_private->_sgdByteLength = 0;
-        if (This->_private->_supercompressionGlobalData) {
-            free(This->_private->_supercompressionGlobalData);
-            This->_private->_supercompressionGlobalData = NULL;
-        }
+        if (cacheDir)
+            storeCachedTranscode(This, cachePath, cacheKey);
     }
     ktxTexture2_Destroy(prototype);
     return result;
  }
 
+/*
+ * Transcoder for a texture whose levels are read and transcoded one at a
+ * time by ktxTexture2_IterateLoadLevelFacesEx(). It holds what is shared
+ * by all levels so levels can be transcoded on different threads.
+ */
+struct ktxLevelTranscoder {
+    ktxTexture2* This;
+    ktxTexture2* prototype; // All levels, no storage.
+    ktx_transcode_fmt_e outputFormat;
+    ktx_transcode_flags transcodeFlags;
+    alpha_content_e alphaContent;
+    ktx_uint32_t threadCount;
+    basisu_lowlevel_etc1s_transcoder etc1s;
+    basisu_lowlevel_uastc_transcoder uastc;
+    ktxVector<uint32_t> firstImages; // ETC1S only.
+};
+
+/**
+ * @internal
+ * @~English
+ * @brief Create a transcoder for transcoding the levels of @p This one at
+ *        a time, as they are read from its source.
+ *
+ * @param[in]  This           the texture whose levels are to be transcoded.
+ *                            It must not be modified until the transcoder
+ *                            is destroyed.
+ * @param[in]  outputFormat   as for ktxTexture2_TranscodeBasis().
+ * @param[in]  transcodeFlags as for ktxTexture2_TranscodeBasis().
+ * @param[in]  threadCount    threads to transcode the images of a level
+ *                            with. 0 or 1 for the calling thread.
+ * @param[out] pXcoder        where to write the new transcoder.
+ *
+ * @return KTX_SUCCESS or the errors of ktxTexture2_TranscodeBasis().
+ */
+KTX_error_code
+ktxLevelTranscoder_create(ktxTexture2* This,
+                          ktx_transcode_fmt_e outputFormat,
+                          ktx_transcode_flags transcodeFlags,
+                          ktx_uint32_t threadCount,
+                          ktxLevelTranscoder** pXcoder)
+{
+    KTX_error_code result;
+    alpha_content_e alphaContent;
+    VkFormat vkFormat;
+    result = selectTranscodeTarget(This, outputFormat, transcodeFlags,
+                                   alphaContent, vkFormat);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    ktxLevelTranscoder* xcoder = ktxNew<ktxLevelTranscoder>();
+    if (!xcoder)
+        return KTX_OUT_OF_MEMORY;
+    xcoder->This = This;
+    xcoder->outputFormat = outputFormat;
+    xcoder->transcodeFlags = transcodeFlags;
+    xcoder->alphaContent = alphaContent;
+    xcoder->threadCount = threadCount;
+    result = createPrototype(This, vkFormat, 0, This->numLevels,
+                             KTX_TEXTURE_CREATE_NO_STORAGE,
+                             &xcoder->prototype);
+    if (result != KTX_SUCCESS) {
+        ktxDelete(xcoder);
+        return result;
+    }
+
+    initTranscoder();
+    if (This->supercompressionScheme == KTX_SS_BASIS_LZ)
+        result = prepareEtc1s(This, xcoder->etc1s, xcoder->firstImages);
+    if (result != KTX_SUCCESS) {
+        ktxLevelTranscoder_destroy(xcoder);
+        return result;
+    }
+    *pXcoder = xcoder;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Destroy a ktxLevelTranscoder.
+ */
+void
+ktxLevelTranscoder_destroy(ktxLevelTranscoder* xcoder)
+{
+    ktxTexture2_Destroy(xcoder->prototype);
+    ktxDelete(xcoder);
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Return a texture with no images describing the transcoded levels.
+ */
+ktxTexture2*
+ktxLevelTranscoder_getPrototype(ktxLevelTranscoder* xcoder)
+{
+    return xcoder->prototype;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Return the size of the largest transcoded level.
+ */
+ktx_size_t
+ktxLevelTranscoder_getMaxLevelSize(ktxLevelTranscoder* xcoder)
+{
+    return ktxTexture_calcLevelSize(ktxTexture(xcoder->prototype), 0,
+                                    KTX_FORMAT_VERSION_TWO);
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Transcode one level.
+ *
+ * May be called for different levels on different threads at the same
+ * time.
+ *
+ * @param[in]  xcoder     the transcoder.
+ * @param[in]  level      the level to transcode.
+ * @param[in]  pLevelData the level's data after any Zstd or ZLIB
+ *                        supercompression has been inflated.
+ * @param[in]  levelDataSize size of the data at @p pLevelData.
+ * @param[out] pDest      where to write the transcoded level. Must have
+ *                        room for ktxLevelTranscoder_getMaxLevelSize()
+ *                        bytes.
+ * @param[out] pLevelSize where to write the size of the transcoded level.
+ *
+ * @return KTX_SUCCESS, KTX_FILE_DATA_ERROR or KTX_TRANSCODE_FAILED.
+ */
+KTX_error_code
+ktxLevelTranscoder_transcode(ktxLevelTranscoder* xcoder, ktx_uint32_t level,
+                             const ktx_uint8_t* pLevelData,
+                             ktx_size_t levelDataSize,
+                             ktx_uint8_t* pDest, ktx_size_t* pLevelSize)
+{
+    ktxXcodeJobs jobs;
+    ktxTranscodeParams params = { };
+    ktx_size_t levelSizeOut;
+    KTX_error_code result;
+
+    jobs.This = xcoder->This;
+    jobs.prototype = xcoder->prototype;
+    jobs.pSrc = pLevelData;
+    jobs.srcSize = levelDataSize;
+    jobs.dest.pData = pDest;
+    jobs.dest.dataSize = ktxLevelTranscoder_getMaxLevelSize(xcoder);
+    jobs.dest.levels = nullptr;
+    jobs.firstLevel = 0;
+    jobs.outputFormat = xcoder->outputFormat;
+    jobs.transcodeFlags = xcoder->transcodeFlags;
+    jobs.hasAlpha = xcoder->alphaContent != eNone;
+    if (xcoder->This->supercompressionScheme == KTX_SS_BASIS_LZ) {
+        jobs.etc1s = &xcoder->etc1s;
+        jobs.uastc = nullptr;
+        result = addEtc1sLevelImages(jobs, xcoder->firstImages, level,
+                                     0, 0, level, levelSizeOut);
+        if (result != KTX_SUCCESS)
+            return result;
+    } else {
+        jobs.etc1s = nullptr;
+        jobs.uastc = &xcoder->uastc;
+        addUastcLevelImages(jobs, level, 0, 0, level, levelSizeOut);
+    }
+
+    params.structSize = sizeof(params);
+    params.threadCount = xcoder->threadCount;
+    result = transcodeImages(jobs, &params);
+    if (result == KTX_SUCCESS)
+        *pLevelSize = levelSizeOut;
+    return result;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Change the texture's format description to that of the
+ *        transcoded levels once they have all been transcoded.
+ */
+void
+ktxLevelTranscoder_adoptFormat(ktxLevelTranscoder* xcoder)
+{
+    adoptPrototypeFormat(xcoder->This, xcoder->prototype);
+}
+
+/*
+ * Transcoder for the frames of a video texture. See
+ * ktxVideoTranscoder_Create().
+ */
+struct ktxVideoTranscoder {
+    ktxTexture2* texture;
+    ktxTexture2* prototype; // All levels, no storage.
+    ktxXcodeJobs jobs;
+    basisu_lowlevel_etc1s_transcoder etc1s;
+    basisu_lowlevel_uastc_transcoder uastc;
+    ktxVector<uint32_t> firstImages; // ETC1S only.
+    // For each level, the frame the face states are ready to transcode,
+    // i.e. the one after the last frame transcoded. UINT32_MAX if none.
+    ktxVector<uint32_t> nextFrames;
+    ktxVector<basisu_transcoder_state> states; // One per face.
+    ktxVector<ktx_uint8_t> scratch; // Output of frames skipped over.
+};
+
+/**
+ * @memberof ktxVideoTranscoder
+ * @~English
+ * @brief Create a transcoder for transcoding the frames of a BasisLZ/ETC1S
+ *        or UASTC video texture one at a time.
+ *
+ * The supercompression global data is decoded once, when the transcoder
+ * is created. Each call to ktxVideoTranscoder_TranscodeFrame() then
+ * transcodes only the requested frame, so frames can be transcoded as
+ * they are needed for playback instead of all up front.
+ *
+ * The texture's images are loaded, if that is still pending, but the
+ * texture is otherwise unchanged. It must not be modified or destroyed
+ * while the transcoder exists.
+ *
+ * @param[in]  texture        pointer to the video texture. Its frames
+ *                            are its array layers.
+ * @param[in]  outputFormat   a value from the ktx_texture_transcode_fmt_e
+ *                            enum specifying the target format.
+ * @param[in]  transcodeFlags bitfield of flags modifying the transcode
+ *                            operation. @sa ktx_texture_decode_flags_e.
+ * @param[out] newXcoder      pointer to a location in which store the
+ *                            address of the new transcoder.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p texture or @p newXcoder is @c NULL.
+ * @exception KTX_INVALID_OPERATION
+ *                              @p texture is not a video texture.
+ *
+ * The other errors are as for ktxTexture2_TranscodeBasis().
+ */
+KTX_error_code
+ktxVideoTranscoder_Create(ktxTexture2* texture,
+                          ktx_transcode_fmt_e outputFormat,
+                          ktx_transcode_flags transcodeFlags,
+                          ktxVideoTranscoder** newXcoder)
+{
+    if (texture == nullptr || newXcoder == nullptr)
+        return KTX_INVALID_VALUE;
+    if (!texture->isVideo)
+        return KTX_INVALID_OPERATION;
+
+    KTX_error_code result;
+    alpha_content_e alphaContent;
+    VkFormat vkFormat;
+    result = selectTranscodeTarget(texture, outputFormat, transcodeFlags,
+                                   alphaContent, vkFormat);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    if (!texture->pData) {
+        if (!ktxTexture_isActiveStream((ktxTexture*)texture))
+            return KTX_INVALID_OPERATION;
+        result = ktxTexture2_LoadImageData(texture, NULL, 0);
+        if (result != KTX_SUCCESS)
+            return result;
+    }
+
+    ktxVideoTranscoder* xcoder = ktxNew<ktxVideoTranscoder>();
+    if (!xcoder)
+        return KTX_OUT_OF_MEMORY;
+    xcoder->texture = texture;
+    result = createPrototype(texture, vkFormat, 0, texture->numLevels,
+                             KTX_TEXTURE_CREATE_NO_STORAGE,
+                             &xcoder->prototype);
+    if (result != KTX_SUCCESS) {
+        ktxDelete(xcoder);
+        return result;
+    }
+
+    initTranscoder();
+    ktxXcodeJobs& jobs = xcoder->jobs;
+    jobs.This = texture;
+    jobs.prototype = xcoder->prototype;
+    jobs.pSrc = texture->pData;
+    jobs.srcSize = texture->dataSize;
+    jobs.firstLevel = 0;
+    jobs.outputFormat = outputFormat;
+    jobs.transcodeFlags = transcodeFlags;
+    jobs.hasAlpha = alphaContent != eNone;
+    if (texture->supercompressionScheme == KTX_SS_BASIS_LZ) {
+        jobs.etc1s = &xcoder->etc1s;
+        jobs.uastc = nullptr;
+        result = prepareEtc1s(texture, xcoder->etc1s, xcoder->firstImages);
+        if (result != KTX_SUCCESS) {
+            ktxVideoTranscoder_Destroy(xcoder);
+            return result;
+        }
+    } else {
+        jobs.etc1s = nullptr;
+        jobs.uastc = &xcoder->uastc;
+    }
+    xcoder->nextFrames.assign(texture->numLevels, UINT32_MAX);
+    xcoder->states.resize(texture->numFaces);
+    *newXcoder = xcoder;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxVideoTranscoder
+ * @~English
+ * @brief Destroy a ktxVideoTranscoder.
+ *
+ * @param[in] xcoder pointer to the transcoder to destroy.
+ */
+void
+ktxVideoTranscoder_Destroy(ktxVideoTranscoder* xcoder)
+{
+    if (xcoder == nullptr)
+        return;
+    ktxTexture2_Destroy(xcoder->prototype);
+    ktxDelete(xcoder);
+}
+
+/**
+ * @memberof ktxVideoTranscoder
+ * @~English
+ * @brief Return the VkFormat of the transcoded frames.
+ *
+ * @param[in] xcoder pointer to the transcoder of interest.
+ */
+ktx_uint32_t
+ktxVideoTranscoder_GetVkFormat(ktxVideoTranscoder* xcoder)
+{
+    return xcoder->prototype->vkFormat;
+}
+
+/**
+ * @memberof ktxVideoTranscoder
+ * @~English
+ * @brief Return the size in bytes of a transcoded frame of a mip level.
+ *
+ * A frame holds one image for each face of the texture.
+ *
+ * @param[in] xcoder pointer to the transcoder of interest.
+ * @param[in] level  the mip level of interest.
+ */
+ktx_size_t
+ktxVideoTranscoder_GetFrameSize(ktxVideoTranscoder* xcoder,
+                                ktx_uint32_t level)
+{
+    return ktxTexture2_GetImageSize(xcoder->prototype, level)
+           * xcoder->texture->numFaces;
+}
+
+/*
+ * True if @p frame of @p level is coded relative to the previous frame.
+ */
+static bool
+isPFrame(ktxVideoTranscoder* xcoder, uint32_t level, uint32_t frame)
+{
+    ktxTexture2* texture = xcoder->texture;
+    if (texture->supercompressionScheme != KTX_SS_BASIS_LZ)
+        return false;
+    const ktxBasisLzEtc1sImageDesc* imageDescs
+          = BGD_ETC1S_IMAGE_DESCS(texture->_private->_supercompressionGlobalData);
+    uint32_t image = xcoder->firstImages[level] + frame * texture->numFaces;
+    return (imageDescs[image].imageFlags & ETC1S_P_FRAME) != 0;
+}
+
+/*
+ * Transcode the faces of one frame of @p level to @p pDest, continuing
+ * from the frame the face states last transcoded.
+ */
+static KTX_error_code
+transcodeFrame(ktxVideoTranscoder* xcoder, uint32_t level, uint32_t frame,
+               ktx_uint8_t* pDest)
+{
+    ktxTexture2* texture = xcoder->texture;
+    ktxXcodeJobs& jobs = xcoder->jobs;
+    ktx_size_t imageSizeOut = ktxTexture2_GetImageSize(xcoder->prototype,
+                                                       level);
+    uint64_t levelOffset = ktxTexture2_levelDataOffset(texture, level);
+
+    jobs.dest.pData = pDest;
+    jobs.dest.dataSize = imageSizeOut * texture->numFaces;
+    jobs.dest.levels = nullptr;
+    for (uint32_t face = 0; face < texture->numFaces; face++) {
+        uint32_t imageInLevel = frame * texture->numFaces + face;
+        ktxXcodeImage xcodeImage;
+
+        xcodeImage.level = level;
+        xcodeImage.stateIndex = face;
+        xcodeImage.writeOffset = face * imageSizeOut;
+        xcodeImage.rowPitch = 0;
+        if (jobs.etc1s) {
+            const ktxBasisLzEtc1sImageDesc& imageDesc
+                = BGD_ETC1S_IMAGE_DESCS(texture->_private->_supercompressionGlobalData)
+                                   [xcoder->firstImages[level] + imageInLevel];
+            if (jobs.hasAlpha && (imageDesc.alphaSliceByteOffset == 0
+                                  || imageDesc.alphaSliceByteLength == 0))
+                return KTX_FILE_DATA_ERROR;
+            xcodeImage.rgbOffset
+                = (uint32_t)(levelOffset + imageDesc.rgbSliceByteOffset);
+            xcodeImage.rgbLength = imageDesc.rgbSliceByteLength;
+            xcodeImage.alphaOffset
+                = (uint32_t)(levelOffset + imageDesc.alphaSliceByteOffset);
+            xcodeImage.alphaLength = imageDesc.alphaSliceByteLength;
+        } else {
+            ktx_size_t imageSizeIn
+                = ktxTexture_calcImageSize(ktxTexture(texture), level,
+                                           KTX_FORMAT_VERSION_TWO);
+            xcodeImage.rgbOffset
+                = (uint32_t)(levelOffset + imageInLevel * imageSizeIn);
+            xcodeImage.rgbLength = (uint32_t)imageSizeIn;
+            xcodeImage.alphaOffset = xcodeImage.alphaLength = 0;
+        }
+        if (!transcodeImage(jobs, xcodeImage, xcoder->states[face]))
+            return KTX_TRANSCODE_FAILED;
+    }
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxVideoTranscoder
+ * @~English
+ * @brief Transcode one frame of a mip level of a video texture.
+ *
+ * The faces of the frame are written one after the other to @p pDest.
+ *
+ * ETC1S P-frames are coded relative to the preceding frame, so a P-frame
+ * can only be transcoded after the frame before it. Playing frames in
+ * order transcodes each frame once. When another frame is requested, the
+ * frames from the closest preceding I-frame, or from the frame after the
+ * last one transcoded if that is closer, are transcoded first to a
+ * scratch buffer.
+ *
+ * A transcoder must not be used by more than one thread at a time.
+ *
+ * @param[in]  xcoder   pointer to the transcoder.
+ * @param[in]  level    the mip level to transcode.
+ * @param[in]  frame    the frame, i.e. array layer, to transcode.
+ * @param[out] pDest    pointer to the memory to write the frame to.
+ * @param[in]  destSize size in bytes of the memory at @p pDest.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p xcoder or @p pDest is @c NULL, @p level
+ *                              or @p frame is out of range or @p destSize
+ *                              is less than
+ *                              ktxVideoTranscoder_GetFrameSize().
+ * @exception KTX_FILE_DATA_ERROR
+ *                              An image description is missing its alpha
+ *                              slice.
+ * @exception KTX_TRANSCODE_FAILED
+ *                              Something went wrong transcoding a frame.
+ */
+KTX_error_code
+ktxVideoTranscoder_TranscodeFrame(ktxVideoTranscoder* xcoder,
+                                  ktx_uint32_t level, ktx_uint32_t frame,
+                                  ktx_uint8_t* pDest, ktx_size_t destSize)
+{
+    if (xcoder == nullptr || pDest == nullptr)
+        return KTX_INVALID_VALUE;
+    ktxTexture2* texture = xcoder->texture;
+    if (level >= texture->numLevels || frame >= texture->numLayers)
+        return KTX_INVALID_VALUE;
+    ktx_size_t frameSize = ktxVideoTranscoder_GetFrameSize(xcoder, level);
+    if (destSize < frameSize)
+        return KTX_INVALID_VALUE;
+
+    // Walk back to a frame the states are ready for.
+    uint32_t start = frame;
+    while (start > 0 && start != xcoder->nextFrames[level]
+           && isPFrame(xcoder, level, start))
+        start--;
+    if (start < frame)
+        xcoder->scratch.resize(frameSize);
+
+    for (uint32_t f = start; f <= frame; f++) {
+        KTX_error_code result;
+        result = transcodeFrame(xcoder, level, f,
+                                f == frame ? pDest : xcoder->scratch.data());
+        if (result != KTX_SUCCESS) {
+            xcoder->nextFrames[level] = UINT32_MAX;
+            return result;
+        }
+    }
+    xcoder->nextFrames[level] = frame + 1;
+    return KTX_SUCCESS;
+}
+
 /**
  * @memberof ktxTexture2 @private
  * @ingroup reader
@@ -426,6 +1903,7 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
  *                           specifying the target format.
  * @param[in]   transcodeFlags  bitfield of flags modifying the transcode
  *                           operation. @sa ktx_texture_decode_flags_e.
+ * @param[in]   params       threading parameters or @c NULL.
  *
  * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
  *
@@ -457,185 +1935,67 @@ KTX_error_code
 ktxTexture2_transcodeLzEtc1s(ktxTexture2* This,
                              alpha_content_e alphaContent,
                              ktxTexture2* prototype,
+                             ktx_uint32_t firstLevel,
                              ktx_transcode_fmt_e outputFormat,
-                             ktx_transcode_flags transcodeFlags)
+                             ktx_transcode_flags transcodeFlags,
+                             const ktxXcodeDest& dest,
+                             const ktxTranscodeParams* params)
 {
-    DECLARE_PRIVATE(priv, This);
     DECLARE_PRIVATE(protoPriv, prototype);
     KTX_error_code result = KTX_SUCCESS;
 
     assert(This->supercompressionScheme == KTX_SS_BASIS_LZ);
 
-    uint8_t* bgd = priv._supercompressionGlobalData;
-    ktxBasisLzGlobalHeader& bgdh = *reinterpret_cast<ktxBasisLzGlobalHeader*>(bgd);
-    if (!(bgdh.endpointsByteLength && bgdh.selectorsByteLength && bgdh.tablesByteLength)) {
-        debug_printf("ktxTexture_TranscodeBasis: missing endpoints, selectors or tables");
-        return KTX_FILE_DATA_ERROR;
-    }
-
-    // Compute some helpful numbers.
-    //
-    // firstImages contains the indices of the first images for each level to
-    // ease finding the correct slice description when iterating from smallest
-    // level to largest or when randomly accessing them (t.b.c). The last array
-    // entry contains the total number of images, for calculating the offsets
-    // of the endpoints, etc.
-    uint32_t* firstImages = new uint32_t[This->numLevels+1];
-
-    // Temporary invariant value
-    uint32_t layersFaces = This->numLayers * This->numFaces;
-    firstImages[0] = 0;
-    for (uint32_t level = 1; level <= This->numLevels; level++) {
-        // NOTA BENE: numFaces * depth is only reasonable because they can't
-        // both be > 1. I.e there are no 3d cubemaps.
-        firstImages[level] = firstImages[level - 1]
-                           + layersFaces * MAX(This->baseDepth >> (level - 1), 1);
-    }
-    uint32_t& imageCount = firstImages[This->numLevels];
-
-    if (BGD_TABLES_ADDR(0, bgdh, imageCount) + bgdh.tablesByteLength > priv._sgdByteLength) {
-        return KTX_FILE_DATA_ERROR;
-    }
-    // FIXME: Do more validation.
-
-    // Prepare low-level transcoder for transcoding slices.
+    ktxVector<uint32_t> firstImages;
     basist::basisu_lowlevel_etc1s_transcoder bit;
+    result = prepareEtc1s(This, bit, firstImages);
+    if (result != KTX_SUCCESS)
+        return result;
 
-    // basisu_transcoder_state is used to find the previous frame when
-    // decoding a video P-Frame. It tracks the previous frame for each mip
-    // level. For cube map array textures we need to find the previous frame
-    // for each face so we a state per face. Although providing this is only
-    // needed for video, it is easier to always pass our own.
-    std::vector<basisu_transcoder_state> xcoderStates;
-    xcoderStates.resize(This->isVideo ? This->numFaces : 1);
-
-    bit.decode_palettes(bgdh.endpointCount, BGD_ENDPOINTS_ADDR(bgd, imageCount),
-                        bgdh.endpointsByteLength,
-                        bgdh.selectorCount, BGD_SELECTORS_ADDR(bgd, bgdh, imageCount),
-                        bgdh.selectorsByteLength);
-
-    bit.decode_tables(BGD_TABLES_ADDR(bgd, bgdh, imageCount),
-                      bgdh.tablesByteLength);
-
-    // Find matching VkFormat and calculate output sizes.
-
-    const bool isVideo = This->isVideo;
+    ktxXcodeJobs jobs;
+    jobs.This = This;
+    jobs.prototype = prototype;
+    jobs.pSrc = This->pData;
+    jobs.srcSize = This->dataSize;
+    jobs.dest = dest;
+    jobs.firstLevel = firstLevel;
+    jobs.outputFormat = outputFormat;
+    jobs.transcodeFlags = transcodeFlags;
+    jobs.hasAlpha = alphaContent != eNone;
+    jobs.etc1s = &bit;
+    jobs.uastc = nullptr;
+    jobs.images.reserve(firstImages[This->numLevels]);
 
-    ktx_uint8_t* pXcodedData = prototype->pData;
-    // Inconveniently, the output buffer size parameter of transcode_image
-    // has to be in pixels for uncompressed output and in blocks for
-    // compressed output. The only reason for humouring the API is so
-    // its buffer size tests provide a real check. An alternative is to
-    // always provide the size in bytes which will always pass.
-    ktx_uint32_t outputBlockByteLength
-                      = prototype->_protected->_formatSize.blockSizeInBits / 8;
-    ktx_size_t xcodedDataLength
-                      = prototype->dataSize / outputBlockByteLength;
     ktxLevelIndexEntry* protoLevelIndex;
     uint64_t levelOffsetWrite;
-    const ktxBasisLzEtc1sImageDesc* imageDescs = BGD_ETC1S_IMAGE_DESCS(bgd);
-
-    // Finally we're ready to transcode the slices.
 
-    // FIXME: Iframe flag needs to be queryable by the application. In Basis
-    // the app can query file_info and image_info from the transcoder which
-    // returns a structure with lots of info about the image.
+    // Find where each image goes and lay out the prototype's levels before
+    // transcoding any of them, so images can be transcoded in any order.
 
     protoLevelIndex = protoPriv._levelIndex;
     levelOffsetWrite = 0;
-    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
-        uint64_t levelOffset = ktxTexture2_levelDataOffset(This, level);
-        uint64_t writeOffset = levelOffsetWrite;
-        uint64_t writeOffsetBlocks = levelOffsetWrite / outputBlockByteLength;
-        uint32_t levelWidth = MAX(1, This->baseWidth >> level);
-        uint32_t levelHeight = MAX(1, This->baseHeight >> level);
-        // ETC1S texel block dimensions
-        const uint32_t bw = 4, bh = 4;
-        uint32_t levelBlocksX = (levelWidth + (bw - 1)) / bw;
-        uint32_t levelBlocksY = (levelHeight + (bh - 1)) / bh;
-        uint32_t depth = MAX(1, This->baseDepth >> level);
-        //uint32_t faceSlices = This->numFaces == 1 ? depth : This->numFaces;
-        uint32_t faceSlices = This->numFaces * depth;
-        uint32_t numImages = This->numLayers * faceSlices;
-        uint32_t image = firstImages[level];
-        uint32_t endImage = image + numImages;
-        ktx_size_t levelImageSizeOut, levelSizeOut;
-        uint32_t stateIndex = 0;
-
-        levelSizeOut = 0;
-        // FIXME: Figure out a way to get the size out of the transcoder.
-        levelImageSizeOut = ktxTexture2_GetImageSize(prototype, level);
-        for (; image < endImage; image++) {
-            const ktxBasisLzEtc1sImageDesc& imageDesc = imageDescs[image];
-
-            basisu_transcoder_state& xcoderState = xcoderStates[stateIndex];
-            // We have face0 [face1 ...] within each layer. Use `stateIndex`
-            // rather than a double loop of layers and faceSlices as this
-            // works for 3d texture and non-array cube maps as well as
-            // cube map arrays without special casing.
-            if (++stateIndex == xcoderStates.size())
-                stateIndex = 0;
-
-            if (alphaContent != eNone)
-            {
-                // The slice descriptions should have alpha information.
-                if (imageDesc.alphaSliceByteOffset == 0
-                    || imageDesc.alphaSliceByteLength == 0)
-                    return KTX_FILE_DATA_ERROR;
-            }
+    for (int32_t level = firstLevel + prototype->numLevels - 1;
+         level >= (int32_t)firstLevel; level--) {
+        uint32_t protoLevel = level - firstLevel;
+        ktx_size_t levelSizeOut;
 
-            bool status;
-            status = bit.transcode_image(
-                      (transcoder_texture_format)outputFormat,
-                      pXcodedData + writeOffset,
-                      (uint32_t)(xcodedDataLength - writeOffsetBlocks),
-                      This->pData,
-                      (uint32_t)This->dataSize,
-                      levelBlocksX,
-                      levelBlocksY,
-                      levelWidth,
-                      levelHeight,
-                      level,
-                      (uint32_t)(levelOffset + imageDesc.rgbSliceByteOffset),
-                      imageDesc.rgbSliceByteLength,
-                      (uint32_t)(levelOffset + imageDesc.alphaSliceByteOffset),
-                      imageDesc.alphaSliceByteLength,
-                      transcodeFlags,
-                      alphaContent != eNone,
-                      isVideo,
-                      // Our P-Frame flag is in the same bit as
-                      // cSliceDescFlagsFrameIsIFrame. We have to
-                      // invert it to make it an I-Frame flag.
-                      //
-                      // API currently doesn't have any way to pass
-                      // the I-Frame flag.
-                      //imageDesc.imageFlags ^ cSliceDescFlagsFrameIsIFrame,
-                      0, // output_row_pitch_in_blocks_or_pixels
-                      &xcoderState,
-                      0  // output_rows_in_pixels
-                      );
-            if (!status) {
-                result = KTX_TRANSCODE_FAILED;
-                goto cleanup;
-            }
-
-            writeOffset += levelImageSizeOut;
-            levelSizeOut += levelImageSizeOut;
-        } // end images loop
-        protoLevelIndex[level].byteOffset = levelOffsetWrite;
-        protoLevelIndex[level].byteLength = levelSizeOut;
-        protoLevelIndex[level].uncompressedByteLength = levelSizeOut;
+        result = addEtc1sLevelImages(jobs, firstImages, level,
+                                     ktxTexture2_levelDataOffset(This, level),
+                                     levelOffsetWrite, protoLevel,
+                                     levelSizeOut);
+        if (result != KTX_SUCCESS)
+            return result;
+        protoLevelIndex[protoLevel].byteOffset = levelOffsetWrite;
+        protoLevelIndex[protoLevel].byteLength = levelSizeOut;
+        protoLevelIndex[protoLevel].uncompressedByteLength = levelSizeOut;
         levelOffsetWrite += levelSizeOut;
-        assert(levelOffsetWrite == writeOffset);
         // In case of transcoding to uncompressed.
         levelOffsetWrite = _KTX_PADN(protoPriv._requiredLevelAlignment,
                                      levelOffsetWrite);
     } // level loop
 
-    result = KTX_SUCCESS;
-
-cleanup:
-    delete[] firstImages;
+    // Finally we're ready to transcode the slices.
+    result = transcodeImages(jobs, params);
     return result;
 }
 
@@ -644,96 +2004,46 @@ KTX_error_code
 ktxTexture2_transcodeUastc(ktxTexture2* This,
                            alpha_content_e alphaContent,
                            ktxTexture2* prototype,
+                           ktx_uint32_t firstLevel,
                            ktx_transcode_fmt_e outputFormat,
-                           ktx_transcode_flags transcodeFlags)
+                           ktx_transcode_flags transcodeFlags,
+                           const ktxXcodeDest& dest,
+                           const ktxTranscodeParams* params)
 {
     assert(This->supercompressionScheme != KTX_SS_BASIS_LZ);
 
-    ktx_uint8_t* pXcodedData = prototype->pData;
-    ktx_uint32_t outputBlockByteLength
-                      = prototype->_protected->_formatSize.blockSizeInBits / 8;
-    ktx_size_t xcodedDataLength
-                      = prototype->dataSize / outputBlockByteLength;
     DECLARE_PRIVATE(protoPriv, prototype);
     ktxLevelIndexEntry* protoLevelIndex = protoPriv._levelIndex;
     ktx_size_t levelOffsetWrite = 0;
 
     basisu_lowlevel_uastc_transcoder uit;
-    // See comment on same declaration in transcodeEtc1s.
-    std::vector<basisu_transcoder_state> xcoderStates;
-    xcoderStates.resize(This->isVideo ? This->numFaces : 1);
+    ktxXcodeJobs jobs;
+    jobs.This = This;
+    jobs.prototype = prototype;
+    jobs.pSrc = This->pData;
+    jobs.srcSize = This->dataSize;
+    jobs.dest = dest;
+    jobs.firstLevel = firstLevel;
+    jobs.outputFormat = outputFormat;
+    jobs.transcodeFlags = transcodeFlags;
+    jobs.hasAlpha = alphaContent != eNone;
+    jobs.etc1s = nullptr;
+    jobs.uastc = &uit;
 
-    for (ktx_int32_t level = This->numLevels - 1; level >= 0; level--)
+    for (ktx_int32_t level = firstLevel + prototype->numLevels - 1;
+         level >= (ktx_int32_t)firstLevel; level--)
     {
-        ktx_uint32_t depth;
-        uint64_t writeOffset = levelOffsetWrite;
-        uint64_t writeOffsetBlocks = levelOffsetWrite / outputBlockByteLength;
-        ktx_size_t levelImageSizeIn, levelImageOffsetIn;
-        ktx_size_t levelImageSizeOut, levelSizeOut;
-        ktx_uint32_t levelImageCount;
-        uint32_t levelWidth = MAX(1, This->baseWidth >> level);
-        uint32_t levelHeight = MAX(1, This->baseHeight >> level);
-        // UASTC texel block dimensions
-        const uint32_t bw = 4, bh = 4;
-        uint32_t levelBlocksX = (levelWidth + (bw - 1)) / bw;
-        uint32_t levelBlocksY = (levelHeight + (bh - 1)) / bh;
-        uint32_t stateIndex = 0;
-
-        depth = MAX(1, This->baseDepth  >> level);
-
-        levelImageCount = This->numLayers * This->numFaces * depth;
-        levelImageSizeIn = ktxTexture_calcImageSize(ktxTexture(This), level,
-                                                    KTX_FORMAT_VERSION_TWO);
-        levelImageSizeOut = ktxTexture_calcImageSize(ktxTexture(prototype),
-                                                     level,
-                                                     KTX_FORMAT_VERSION_TWO);
-
-        levelImageOffsetIn = ktxTexture2_levelDataOffset(This, level);
-        levelSizeOut = 0;
-        bool status;
-        for (uint32_t image = 0; image < levelImageCount; image++) {
-            basisu_transcoder_state& xcoderState = xcoderStates[stateIndex];
-            // See comment before same lines in transcodeEtc1s.
-            if (++stateIndex == xcoderStates.size())
-                stateIndex = 0;
-
-            status = uit.transcode_image(
-                          (transcoder_texture_format)outputFormat,
-                          pXcodedData + writeOffset,
-                          (uint32_t)(xcodedDataLength - writeOffsetBlocks),
-                          This->pData,
-                          (uint32_t)This->dataSize,
-                          levelBlocksX,
-                          levelBlocksY,
-                          levelWidth,
-                          levelHeight,
-                          level,
-                          (uint32_t)levelImageOffsetIn,
-                          (uint32_t)levelImageSizeIn,
-                          transcodeFlags,
-                          alphaContent != eNone,
-                          This->isVideo, // is_video
-                          //imageDesc.imageFlags ^ cSliceDescFlagsFrameIsIFrame,
-                          0, // output_row_pitch_in_blocks_or_pixels
-                          &xcoderState, // pState
-                          0, // output_rows_in_pixels,
-                          -1, // channel0
-                          -1  // channel1
-                          );
-            if (!status)
-                return KTX_TRANSCODE_FAILED;
-            writeOffset += levelImageSizeOut;
-            levelSizeOut += levelImageSizeOut;
-            levelImageOffsetIn += levelImageSizeIn;
-        }
-        protoLevelIndex[level].byteOffset = levelOffsetWrite;
+        ktx_uint32_t protoLevel = level - firstLevel;
+        ktx_size_t levelSizeOut;
+
+        addUastcLevelImages(jobs, level,
+                            ktxTexture2_levelDataOffset(This, level),
+                            levelOffsetWrite, protoLevel, levelSizeOut);
+        protoLevelIndex[protoLevel].byteOffset = levelOffsetWrite;
         // writeOffset will be equal to total size of the images in the level.
-        protoLevelIndex[level].byteLength = levelSizeOut;
-        protoLevelIndex[level].uncompressedByteLength = levelSizeOut;
+        protoLevelIndex[protoLevel].byteLength = levelSizeOut;
+        protoLevelIndex[protoLevel].uncompressedByteLength = levelSizeOut;
         levelOffsetWrite += levelSizeOut;
     }
-    // In case of transcoding to uncompressed.
-    levelOffsetWrite = _KTX_PADN(protoPriv._requiredLevelAlignment,
-                                 levelOffsetWrite);
-    return KTX_SUCCESS;
+    return transcodeImages(jobs, params);
 }
@@ -0,0 +1,115 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file decodecontext.c
+ * @~English
+ *
+ * @brief Implementation of ktxDecodeContext, cached state for decoding
+ *        ktxTexture2 image data.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "decodecontext.h"
+
+/**
+ * @defgroup decodecontext Decode Context
+ * @brief Reusable state for loading and inflating textures.
+ * @{
+ */
+
+/**
+ * @~English
+ * @brief Create a ktxDecodeContext.
+ *
+ * A ktxDecodeContext caches the Zstandard decompression contexts and the
+ * temporary buffers used by ktxTexture2_LoadImageDataEx() and
+ * ktxTexture2_IterateLoadLevelFacesEx(). Pass it in ktxLoadParams to avoid
+ * creating and freeing them on every call when loading many textures. The
+ * buffers only grow, to the size needed by the largest texture decoded.
+ *
+ * A ktxDecodeContext must only be used by one call at a time. Keep one per
+ * thread.
+ *
+ * @param[in,out] newCtx  pointer to a location in which to write the address
+ *                        of the new context.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p newCtx is @c NULL.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the context.
+ */
+KTX_error_code
+ktxDecodeContext_Create(ktxDecodeContext** newCtx)
+{
+    ktxDecodeContext* ctx;
+
+    if (newCtx == NULL)
+        return KTX_INVALID_VALUE;
+
+    ctx = (ktxDecodeContext*)ktxMalloc(sizeof(ktxDecodeContext));
+    if (ctx == NULL)
+        return KTX_OUT_OF_MEMORY;
+    memset(ctx, 0, sizeof(*ctx));
+    *newCtx = ctx;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Destroy a ktxDecodeContext and free everything it has cached.
+ *
+ * @param[in] ctx   pointer to the context to destroy. May be @c NULL.
+ */
+void
+ktxDecodeContext_Destroy(ktxDecodeContext* ctx)
+{
+    if (ctx == NULL)
+        return;
+
+    for (ktx_uint32_t i = 0; i < KTX_DECODE_NUM_SLOTS; i++) {
+        if (ctx->dctx[i])
+            ZSTD_freeDCtx(ctx->dctx[i]);
+    }
+    for (ktx_uint32_t i = 0; i < KTX_DECODE_NUM_BUFFERS; i++)
+        ktxFree(ctx->buffers[i].pData);
+    ktxFree(ctx);
+}
+
+/** @} */
+
+ktx_uint8_t*
+ktxDecodeContext_getBuffer(ktxDecodeContext* ctx, ktxDecodeBufferId id,
+                           ktx_size_t size)
+{
+    assert(id < KTX_DECODE_NUM_BUFFERS);
+
+    if (ctx->buffers[id].size < size) {
+        // Contents need not be preserved so avoid realloc's copy.
+        ktxFree(ctx->buffers[id].pData);
+        ctx->buffers[id].pData = (ktx_uint8_t*)ktxMalloc(size);
+        ctx->buffers[id].size = ctx->buffers[id].pData ? size : 0;
+    }
+    return ctx->buffers[id].pData;
+}
+
+ZSTD_DCtx*
+ktxDecodeContext_getDCtx(ktxDecodeContext* ctx, ktx_uint32_t slot)
+{
+    assert(slot < KTX_DECODE_NUM_SLOTS);
+
+    if (ctx->dctx[slot] == NULL)
+        ctx->dctx[slot] = ktxZSTD_createDCtx();
+    return ctx->dctx[slot];
+}
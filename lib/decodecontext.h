@@ -0,0 +1,68 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file decodecontext.h
+ * @~English
+ *
+ * @brief Internal definition of ktxDecodeContext.
+ */
+
+#ifndef DECODECONTEXT_H
+#define DECODECONTEXT_H
+
+#include <zstd.h>
+#include "ktx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Scratch buffers held by a ktxDecodeContext. Slot 0 is used by the calling
+ * thread, slot 1 by the read-ahead thread of
+ * ktxTexture2_IterateLoadLevelFacesEx.
+ */
+typedef enum ktxDecodeBufferId {
+    KTX_DECODE_READ_BUFFER0,
+    KTX_DECODE_INFLATE_BUFFER0,
+    KTX_DECODE_READ_BUFFER1,
+    KTX_DECODE_INFLATE_BUFFER1,
+    KTX_DECODE_NUM_BUFFERS
+} ktxDecodeBufferId;
+
+#define KTX_DECODE_NUM_SLOTS 2
+
+struct ktxDecodeContext {
+    ZSTD_DCtx* dctx[KTX_DECODE_NUM_SLOTS];
+    struct {
+        ktx_uint8_t* pData;
+        ktx_size_t size;
+    } buffers[KTX_DECODE_NUM_BUFFERS];
+};
+
+/*
+ * Return scratch buffer @p id grown to at least @p size bytes. The contents
+ * are not preserved when it grows. NULL if out of memory.
+ */
+ktx_uint8_t* ktxDecodeContext_getBuffer(ktxDecodeContext* ctx,
+                                        ktxDecodeBufferId id,
+                                        ktx_size_t size);
+
+/*
+ * Return the Zstandard decompression context for @p slot, creating it on
+ * first use. NULL if out of memory.
+ */
+ZSTD_DCtx* ktxDecodeContext_getDCtx(ktxDecodeContext* ctx, ktx_uint32_t slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DECODECONTEXT_H */
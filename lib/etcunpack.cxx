@@ -198,7 +198,7 @@ _ktxUnpackETC(const GLubyte* srcETC, const GLenum srcFormat,
 	/* printf("Width = %d, Height = %d\n", width, height); */
 	/* printf("active pixel area: top left %d x %d area.\n", activeWidth, activeHeight); */
 
-	*dstImage = (GLubyte*)malloc(dstChannels*dstChannelBytes*width*height);
+	*dstImage = (GLubyte*)ktxMalloc(dstChannels*dstChannelBytes*width*height);
 	if (!*dstImage) {
 		return KTX_OUT_OF_MEMORY;
 	}
@@ -248,12 +248,12 @@ _ktxUnpackETC(const GLubyte* srcETC, const GLenum srcFormat,
 		int dstPixelBytes = dstChannels * dstChannelBytes;
 		int dstRowBytes = dstPixelBytes * width;
 		int activeRowBytes = activeWidth * dstPixelBytes;
-		GLubyte *newimg = (GLubyte*)malloc(dstPixelBytes * activeWidth * activeHeight);
+		GLubyte *newimg = (GLubyte*)ktxMalloc(dstPixelBytes * activeWidth * activeHeight);
 		unsigned int xx, yy;
 		int zz;
 
 		if (!newimg) {
-			free(*dstImage);
+			ktxFree(*dstImage);
 			return KTX_OUT_OF_MEMORY;
 		}
 		
@@ -267,7 +267,7 @@ _ktxUnpackETC(const GLubyte* srcETC, const GLenum srcFormat,
 			}
 		}
 
-		free(*dstImage);
+		ktxFree(*dstImage);
 		*dstImage = newimg;
 	}
 
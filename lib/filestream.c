@@ -31,9 +31,19 @@
 #define __USE_MISC 1       // For declaration of S_IF...
 #include <sys/stat.h>
 
+#if defined(_WIN32)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+  #include <io.h>          // For _get_osfhandle.
+#elif defined(__unix__) || defined(__APPLE__)
+  #include <sys/mman.h>
+  #define KTX_HAVE_MMAP 1
+#endif
+
 #include "ktx.h"
 #include "ktxint.h"
 #include "filestream.h"
+#include "unused.h"
 
 // Gotta love Windows :-(
 #if defined(_MSC_VER)
@@ -393,3 +403,334 @@ ktxFileStream_destruct(ktxStream* str)
         fclose(str->data.file);
     str->data.file = 0;
 }
+
+/*
+ * ktxMappedFileStream
+ *
+ * A read-only stream over a memory mapping of an entire file. Reading
+ * copies from the mapping but callers that know the stream type can use
+ * ktxMappedFileStream_getview() to access the bytes in place. The mapping
+ * is private and writable so that any modification of a view, e.g.
+ * endianness conversion, is copy-on-write and never reaches the file.
+ */
+
+#if defined(_WIN32) || KTX_HAVE_MMAP
+
+/**
+ * @~English
+ * @brief Read bytes from a ktxMappedFileStream.
+ *
+ * @param [in]  str     pointer to the ktxStream from which to read.
+ * @param [out] dst     pointer to a block of memory with a size
+ *                      of at least @p count bytes, converted to a void*.
+ * @param [in]  count   total count of bytes to be read.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str or @p dst is @c NULL.
+ * @exception KTX_FILE_UNEXPECTED_EOF not enough data to satisfy the request.
+ */
+static
+KTX_error_code ktxMappedFileStream_read(ktxStream* str, void* dst,
+                                        const ktx_size_t count)
+{
+    if (!str || !dst)
+        return KTX_INVALID_VALUE;
+
+    assert(str->type == eStreamTypeMappedFile);
+
+    if (count > str->data.map.size - (ktx_size_t)str->readpos)
+        return KTX_FILE_UNEXPECTED_EOF;
+
+    memcpy(dst, str->data.map.base + str->readpos, count);
+    str->readpos += count;
+
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Skip bytes in a ktxMappedFileStream.
+ *
+ * @param [in] str           pointer to a ktxStream object.
+ * @param [in] count         number of bytes to be skipped.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str is @c NULL.
+ * @exception KTX_FILE_UNEXPECTED_EOF not enough data to satisfy the request.
+ */
+static
+KTX_error_code ktxMappedFileStream_skip(ktxStream* str, const ktx_size_t count)
+{
+    if (!str)
+        return KTX_INVALID_VALUE;
+
+    assert(str->type == eStreamTypeMappedFile);
+
+    if (count > str->data.map.size - (ktx_size_t)str->readpos)
+        return KTX_FILE_UNEXPECTED_EOF;
+
+    str->readpos += count;
+
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Write to a ktxMappedFileStream.
+ *
+ * Mapped file streams are read-only.
+ *
+ * @return      KTX_INVALID_OPERATION.
+ */
+static
+KTX_error_code ktxMappedFileStream_write(ktxStream* str, const void *src,
+                                         const ktx_size_t size,
+                                         const ktx_size_t count)
+{
+    UNUSED(str);
+    UNUSED(src);
+    UNUSED(size);
+    UNUSED(count);
+
+    return KTX_INVALID_OPERATION;
+}
+
+/**
+ * @~English
+ * @brief Get the current read position in a ktxMappedFileStream.
+ *
+ * @param [in] str      pointer to the ktxStream to query.
+ * @param [in,out] pos  pointer to variable to receive the offset value.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str or @p pos is @c NULL.
+ */
+static
+KTX_error_code ktxMappedFileStream_getpos(ktxStream* str, ktx_off_t* pos)
+{
+    if (!str || !pos)
+        return KTX_INVALID_VALUE;
+
+    assert(str->type == eStreamTypeMappedFile);
+
+    *pos = str->readpos;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Set the current read position in a ktxMappedFileStream.
+ *
+ * Offset of 0 is the start of the file.
+ *
+ * @param [in] str    pointer to the ktxStream whose read position is to be set.
+ * @param [in] pos    the offset value to set.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str is @c NULL.
+ * @exception KTX_INVALID_OPERATION @p pos is > the size of the file.
+ */
+static
+KTX_error_code ktxMappedFileStream_setpos(ktxStream* str, ktx_off_t pos)
+{
+    if (!str)
+        return KTX_INVALID_VALUE;
+
+    assert(str->type == eStreamTypeMappedFile);
+
+    if (pos > (ktx_off_t)str->data.map.size)
+        return KTX_INVALID_OPERATION;
+
+    str->readpos = pos;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Get the size of a ktxMappedFileStream in bytes.
+ *
+ * @param [in] str       pointer to the ktxStream whose size is to be queried.
+ * @param [in,out] size  pointer to a variable in which size will be written.
+ *
+ * @return    KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str or @p size is @c NULL.
+ */
+static
+KTX_error_code ktxMappedFileStream_getsize(ktxStream* str, ktx_size_t* size)
+{
+    if (!str || !size)
+        return KTX_INVALID_VALUE;
+
+    assert(str->type == eStreamTypeMappedFile);
+
+    *size = str->data.map.size;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @~English
+ * @brief Destruct a ktxMappedFileStream, unmapping the file.
+ *
+ * @param [in] str pointer to the ktxStream to destruct.
+ */
+static void
+ktxMappedFileStream_destruct(ktxStream* str)
+{
+    assert(str && str->type == eStreamTypeMappedFile);
+
+#if defined(_WIN32)
+    UnmapViewOfFile(str->data.map.base);
+#else
+    munmap(str->data.map.base, str->data.map.size);
+#endif
+    str->data.map.base = NULL;
+    str->data.map.size = 0;
+}
+
+/**
+ * @~English
+ * @brief Map the whole of a file into memory.
+ *
+ * @param [in] file     pointer to the FILE object to map.
+ * @param [in] size     size of the file.
+ *
+ * @return  pointer to the start of the mapping or @c NULL on failure.
+ */
+static ktx_uint8_t*
+mapFile(FILE* file, ktx_size_t size)
+{
+#if defined(_WIN32)
+    HANDLE hFile = (HANDLE)_get_osfhandle(fileno(file));
+    HANDLE hMapping;
+    void* base;
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return NULL;
+    hMapping = CreateFileMapping(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (hMapping == NULL)
+        return NULL;
+    base = MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, size);
+    // The view keeps a reference to the mapping object.
+    CloseHandle(hMapping);
+    return (ktx_uint8_t*)base;
+#else
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                      fileno(file), 0);
+    return base == MAP_FAILED ? NULL : (ktx_uint8_t*)base;
+#endif
+}
+
+#endif /* _WIN32 || KTX_HAVE_MMAP */
+
+/**
+ * @~English
+ * @brief Initialize a ktxMappedFileStream.
+ *
+ * Maps the whole of @p file into memory. The read position is set to the
+ * current position of @p file. The mapping remains valid until the stream is
+ * destructed, regardless of whether @p file is closed.
+ *
+ * If the file cannot be mapped, e.g. because it is a pipe, is empty or the
+ * platform does not support file mapping, the stream is initialized as a
+ * regular ktxFileStream instead. Callers can distinguish the two by the
+ * stream's @c type.
+ *
+ * @param [in] str      pointer to the ktxStream to initialize.
+ * @param [in] file     pointer to the underlying FILE object.
+ * @param [in] closeFileOnDestruct if not false, stdio file pointer will be
+ *             closed when ktxStream is destructed. When the file has been
+ *             successfully mapped, it is closed immediately as it is no longer
+ *             needed.
+ *
+ * @return      KTX_SUCCESS on success, KTX_INVALID_VALUE on error.
+ *
+ * @exception KTX_INVALID_VALUE @p stream is @c NULL or @p file is @c NULL.
+ */
+KTX_error_code ktxMappedFileStream_construct(ktxStream* str, FILE* file,
+                                             ktx_bool_t closeFileOnDestruct)
+{
+#if defined(_WIN32) || KTX_HAVE_MMAP
+    ktx_size_t size;
+    ktx_off_t pos;
+    ktx_uint8_t* base;
+    KTX_error_code result;
+
+    if (!str || !file)
+        return KTX_INVALID_VALUE;
+
+    // Use a regular stream to find the size. This also rejects pipes, ttys
+    // and the like.
+    result = ktxFileStream_construct(str, file, closeFileOnDestruct);
+    if (result != KTX_SUCCESS)
+        return result;
+    if (file == stdin
+        || str->getsize(str, &size) != KTX_SUCCESS || size == 0
+        || str->getpos(str, &pos) != KTX_SUCCESS || pos > (ktx_off_t)size)
+        return KTX_SUCCESS;
+
+    base = mapFile(file, size);
+    if (base == NULL)
+        return KTX_SUCCESS;
+
+    if (closeFileOnDestruct)
+        fclose(file);
+
+    str->data.map.base = base;
+    str->data.map.size = size;
+    str->readpos = pos;
+    str->type = eStreamTypeMappedFile;
+    str->read = ktxMappedFileStream_read;
+    str->skip = ktxMappedFileStream_skip;
+    str->write = ktxMappedFileStream_write;
+    str->getpos = ktxMappedFileStream_getpos;
+    str->setpos = ktxMappedFileStream_setpos;
+    str->getsize = ktxMappedFileStream_getsize;
+    str->destruct = ktxMappedFileStream_destruct;
+    str->closeOnDestruct = KTX_TRUE;
+
+    return KTX_SUCCESS;
+#else
+    return ktxFileStream_construct(str, file, closeFileOnDestruct);
+#endif
+}
+
+/**
+ * @~English
+ * @brief Get a pointer to data in a ktxMappedFileStream without copying.
+ *
+ * @param [in] str     pointer to the ktxStream of interest.
+ * @param [in] offset  offset from the start of the file of the first byte.
+ * @param [in] count   number of bytes that will be accessed.
+ * @param [out] ppBytes pointer to a location in which to write a pointer to
+ *                     the data at @p offset. It remains valid until the
+ *                     stream is destructed.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str or @p ppBytes is @c NULL.
+ * @exception KTX_INVALID_OPERATION @p str is not a mapped file stream.
+ * @exception KTX_FILE_UNEXPECTED_EOF the range extends beyond the end of the
+ *                                    file.
+ */
+KTX_error_code ktxMappedFileStream_getview(ktxStream* str, ktx_off_t offset,
+                                           ktx_size_t count,
+                                           ktx_uint8_t** ppBytes)
+{
+    if (!str || !ppBytes)
+        return KTX_INVALID_VALUE;
+
+    if (str->type != eStreamTypeMappedFile)
+        return KTX_INVALID_OPERATION;
+
+    if (offset > (ktx_off_t)str->data.map.size
+        || count > str->data.map.size - (ktx_size_t)offset)
+        return KTX_FILE_UNEXPECTED_EOF;
+
+    *ppBytes = str->data.map.base + offset;
+    return KTX_SUCCESS;
+}
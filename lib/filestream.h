@@ -16,6 +16,10 @@
 
 #include "ktx.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /*
  * ktxFileInit: Initialize a ktxStream to a ktxFileStream with a FILE object
  */
@@ -24,4 +28,20 @@ KTX_error_code ktxFileStream_construct(ktxStream* str, FILE* file,
 
 void ktxFileStream_destruct(ktxStream* str);
 
+/*
+ * ktxMappedFileStream_construct: Initialize a ktxStream to a read-only
+ * ktxMappedFileStream over a memory mapping of a FILE. Falls back to a
+ * ktxFileStream if the file cannot be mapped.
+ */
+KTX_error_code ktxMappedFileStream_construct(ktxStream* str, FILE* file,
+                                             ktx_bool_t closeFileOnDestruct);
+
+KTX_error_code ktxMappedFileStream_getview(ktxStream* str, ktx_off_t offset,
+                                           ktx_size_t count,
+                                           ktx_uint8_t** ppBytes);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* FILESTREAM_H */
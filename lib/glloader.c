@@ -566,7 +566,7 @@ compressedTexImage2DCallback(int miplevel, int face,
                      cbData->numLayers == 0 ? (GLuint)height : cbData->numLayers, 0,
                      format, type, unpacked);
 
-        free(unpacked);
+        ktxFree(unpacked);
         glerror = glGetError();
     }
 #endif
@@ -822,7 +822,8 @@ ktxTexture_GLUploadPrivate(ktxTexture* This, ktx_glformatinfo* formatInfo,
     }
 
     if (ktxTexture_isActiveStream(ktxTexture(This)))
-        result = ktxTexture_IterateLoadLevelFaces(This, iterCb, &cbData);
+        result = ktxTexture_iterateLoadLevelFacesReadAhead(ktxTexture(This),
+                                                           iterCb, &cbData);
     else
         result = ktxTexture_IterateLevelFaces(This, iterCb, &cbData);
 
@@ -46,6 +46,9 @@ typedef struct ktxKVListEntry {
     char* key;              /*!< Pointer to key string */
     unsigned int valueLen;  /*!< Length of the value */
     void* value;            /*!< Pointer to the value */
+    ktx_bool_t borrowed;    /*!< Entry, key and value are in a block
+                                 from ktxHashList_DeserializeView() so are
+                                 not freed with the entry. */
     UT_hash_handle hh;      /*!< handle used by UT hash */
 } ktxKVListEntry;
 
@@ -103,7 +106,8 @@ ktxHashList_Destruct(ktxHashList* pHead)
     for(kv = head; kv != NULL;) {
         ktxKVListEntry* tmp = (ktxKVListEntry*)kv->hh.next;
         HASH_DELETE(hh, head, kv);
-        free(kv);
+        if (!kv->borrowed)
+            ktxFree(kv);
         kv = tmp;
     }
 }
@@ -123,7 +127,7 @@ ktxHashList_Destruct(ktxHashList* pHead)
 KTX_error_code
 ktxHashList_Create(ktxHashList** ppHl)
 {
-    ktxHashList* hl = (ktxHashList*)malloc(sizeof (ktxKVListEntry*));
+    ktxHashList* hl = (ktxHashList*)ktxMalloc(sizeof (ktxKVListEntry*));
     if (hl == NULL)
         return KTX_OUT_OF_MEMORY;
 
@@ -148,7 +152,7 @@ ktxHashList_Create(ktxHashList** ppHl)
 KTX_error_code
 ktxHashList_CreateCopy(ktxHashList** ppHl, ktxHashList orig)
 {
-    ktxHashList* hl = (ktxHashList*)malloc(sizeof (ktxKVListEntry*));
+    ktxHashList* hl = (ktxHashList*)ktxMalloc(sizeof (ktxKVListEntry*));
     if (hl == NULL)
         return KTX_OUT_OF_MEMORY;
 
@@ -172,7 +176,7 @@ void
 ktxHashList_Destroy(ktxHashList* pHead)
 {
     ktxHashList_Destruct(pHead);
-    free(pHead);
+    ktxFree(pHead);
 }
 
 #if !__clang__ && __GNUC__ // Grumble clang grumble
@@ -208,7 +212,8 @@ ktxHashList_AddKVPair(ktxHashList* pHead, const char* key, unsigned int valueLen
             return KTX_INVALID_VALUE;   /* Empty string */
 
         /* Allocate all the memory as a block */
-        kv = (ktxKVListEntry*)malloc(sizeof(ktxKVListEntry) + keyLen + valueLen);
+        kv = (ktxKVListEntry*)ktxMalloc(sizeof(ktxKVListEntry) + keyLen + valueLen);
+        kv->borrowed = KTX_FALSE;
         /* Put key first */
         kv->key = (char *)kv + sizeof(ktxKVListEntry);
         kv->keyLen = keyLen;
@@ -433,7 +438,7 @@ ktxHashList_Serialize(ktxHashList* pHead,
             *pKvdLen = 0;
             *ppKvd = NULL;
         } else {
-            sd = malloc(bytesOfKeyValueData);
+            sd = ktxMalloc(bytesOfKeyValueData);
             if (!sd)
                 return KTX_OUT_OF_MEMORY;
 
@@ -481,9 +486,15 @@ KTX_error_code
 ktxHashList_Sort(ktxHashList* pHead)
 {
     if (pHead) {
-        //ktxKVListEntry* kv = (ktxKVListEntry*)pHead;
+        ktxKVListEntry* kv;
 
-        HASH_SORT(*pHead, sort_by_key_codepoint);
+        // Lists deserialized from a KTX 2 file are already in order.
+        for (kv = *pHead; kv != NULL && kv->hh.next != NULL; kv = kv->hh.next) {
+            if (sort_by_key_codepoint(kv, kv->hh.next) > 0)
+                break;
+        }
+        if (kv != NULL && kv->hh.next != NULL)
+            HASH_SORT(*pHead, sort_by_key_codepoint);
         return KTX_SUCCESS;
     } else {
         return KTX_INVALID_VALUE;
@@ -491,6 +502,57 @@ ktxHashList_Sort(ktxHashList* pHead)
 }
 
 
+/*
+ * Parse the key-value pair at @p *pSrc, which must be before @p end, and
+ * advance @p *pSrc to the next one. @p *pValue is NULL for an empty value.
+ */
+static KTX_error_code
+kvdNextPair(char** pSrc, char* end, char** pKey, unsigned int* pKeyLen,
+            void** pValue, unsigned int* pValueLen)
+{
+    char* src = *pSrc;
+    char* key;
+    unsigned int keyLen;
+    ktx_uint32_t keyAndValueByteSize;
+
+    if (src + 6 > end) {
+        // Not enough space for another entry
+        return KTX_FILE_DATA_ERROR;
+    }
+
+    keyAndValueByteSize = *((ktx_uint32_t*)src);
+
+    if (src + 4 + keyAndValueByteSize > end) {
+        // Not enough space for this entry
+        return KTX_FILE_DATA_ERROR;
+    }
+
+    src += sizeof(keyAndValueByteSize);
+    key = src;
+    keyLen = 0;
+
+    while (keyLen < keyAndValueByteSize && key[keyLen] != '\0') keyLen++;
+
+    if (key[keyLen] != '\0') {
+        // Missing NULL terminator
+        return KTX_FILE_DATA_ERROR;
+    }
+
+    if (keyLen >= 3 && key[0] == '\xEF' && key[1] == '\xBB' && key[2] == '\xBF') {
+        // Forbidden BOM
+        return KTX_FILE_DATA_ERROR;
+    }
+
+    keyLen += 1;
+    *pKey = key;
+    *pKeyLen = keyLen;
+    *pValueLen = keyAndValueByteSize - keyLen;
+    *pValue = *pValueLen > 0 ? key + keyLen : NULL;
+    *pSrc = src + _KTX_PAD4(keyAndValueByteSize);
+    return KTX_SUCCESS;
+}
+
+
 /**
  * @memberof ktxHashList @public
  * @~English
@@ -525,50 +587,115 @@ ktxHashList_Deserialize(ktxHashList* pHead, unsigned int kvdLen, void* pKvd)
 
     result = KTX_SUCCESS;
     while (result == KTX_SUCCESS && src < (char *)pKvd + kvdLen) {
-        if (src + 6 > (char *)pKvd + kvdLen) {
-            // Not enough space for another entry
-            return KTX_FILE_DATA_ERROR;
-        }
-
         char* key;
         unsigned int keyLen, valueLen;
         void* value;
-        ktx_uint32_t keyAndValueByteSize = *((ktx_uint32_t*)src);
 
-        if (src + 4 + keyAndValueByteSize > (char *)pKvd + kvdLen) {
-            // Not enough space for this entry
-            return KTX_FILE_DATA_ERROR;
-        }
+        result = kvdNextPair(&src, (char *)pKvd + kvdLen,
+                             &key, &keyLen, &value, &valueLen);
+        if (result == KTX_SUCCESS)
+            result = ktxHashList_AddKVPair(pHead, key, valueLen, value);
+    }
+    return result;
+}
 
-        src += sizeof(keyAndValueByteSize);
-        key = src;
-        keyLen = 0;
 
-        while (keyLen < keyAndValueByteSize && key[keyLen] != '\0') keyLen++;
+#if !__clang__ && __GNUC__ // Grumble clang grumble
+// These are in uthash.h macros. I don't want to change that file.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wimplicit-fallthrough"
+#endif
 
-        if (key[keyLen] != '\0') {
-            // Missing NULL terminator
-            return KTX_FILE_DATA_ERROR;
-        }
+/**
+ * @memberof ktxHashList @private
+ * @~English
+ * @brief Construct a hash list whose entries reference a block of
+ *        serialized key-value data instead of copying it.
+ *
+ * The block at @p *ppKvd, which must have been allocated with ktxMalloc(),
+ * is enlarged with ktxRealloc() to also hold the list entries so loading
+ * makes one allocation rather than one per key-value pair. The key and
+ * value pointers returned for these entries point into the block. Pairs
+ * added later are copied as usual. Entries deleted from the list stay
+ * valid until the block is freed.
+ *
+ * The caller continues to own the block. It must destruct the list before
+ * freeing it with ktxFree().
+ *
+ * @note The bytes of the 32-bit key-value lengths within the serialized data
+ *       are expected to be in native endianness.
+ *
+ * @param [in]      pHead       pointer to the head of the target hash list.
+ * @param [in]      kvdLen      the length of the serialized key-value data.
+ * @param [in,out]  ppKvd       pointer to the location of the serialized
+ *                              key-value data. Updated if the block moves.
+ *
+ * @return KTX_SUCCESS or one of the following error codes.
+ *
+ * @exception KTX_INVALID_OPERATION if @p pHead does not point to an empty list.
+ * @exception KTX_INVALID_VALUE if @p pHead, @p ppKvd or @p *ppKvd is NULL or
+ *                              kvdLen == 0.
+ * @exception KTX_FILE_DATA_ERROR the serialized data is malformed.
+ * @exception KTX_OUT_OF_MEMORY there was not enough memory to enlarge the
+ *                              block. @p *ppKvd is unchanged.
+ */
+KTX_error_code
+ktxHashList_DeserializeView(ktxHashList* pHead, unsigned int kvdLen,
+                            void** ppKvd)
+{
+    char* src;
+    char* end;
+    ktx_size_t entriesOffset;
+    ktx_uint32_t numEntries = 0;
+    ktxKVListEntry* entries;
+    ktx_uint8_t* block;
+    KTX_error_code result;
 
-        if (keyLen >= 3 && key[0] == '\xEF' && key[1] == '\xBB' && key[2] == '\xBF') {
-            // Forbidden BOM
-            return KTX_FILE_DATA_ERROR;
-        }
+    if (kvdLen == 0 || ppKvd == NULL || *ppKvd == NULL || pHead == NULL)
+        return KTX_INVALID_VALUE;
 
-        keyLen += 1;
-        value = key + keyLen;
+    if (*pHead != NULL)
+        return KTX_INVALID_OPERATION;
 
-        valueLen = keyAndValueByteSize - keyLen;
-        result = ktxHashList_AddKVPair(pHead, key, valueLen,
-                                       valueLen > 0 ? value : NULL);
-        if (result == KTX_SUCCESS) {
-            src += _KTX_PAD4(keyAndValueByteSize);
-        }
+    // Validate and count the pairs before anything is allocated.
+    src = *ppKvd;
+    end = src + kvdLen;
+    while (src < end) {
+        char* key;
+        unsigned int keyLen, valueLen;
+        void* value;
+
+        result = kvdNextPair(&src, end, &key, &keyLen, &value, &valueLen);
+        if (result != KTX_SUCCESS)
+            return result;
+        numEntries++;
     }
-    return result;
+
+    entriesOffset = ((ktx_size_t)kvdLen + 7) & ~(ktx_size_t)7;
+    block = ktxRealloc(*ppKvd,
+                       entriesOffset + numEntries * sizeof(ktxKVListEntry));
+    if (block == NULL)
+        return KTX_OUT_OF_MEMORY;
+    *ppKvd = block;
+    entries = (ktxKVListEntry*)(block + entriesOffset);
+
+    src = (char*)block;
+    end = src + kvdLen;
+    for (ktx_uint32_t i = 0; i < numEntries; i++) {
+        ktxKVListEntry* kv = &entries[i];
+
+        (void)kvdNextPair(&src, end, &kv->key, &kv->keyLen,
+                          &kv->value, &kv->valueLen);
+        kv->borrowed = KTX_TRUE;
+        HASH_ADD_KEYPTR( hh, *pHead, kv->key, kv->keyLen-1, kv);
+    }
+    return KTX_SUCCESS;
 }
 
+#if !__clang__ && __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
 
 /**
  * @memberof ktxHashListEntry @public
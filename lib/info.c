@@ -476,10 +476,10 @@ printKTXInfo2(ktxStream* stream, KTX_header* pHeader)
 
     if (pHeader->bytesOfKeyValueData) {
         fprintf(stdout, "\nKey/Value Data\n\n");
-        metadata = malloc(pHeader->bytesOfKeyValueData);
+        metadata = ktxMalloc(pHeader->bytesOfKeyValueData);
         stream->read(stream, metadata, pHeader->bytesOfKeyValueData);
         printKVData(metadata, pHeader->bytesOfKeyValueData);
-        free(metadata);
+        ktxFree(metadata);
     } else {
         fprintf(stdout, "\nNo Key/Value data.\n");
     }
@@ -681,64 +681,64 @@ printKTX2Info2(ktxStream* stream, KTX_header2* pHeader)
     fprintf(stdout, "\nLevel Index\n\n");
     numLevels = MAX(1, pHeader->levelCount);
     levelIndexSize = sizeof(ktxLevelIndexEntry) * numLevels;
-    levelIndex = (ktxLevelIndexEntry*)malloc(levelIndexSize);
+    levelIndex = (ktxLevelIndexEntry*)ktxMalloc(levelIndexSize);
     if (levelIndex == NULL)
         return KTX_OUT_OF_MEMORY;
     ec = stream->read(stream, levelIndex, levelIndexSize);
     if (ec != KTX_SUCCESS) {
-        free(levelIndex);
+        ktxFree(levelIndex);
         return ec;
     }
     printLevelIndex(levelIndex, numLevels);
-    free(levelIndex);
+    ktxFree(levelIndex);
 
     if (hasDFD) {
         fprintf(stdout, "\nData Format Descriptor\n\n");
-        ktx_uint32_t* dfd = (ktx_uint32_t*)malloc(pHeader->dataFormatDescriptor.byteLength);
+        ktx_uint32_t* dfd = (ktx_uint32_t*)ktxMalloc(pHeader->dataFormatDescriptor.byteLength);
         if (dfd == NULL)
             return KTX_OUT_OF_MEMORY;
         ec = stream->read(stream, dfd, pHeader->dataFormatDescriptor.byteLength);
         if (ec != KTX_SUCCESS) {
-            free(dfd);
+            ktxFree(dfd);
             return ec;
         }
         if (*dfd != pHeader->dataFormatDescriptor.byteLength) {
-            free(dfd);
+            ktxFree(dfd);
             return KTX_FILE_DATA_ERROR;
         }
         printDFD(dfd, pHeader->dataFormatDescriptor.byteLength);
-        free(dfd);
+        ktxFree(dfd);
     }
 
     if (hasKVD) {
         fprintf(stdout, "\nKey/Value Data\n\n");
-        ktx_uint8_t* kvd = malloc(pHeader->keyValueData.byteLength);
+        ktx_uint8_t* kvd = ktxMalloc(pHeader->keyValueData.byteLength);
         if (kvd == NULL)
             return KTX_OUT_OF_MEMORY;
         ec = stream->read(stream, kvd, pHeader->keyValueData.byteLength);
         if (ec != KTX_SUCCESS) {
-            free(kvd);
+            ktxFree(kvd);
             return ec;
         }
         printKVData(kvd, pHeader->keyValueData.byteLength);
-        free(kvd);
+        ktxFree(kvd);
     } else {
         fprintf(stdout, "\nNo Key/Value data.\n");
     }
 
     if (hasSGD) {
         if (pHeader->supercompressionScheme == KTX_SS_BASIS_LZ) {
-            ktx_uint8_t* sgd = malloc(pHeader->supercompressionGlobalData.byteLength);
+            ktx_uint8_t* sgd = ktxMalloc(pHeader->supercompressionGlobalData.byteLength);
             if (sgd == NULL)
                 return KTX_OUT_OF_MEMORY;
             ec = stream->setpos(stream, pHeader->supercompressionGlobalData.byteOffset);
             if (ec != KTX_SUCCESS) {
-                free(sgd);
+                ktxFree(sgd);
                 return ec;
             }
             ec = stream->read(stream, sgd, pHeader->supercompressionGlobalData.byteLength);
             if (ec != KTX_SUCCESS) {
-                free(sgd);
+                ktxFree(sgd);
                 return ec;
             }
             //
@@ -753,7 +753,7 @@ printKTX2Info2(ktxStream* stream, KTX_header2* pHeader)
             uint32_t numImages = layersFaces * layerPixelDepth;
             fprintf(stdout, "\nBasis Supercompression Global Data\n\n");
             printBasisSGDInfo(sgd, pHeader->supercompressionGlobalData.byteLength, numImages);
-            free(sgd);
+            ktxFree(sgd);
         } else {
             fprintf(stdout, "\nUnrecognized supercompressionScheme.\n");
         }
@@ -826,13 +826,13 @@ printKTX2Info2JSON(ktxStream* stream, KTX_header2* pHeader, ktx_uint32_t base_in
 
     numLevels = MAX(1, pHeader->levelCount);
     levelIndexSize = sizeof(ktxLevelIndexEntry) * numLevels;
-    levelIndex = (ktxLevelIndexEntry*)malloc(levelIndexSize);
+    levelIndex = (ktxLevelIndexEntry*)ktxMalloc(levelIndexSize);
     if (levelIndex == NULL)
         return KTX_OUT_OF_MEMORY;
     ec = stream->read(stream, levelIndex, levelIndexSize);
     if (ec != KTX_SUCCESS) {
         printf("%s", nl);
-        free(levelIndex);
+        ktxFree(levelIndex);
         return ec;
     }
 
@@ -863,40 +863,40 @@ printKTX2Info2JSON(ktxStream* stream, KTX_header2* pHeader, ktx_uint32_t base_in
     }
     PRINT_INDENT(1, "]%s", nl) // End of levels
 
-    free(levelIndex);
+    ktxFree(levelIndex);
     PRINT_INDENT_NOARG(0, "}") // End of index
 
     if (hasDFD) {
-        ktx_uint32_t* dfd = (ktx_uint32_t*)malloc(pHeader->dataFormatDescriptor.byteLength);
+        ktx_uint32_t* dfd = (ktx_uint32_t*)ktxMalloc(pHeader->dataFormatDescriptor.byteLength);
         if (dfd == NULL)
             return KTX_OUT_OF_MEMORY;
         ec = stream->read(stream, dfd, pHeader->dataFormatDescriptor.byteLength);
         if (ec != KTX_SUCCESS) {
             printf("%s", nl);
-            free(dfd);
+            ktxFree(dfd);
             return ec;
         }
         printf(",%s", nl);
         PRINT_INDENT(0, "\"dataFormatDescriptor\":%s{%s", space, nl)
         printDFDJSON(dfd, pHeader->dataFormatDescriptor.byteLength, base_indent + 1, indent_width, minified);
-        free(dfd);
+        ktxFree(dfd);
         PRINT_INDENT_NOARG(0, "}")
     }
 
     if (hasKVD) {
-        ktx_uint8_t* kvd = malloc(pHeader->keyValueData.byteLength);
+        ktx_uint8_t* kvd = ktxMalloc(pHeader->keyValueData.byteLength);
         if (kvd == NULL)
             return KTX_OUT_OF_MEMORY;
         ec = stream->read(stream, kvd, pHeader->keyValueData.byteLength);
         if (ec != KTX_SUCCESS) {
             printf("%s", nl);
-            free(kvd);
+            ktxFree(kvd);
             return ec;
         }
         printf(",%s", nl);
         PRINT_INDENT(0, "\"keyValueData\":%s{%s", space, nl)
         printKVDataJSON(kvd, pHeader->keyValueData.byteLength, base_indent + 1, indent_width, minified);
-        free(kvd);
+        ktxFree(kvd);
         PRINT_INDENT_NOARG(0, "}")
     }
 
@@ -912,21 +912,21 @@ printKTX2Info2JSON(ktxStream* stream, KTX_header2* pHeader, ktx_uint32_t base_in
         case KTX_SS_BASIS_LZ: {
             PRINT_INDENT(1, "\"type\":%s\"%s\"", space, "KTX_SS_BASIS_LZ")
             ktx_size_t sgdByteLength = pHeader->supercompressionGlobalData.byteLength;
-            ktx_uint8_t* sgd = malloc(sgdByteLength);
+            ktx_uint8_t* sgd = ktxMalloc(sgdByteLength);
             if (sgd == NULL)
                 return KTX_OUT_OF_MEMORY;
             ec = stream->setpos(stream, pHeader->supercompressionGlobalData.byteOffset);
             if (ec != KTX_SUCCESS) {
                 printf("%s", nl);
                 PRINT_INDENT(0, "}%s", nl)
-                free(sgd);
+                ktxFree(sgd);
                 return ec;
             }
             ec = stream->read(stream, sgd, sgdByteLength);
             if (ec != KTX_SUCCESS) {
                 printf("%s", nl);
                 PRINT_INDENT(0, "}%s", nl)
-                free(sgd);
+                ktxFree(sgd);
                 return ec;
             }
 
@@ -943,7 +943,7 @@ printKTX2Info2JSON(ktxStream* stream, KTX_header2* pHeader, ktx_uint32_t base_in
             if (sgdByteLength < sizeof(ktxBasisLzGlobalHeader)) {
                 printf("%s", nl);
                 PRINT_INDENT(0, "}%s", nl)
-                free(sgd);
+                ktxFree(sgd);
                 return ec;
             }
             printf(",%s", nl);
@@ -985,7 +985,7 @@ printKTX2Info2JSON(ktxStream* stream, KTX_header2* pHeader, ktx_uint32_t base_in
             printf("%s", nl);
             PRINT_INDENT(1, "]%s", nl)
 
-            free(sgd);
+            ktxFree(sgd);
             break;
         }
         case KTX_SS_ZSTD: {
@@ -245,6 +245,54 @@ KTX_error_code ktxUncompressZLIBInt(unsigned char* pDest,
                                     const unsigned char* pSrc,
                                     ktx_size_t srcLength);
 
+/*
+ * @internal
+ * ktxZLIBInflater
+ *
+ * Uncompresses data supplied in chunks using miniz (ZLIB)
+ */
+typedef struct ktxZLIBInflater ktxZLIBInflater;
+
+KTX_error_code ktxZLIBInflater_create(unsigned char* pDest,
+                                      ktx_size_t destLength,
+                                      ktxZLIBInflater** ppInflater);
+KTX_error_code ktxZLIBInflater_inflate(ktxZLIBInflater* inflater,
+                                       const unsigned char* pSrc,
+                                       ktx_size_t srcLength);
+KTX_error_code ktxZLIBInflater_destroy(ktxZLIBInflater* inflater,
+                                       ktx_size_t* pInflatedLength);
+
+/*
+ * @internal
+ * ktxHashList_DeserializeView
+ *
+ * Build a hash list whose entries reference a ktxMalloc'ed block of
+ * serialized key-value data. The block is enlarged to hold the entries.
+ */
+KTX_error_code ktxHashList_DeserializeView(ktxHashList* pHead,
+                                           unsigned int kvdLen, void** ppKvd);
+
+/*
+ * @internal
+ * ktxMalloc, ktxRealloc, ktxFree
+ *
+ * Allocate and free memory using the allocator set by ktxSetAllocator.
+ * All memory libktx allocates or frees must go through these.
+ */
+void* ktxMalloc(size_t size);
+void* ktxRealloc(void* ptr, size_t size);
+void ktxFree(void* ptr);
+
+/*
+ * @internal
+ * ktxZSTD_createDCtx, ktxZSTD_createCCtx
+ *
+ * Create Zstandard contexts that allocate using ktxMalloc and ktxFree.
+ * Free them with the usual ZSTD_free* functions.
+ */
+struct ZSTD_DCtx_s* ktxZSTD_createDCtx(void);
+struct ZSTD_CCtx_s* ktxZSTD_createCCtx(void);
+
 /*
  * Pad nbytes to next multiple of n
  */
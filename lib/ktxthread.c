@@ -0,0 +1,356 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file ktxthread.c
+ * @~English
+ *
+ * @brief Minimal portable threading and timing helpers for libktx's C code.
+ *
+ * Uses pthreads, or native threads on Windows, the same as the ASTC
+ * encoder.
+ */
+
+#include <stdlib.h>
+
+#if defined(_WIN32)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#else
+  #include <time.h>
+#endif
+
+#if defined(_WIN32) && !defined(WIN32_HAS_PTHREADS)
+  typedef HANDLE ktxThread;
+  typedef CRITICAL_SECTION ktxMutex;
+  typedef CONDITION_VARIABLE ktxCond;
+#else
+  #include <pthread.h>
+  typedef pthread_t ktxThread;
+  typedef pthread_mutex_t ktxMutex;
+  typedef pthread_cond_t ktxCond;
+#endif
+
+#include "ktxthread.h"
+#include "ktxint.h"
+
+typedef struct {
+    ktxThread handle;
+    ktx_bool_t started;
+    ktx_uint32_t threadCount;
+    ktx_uint32_t threadId;
+    ktxThreadFunc func;
+    void* payload;
+} ktxLaunchDesc;
+
+#if defined(_WIN32) && !defined(WIN32_HAS_PTHREADS)
+static DWORD WINAPI
+launchThreadsHelper(LPVOID p)
+{
+    ktxLaunchDesc* ltd = (ktxLaunchDesc*)p;
+    ltd->func(ltd->threadCount, ltd->threadId, ltd->payload);
+    return 0;
+}
+
+static ktx_bool_t
+startThread(ktxLaunchDesc* ltd)
+{
+    ltd->handle = CreateThread(NULL, 0, launchThreadsHelper, ltd, 0, NULL);
+    return ltd->handle != NULL;
+}
+
+static void
+joinThread(ktxLaunchDesc* ltd)
+{
+    WaitForSingleObject(ltd->handle, INFINITE);
+    CloseHandle(ltd->handle);
+}
+#else
+static void*
+launchThreadsHelper(void* p)
+{
+    ktxLaunchDesc* ltd = (ktxLaunchDesc*)p;
+    ltd->func(ltd->threadCount, ltd->threadId, ltd->payload);
+    return NULL;
+}
+
+static ktx_bool_t
+startThread(ktxLaunchDesc* ltd)
+{
+    return pthread_create(&ltd->handle, NULL, launchThreadsHelper, ltd) == 0;
+}
+
+static void
+joinThread(ktxLaunchDesc* ltd)
+{
+    pthread_join(ltd->handle, NULL);
+}
+#endif
+
+/**
+ * @internal
+ * @~English
+ * @brief Run a function on multiple threads and wait for completion.
+ *
+ * The calling thread runs the share with @c threadId 0. If a thread cannot
+ * be started, e.g. on a platform without thread support, its share is run
+ * on the calling thread so the work is always completed.
+ *
+ * @param[in] threadCount number of threads. Values of 0 and 1 run @p func
+ *                        directly on the calling thread.
+ * @param[in] func        the function to run.
+ * @param[in] payload     pointer passed to each invocation of @p func.
+ */
+void
+ktxLaunchThreads(ktx_uint32_t threadCount, ktxThreadFunc func, void* payload)
+{
+    ktxLaunchDesc* threadDescs;
+    ktx_uint32_t i;
+
+    if (threadCount <= 1) {
+        func(1, 0, payload);
+        return;
+    }
+
+    threadDescs = (ktxLaunchDesc*)ktxMalloc(threadCount * sizeof(ktxLaunchDesc));
+    if (threadDescs == NULL) {
+        // Run every share here.
+        for (i = 0; i < threadCount; i++)
+            func(threadCount, i, payload);
+        return;
+    }
+
+    for (i = 1; i < threadCount; i++) {
+        threadDescs[i].threadCount = threadCount;
+        threadDescs[i].threadId = i;
+        threadDescs[i].func = func;
+        threadDescs[i].payload = payload;
+        threadDescs[i].started = startThread(&threadDescs[i]);
+    }
+
+    func(threadCount, 0, payload);
+
+    for (i = 1; i < threadCount; i++) {
+        if (threadDescs[i].started)
+            joinThread(&threadDescs[i]);
+        else
+            func(threadCount, i, payload);
+    }
+
+    ktxFree(threadDescs);
+}
+
+#if defined(_WIN32) && !defined(WIN32_HAS_PTHREADS)
+static void mutexInit(ktxMutex* m) { InitializeCriticalSection(m); }
+static void mutexDestroy(ktxMutex* m) { DeleteCriticalSection(m); }
+static void mutexLock(ktxMutex* m) { EnterCriticalSection(m); }
+static void mutexUnlock(ktxMutex* m) { LeaveCriticalSection(m); }
+static void condInit(ktxCond* c) { InitializeConditionVariable(c); }
+static void condDestroy(ktxCond* c) { (void)c; }
+static void condWait(ktxCond* c, ktxMutex* m)
+{
+    SleepConditionVariableCS(c, m, INFINITE);
+}
+static void condBroadcast(ktxCond* c) { WakeAllConditionVariable(c); }
+#else
+static void mutexInit(ktxMutex* m) { pthread_mutex_init(m, NULL); }
+static void mutexDestroy(ktxMutex* m) { pthread_mutex_destroy(m); }
+static void mutexLock(ktxMutex* m) { pthread_mutex_lock(m); }
+static void mutexUnlock(ktxMutex* m) { pthread_mutex_unlock(m); }
+static void condInit(ktxCond* c) { pthread_cond_init(c, NULL); }
+static void condDestroy(ktxCond* c) { pthread_cond_destroy(c); }
+static void condWait(ktxCond* c, ktxMutex* m) { pthread_cond_wait(c, m); }
+static void condBroadcast(ktxCond* c) { pthread_cond_broadcast(c); }
+#endif
+
+struct ktxWorker {
+    ktxLaunchDesc thread;
+    ktxMutex mutex;
+    ktxCond cond;
+    ktxWorkerFunc func;
+    void* payload;
+    ktx_bool_t busy;
+    ktx_bool_t quit;
+};
+
+static void
+workerLoop(ktx_uint32_t threadCount, ktx_uint32_t threadId, void* p)
+{
+    ktxWorker* worker = (ktxWorker*)p;
+    (void)threadCount;
+    (void)threadId;
+
+    mutexLock(&worker->mutex);
+    for (;;) {
+        while (!worker->busy && !worker->quit)
+            condWait(&worker->cond, &worker->mutex);
+        if (!worker->busy)
+            break;
+        mutexUnlock(&worker->mutex);
+        worker->func(worker->payload);
+        mutexLock(&worker->mutex);
+        worker->busy = KTX_FALSE;
+        condBroadcast(&worker->cond);
+    }
+    mutexUnlock(&worker->mutex);
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Start a thread that runs jobs submitted to it one at a time.
+ *
+ * Use this instead of ktxLaunchThreads() when a series of short jobs is to
+ * be overlapped with work on the calling thread, to avoid starting and
+ * joining a thread for each.
+ *
+ * @return the new worker or @c NULL if memory could not be allocated or
+ *         the thread could not be started.
+ */
+ktxWorker*
+ktxWorker_create(void)
+{
+    ktxWorker* worker = (ktxWorker*)ktxMalloc(sizeof(ktxWorker));
+    if (worker == NULL)
+        return NULL;
+    mutexInit(&worker->mutex);
+    condInit(&worker->cond);
+    worker->busy = KTX_FALSE;
+    worker->quit = KTX_FALSE;
+    worker->thread.threadCount = 1;
+    worker->thread.threadId = 0;
+    worker->thread.func = workerLoop;
+    worker->thread.payload = worker;
+    if (!startThread(&worker->thread)) {
+        condDestroy(&worker->cond);
+        mutexDestroy(&worker->mutex);
+        ktxFree(worker);
+        return NULL;
+    }
+    return worker;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Run @p func with @p payload on the worker's thread.
+ *
+ * Returns immediately. The previous job must have been waited for with
+ * ktxWorker_wait().
+ */
+void
+ktxWorker_submit(ktxWorker* worker, ktxWorkerFunc func, void* payload)
+{
+    mutexLock(&worker->mutex);
+    worker->func = func;
+    worker->payload = payload;
+    worker->busy = KTX_TRUE;
+    condBroadcast(&worker->cond);
+    mutexUnlock(&worker->mutex);
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Wait for the job last submitted to the worker to complete.
+ */
+void
+ktxWorker_wait(ktxWorker* worker)
+{
+    mutexLock(&worker->mutex);
+    while (worker->busy)
+        condWait(&worker->cond, &worker->mutex);
+    mutexUnlock(&worker->mutex);
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Complete any submitted job then stop and free the worker.
+ */
+void
+ktxWorker_destroy(ktxWorker* worker)
+{
+    mutexLock(&worker->mutex);
+    worker->quit = KTX_TRUE;
+    condBroadcast(&worker->cond);
+    mutexUnlock(&worker->mutex);
+    joinThread(&worker->thread);
+    condDestroy(&worker->cond);
+    mutexDestroy(&worker->mutex);
+    ktxFree(worker);
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Return the current time from a monotonic clock.
+ *
+ * @return      the time in seconds. Only differences between values are
+ *              meaningful.
+ */
+double
+ktxGetSeconds(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Atomically increment a value.
+ *
+ * The increment has acquire and release ordering: memory operations of the
+ * calling thread are not reordered across it.
+ *
+ * @param[in,out] value pointer to the value to increment.
+ *
+ * @return      the incremented value.
+ */
+ktx_uint32_t
+ktxAtomicIncrement(ktx_uint32_t* value)
+{
+#if defined(_WIN32)
+    return (ktx_uint32_t)InterlockedIncrement((LONG volatile*)value);
+#else
+    return __atomic_add_fetch(value, 1, __ATOMIC_ACQ_REL);
+#endif
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Atomically decrement a value.
+ *
+ * The decrement has acquire and release ordering so a thread that sees it
+ * reach zero also sees every write made by other threads before their own
+ * decrements, e.g. before releasing shared data.
+ *
+ * @param[in,out] value pointer to the value to decrement.
+ *
+ * @return      the decremented value.
+ */
+ktx_uint32_t
+ktxAtomicDecrement(ktx_uint32_t* value)
+{
+#if defined(_WIN32)
+    return (ktx_uint32_t)InterlockedDecrement((LONG volatile*)value);
+#else
+    return __atomic_sub_fetch(value, 1, __ATOMIC_ACQ_REL);
+#endif
+}
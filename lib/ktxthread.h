@@ -0,0 +1,70 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file ktxthread.h
+ * @~English
+ *
+ * @brief Minimal portable threading and timing helpers for libktx's C code.
+ */
+
+#ifndef KTXTHREAD_H
+#define KTXTHREAD_H
+
+#include "ktx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Type of a function run by ktxLaunchThreads. @p threadId is in the
+ * range [0, threadCount).
+ */
+typedef void (*ktxThreadFunc)(ktx_uint32_t threadCount, ktx_uint32_t threadId,
+                              void* payload);
+
+/*
+ * Run @p func on @p threadCount threads, one of which is the calling thread,
+ * and wait for all of them to complete.
+ */
+void ktxLaunchThreads(ktx_uint32_t threadCount, ktxThreadFunc func,
+                      void* payload);
+
+/*
+ * A thread that runs submitted jobs one at a time, for overlapping a series
+ * of jobs with work on the calling thread without starting a thread per
+ * job.
+ */
+typedef struct ktxWorker ktxWorker;
+typedef void (*ktxWorkerFunc)(void* payload);
+
+ktxWorker* ktxWorker_create(void);
+void ktxWorker_submit(ktxWorker* worker, ktxWorkerFunc func, void* payload);
+void ktxWorker_wait(ktxWorker* worker);
+void ktxWorker_destroy(ktxWorker* worker);
+
+/*
+ * Return the current time, in seconds, from a monotonic clock. Only
+ * differences between values are meaningful.
+ */
+double ktxGetSeconds(void);
+
+/*
+ * Atomically add 1 to, or subtract 1 from, @p *value and return the
+ * new value.
+ */
+ktx_uint32_t ktxAtomicIncrement(ktx_uint32_t* value);
+ktx_uint32_t ktxAtomicDecrement(ktx_uint32_t* value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KTXTHREAD_H */
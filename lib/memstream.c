@@ -53,17 +53,22 @@ static KTX_error_code ktxMem_expand(ktxMem* pMem, const ktx_size_t size);
  *
  * @sa ktxMem_getdata.
  *
- * @param [in] pMem pointer to the @c ktxMem to initialize.
+ * @param [in] pMem        pointer to the @c ktxMem to initialize.
+ * @param [in] initialSize number of bytes to allocate initially.
  */
 static KTX_error_code
-ktxMem_construct(ktxMem* pMem)
+ktxMem_construct(ktxMem* pMem, ktx_size_t initialSize)
 {
     pMem->pos = 0;
-    pMem->alloc_size = 0;
     pMem->robytes = 0;
-    pMem->bytes = 0;
     pMem->used_size = 0;
-    return ktxMem_expand(pMem, KTX_MEM_DEFAULT_ALLOCATED_SIZE);
+    pMem->bytes = (ktx_uint8_t*)ktxMalloc(initialSize);
+    if (!pMem->bytes) {
+        pMem->alloc_size = 0;
+        return KTX_OUT_OF_MEMORY;
+    }
+    pMem->alloc_size = initialSize;
+    return KTX_SUCCESS;
 }
 
 /**
@@ -73,19 +78,22 @@ ktxMem_construct(ktxMem* pMem)
  *
  * @param [in,out] ppMem pointer to the location in which to return
  *                       a pointer to the newly created @c ktxMem.
+ * @param [in] initialSize number of bytes to allocate initially.
  *
  * @return     KTX_SUCCESS on success, KTX_OUT_OF_MEMORY on error.
  *
  * @exception  KTX_OUT_OF_MEMORY    System failed to allocate sufficient pMemory.
  */
 static KTX_error_code
-ktxMem_create(ktxMem** ppMem)
+ktxMem_create(ktxMem** ppMem, ktx_size_t initialSize)
 {
-    ktxMem* pNewMem = (ktxMem*)malloc(sizeof(ktxMem));
+    ktxMem* pNewMem = (ktxMem*)ktxMalloc(sizeof(ktxMem));
     if (pNewMem) {
-        KTX_error_code result = ktxMem_construct(pNewMem);
+        KTX_error_code result = ktxMem_construct(pNewMem, initialSize);
         if (result == KTX_SUCCESS)
             *ppMem = pNewMem;
+        else
+            ktxFree(pNewMem);
         return result;
     }
     else {
@@ -127,7 +135,7 @@ ktxMem_construct_ro(ktxMem* pMem, const void* bytes, ktx_size_t numBytes)
 static KTX_error_code
 ktxMem_create_ro(ktxMem** ppMem, const void* bytes, ktx_size_t numBytes)
 {
-    ktxMem* pNewMem = (ktxMem*)malloc(sizeof(ktxMem));
+    ktxMem* pNewMem = (ktxMem*)ktxMalloc(sizeof(ktxMem));
     if (pNewMem) {
         ktxMem_construct_ro(pNewMem, bytes, numBytes);
         *ppMem = pNewMem;
@@ -153,9 +161,9 @@ ktxMem_destroy(ktxMem* pMem, ktx_bool_t freeData)
 {
     assert(pMem != NULL);
     if (freeData) {
-        free(pMem->bytes);
+        ktxFree(pMem->bytes);
     }
-    free(pMem);
+    ktxFree(pMem);
 }
 
 #ifdef KTXMEM_CLEAR_USED
@@ -205,9 +213,9 @@ ktxMem_expand(ktxMem *pMem, const ktx_size_t newsize)
         return KTX_SUCCESS;
 
     if (!pMem->bytes)
-        pMem->bytes = (ktx_uint8_t*)malloc(new_alloc_size);
+        pMem->bytes = (ktx_uint8_t*)ktxMalloc(new_alloc_size);
     else
-        pMem->bytes = (ktx_uint8_t*)realloc(pMem->bytes, new_alloc_size);
+        pMem->bytes = (ktx_uint8_t*)ktxRealloc(pMem->bytes, new_alloc_size);
 
     if (!pMem->bytes)
     {
@@ -422,6 +430,46 @@ KTX_error_code ktxMemStream_getdata(ktxStream* str, ktx_uint8_t** ppBytes)
     return KTX_SUCCESS;
 }
 
+/**
+ * @~English
+ * @brief Get a pointer to data in a ktxMemStream without copying.
+ *
+ * The pointer remains valid as long as the underlying memory. For a
+ * read-only stream that is the caller's array of bytes. For a read-write
+ * stream it is invalidated by the next write.
+ *
+ * @param [in] str     pointer to the ktxStream of interest.
+ * @param [in] offset  offset from the start of the stream of the first byte.
+ * @param [in] count   number of bytes that will be accessed.
+ * @param [out] ppBytes pointer to a location in which to write a pointer to
+ *                     the data at @p offset.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p str or @p ppBytes is @c NULL.
+ * @exception KTX_FILE_UNEXPECTED_EOF the range extends beyond the end of the
+ *                                    data.
+ */
+KTX_error_code ktxMemStream_getview(ktxStream* str, ktx_off_t offset,
+                                    ktx_size_t count,
+                                    const ktx_uint8_t** ppBytes)
+{
+    ktxMem* mem;
+
+    if (!str || !ppBytes)
+        return KTX_INVALID_VALUE;
+
+    assert(str->type == eStreamTypeMemory);
+
+    mem = str->data.mem;
+    if (offset > (ktx_off_t)mem->used_size
+        || count > mem->used_size - (ktx_size_t)offset)
+        return KTX_FILE_UNEXPECTED_EOF;
+
+    *ppBytes = (mem->robytes ? mem->robytes : mem->bytes) + offset;
+    return KTX_SUCCESS;
+}
+
 /**
  * @~English
  * @brief Get the size of a ktxMemStream in bytes.
@@ -481,14 +529,41 @@ ktxMemStream_setup(ktxStream* str)
  */
 KTX_error_code ktxMemStream_construct(ktxStream* str,
                                       ktx_bool_t freeOnDestruct)
+{
+    return ktxMemStream_construct_sized(str, KTX_MEM_DEFAULT_ALLOCATED_SIZE,
+                                        freeOnDestruct);
+}
+
+/**
+ * @~English
+ * @brief Initialize a read-write ktxMemStream with a given amount of memory
+ *        allocated up front.
+ *
+ * When the amount of data to be written is known, passing it as
+ * @p initialSize avoids reallocating and copying as the data grows. The
+ * stream still grows if more is written.
+ *
+ * @param [in] str             pointer to a ktxStream struct to initialize.
+ * @param [in] initialSize     number of bytes to allocate initially.
+ * @param [in] freeOnDestruct  If not KTX_FALSE memory holding the data will
+ *                             be freed by the destructor.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p str is @c NULL or @p initialSize is 0.
+ * @exception KTX_OUT_OF_MEMORY     system failed to allocate sufficient memory.
+ */
+KTX_error_code ktxMemStream_construct_sized(ktxStream* str,
+                                            ktx_size_t initialSize,
+                                            ktx_bool_t freeOnDestruct)
 {
     ktxMem* mem;
     KTX_error_code result = KTX_SUCCESS;
 
-    if (!str)
+    if (!str || initialSize == 0)
         return KTX_INVALID_VALUE;
 
-    result = ktxMem_create(&mem);
+    result = ktxMem_create(&mem, initialSize);
 
     if (KTX_SUCCESS == result) {
         str->data.mem = mem;
@@ -29,6 +29,13 @@
  */
 KTX_error_code ktxMemStream_construct(ktxStream* str,
                                       ktx_bool_t freeOnDestruct);
+/*
+ * Initialize a ktxStream to a ktxMemStream with initialSize bytes of
+ * internally allocated memory. Can be read or written.
+ */
+KTX_error_code ktxMemStream_construct_sized(ktxStream* str,
+                                            ktx_size_t initialSize,
+                                            ktx_bool_t freeOnDestruct);
 /*
  * Initialize a ktxStream to a read-only ktxMemStream reading
  * from an array of bytes.
@@ -39,5 +46,8 @@ KTX_error_code ktxMemStream_construct_ro(ktxStream* str,
 void ktxMemStream_destruct(ktxStream* str);
 
 KTX_error_code ktxMemStream_getdata(ktxStream* str, ktx_uint8_t** ppBytes);
+KTX_error_code ktxMemStream_getview(ktxStream* str, ktx_off_t offset,
+                                    ktx_size_t count,
+                                    const ktx_uint8_t** ppBytes);
 
 #endif /* MEMSTREAM_H */
@@ -21,10 +21,17 @@
 #include "ktxint.h"
 
 #include <assert.h>
+#include <string.h>
 
-#if !KTX_FEATURE_WRITE
 // The reader does not link with the basisu components that already include a
-// definition of miniz so we include it here explicitly.
+// definition of miniz so we include it here explicitly. Otherwise we only
+// include the declarations and link with the basisu version. This is needed
+// because while miniz is defined as a header in basisu it's not declaring the
+// functions as static or inline, hence causing multiple conflicting
+// definitions at link-time.
+#if KTX_FEATURE_WRITE
+#define MINIZ_HEADER_FILE_ONLY
+#endif
 #ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wextra"
@@ -34,19 +41,6 @@
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
-#else
-// Otherwise we only declare the interfaces and link with the basisu version.
-// This is needed because while miniz is defined as a header in basisu it's
-// not declaring the functions as static or inline, hence causing multiple
-// conflicting definitions at link-time.
-namespace buminiz {
-    typedef unsigned long mz_ulong;
-    enum { MZ_OK = 0, MZ_STREAM_END = 1, MZ_NEED_DICT = 2, MZ_ERRNO = -1, MZ_STREAM_ERROR = -2, MZ_DATA_ERROR = -3, MZ_MEM_ERROR = -4, MZ_BUF_ERROR = -5, MZ_VERSION_ERROR = -6, MZ_PARAM_ERROR = -10000 };
-    mz_ulong mz_compressBound(mz_ulong source_len);
-    int mz_compress2(unsigned char *pDest, mz_ulong *pDest_len, const unsigned char *pSource, mz_ulong source_len, int level);
-    int mz_uncompress(unsigned char *pDest, mz_ulong *pDest_len, const unsigned char *pSource, mz_ulong source_len);
-}
-#endif
 
 using namespace buminiz;
 
@@ -146,4 +140,111 @@ KTX_error_code ktxUncompressZLIBInt(unsigned char* pDest,
     }
 }
 
+struct ktxZLIBInflater {
+    mz_stream stream;
+    bool ended;
+};
+
+static void* ktxZLIBAlloc(void*, size_t items, size_t size) {
+    return ktxMalloc(items * size);
+}
+
+static void ktxZLIBFree(void*, void* address) {
+    ktxFree(address);
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Start inflating ZLIB data that is supplied in chunks.
+ *
+ * @param pDest         destination data buffer
+ * @param destLength    destination data buffer size
+ * @param ppInflater    filled with the new inflater on success
+ */
+KTX_error_code ktxZLIBInflater_create(unsigned char* pDest,
+                                      ktx_size_t destLength,
+                                      ktxZLIBInflater** ppInflater) {
+    if (destLength > 0xFFFFFFFFU) return KTX_INVALID_VALUE;
+    ktxZLIBInflater* inflater
+        = static_cast<ktxZLIBInflater*>(ktxMalloc(sizeof(ktxZLIBInflater)));
+    if (inflater == nullptr) return KTX_OUT_OF_MEMORY;
+    memset(inflater, 0, sizeof(ktxZLIBInflater));
+    inflater->stream.zalloc = ktxZLIBAlloc;
+    inflater->stream.zfree = ktxZLIBFree;
+    inflater->stream.next_out = pDest;
+    inflater->stream.avail_out = (unsigned int)destLength;
+    if (mz_inflateInit(&inflater->stream) != MZ_OK) {
+        ktxFree(inflater);
+        return KTX_OUT_OF_MEMORY;
+    }
+    *ppInflater = inflater;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Inflate the next chunk of ZLIB data.
+ *
+ * @param inflater      the inflater
+ * @param pSrc          source data chunk
+ * @param srcLength     source data chunk size
+ */
+KTX_error_code ktxZLIBInflater_inflate(ktxZLIBInflater* inflater,
+                                       const unsigned char* pSrc,
+                                       ktx_size_t srcLength) {
+    if (srcLength > 0xFFFFFFFFU) return KTX_INVALID_VALUE;
+    inflater->stream.next_in = pSrc;
+    inflater->stream.avail_in = (unsigned int)srcLength;
+    while (inflater->stream.avail_in > 0 && !inflater->ended) {
+        mz_ulong prevTotalIn = inflater->stream.total_in;
+        mz_ulong prevTotalOut = inflater->stream.total_out;
+        int status = mz_inflate(&inflater->stream, MZ_SYNC_FLUSH);
+        switch (status) {
+        case MZ_OK:
+            // When the output is full miniz keeps returning MZ_OK without
+            // consuming input so the recorded inflated length is too small.
+            if ((inflater->stream.total_in == prevTotalIn
+                 && inflater->stream.total_out == prevTotalOut)
+                || (inflater->stream.avail_out == 0
+                    && inflater->stream.avail_in > 0))
+                return KTX_DECOMPRESS_LENGTH_ERROR;
+            break;
+        case MZ_STREAM_END:
+            inflater->ended = true;
+            break;
+        case MZ_BUF_ERROR:
+            // No progress possible. Input remains so the output is full.
+            return KTX_DECOMPRESS_LENGTH_ERROR;
+        case MZ_MEM_ERROR:
+            return KTX_OUT_OF_MEMORY;
+        default:
+            return KTX_FILE_DATA_ERROR;
+        }
+    }
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Finish inflating and destroy the inflater.
+ *
+ * @param inflater          the inflater
+ * @param pInflatedLength   if not NULL, filled with the written byte count
+ * @return KTX_FILE_DATA_ERROR if the end of the ZLIB stream has not been
+ *         reached.
+ */
+KTX_error_code ktxZLIBInflater_destroy(ktxZLIBInflater* inflater,
+                                       ktx_size_t* pInflatedLength) {
+    KTX_error_code result = inflater->ended ? KTX_SUCCESS
+                                            : KTX_FILE_DATA_ERROR;
+    if (pInflatedLength)
+        *pInflatedLength = inflater->stream.total_out;
+    mz_inflateEnd(&inflater->stream);
+    ktxFree(inflater);
+    return result;
+}
+
 }
@@ -0,0 +1,459 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file probe.c
+ * @~English
+ *
+ * @brief Functions for reading the header information of KTX and KTX2
+ *        files without creating a ktxTexture.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "filestream.h"
+
+/*
+ * Source of the data being probed. Either a stream, which is only read
+ * forwards, or bytes in memory which are accessed in place.
+ */
+typedef struct {
+    ktxStream* stream;
+    const ktx_uint8_t* bytes;
+    ktx_size_t size;
+    ktx_size_t pos;
+} ktxProbeSource;
+
+/*
+ * Copy @p count bytes at @p offset in the source to @p dst.
+ */
+static KTX_error_code
+ktxProbeSource_read(ktxProbeSource* src, ktx_size_t offset, void* dst,
+                    ktx_size_t count)
+{
+    KTX_error_code result = KTX_SUCCESS;
+
+    if (src->stream) {
+        // Sections of a KTX file are in ascending order so a stream never
+        // needs to go back.
+        if (offset < src->pos)
+            return KTX_FILE_DATA_ERROR;
+        if (offset > src->pos)
+            result = src->stream->skip(src->stream, offset - src->pos);
+        if (result == KTX_SUCCESS)
+            result = src->stream->read(src->stream, dst, count);
+    } else {
+        if (offset > src->size || count > src->size - offset)
+            return KTX_FILE_UNEXPECTED_EOF;
+        memcpy(dst, src->bytes + offset, count);
+    }
+    src->pos = offset + count;
+    return result;
+}
+
+/*
+ * Return the key/value data at @p offset. In memory it is used in place.
+ * From a stream it is read into the caller's kvdBuffer. Returns NULL in
+ * @p ppKvd if the buffer is too small.
+ */
+static KTX_error_code
+ktxProbeSource_kvd(ktxProbeSource* src, ktx_size_t offset,
+                   ktx_uint32_t kvdLen, ktxTextureInfo* info,
+                   const ktx_uint8_t** ppKvd)
+{
+    KTX_error_code result;
+
+    *ppKvd = NULL;
+    if (src->stream) {
+        if (info->kvdBuffer == NULL || info->kvdBufferSize < kvdLen)
+            return KTX_SUCCESS;
+        result = ktxProbeSource_read(src, offset, info->kvdBuffer, kvdLen);
+        if (result == KTX_SUCCESS)
+            *ppKvd = info->kvdBuffer;
+        return result;
+    }
+    if (offset > src->size || kvdLen > src->size - offset)
+        return KTX_FILE_UNEXPECTED_EOF;
+    *ppKvd = src->bytes + offset;
+    return KTX_SUCCESS;
+}
+
+/*
+ * Find the requested keys in serialized key/value data. @p swap is set for
+ * KTX files of the opposite endianness.
+ */
+static KTX_error_code
+ktxProbe_findKeys(ktxTextureInfo* info, const ktx_uint8_t* pKvd,
+                  ktx_uint32_t kvdLen, ktx_bool_t swap)
+{
+    const ktx_uint8_t* src = pKvd;
+    const ktx_uint8_t* end = pKvd + kvdLen;
+
+    while (src < end) {
+        ktx_uint32_t keyAndValueByteSize;
+        ktx_uint32_t keyLen;
+        const char* key;
+
+        if (end - src < 4)
+            return KTX_FILE_DATA_ERROR;
+        memcpy(&keyAndValueByteSize, src, sizeof(keyAndValueByteSize));
+        if (swap)
+            _ktxSwapEndian32(&keyAndValueByteSize, 1);
+        src += sizeof(keyAndValueByteSize);
+        if (keyAndValueByteSize > (ktx_size_t)(end - src))
+            return KTX_FILE_DATA_ERROR;
+
+        key = (const char*)src;
+        keyLen = 0;
+        while (keyLen < keyAndValueByteSize && key[keyLen] != '\0')
+            keyLen++;
+        if (keyLen == keyAndValueByteSize)
+            return KTX_FILE_DATA_ERROR;  // Missing NUL terminator.
+        keyLen++;
+
+        for (ktx_uint32_t i = 0; i < info->numKeys; i++) {
+            if (info->keys[i].value == NULL
+                && !strcmp(info->keys[i].key, key)) {
+                info->keys[i].value = src + keyLen;
+                info->keys[i].valueLen = keyAndValueByteSize - keyLen;
+            }
+        }
+        src += _KTX_PAD4(keyAndValueByteSize);
+    }
+    return KTX_SUCCESS;
+}
+
+/*
+ * Fill @p info from a KTX file. The identifier is already in @p header.
+ */
+static KTX_error_code
+ktxProbe_ktx1(ktxProbeSource* src, KTX_header* pHeader, ktxTextureInfo* info)
+{
+    KTX_header header = *pHeader;
+    KTX_supplemental_info suppInfo;
+    KTX_error_code result;
+    const ktx_uint8_t* pKvd;
+
+    result = ktxProbeSource_read(src, sizeof(header.identifier),
+                                 &header.endianness,
+                                 KTX_HEADER_SIZE - sizeof(header.identifier));
+    if (result != KTX_SUCCESS)
+        return result;
+    result = ktxCheckHeader1_(&header, &suppInfo);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    info->classId = ktxTexture1_c;
+    info->glInternalformat = header.glInternalformat;
+    info->glFormat = header.glFormat;
+    info->glType = header.glType;
+    info->typeSize = header.glTypeSize;
+    info->baseWidth = header.pixelWidth;
+    info->baseHeight = MAX(1, header.pixelHeight);
+    info->baseDepth = MAX(1, header.pixelDepth);
+    info->numDimensions = suppInfo.textureDimension;
+    info->numLevels = header.numberOfMipLevels;
+    info->isArray = header.numberOfArrayElements > 0;
+    info->numLayers = MAX(1, header.numberOfArrayElements);
+    info->numFaces = header.numberOfFaces;
+    info->isCubemap = header.numberOfFaces == 6;
+    info->generateMipmaps = suppInfo.generateMipmaps;
+    info->kvdByteLength = header.bytesOfKeyValueData;
+
+    if (info->numKeys == 0 || header.bytesOfKeyValueData == 0)
+        return KTX_SUCCESS;
+    result = ktxProbeSource_kvd(src, KTX_HEADER_SIZE,
+                                header.bytesOfKeyValueData, info, &pKvd);
+    if (result != KTX_SUCCESS || pKvd == NULL)
+        return result;
+    return ktxProbe_findKeys(info, pKvd, header.bytesOfKeyValueData,
+                             header.endianness == KTX_ENDIAN_REF_REV);
+}
+
+/*
+ * Fill @p info from a KTX2 file. The identifier is already in @p header.
+ */
+static KTX_error_code
+ktxProbe_ktx2(ktxProbeSource* src, KTX_header2* pHeader, ktxTextureInfo* info)
+{
+    KTX_header2 header = *pHeader;
+    KTX_supplemental_info suppInfo;
+    KTX_error_code result;
+    ktx_uint32_t dfd[7];  // Total size + basic descriptor block header.
+    const ktx_uint8_t* pKvd;
+
+    result = ktxProbeSource_read(src, sizeof(header.identifier),
+                                 &header.vkFormat,
+                                 KTX2_HEADER_SIZE - sizeof(header.identifier));
+    if (result != KTX_SUCCESS)
+        return result;
+    result = ktxCheckHeader2_(&header, &suppInfo);
+    if (result != KTX_SUCCESS)
+        return result;
+    // ktxCheckHeader2_ has done the max(1, levelCount) on header.levelCount.
+    if (header.levelCount > KTX_PROBE_MAX_LEVELS)
+        return KTX_FILE_DATA_ERROR;
+
+    info->classId = ktxTexture2_c;
+    info->vkFormat = header.vkFormat;
+    info->typeSize = header.typeSize;
+    info->baseWidth = header.pixelWidth;
+    info->baseHeight = MAX(1, header.pixelHeight);
+    info->baseDepth = MAX(1, header.pixelDepth);
+    info->numDimensions = suppInfo.textureDimension;
+    info->numLevels = header.levelCount;
+    info->isArray = header.layerCount > 0;
+    info->numLayers = MAX(1, header.layerCount);
+    info->numFaces = header.faceCount;
+    info->isCubemap = header.faceCount == 6;
+    info->generateMipmaps = suppInfo.generateMipmaps;
+    info->supercompressionScheme = header.supercompressionScheme;
+    info->kvdByteLength = header.keyValueData.byteLength;
+    info->sgdByteLength = header.supercompressionGlobalData.byteLength;
+
+    assert(sizeof(info->levels[0]) == sizeof(ktxLevelIndexEntry));
+    result = ktxProbeSource_read(src, KTX2_HEADER_SIZE, info->levels,
+                                 header.levelCount
+                                 * sizeof(ktxLevelIndexEntry));
+    if (result != KTX_SUCCESS)
+        return result;
+
+    if (header.dataFormatDescriptor.byteLength < sizeof(dfd))
+        return KTX_FILE_DATA_ERROR;
+    result = ktxProbeSource_read(src, header.dataFormatDescriptor.byteOffset,
+                                 dfd, sizeof(dfd));
+    if (result != KTX_SUCCESS)
+        return result;
+    info->colorModel = KHR_DFDVAL(dfd + 1, MODEL);
+    info->colorPrimaries = KHR_DFDVAL(dfd + 1, PRIMARIES);
+    info->transferFunction = KHR_DFDVAL(dfd + 1, TRANSFER);
+    info->premultipliedAlpha =
+              (KHR_DFDVAL(dfd + 1, FLAGS) & KHR_DF_FLAG_ALPHA_PREMULTIPLIED)
+              != 0;
+
+    if (info->numKeys == 0 || header.keyValueData.byteLength == 0)
+        return KTX_SUCCESS;
+    result = ktxProbeSource_kvd(src, header.keyValueData.byteOffset,
+                                header.keyValueData.byteLength, info, &pKvd);
+    if (result != KTX_SUCCESS || pKvd == NULL)
+        return result;
+    return ktxProbe_findKeys(info, pKvd, header.keyValueData.byteLength,
+                             KTX_FALSE);
+}
+
+/*
+ * Identify the file type and fill @p info accordingly.
+ */
+static KTX_error_code
+ktxProbe(ktxProbeSource* src, ktxTextureInfo* info)
+{
+    ktx_uint8_t ktx_ident_ref[12] = KTX_IDENTIFIER_REF;
+    ktx_uint8_t ktx2_ident_ref[12] = KTX2_IDENTIFIER_REF;
+    union {
+        KTX_header ktx;
+        KTX_header2 ktx2;
+    } header;
+    ktxProbeKey* keys;
+    ktx_uint32_t numKeys;
+    ktx_uint8_t* kvdBuffer;
+    ktx_uint32_t kvdBufferSize;
+    KTX_error_code result;
+
+    if (info == NULL || info->structSize != sizeof(ktxTextureInfo))
+        return KTX_INVALID_VALUE;
+    if (info->numKeys > 0 && info->keys == NULL)
+        return KTX_INVALID_VALUE;
+
+    keys = info->keys;
+    numKeys = info->numKeys;
+    kvdBuffer = info->kvdBuffer;
+    kvdBufferSize = info->kvdBufferSize;
+    memset(info, 0, sizeof(*info));
+    info->structSize = sizeof(*info);
+    info->keys = keys;
+    info->numKeys = numKeys;
+    info->kvdBuffer = kvdBuffer;
+    info->kvdBufferSize = kvdBufferSize;
+    for (ktx_uint32_t i = 0; i < numKeys; i++) {
+        keys[i].value = NULL;
+        keys[i].valueLen = 0;
+    }
+
+    result = ktxProbeSource_read(src, 0, header.ktx.identifier,
+                                 sizeof(header.ktx.identifier));
+    if (result != KTX_SUCCESS)
+        return result;
+    if (!memcmp(header.ktx.identifier, ktx_ident_ref, 12))
+        return ktxProbe_ktx1(src, &header.ktx, info);
+    else if (!memcmp(header.ktx2.identifier, ktx2_ident_ref, 12))
+        return ktxProbe_ktx2(src, &header.ktx2, info);
+    else
+        return KTX_UNKNOWN_FILE_FORMAT;
+}
+
+/**
+ * @~English
+ * @brief Read the header information of KTX or KTX2 data in a ktxStream.
+ *
+ * Parses the header, the level index, a summary of the DFD and selected
+ * metadata into @p info without creating a ktxTexture or allocating
+ * memory. Use it to index many files cheaply.
+ *
+ * To look up metadata set @c info->keys to an array of ktxProbeKey with
+ * the keys filled in and @c info->kvdBuffer to a buffer into which the
+ * key/value data can be read. If the buffer is smaller than
+ * @c info->kvdByteLength the values are left @c NULL and the caller can
+ * retry with a larger buffer.
+ *
+ * The stream is only read forwards. Its position afterwards is unspecified.
+ *
+ * @param[in] stream    pointer to the ktxStream from which to read.
+ * @param[in,out] info  pointer to a ktxTextureInfo with @c structSize and
+ *                      the input fields set. Receives the information.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p stream or @p info is @c NULL,
+ *                              @c info->structSize is wrong or
+ *                              @c info->keys is @c NULL while
+ *                              @c info->numKeys is not 0.
+ * @exception KTX_UNKNOWN_FILE_FORMAT The data is not KTX or KTX2.
+ * @exception KTX_FILE_DATA_ERROR The header or metadata is invalid or
+ *                                the file has more than
+ *                                KTX_PROBE_MAX_LEVELS levels.
+ * @exception KTX_FILE_UNEXPECTED_EOF The data ends inside the header
+ *                                    information.
+ * @exception KTX_UNSUPPORTED_FEATURE The file uses a feature libktx does
+ *                                    not support.
+ */
+KTX_error_code
+ktxProbeHeaderFromStream(ktxStream* stream, ktxTextureInfo* info)
+{
+    ktxProbeSource src;
+
+    if (stream == NULL)
+        return KTX_INVALID_VALUE;
+
+    memset(&src, 0, sizeof(src));
+    src.stream = stream;
+    return ktxProbe(&src, info);
+}
+
+/**
+ * @~English
+ * @brief Read the header information of KTX or KTX2 data in a stdio FILE.
+ *
+ * The file is read from its current position.
+ *
+ * @param[in] stdioStream   stdio FILE pointer to read from.
+ * @param[in,out] info      pointer to a ktxTextureInfo with @c structSize and
+ *                          the input fields set. Receives the information.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p stdioStream is @c NULL.
+ *
+ * For other exceptions, see ktxProbeHeaderFromStream().
+ */
+KTX_error_code
+ktxProbeHeaderFromStdioStream(FILE* stdioStream, ktxTextureInfo* info)
+{
+    KTX_error_code result;
+    ktxStream stream;
+
+    if (stdioStream == NULL)
+        return KTX_INVALID_VALUE;
+
+    result = ktxFileStream_construct(&stream, stdioStream, KTX_FALSE);
+    if (result == KTX_SUCCESS) {
+        result = ktxProbeHeaderFromStream(&stream, info);
+        stream.destruct(&stream);
+    }
+    return result;
+}
+
+/**
+ * @~English
+ * @brief Read the header information of a named KTX or KTX2 file.
+ *
+ * Only the start of the file is read. This is much cheaper than
+ * ktxTexture_CreateFromNamedFile() which allocates the texture, its DFD,
+ * metadata and supercompression global data.
+ *
+ * @param[in] filename      pointer to a char array containing the file name.
+ * @param[in,out] info      pointer to a ktxTextureInfo with @c structSize and
+ *                          the input fields set. Receives the information.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_FILE_OPEN_FAILED The file could not be opened.
+ * @exception KTX_INVALID_VALUE @p filename is @c NULL.
+ *
+ * For other exceptions, see ktxProbeHeaderFromStream().
+ */
+KTX_error_code
+ktxProbeHeaderFromNamedFile(const char* const filename, ktxTextureInfo* info)
+{
+    KTX_error_code result;
+    ktxStream stream;
+    FILE* file;
+
+    if (filename == NULL)
+        return KTX_INVALID_VALUE;
+
+    file = fopen(filename, "rb");
+    if (!file)
+       return KTX_FILE_OPEN_FAILED;
+
+    result = ktxFileStream_construct(&stream, file, KTX_TRUE);
+    if (result == KTX_SUCCESS) {
+        result = ktxProbeHeaderFromStream(&stream, info);
+        stream.destruct(&stream);
+    } else {
+        fclose(file);
+    }
+    return result;
+}
+
+/**
+ * @~English
+ * @brief Read the header information of KTX or KTX2 data in memory.
+ *
+ * The data is accessed in place. The values of requested metadata keys
+ * point into @p bytes and @c info->kvdBuffer is not used.
+ *
+ * @param[in] bytes         pointer to the memory containing the data.
+ * @param[in] size          length of the data in bytes.
+ * @param[in,out] info      pointer to a ktxTextureInfo with @c structSize and
+ *                          the input fields set. Receives the information.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p bytes is @c NULL or @p size is 0.
+ *
+ * For other exceptions, see ktxProbeHeaderFromStream().
+ */
+KTX_error_code
+ktxProbeHeaderFromMemory(const ktx_uint8_t* bytes, ktx_size_t size,
+                         ktxTextureInfo* info)
+{
+    ktxProbeSource src;
+
+    if (bytes == NULL || size == 0)
+        return KTX_INVALID_VALUE;
+
+    memset(&src, 0, sizeof(src));
+    src.bytes = bytes;
+    src.size = size;
+    return ktxProbe(&src, info);
+}
@@ -87,7 +87,7 @@ ktxTexture_construct(ktxTexture* This, ktxTextureCreateInfo* createInfo,
     DECLARE_PROTECTED(ktxTexture);
 
     memset(This, 0, sizeof(*This));
-    This->_protected = (struct ktxTexture_protected*)malloc(sizeof(*prtctd));
+    This->_protected = (struct ktxTexture_protected*)ktxMalloc(sizeof(*prtctd));
     if (!This->_protected)
         return KTX_OUT_OF_MEMORY;
     prtctd = This->_protected;
@@ -198,13 +198,15 @@ ktxTexture_constructFromStream(ktxTexture* This, ktxStream* pStream,
     assert(pStream->data.mem != NULL);
     assert(pStream->type == eStreamTypeFile
            || pStream->type == eStreamTypeMemory
-           || pStream->type == eStreamTypeCustom);
+           || pStream->type == eStreamTypeCustom
+           || pStream->type == eStreamTypeMappedFile);
 
     This->_protected = (struct ktxTexture_protected *)
-                                malloc(sizeof(struct ktxTexture_protected));
+                                ktxMalloc(sizeof(struct ktxTexture_protected));
     stream = ktxTexture_getStream(This);
     // Copy stream info into struct for later use.
     *stream = *pStream;
+    This->_protected->_kvdBlock = NULL;
 
     This->orientation.x = KTX_ORIENT_X_RIGHT;
     This->orientation.y = KTX_ORIENT_Y_DOWN;
@@ -231,11 +233,13 @@ ktxTexture_destruct(ktxTexture* This)
         stream.destruct(&stream);
     if (This->kvDataHead != NULL)
         ktxHashList_Destruct(&This->kvDataHead);
+    if (This->_protected->_kvdBlock != NULL)
+        ktxFree(This->_protected->_kvdBlock);
     if (This->kvData != NULL)
-        free(This->kvData);
+        ktxFree(This->kvData);
     if (This->pData != NULL)
-        free(This->pData);
-    free(This->_protected);
+        ktxFree(This->pData);
+    ktxFree(This->_protected);
 }
 
 
@@ -274,7 +278,8 @@ ktxDetermineFileType_(ktxStream* pStream, ktxFileType_* pFileType,
     assert(pStream->data.mem != NULL);
     assert(pStream->type == eStreamTypeFile
            || pStream->type == eStreamTypeMemory
-           || pStream->type == eStreamTypeCustom);
+           || pStream->type == eStreamTypeCustom
+           || pStream->type == eStreamTypeMappedFile);
 
     result = pStream->read(pStream, pHeader, sizeof(ktx2_ident_ref));
     if (result == KTX_SUCCESS) {
@@ -325,7 +330,7 @@ ktxTexture_CreateFromStream(ktxStream* pStream,
         return result;
 
     if (fileType == KTX1) {
-        ktxTexture1* tex1 = (ktxTexture1*)malloc(sizeof(ktxTexture1));
+        ktxTexture1* tex1 = (ktxTexture1*)ktxMalloc(sizeof(ktxTexture1));
         if (tex1 == NULL)
             return KTX_OUT_OF_MEMORY;
         memset(tex1, 0, sizeof(ktxTexture1));
@@ -334,7 +339,7 @@ ktxTexture_CreateFromStream(ktxStream* pStream,
                                                           createFlags);
         tex = ktxTexture(tex1);
     } else {
-        ktxTexture2* tex2 = (ktxTexture2*)malloc(sizeof(ktxTexture2));
+        ktxTexture2* tex2 = (ktxTexture2*)ktxMalloc(sizeof(ktxTexture2));
         if (tex2 == NULL)
             return KTX_OUT_OF_MEMORY;
         memset(tex2, 0, sizeof(ktxTexture2));
@@ -347,7 +352,7 @@ ktxTexture_CreateFromStream(ktxStream* pStream,
     if (result == KTX_SUCCESS)
         *newTex = (ktxTexture*)tex;
     else {
-        free(tex);
+        ktxFree(tex);
         *newTex = NULL;
     }
     return result;
@@ -397,6 +402,12 @@ ktxTexture_CreateFromStdioStream(FILE* stdioStream,
  * provided solely to enable implementation of the @e libktx v1 API on top of
  * ktxTexture.
  *
+ * If the create flag KTX_TEXTURE_CREATE_MAP_FILE_BIT is set, the file is
+ * memory mapped, when possible, instead of being read through stdio. Loading
+ * the image data of a KTX2 file that is not supercompressed then points
+ * @c pData into the mapping instead of allocating memory and copying. The
+ * mapping is private so modifying the images does not change the file.
+ *
  * @param[in] filename    pointer to a char array containing the file name.
  * @param[in] createFlags bitmask requesting specific actions during creation.
  * @param[in,out] newTex  pointer to a location in which store the address of
@@ -425,7 +436,10 @@ ktxTexture_CreateFromNamedFile(const char* const filename,
     if (!file)
        return KTX_FILE_OPEN_FAILED;
 
-    result = ktxFileStream_construct(&stream, file, KTX_TRUE);
+    if (createFlags & KTX_TEXTURE_CREATE_MAP_FILE_BIT)
+        result = ktxMappedFileStream_construct(&stream, file, KTX_TRUE);
+    else
+        result = ktxFileStream_construct(&stream, file, KTX_TRUE);
     if (result == KTX_SUCCESS) {
         result = ktxTexture_CreateFromStream(&stream, createFlags, newTex);
     }
@@ -450,6 +464,18 @@ ktxTexture_CreateFromNamedFile(const char* const filename,
  * provided solely to enable implementation of the @e libktx v1 API on top of
  * ktxTexture.
  *
+ * If the create flag KTX_TEXTURE_CREATE_BORROW_DATA_BIT is set and the data
+ * is KTX2 that is not supercompressed, loading the image data into the
+ * texture does not copy it; @c pData points into @p bytes. The caller must
+ * then keep @p bytes valid and unchanged until the texture is destroyed or
+ * its image data is replaced, e.g. by transcoding or deflation. Functions
+ * that modify the images, such as ktxTexture_SetImageFromMemory(), first
+ * replace @c pData with a private copy so @p bytes is never written. The
+ * image pointers passed to the callbacks of ktxTexture_IterateLevels() and
+ * ktxTexture_IterateLevelFaces() point into @p bytes so the callbacks must
+ * not write through them. Without the flag, @p bytes may be freed as soon as
+ * the image data has been loaded.
+ *
  * @param[in] bytes pointer to the memory containing the serialized KTX data.
  * @param[in] size  length of the KTX data in bytes.
  * @param[in] createFlags bitmask requesting specific actions during creation.
@@ -895,7 +921,8 @@ ktxTexture_rowInfo(ktxTexture* This, ktx_uint32_t level,
  * @brief Query if a ktxTexture has an active stream.
  *
  * Tests if a ktxTexture has unread image data. The internal stream is closed
- * once all the images have been read.
+ * once all the images have been read, unless @c pData is a view into the
+ * stream's data, in which case the stream is kept but is not active.
  *
  * @param[in]     This     pointer to the ktxTexture object of interest.
  *
@@ -906,7 +933,36 @@ ktxTexture_isActiveStream(ktxTexture* This)
 {
     assert(This != NULL);
     ktxStream* stream = ktxTexture_getStream(This);
-    return stream->data.file != NULL;
+    return stream->data.file != NULL && This->pData == NULL;
+}
+
+/**
+ * @memberof ktxTexture @private
+ * @~English
+ * @brief Iterate over the images while loading them, reading ahead when
+ *        the texture supports it.
+ *
+ * Used by the GL and Vulkan loaders so reading and inflating the next level
+ * of a KTX2 texture overlaps with the upload of the current one. KTX1
+ * textures, and KTX2 textures read from a custom ktxStream, are iterated
+ * as usual on the calling thread.
+ *
+ * @copydetails ktxTexture2_IterateLoadLevelFaces
+ */
+KTX_error_code
+ktxTexture_iterateLoadLevelFacesReadAhead(ktxTexture* This,
+                                          PFNKTXITERCB iterCb,
+                                          void* userdata)
+{
+    if (This->classId == ktxTexture2_c) {
+        ktxLoadParams params = {0};
+
+        params.structSize = sizeof(params);
+        params.readAhead = KTX_TRUE;
+        return ktxTexture2_IterateLoadLevelFacesEx((ktxTexture2*)This,
+                                                   iterCb, userdata, &params);
+    }
+    return ktxTexture_IterateLoadLevelFaces(This, iterCb, userdata);
 }
 
 /** @} */
@@ -63,6 +63,7 @@ typedef struct ktxTexture_protected {
     ktxFormatSize _formatSize;
     ktx_uint32_t _typeSize;
     ktxStream _stream;
+    void* _kvdBlock; /*!< Key-value data block referenced by kvDataHead. */
 } ktxTexture_protected;
 
 #define ktxTexture_getStream(t) ((ktxStream*)(&(t)->_protected->_stream))
@@ -80,6 +81,10 @@ ktx_size_t ktxTexture_calcDataSizeTexture(ktxTexture* This);
 ktx_size_t ktxTexture_calcImageSize(ktxTexture* This, ktx_uint32_t level,
                                     ktxFormatVersionEnum fv);
 ktx_bool_t ktxTexture_isActiveStream(ktxTexture* This);
+KTX_error_code
+ktxTexture_iterateLoadLevelFacesReadAhead(ktxTexture* This,
+                                          PFNKTXITERCB iterCb,
+                                          void* userdata);
 ktx_size_t ktxTexture_calcLevelSize(ktxTexture* This, ktx_uint32_t level,
                                     ktxFormatVersionEnum fv);
 ktx_size_t ktxTexture_doCalcFaceLodSize(ktxTexture* This, ktx_uint32_t level,
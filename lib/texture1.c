@@ -47,7 +47,7 @@ ktxTexture1_constructCommon(ktxTexture1* This)
     This->classId = ktxTexture1_c;
     This->vtbl = &ktxTexture1_vtbl;
     This->_protected->_vtbl = ktxTexture1_vtblInt;
-    This->_private = (ktxTexture1_private*)malloc(sizeof(ktxTexture1_private));
+    This->_private = (ktxTexture1_private*)ktxMalloc(sizeof(ktxTexture1_private));
     if (This->_private == NULL) {
         return KTX_OUT_OF_MEMORY;
     }
@@ -126,7 +126,7 @@ ktxTexture1_construct(ktxTexture1* This, ktxTextureCreateInfo* createInfo,
     if (storageAllocation == KTX_TEXTURE_CREATE_ALLOC_STORAGE) {
         This->dataSize
                     = ktxTexture_calcDataSizeTexture(ktxTexture(This));
-        This->pData = malloc(This->dataSize);
+        This->pData = ktxMalloc(This->dataSize);
         if (This->pData == NULL) {
             result = KTX_OUT_OF_MEMORY;
             goto cleanup;
@@ -276,7 +276,7 @@ ktxTexture1_constructFromStreamAndHeader(ktxTexture1* This, ktxStream* pStream,
             ktx_uint32_t kvdLen = pHeader->bytesOfKeyValueData;
             ktx_uint8_t* pKvd;
 
-            pKvd = malloc(kvdLen);
+            pKvd = ktxMalloc(kvdLen);
             if (pKvd == NULL) {
                 result = KTX_OUT_OF_MEMORY;
                 goto cleanup;
@@ -301,12 +301,13 @@ ktxTexture1_constructFromStreamAndHeader(ktxTexture1* This, ktxStream* pStream,
                 char* orientation;
                 ktx_uint32_t orientationLen;
 
-                result = ktxHashList_Deserialize(&This->kvDataHead,
-                                                 kvdLen, pKvd);
-                free(pKvd);
+                result = ktxHashList_DeserializeView(&This->kvDataHead,
+                                                     kvdLen, (void**)&pKvd);
                 if (result != KTX_SUCCESS) {
+                    ktxFree(pKvd);
                     goto cleanup;
                 }
+                This->_protected->_kvdBlock = pKvd;
 
                 result = ktxHashList_FindValue(&This->kvDataHead,
                                                KTX_ORIENTATION_KEY,
@@ -488,7 +489,10 @@ ktxTexture1_constructFromNamedFile(ktxTexture1* This,
     if (!file)
        return KTX_FILE_OPEN_FAILED;
 
-    result = ktxFileStream_construct(&stream, file, KTX_TRUE);
+    if (createFlags & KTX_TEXTURE_CREATE_MAP_FILE_BIT)
+        result = ktxMappedFileStream_construct(&stream, file, KTX_TRUE);
+    else
+        result = ktxFileStream_construct(&stream, file, KTX_TRUE);
     if (result == KTX_SUCCESS)
         result = ktxTexture1_constructFromStream(This, &stream, createFlags);
 
@@ -534,7 +538,7 @@ ktxTexture1_constructFromMemory(ktxTexture1* This,
 void
 ktxTexture1_destruct(ktxTexture1* This)
 {
-    if (This->_private) free(This->_private);
+    if (This->_private) ktxFree(This->_private);
     ktxTexture_destruct(ktxTexture(This));
 }
 
@@ -596,13 +600,13 @@ ktxTexture1_Create(ktxTextureCreateInfo* createInfo,
     if (newTex == NULL)
         return KTX_INVALID_VALUE;
 
-    ktxTexture1* tex = (ktxTexture1*)malloc(sizeof(ktxTexture1));
+    ktxTexture1* tex = (ktxTexture1*)ktxMalloc(sizeof(ktxTexture1));
     if (tex == NULL)
         return KTX_OUT_OF_MEMORY;
 
     result = ktxTexture1_construct(tex, createInfo, storageAllocation);
     if (result != KTX_SUCCESS) {
-        free(tex);
+        ktxFree(tex);
     } else {
         *newTex = tex;
     }
@@ -658,7 +662,7 @@ ktxTexture1_CreateFromStdioStream(FILE* stdioStream,
     if (newTex == NULL)
         return KTX_INVALID_VALUE;
 
-    ktxTexture1* tex = (ktxTexture1*)malloc(sizeof(ktxTexture1));
+    ktxTexture1* tex = (ktxTexture1*)ktxMalloc(sizeof(ktxTexture1));
     if (tex == NULL)
         return KTX_OUT_OF_MEMORY;
 
@@ -667,7 +671,7 @@ ktxTexture1_CreateFromStdioStream(FILE* stdioStream,
     if (result == KTX_SUCCESS)
         *newTex = (ktxTexture1*)tex;
     else {
-        free(tex);
+        ktxFree(tex);
         *newTex = NULL;
     }
     return result;
@@ -712,7 +716,7 @@ ktxTexture1_CreateFromNamedFile(const char* const filename,
     if (newTex == NULL)
         return KTX_INVALID_VALUE;
 
-    ktxTexture1* tex = (ktxTexture1*)malloc(sizeof(ktxTexture1));
+    ktxTexture1* tex = (ktxTexture1*)ktxMalloc(sizeof(ktxTexture1));
     if (tex == NULL)
         return KTX_OUT_OF_MEMORY;
 
@@ -720,7 +724,7 @@ ktxTexture1_CreateFromNamedFile(const char* const filename,
     if (result == KTX_SUCCESS)
         *newTex = (ktxTexture1*)tex;
     else {
-        free(tex);
+        ktxFree(tex);
         *newTex = NULL;
     }
     return result;
@@ -764,7 +768,7 @@ ktxTexture1_CreateFromMemory(const ktx_uint8_t* bytes, ktx_size_t size,
     if (newTex == NULL)
         return KTX_INVALID_VALUE;
 
-    ktxTexture1* tex = (ktxTexture1*)malloc(sizeof(ktxTexture1));
+    ktxTexture1* tex = (ktxTexture1*)ktxMalloc(sizeof(ktxTexture1));
     if (tex == NULL)
         return KTX_OUT_OF_MEMORY;
 
@@ -773,7 +777,7 @@ ktxTexture1_CreateFromMemory(const ktx_uint8_t* bytes, ktx_size_t size,
     if (result == KTX_SUCCESS)
         *newTex = (ktxTexture1*)tex;
     else {
-        free(tex);
+        ktxFree(tex);
         *newTex = NULL;
     }
     return result;
@@ -816,7 +820,7 @@ ktxTexture1_CreateFromStream(ktxStream* stream,
     if (newTex == NULL)
         return KTX_INVALID_VALUE;
 
-    ktxTexture1* tex = (ktxTexture1*)malloc(sizeof(ktxTexture1));
+    ktxTexture1* tex = (ktxTexture1*)ktxMalloc(sizeof(ktxTexture1));
     if (tex == NULL)
         return KTX_OUT_OF_MEMORY;
 
@@ -824,7 +828,7 @@ ktxTexture1_CreateFromStream(ktxStream* stream,
     if (result == KTX_SUCCESS)
         *newTex = (ktxTexture1*)tex;
     else {
-        free(tex);
+        ktxFree(tex);
         *newTex = NULL;
     }
     return result;
@@ -845,7 +849,7 @@ void
 ktxTexture1_Destroy(ktxTexture1* This)
 {
     ktxTexture1_destruct(This);
-    free(This);
+    ktxFree(This);
 }
 
 /**
@@ -1195,7 +1199,7 @@ ktxTexture1_IterateLoadLevelFaces(ktxTexture1* This, PFNKTXITERCB iterCb,
 #endif
         if (!data) {
             /* allocate memory sufficient for the base miplevel */
-            data = malloc(faceLodSizePadded);
+            data = ktxMalloc(faceLodSizePadded);
             if (!data) {
                 result = KTX_OUT_OF_MEMORY;
                 goto cleanup;
@@ -1241,7 +1245,7 @@ ktxTexture1_IterateLoadLevelFaces(ktxTexture1* This, PFNKTXITERCB iterCb,
     }
 
 cleanup:
-    free(data);
+    ktxFree(data);
     // No further need for this.
     stream->destruct(stream);
 
@@ -1287,7 +1291,7 @@ ktxTexture1_LoadImageData(ktxTexture1* This,
         return KTX_INVALID_OPERATION;
 
     if (pBuffer == NULL) {
-        This->pData = malloc(This->dataSize);
+        This->pData = ktxMalloc(This->dataSize);
         if (This->pData == NULL)
             return KTX_OUT_OF_MEMORY;
         pDest = This->pData;
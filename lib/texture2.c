@@ -30,7 +30,10 @@
 #include "dfdutils/dfd.h"
 #include "ktx.h"
 #include "ktxint.h"
+#include "basis_sgd.h"
+#include "decodecontext.h"
 #include "filestream.h"
+#include "ktxthread.h"
 #include "memstream.h"
 #include "texture2.h"
 #include "unused.h"
@@ -330,7 +333,18 @@ ktxFormatSize_initFromDfd(ktxFormatSize* This, ktx_uint32_t* pDfd)
 static uint32_t*
 ktxVk2dfd(ktx_uint32_t vkFormat)
 {
-    return vk2dfd(vkFormat);
+    // dfdutils allocates with malloc. Copy the DFD so it can be freed with
+    // ktxFree like every other allocation held by a texture.
+    uint32_t* dfd = vk2dfd(vkFormat);
+    uint32_t* pDfd;
+
+    if (dfd == NULL)
+        return NULL;
+    pDfd = ktxMalloc(*dfd);
+    if (pDfd != NULL)
+        memcpy(pDfd, dfd, *dfd);
+    free(dfd);
+    return pDfd;
 }
 
 /**
@@ -357,7 +371,7 @@ ktxTexture2_constructCommon(ktxTexture2* This, ktx_uint32_t numLevels)
     This->_protected->_vtbl = ktxTexture2_vtblInt;
     privateSize = sizeof(ktxTexture2_private)
                 + sizeof(ktxLevelIndexEntry) * (numLevels - 1);
-    This->_private = (ktxTexture2_private*)malloc(privateSize);
+    This->_private = (ktxTexture2_private*)ktxMalloc(privateSize);
     if (This->_private == NULL) {
         return KTX_OUT_OF_MEMORY;
     }
@@ -407,7 +421,7 @@ ktxTexture2_construct(ktxTexture2* This, ktxTextureCreateInfo* createInfo,
 
     } else {
         // TODO: Validate createInfo->pDfd.
-        This->pDfd = (ktx_uint32_t*)malloc(*createInfo->pDfd);
+        This->pDfd = (ktx_uint32_t*)ktxMalloc(*createInfo->pDfd);
         if (!This->pDfd)
             return KTX_OUT_OF_MEMORY;
         memcpy(This->pDfd, createInfo->pDfd, *createInfo->pDfd);
@@ -480,7 +494,7 @@ ktxTexture2_construct(ktxTexture2* This, ktxTextureCreateInfo* createInfo,
     if (storageAllocation == KTX_TEXTURE_CREATE_ALLOC_STORAGE) {
         This->dataSize
                 = ktxTexture_calcDataSizeTexture(ktxTexture(This));
-        This->pData = malloc(This->dataSize);
+        This->pData = ktxMalloc(This->dataSize);
         if (This->pData == NULL) {
             result = KTX_OUT_OF_MEMORY;
             goto cleanup;
@@ -498,16 +512,19 @@ cleanup:
  * @~English
  * @brief Construct a ktxTexture by copying a source ktxTexture.
  *
- * @param[in] This pointer to a ktxTexture2-sized block of memory to
- *                 initialize.
- * @param[in] orig pointer to the source texture to copy.
+ * @param[in] This      pointer to a ktxTexture2-sized block of memory to
+ *                      initialize.
+ * @param[in] orig      pointer to the source texture to copy.
+ * @param[in] shareData if true, share orig's image data instead of copying
+ *                      it, unless it is a view of orig's source.
  *
  * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
  *
  * @exception KTX_OUT_OF_MEMORY Not enough memory for the texture data.
  */
-KTX_error_code
-ktxTexture2_constructCopy(ktxTexture2* This, ktxTexture2* orig)
+static KTX_error_code
+ktxTexture2_constructCopyInt(ktxTexture2* This, ktxTexture2* orig,
+                             ktx_bool_t shareData)
 {
     KTX_error_code result;
 
@@ -521,25 +538,34 @@ ktxTexture2_constructCopy(ktxTexture2* This, ktxTexture2* orig)
     This->pData = NULL;
 
     This->_protected =
-                    (ktxTexture_protected*)malloc(sizeof(ktxTexture_protected));
+                    (ktxTexture_protected*)ktxMalloc(sizeof(ktxTexture_protected));
     if (!This->_protected)
         return KTX_OUT_OF_MEMORY;
     // Must come before memcpy of _protected so as to close an active stream.
     if (!orig->pData && ktxTexture_isActiveStream((ktxTexture*)orig))
         ktxTexture2_LoadImageData(orig, NULL, 0);
     memcpy(This->_protected, orig->_protected, sizeof(ktxTexture_protected));
+    // The copy's key-value entries are copied, not views of orig's block.
+    This->_protected->_kvdBlock = NULL;
+    // If orig's data is a view, orig's stream is still open. The copy has
+    // its own data so must not share the stream.
+    if (orig->_private->_pDataIsView)
+        memset(&This->_protected->_stream, 0, sizeof(ktxStream));
 
     ktx_size_t privateSize = sizeof(ktxTexture2_private)
                            + sizeof(ktxLevelIndexEntry) * (orig->numLevels - 1);
-    This->_private = (ktxTexture2_private*)malloc(privateSize);
+    This->_private = (ktxTexture2_private*)ktxMalloc(privateSize);
     if (This->_private == NULL) {
         result = KTX_OUT_OF_MEMORY;
         goto cleanup;
     }
     memcpy(This->_private, orig->_private, privateSize);
+    This->_private->_pDataIsView = KTX_FALSE;
+    This->_private->_canViewSource = KTX_FALSE;
+    This->_private->_pDataRefCount = NULL;
     if (orig->_private->_sgdByteLength > 0) {
         This->_private->_supercompressionGlobalData
-                        = (ktx_uint8_t*)malloc(orig->_private->_sgdByteLength);
+                        = (ktx_uint8_t*)ktxMalloc(orig->_private->_sgdByteLength);
         if (!This->_private->_supercompressionGlobalData) {
             result = KTX_OUT_OF_MEMORY;
             goto cleanup;
@@ -549,7 +575,7 @@ ktxTexture2_constructCopy(ktxTexture2* This, ktxTexture2* orig)
                orig->_private->_sgdByteLength);
     }
 
-    This->pDfd = (ktx_uint32_t*)malloc(*orig->pDfd);
+    This->pDfd = (ktx_uint32_t*)ktxMalloc(*orig->pDfd);
     if (!This->pDfd) {
         result = KTX_OUT_OF_MEMORY;
         goto cleanup;
@@ -559,7 +585,7 @@ ktxTexture2_constructCopy(ktxTexture2* This, ktxTexture2* orig)
     if (orig->kvDataHead) {
         ktxHashList_ConstructCopy(&This->kvDataHead, orig->kvDataHead);
     } else if (orig->kvData) {
-        This->kvData = (ktx_uint8_t*)malloc(orig->kvDataLen);
+        This->kvData = (ktx_uint8_t*)ktxMalloc(orig->kvDataLen);
         if (!This->kvData) {
             result = KTX_OUT_OF_MEMORY;
             goto cleanup;
@@ -567,13 +593,26 @@ ktxTexture2_constructCopy(ktxTexture2* This, ktxTexture2* orig)
         memcpy(This->kvData, orig->kvData, orig->kvDataLen);
     }
 
-    // Can't share the image data as the data pointer is exposed in the
-    // ktxTexture2 structure. Changing it to a ref-counted pointer would
-    // break code. Maybe that's okay as we're still pre-release. But,
-    // since this constructor will be mostly be used when transcoding
-    // supercompressed images, it is probably not too big a deal to make
-    // a copy of the data.
-    This->pData = (ktx_uint8_t*)malloc(This->dataSize);
+    // The data pointer is exposed in the ktxTexture2 structure so the
+    // data is only shared when asked for by ktxTexture2_CreateSharedCopy.
+    // Its documentation warns against writing through pData.
+    if (shareData && orig->pData != NULL && !orig->_private->_pDataIsView) {
+        if (orig->_private->_pDataRefCount == NULL) {
+            orig->_private->_pDataRefCount
+                            = (ktx_uint32_t*)ktxMalloc(sizeof(ktx_uint32_t));
+            if (orig->_private->_pDataRefCount == NULL) {
+                result = KTX_OUT_OF_MEMORY;
+                goto cleanup;
+            }
+            *orig->_private->_pDataRefCount = 1;
+        }
+        ktxAtomicIncrement(orig->_private->_pDataRefCount);
+        This->_private->_pDataRefCount = orig->_private->_pDataRefCount;
+        This->pData = orig->pData;
+        return KTX_SUCCESS;
+    }
+
+    This->pData = (ktx_uint8_t*)ktxMalloc(This->dataSize);
     if (This->pData == NULL) {
         result = KTX_OUT_OF_MEMORY;
         goto cleanup;
@@ -582,18 +621,102 @@ ktxTexture2_constructCopy(ktxTexture2* This, ktxTexture2* orig)
     return KTX_SUCCESS;
 
 cleanup:
-    if (This->_protected) free(This->_protected);
+    if (This->_protected) ktxFree(This->_protected);
     if (This->_private) {
         if (This->_private->_supercompressionGlobalData)
-            free(This->_private->_supercompressionGlobalData);
-        free(This->_private);
+            ktxFree(This->_private->_supercompressionGlobalData);
+        ktxFree(This->_private);
     }
-    if (This->pDfd) free (This->pDfd);
+    if (This->pDfd) ktxFree(This->pDfd);
     if (This->kvDataHead) ktxHashList_Destruct(&This->kvDataHead);
 
     return result;
 }
 
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Construct a ktxTexture by copying a source ktxTexture.
+ *
+ * @param[in] This pointer to a ktxTexture2-sized block of memory to
+ *                 initialize.
+ * @param[in] orig pointer to the source texture to copy.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the texture data.
+ */
+KTX_error_code
+ktxTexture2_constructCopy(ktxTexture2* This, ktxTexture2* orig)
+{
+    return ktxTexture2_constructCopyInt(This, orig, KTX_FALSE);
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Drop the largest mip levels so the base level fits within
+ *        @p maxDimension.
+ *
+ * Only the level index and, for BasisLZ, the image descriptors in the
+ * supercompression global data are rewritten. Level 0 is last in the data so
+ * the remaining levels keep their offsets from _firstLevelFileOffset and the
+ * skipped levels are never read.
+ *
+ * @param[in] This         pointer to the ktxTexture2 object of interest.
+ * @param[in] maxDimension largest base dimension to keep.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_FILE_DATA_ERROR
+ *                              The supercompression global data is too
+ *                              small for the number of images.
+ */
+static KTX_error_code
+ktxTexture2_skipLevels(ktxTexture2* This, ktx_uint32_t maxDimension)
+{
+    ktxTexture2_private* private = This->_private;
+    ktx_uint32_t skip = 0;
+
+    while (skip < This->numLevels - 1
+           && MAX(MAX(This->baseWidth >> skip, This->baseHeight >> skip),
+                  This->baseDepth >> skip) > maxDimension) {
+        skip++;
+    }
+    if (skip == 0)
+        return KTX_SUCCESS;
+
+    if (This->supercompressionScheme == KTX_SS_BASIS_LZ) {
+        ktx_uint8_t* pImageDescs = private->_supercompressionGlobalData
+                                 + sizeof(ktxBasisLzGlobalHeader);
+        ktx_uint32_t skippedImages = 0;
+        ktx_size_t skippedBytes;
+
+        for (ktx_uint32_t level = 0; level < skip; level++) {
+            skippedImages += This->numLayers * This->numFaces
+                             * MAX(1, This->baseDepth >> level);
+        }
+        skippedBytes = skippedImages * sizeof(ktxBasisLzEtc1sImageDesc);
+        if (private->_sgdByteLength
+            < sizeof(ktxBasisLzGlobalHeader) + skippedBytes)
+            return KTX_FILE_DATA_ERROR;
+        memmove(pImageDescs, pImageDescs + skippedBytes,
+                private->_sgdByteLength - sizeof(ktxBasisLzGlobalHeader)
+                - skippedBytes);
+        private->_sgdByteLength -= skippedBytes;
+    }
+
+    This->numLevels -= skip;
+    memmove(&private->_levelIndex[0], &private->_levelIndex[skip],
+            sizeof(ktxLevelIndexEntry) * This->numLevels);
+    This->baseWidth = MAX(1, This->baseWidth >> skip);
+    if (This->numDimensions > 1)
+        This->baseHeight = MAX(1, This->baseHeight >> skip);
+    if (This->numDimensions > 2)
+        This->baseDepth = MAX(1, This->baseDepth >> skip);
+    return KTX_SUCCESS;
+}
+
 /**
  * @memberof ktxTexture2 @private
  * @~English
@@ -741,7 +864,7 @@ ktxTexture2_constructFromStreamAndHeader(ktxTexture2* This, ktxStream* pStream,
         goto cleanup;
     }
     This->pDfd =
-            (ktx_uint32_t*)malloc(pHeader->dataFormatDescriptor.byteLength);
+            (ktx_uint32_t*)ktxMalloc(pHeader->dataFormatDescriptor.byteLength);
     if (!This->pDfd) {
         result = KTX_OUT_OF_MEMORY;
         goto cleanup;
@@ -849,7 +972,7 @@ ktxTexture2_constructFromStreamAndHeader(ktxTexture2* This, ktxStream* pStream,
             ktx_uint32_t kvdLen = pHeader->keyValueData.byteLength;
             ktx_uint8_t* pKvd;
 
-            pKvd = malloc(kvdLen);
+            pKvd = ktxMalloc(kvdLen);
             if (pKvd == NULL) {
                 result = KTX_OUT_OF_MEMORY;
                 goto cleanup;
@@ -876,12 +999,13 @@ ktxTexture2_constructFromStreamAndHeader(ktxTexture2* This, ktxStream* pStream,
                 ktx_uint32_t animData[3];
                 ktx_uint32_t animDataLen;
 
-                result = ktxHashList_Deserialize(&This->kvDataHead,
-                                                 kvdLen, pKvd);
-                free(pKvd);
+                result = ktxHashList_DeserializeView(&This->kvDataHead,
+                                                     kvdLen, (void**)&pKvd);
                 if (result != KTX_SUCCESS) {
+                    ktxFree(pKvd);
                     goto cleanup;
                 }
+                This->_protected->_kvdBlock = pKvd;
 
                 result = ktxHashList_FindValue(&This->kvDataHead,
                                                KTX_ORIENTATION_KEY,
@@ -970,7 +1094,7 @@ ktxTexture2_constructFromStreamAndHeader(ktxTexture2* This, ktxStream* pStream,
 
         // Read supercompressionGlobalData
         private->_supercompressionGlobalData =
-          (ktx_uint8_t*)malloc(pHeader->supercompressionGlobalData.byteLength);
+          (ktx_uint8_t*)ktxMalloc(pHeader->supercompressionGlobalData.byteLength);
         if (!private->_supercompressionGlobalData) {
             result = KTX_OUT_OF_MEMORY;
             goto cleanup;
@@ -992,10 +1116,26 @@ ktxTexture2_constructFromStreamAndHeader(ktxTexture2* This, ktxStream* pStream,
         goto cleanup;
     }
 
+    if (createFlags & KTX_TEXTURE_CREATE_MAX_BASE_DIMENSION_MASK) {
+        ktx_uint32_t log2MaxDimension
+                = (createFlags & KTX_TEXTURE_CREATE_MAX_BASE_DIMENSION_MASK)
+                  >> 24;
+        result = ktxTexture2_skipLevels(This, 1U << log2MaxDimension);
+        if (result != KTX_SUCCESS)
+            goto cleanup;
+    }
+
     // Calculate size of the image data. Level 0 is the last level in the data.
     This->dataSize = private->_levelIndex[0].byteOffset
                      + private->_levelIndex[0].byteLength;
 
+    // A mapped file lives as long as the stream. Caller's memory does too
+    // when the caller has promised so. In either case pData can point
+    // into the source. Not on big-endian where the data must be swapped.
+    private->_canViewSource = pStream->type == eStreamTypeMappedFile
+        || (pStream->type == eStreamTypeMemory && !IS_BIG_ENDIAN
+            && (createFlags & KTX_TEXTURE_CREATE_BORROW_DATA_BIT));
+
     /*
      * Load the images, if requested.
      */
@@ -1131,7 +1271,10 @@ ktxTexture2_constructFromNamedFile(ktxTexture2* This,
     if (!file)
        return KTX_FILE_OPEN_FAILED;
 
-    result = ktxFileStream_construct(&stream, file, KTX_TRUE);
+    if (createFlags & KTX_TEXTURE_CREATE_MAP_FILE_BIT)
+        result = ktxMappedFileStream_construct(&stream, file, KTX_TRUE);
+    else
+        result = ktxFileStream_construct(&stream, file, KTX_TRUE);
     if (result == KTX_SUCCESS)
         result = ktxTexture2_constructFromStream(This, &stream, createFlags);
 
@@ -1186,15 +1329,98 @@ ktxTexture2_constructFromMemory(ktxTexture2* This,
 void
 ktxTexture2_destruct(ktxTexture2* This)
 {
-    if (This->pDfd) free(This->pDfd);
+    if (This->pDfd) ktxFree(This->pDfd);
     if (This->_private) {
       ktx_uint8_t* sgd = This->_private->_supercompressionGlobalData;
-      if (sgd) free(sgd);
-      free(This->_private);
+      if (sgd) ktxFree(sgd);
+      if (This->_private->_pDataIsView)
+          This->pData = NULL; // Released along with the stream.
+      else if (This->_private->_pDataRefCount)
+          ktxTexture2_freeData(This);
+      ktxFree(This->_private);
     }
     ktxTexture_destruct(ktxTexture(This));
 }
 
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Free the image data of a ktxTexture2.
+ *
+ * Used by functions that replace the image data. If @c pData is a view into
+ * the texture's source, the source is released instead. If it is shared
+ * with other textures, only this texture's reference is released.
+ *
+ * @param[in] This pointer to the ktxTexture2 whose data is to be freed.
+ */
+void
+ktxTexture2_freeData(ktxTexture2* This)
+{
+    DECLARE_PROTECTED(ktxTexture);
+    DECLARE_PRIVATE(ktxTexture2);
+
+    if (private->_pDataIsView) {
+        prtctd->_stream.destruct(&prtctd->_stream);
+        private->_pDataIsView = KTX_FALSE;
+    } else if (private->_pDataRefCount) {
+        if (ktxAtomicDecrement(private->_pDataRefCount) == 0) {
+            ktxFree(private->_pDataRefCount);
+            ktxFree(This->pData);
+        }
+        private->_pDataRefCount = NULL;
+    } else {
+        ktxFree(This->pData);
+    }
+    This->pData = NULL;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Make the image data of a ktxTexture2 memory that only it owns.
+ *
+ * Used by functions that modify the image data in place. If @c pData is
+ * shared with other textures or is a view into memory borrowed from the
+ * application, it is replaced by a copy. Views of memory-mapped files are
+ * left alone as the mapping is private and writable.
+ *
+ * @param[in] This pointer to the ktxTexture2 whose data is to be owned.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the copy.
+ */
+KTX_error_code
+ktxTexture2_ownData(ktxTexture2* This)
+{
+    DECLARE_PROTECTED(ktxTexture);
+    DECLARE_PRIVATE(ktxTexture2);
+    ktx_uint8_t* pData;
+
+    if (private->_pDataIsView) {
+        if (prtctd->_stream.type == eStreamTypeMappedFile)
+            return KTX_SUCCESS;
+    } else if (private->_pDataRefCount == NULL) {
+        return KTX_SUCCESS;
+    }
+
+    // Only textures holding a reference can add one, so when this is the
+    // last reference no other texture can race with us.
+    if (private->_pDataRefCount && *private->_pDataRefCount == 1) {
+        ktxFree(private->_pDataRefCount);
+        private->_pDataRefCount = NULL;
+        return KTX_SUCCESS;
+    }
+
+    pData = (ktx_uint8_t*)ktxMalloc(This->dataSize);
+    if (pData == NULL)
+        return KTX_OUT_OF_MEMORY;
+    memcpy(pData, This->pData, This->dataSize);
+    ktxTexture2_freeData(This);
+    This->pData = pData;
+    return KTX_SUCCESS;
+}
+
 /**
  * @memberof ktxTexture2
  * @ingroup writer
@@ -1248,13 +1474,13 @@ ktxTexture2_Create(ktxTextureCreateInfo* createInfo,
     if (newTex == NULL)
         return KTX_INVALID_VALUE;
 
-    ktxTexture2* tex = (ktxTexture2*)malloc(sizeof(ktxTexture2));
+    ktxTexture2* tex = (ktxTexture2*)ktxMalloc(sizeof(ktxTexture2));
     if (tex == NULL)
         return KTX_OUT_OF_MEMORY;
 
     result = ktxTexture2_construct(tex, createInfo, storageAllocation);
     if (result != KTX_SUCCESS) {
-        free(tex);
+        ktxFree(tex);
     } else {
         *newTex = tex;
     }
@@ -1286,13 +1512,13 @@ ktxTexture2_Create(ktxTextureCreateInfo* createInfo,
     if (newTex == NULL)
         return KTX_INVALID_VALUE;
 
-    ktxTexture2* tex = (ktxTexture2*)malloc(sizeof(ktxTexture2));
+    ktxTexture2* tex = (ktxTexture2*)ktxMalloc(sizeof(ktxTexture2));
     if (tex == NULL)
         return KTX_OUT_OF_MEMORY;
 
     result = ktxTexture2_constructCopy(tex, orig);
     if (result != KTX_SUCCESS) {
-        free(tex);
+        ktxFree(tex);
     } else {
         *newTex = tex;
     }
@@ -1300,6 +1526,61 @@ ktxTexture2_Create(ktxTextureCreateInfo* createInfo,
 
  }
 
+/**
+ * @memberof ktxTexture2
+ * @ingroup writer
+ * @~English
+ * @brief Create a ktxTexture2 by making a copy of a ktxTexture2 that shares
+ *        its image data.
+ *
+ * The image data is reference counted and shared by @p orig and the copy,
+ * so making the copy is cheap. Functions that replace the data, such as
+ * ktxTexture2_TranscodeBasis(), ktxTexture2_CompressBasis() or
+ * ktxTexture2_DeflateZstd(), release only the calling texture's reference.
+ * Functions that modify it in place, such as
+ * ktxTexture_SetImageFromMemory(), first give the calling texture its own
+ * copy. Everything else is copied as by ktxTexture2_CreateCopy().
+ *
+ * Applications must not write through @c pData of either texture while the
+ * data is shared, as the other texture would see the change. If @p orig's
+ * data is a view of a memory-mapped source, the copy gets its own data.
+ *
+ * Textures sharing data can be destroyed, or have their data replaced, on
+ * different threads.
+ *
+ * The address of the newly created ktxTexture2 is written to the location
+ * pointed at by @p newTex.
+ *
+ * @param[in]     orig   pointer to the texture to copy.
+ * @param[in,out] newTex pointer to a location in which store the address of
+ *                       the newly created texture.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p orig or @p newTex is @c NULL.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the texture.
+ */
+KTX_error_code
+ktxTexture2_CreateSharedCopy(ktxTexture2* orig, ktxTexture2** newTex)
+{
+    KTX_error_code result;
+
+    if (orig == NULL || newTex == NULL)
+        return KTX_INVALID_VALUE;
+
+    ktxTexture2* tex = (ktxTexture2*)ktxMalloc(sizeof(ktxTexture2));
+    if (tex == NULL)
+        return KTX_OUT_OF_MEMORY;
+
+    result = ktxTexture2_constructCopyInt(tex, orig, KTX_TRUE);
+    if (result != KTX_SUCCESS) {
+        ktxFree(tex);
+    } else {
+        *newTex = tex;
+    }
+    return result;
+}
+
 /**
  * @defgroup reader Reader
  * @brief Read KTX-formatted data.
@@ -1355,7 +1636,7 @@ ktxTexture2_CreateFromStdioStream(FILE* stdioStream,
     if (newTex == NULL)
         return KTX_INVALID_VALUE;
 
-    ktxTexture2* tex = (ktxTexture2*)malloc(sizeof(ktxTexture2));
+    ktxTexture2* tex = (ktxTexture2*)ktxMalloc(sizeof(ktxTexture2));
     if (tex == NULL)
         return KTX_OUT_OF_MEMORY;
 
@@ -1364,7 +1645,7 @@ ktxTexture2_CreateFromStdioStream(FILE* stdioStream,
     if (result == KTX_SUCCESS)
         *newTex = (ktxTexture2*)tex;
     else {
-        free(tex);
+        ktxFree(tex);
         *newTex = NULL;
     }
     return result;
@@ -1387,6 +1668,12 @@ ktxTexture2_CreateFromStdioStream(FILE* stdioStream,
  * provided solely to enable implementation of the @e libktx v1 API on top of
  * ktxTexture.
  *
+ * If the create flag KTX_TEXTURE_CREATE_MAP_FILE_BIT is set, the file is
+ * memory mapped, when possible, instead of being read through stdio. Loading
+ * the image data of a KTX2 file that is not supercompressed then points
+ * @c pData into the mapping instead of allocating memory and copying. The
+ * mapping is private so modifying the images does not change the file.
+ *
  * @param[in] filename    pointer to a char array containing the file name.
  * @param[in] createFlags bitmask requesting specific actions during creation.
  * @param[in,out] newTex  pointer to a location in which store the address of
@@ -1409,7 +1696,7 @@ ktxTexture2_CreateFromNamedFile(const char* const filename,
     if (newTex == NULL)
         return KTX_INVALID_VALUE;
 
-    ktxTexture2* tex = (ktxTexture2*)malloc(sizeof(ktxTexture2));
+    ktxTexture2* tex = (ktxTexture2*)ktxMalloc(sizeof(ktxTexture2));
     if (tex == NULL)
         return KTX_OUT_OF_MEMORY;
 
@@ -1417,7 +1704,7 @@ ktxTexture2_CreateFromNamedFile(const char* const filename,
     if (result == KTX_SUCCESS)
         *newTex = (ktxTexture2*)tex;
     else {
-        free(tex);
+        ktxFree(tex);
         *newTex = NULL;
     }
     return result;
@@ -1440,6 +1727,18 @@ ktxTexture2_CreateFromNamedFile(const char* const filename,
  * provided solely to enable implementation of the @e libktx v1 API on top of
  * ktxTexture.
  *
+ * If the create flag KTX_TEXTURE_CREATE_BORROW_DATA_BIT is set and the data
+ * is KTX2 that is not supercompressed, loading the image data into the
+ * texture does not copy it; @c pData points into @p bytes. The caller must
+ * then keep @p bytes valid and unchanged until the texture is destroyed or
+ * its image data is replaced, e.g. by transcoding or deflation. Functions
+ * that modify the images, such as ktxTexture_SetImageFromMemory(), first
+ * replace @c pData with a private copy so @p bytes is never written. The
+ * image pointers passed to the callbacks of ktxTexture_IterateLevels() and
+ * ktxTexture_IterateLevelFaces() point into @p bytes so the callbacks must
+ * not write through them. Without the flag, @p bytes may be freed as soon as
+ * the image data has been loaded.
+ *
  * @param[in] bytes pointer to the memory containing the serialized KTX data.
  * @param[in] size  length of the KTX data in bytes.
  * @param[in] createFlags bitmask requesting specific actions during creation.
@@ -1461,7 +1760,7 @@ ktxTexture2_CreateFromMemory(const ktx_uint8_t* bytes, ktx_size_t size,
     if (newTex == NULL)
         return KTX_INVALID_VALUE;
 
-    ktxTexture2* tex = (ktxTexture2*)malloc(sizeof(ktxTexture2));
+    ktxTexture2* tex = (ktxTexture2*)ktxMalloc(sizeof(ktxTexture2));
     if (tex == NULL)
         return KTX_OUT_OF_MEMORY;
 
@@ -1470,7 +1769,7 @@ ktxTexture2_CreateFromMemory(const ktx_uint8_t* bytes, ktx_size_t size,
     if (result == KTX_SUCCESS)
         *newTex = (ktxTexture2*)tex;
     else {
-        free(tex);
+        ktxFree(tex);
         *newTex = NULL;
     }
     return result;
@@ -1513,7 +1812,7 @@ ktxTexture2_CreateFromStream(ktxStream* stream,
     if (newTex == NULL)
         return KTX_INVALID_VALUE;
 
-    ktxTexture2* tex = (ktxTexture2*)malloc(sizeof(ktxTexture2));
+    ktxTexture2* tex = (ktxTexture2*)ktxMalloc(sizeof(ktxTexture2));
     if (tex == NULL)
         return KTX_OUT_OF_MEMORY;
 
@@ -1521,7 +1820,7 @@ ktxTexture2_CreateFromStream(ktxStream* stream,
     if (result == KTX_SUCCESS)
         *newTex = (ktxTexture2*)tex;
     else {
-        free(tex);
+        ktxFree(tex);
         *newTex = NULL;
     }
     return result;
@@ -1542,7 +1841,7 @@ void
 ktxTexture2_Destroy(ktxTexture2* This)
 {
     ktxTexture2_destruct(This);
-    free(This);
+    ktxFree(This);
 }
 
 /**
@@ -2096,6 +2395,321 @@ ktxTexture2_IterateLevels(ktxTexture2* This, PFNKTXITERCB iterCb, void* userdata
     return result;
 }
 
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Get a pointer to a range of the texture's source data, when it can
+ *        be accessed in place.
+ *
+ * @param[in] This   pointer to the ktxTexture2 object of interest.
+ * @param[in] offset offset of the range from the start of the source.
+ * @param[in] count  length of the range in bytes.
+ *
+ * @return pointer to the data or @c NULL, if the source must be read via the
+ *         stream.
+ */
+static ktx_uint8_t*
+ktxTexture2_viewSource(ktxTexture2* This, ktx_uint64_t offset,
+                       ktx_size_t count)
+{
+    ktxStream* stream = &This->_protected->_stream;
+    ktx_uint8_t* pView;
+    const ktx_uint8_t* pMemView;
+
+    switch (stream->type) {
+      case eStreamTypeMappedFile:
+        if (ktxMappedFileStream_getview(stream, (ktx_off_t)offset, count,
+                                        &pView) == KTX_SUCCESS)
+            return pView;
+        break;
+      case eStreamTypeMemory:
+        // The const is cast away only so that the view can become
+        // pData. Nothing in libktx writes through it: a texture whose
+        // pData is a view has _pDataIsView set and every function that
+        // writes to pData calls ktxTexture2_ownData() first, which
+        // replaces the view with a copy. Other callers only read from
+        // the view or pass it to iteration callbacks that are documented
+        // as not writing to it. See KTX_TEXTURE_CREATE_BORROW_DATA_BIT.
+        if (ktxMemStream_getview(stream, (ktx_off_t)offset, count,
+                                 &pMemView) == KTX_SUCCESS)
+            return (ktx_uint8_t*)pMemView;
+        break;
+      default:
+        break;
+    }
+    return NULL;
+}
+
+static KTX_error_code zstdErrorToKtx(size_t zstdResult);
+
+/*
+ * Buffers for reading and inflating one level while iterating. Two are used
+ * when reading ahead.
+ */
+typedef struct {
+    ktx_uint8_t* dataBuf;     /*!< Level as read, if not viewable. */
+    ktx_uint8_t* inflatedBuf; /*!< Level after inflation. */
+    ZSTD_DCtx* dctx;
+    ktxLevelTranscoder* xcoder; /*!< Set when transcoding levels. */
+    ktx_uint8_t* transcodedBuf; /*!< Level after transcoding. */
+    ktx_uint8_t* pData;       /*!< Level data ready for the callback. */
+    ktx_size_t levelSize;     /*!< Size of the data at pData. */
+    ktx_bool_t borrowed;      /*!< Buffers and dctx belong to a
+                                   ktxDecodeContext. */
+} ktxLevelBuffer;
+
+static KTX_error_code
+ktxLevelBuffer_construct(ktxLevelBuffer* buf, ktxTexture2* This,
+                         ktx_bool_t viewable, ktxDecodeContext* ctx,
+                         ktx_uint32_t slot, ktxLevelTranscoder* xcoder)
+{
+    ktxLevelIndexEntry* levelIndex = This->_private->_levelIndex;
+    ktx_size_t inflatedSize = levelIndex[0].uncompressedByteLength;
+
+    memset(buf, 0, sizeof(*buf));
+    buf->borrowed = ctx != NULL;
+    if (xcoder) {
+        buf->xcoder = xcoder;
+        buf->transcodedBuf
+                  = ktxMalloc(ktxLevelTranscoder_getMaxLevelSize(xcoder));
+        if (!buf->transcodedBuf)
+            return KTX_OUT_OF_MEMORY;
+    }
+    if (!viewable) {
+        // Allocate memory sufficient for the largest level as stored. A
+        // supercompressed small level can be larger than the base level.
+        ktx_size_t maxByteLength = 0;
+        for (ktx_uint32_t level = 0; level < This->numLevels; level++)
+            maxByteLength = MAX(maxByteLength, levelIndex[level].byteLength);
+        if (ctx)
+            buf->dataBuf = ktxDecodeContext_getBuffer(ctx,
+                                    slot ? KTX_DECODE_READ_BUFFER1
+                                         : KTX_DECODE_READ_BUFFER0,
+                                    maxByteLength);
+        else
+            buf->dataBuf = ktxMalloc(maxByteLength);
+        if (!buf->dataBuf)
+            return KTX_OUT_OF_MEMORY;
+    }
+    if (This->supercompressionScheme == KTX_SS_ZSTD
+        || This->supercompressionScheme == KTX_SS_ZLIB) {
+        if (ctx)
+            buf->inflatedBuf = ktxDecodeContext_getBuffer(ctx,
+                                    slot ? KTX_DECODE_INFLATE_BUFFER1
+                                         : KTX_DECODE_INFLATE_BUFFER0,
+                                    inflatedSize);
+        else
+            buf->inflatedBuf = ktxMalloc(inflatedSize);
+        if (!buf->inflatedBuf)
+            return KTX_OUT_OF_MEMORY;
+        if (This->supercompressionScheme == KTX_SS_ZSTD) {
+            if (ctx)
+                buf->dctx = ktxDecodeContext_getDCtx(ctx, slot);
+            else
+                buf->dctx = ktxZSTD_createDCtx();
+            if (!buf->dctx)
+                return KTX_OUT_OF_MEMORY;
+        }
+    }
+    return KTX_SUCCESS;
+}
+
+static void
+ktxLevelBuffer_destruct(ktxLevelBuffer* buf)
+{
+    ktxFree(buf->transcodedBuf);
+    if (buf->borrowed)
+        return;
+    ktxFree(buf->dataBuf);
+    ktxFree(buf->inflatedBuf);
+    if (buf->dctx) ZSTD_freeDCtx(buf->dctx);
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Read, and inflate and transcode if necessary, a level into a
+ *        ktxLevelBuffer.
+ *
+ * @param[in] This     pointer to the ktxTexture2 object of interest.
+ * @param[in] level    the level to read.
+ * @param[in] viewable whether the level can be used in place in the source.
+ * @param[in,out] buf  the buffer to read into. pData and levelSize are set
+ *                     on success.
+ */
+static KTX_error_code
+ktxTexture2_readLevelInt(ktxTexture2* This, ktx_uint32_t level,
+                         ktx_bool_t viewable, ktxLevelBuffer* buf)
+{
+    DECLARE_PROTECTED(ktxTexture);
+    ktxStream* stream = (ktxStream *)&prtctd->_stream;
+    ktxLevelIndexEntry* levelIndex = This->_private->_levelIndex;
+    ktx_size_t levelSize = levelIndex[level].byteLength;
+    ktx_uint8_t* pLevelData;
+    KTX_error_code result;
+
+    if (levelIndex[0].uncompressedByteLength
+        < levelIndex[level].uncompressedByteLength) {
+        // Levels cannot be larger than the base level
+        return KTX_FILE_DATA_ERROR;
+    }
+
+    if (viewable) {
+        pLevelData = ktxTexture2_viewSource(This,
+                                  ktxTexture2_levelFileOffset(This, level),
+                                  levelSize);
+        if (pLevelData == NULL)
+            return KTX_FILE_UNEXPECTED_EOF;
+    } else {
+        // Use setpos so we skip any padding.
+        result = stream->setpos(stream,
+                                ktxTexture2_levelFileOffset(This, level));
+        if (result != KTX_SUCCESS)
+            return result;
+
+        result = stream->read(stream, buf->dataBuf, levelSize);
+        if (result != KTX_SUCCESS)
+            return result;
+        pLevelData = buf->dataBuf;
+    }
+
+    if (This->supercompressionScheme == KTX_SS_ZSTD) {
+        levelSize = ZSTD_decompressDCtx(buf->dctx, buf->inflatedBuf,
+                                        levelIndex[0].uncompressedByteLength,
+                                        pLevelData, levelSize);
+        if (ZSTD_isError(levelSize))
+            return zstdErrorToKtx(levelSize);
+        // We don't fix up the texture's dataSize, levelIndex or
+        // _requiredAlignment because after iteration completes there
+        // is no way to get at the texture's data.
+        buf->pData = buf->inflatedBuf;
+    } else if (This->supercompressionScheme == KTX_SS_ZLIB) {
+        ktx_size_t inflatedSize = levelIndex[0].uncompressedByteLength;
+        result = ktxUncompressZLIBInt(buf->inflatedBuf, &inflatedSize,
+                                      pLevelData, levelSize);
+        if (result != KTX_SUCCESS)
+            return result;
+        levelSize = inflatedSize;
+        buf->pData = buf->inflatedBuf;
+    } else {
+        buf->pData = pLevelData;
+    }
+
+    // BasisLZ levels have no uncompressed length.
+    if (This->supercompressionScheme != KTX_SS_BASIS_LZ
+        && levelIndex[level].uncompressedByteLength != levelSize)
+        return KTX_DECOMPRESS_LENGTH_ERROR;
+
+#if IS_BIG_ENDIAN
+    switch (prtctd->_typeSize) {
+      case 2:
+        _ktxSwapEndian16((ktx_uint16_t*)buf->pData, levelSize / 2);
+        break;
+      case 4:
+        _ktxSwapEndian32((ktx_uint32_t*)buf->pData, levelSize / 4);
+        break;
+      case 8:
+        _ktxSwapEndian64((ktx_uint64_t*)buf->pData, levelSize / 8);
+        break;
+    }
+#endif
+
+    if (buf->xcoder) {
+        result = ktxLevelTranscoder_transcode(buf->xcoder, level, buf->pData,
+                                              levelSize, buf->transcodedBuf,
+                                              &levelSize);
+        if (result != KTX_SUCCESS)
+            return result;
+        buf->pData = buf->transcodedBuf;
+    }
+
+    buf->levelSize = levelSize;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Pass the images of a level read by ktxTexture2_readLevelInt() to
+ *        an iteration callback.
+ */
+static KTX_error_code
+ktxTexture2_iterateLevelInt(ktxTexture2* This, ktx_uint32_t level,
+                            ktxLevelBuffer* buf,
+                            PFNKTXITERCB iterCb, void* userdata)
+{
+    ktxTexture_protected* prtctd;
+    GLsizei width, height, depth;
+    KTX_error_code result = KTX_SUCCESS;
+
+    // Transcoded levels have the sizes of the transcoded format.
+    if (buf->xcoder)
+        This = ktxLevelTranscoder_getPrototype(buf->xcoder);
+    prtctd = This->_protected;
+
+    // Array textures have the same number of layers at each mip level.
+    width = MAX(1, This->baseWidth  >> level);
+    height = MAX(1, This->baseHeight >> level);
+    depth = MAX(1, This->baseDepth  >> level);
+
+    // With the exception of non-array cubemaps the entire level
+    // is passed at once because that is how OpenGL and Vulkan need them.
+    // Vulkan could take all the faces at once too but we iterate
+    // them separately for OpenGL.
+    if (This->isCubemap && !This->isArray) {
+        ktx_uint8_t* pFace = buf->pData;
+        struct blockCount {
+            ktx_uint32_t x, y;
+        } blockCount;
+        ktx_size_t faceSize;
+
+        blockCount.x
+          = (uint32_t)ceilf((float)width / prtctd->_formatSize.blockWidth);
+        blockCount.y
+          = (uint32_t)ceilf((float)height / prtctd->_formatSize.blockHeight);
+        blockCount.x = MAX(prtctd->_formatSize.minBlocksX, blockCount.x);
+        blockCount.y = MAX(prtctd->_formatSize.minBlocksX, blockCount.y);
+        faceSize = blockCount.x * blockCount.y
+                   * prtctd->_formatSize.blockSizeInBits / 8;
+
+        for (ktx_uint32_t face = 0; face < This->numFaces; ++face) {
+            result = iterCb(level, face,
+                            width, height, depth,
+                            (ktx_uint32_t)faceSize, pFace, userdata);
+            pFace += faceSize;
+            if (result != KTX_SUCCESS)
+                break;
+        }
+    } else {
+        result = iterCb(level, 0,
+                        width, height, depth,
+                        (ktx_uint32_t)buf->levelSize, buf->pData, userdata);
+    }
+    return result;
+}
+
+/*
+ * Reading of the next level on the read-ahead worker while the calling
+ * thread, which may be bound to a graphics context, passes the current
+ * level to the callback.
+ */
+typedef struct {
+    ktxTexture2* texture;
+    ktx_bool_t viewable;
+    ktx_uint32_t level;
+    ktxLevelBuffer* buffer;
+    KTX_error_code result;
+} ktxReadAheadJob;
+
+static void
+readAheadWorker(void* payload)
+{
+    ktxReadAheadJob* job = (ktxReadAheadJob*)payload;
+
+    job->result = ktxTexture2_readLevelInt(job->texture, job->level,
+                                           job->viewable, job->buffer);
+}
+
 /**
  * @memberof ktxTexture2
  * @~English
@@ -2107,7 +2721,10 @@ ktxTexture2_IterateLevels(ktxTexture2* This, PFNKTXITERCB iterCb, void* userdata
  * while iterating. If supercompressionScheme == KTX_SS_ZSTD or KTX_SS_ZLIB,
  * it will inflate the data before passing it to the callback. The callback function
  * must copy the image data if it wishes to preserve it as the temporary buffer
- * is reused for each level and is freed when this function exits.
+ * is reused for each level and is freed when this function exits. When the
+ * source is in memory or a mapped file and is not supercompressed, the
+ * callback may instead be passed pointers into the source itself so it must
+ * not write to the image data.
  *
  * This function is helpful for reducing memory usage when uploading the data
  * to a graphics API.
@@ -2116,11 +2733,30 @@ ktxTexture2_IterateLevels(ktxTexture2* This, PFNKTXITERCB iterCb, void* userdata
  * KTX_SS_ZSTD or KTX_SS_ZLIB. As there is no access to the ktxTexture's data on
  * conclusion of this function, destroying the texture on completion is recommended.
  *
+ * If @p params->readAhead is set, the next level is read and inflated on a
+ * second thread, into a second temporary buffer, while the callback
+ * consumes the current one. The callback is always called on the calling
+ * thread. One thread is used for the whole iteration. Textures created
+ * from a custom ktxStream are never read ahead because its callbacks may
+ * only work on the calling thread, e.g. when they call into a managed
+ * runtime.
+ *
+ * If @p params->transcode is set, BasisLZ/ETC1S and UASTC textures are
+ * transcoded a level at a time to @p params->transcodeFormat as they are
+ * read, so neither the whole supercompressed data nor the whole transcoded
+ * texture is ever in memory. The callback receives the transcoded images
+ * and sizes. The images of a level are transcoded on
+ * @p params->threadCount threads. When iteration completes the texture's
+ * format, DFD and level index describe the transcoded format, as after
+ * ktxTexture2_TranscodeBasis().
+ *
  * @param[in]     This     pointer to the ktxTexture2 object of interest.
  * @param[in,out] iterCb   the address of a callback function which is called
  *                         with the data for each image.
  * @param[in,out] userdata the address of application-specific data which is
  *                         passed to the callback along with the image data.
+ * @param[in]     params   pointer to a ktxLoadParams struct specifying
+ *                         whether to read ahead.
  *
  * @return  KTX_SUCCESS on success, other KTX_* enum values on error. The
  *          following are returned directly by this function. @p iterCb may
@@ -2135,32 +2771,45 @@ ktxTexture2_IterateLevels(ktxTexture2* This, PFNKTXITERCB iterCb, void* userdata
  * @exception KTX_INVALID_OPERATION
  *                          supercompressionScheme != KTX_SS_NONE,
  *                          supercompressionScheme != KTX_SS_ZSTD, and
- *                          supercompressionScheme != KTX_SS_ZLIB.
- * @exception KTX_INVALID_VALUE     @p This is @c NULL or @p iterCb is @c NULL.
- * @exception KTX_OUT_OF_MEMORY     not enough memory to allocate a block to
- *                                  hold the base level image.
+ *                          supercompressionScheme != KTX_SS_ZLIB and the
+ *                          texture is not being transcoded.
+ * @exception KTX_TRANSCODE_FAILED  a level could not be transcoded. The
+ *                                  other transcoding errors of
+ *                                  ktxTexture2_TranscodeBasis() may also be
+ *                                  returned.
+ * @exception KTX_INVALID_VALUE     @p This, @p iterCb or @p params is
+ *                                  @c NULL or @p params->structSize is
+ *                                  incorrect.
+ * @exception KTX_OUT_OF_MEMORY     not enough memory to allocate the blocks
+ *                                  to hold the base level image.
  */
 KTX_error_code
-ktxTexture2_IterateLoadLevelFaces(ktxTexture2* This, PFNKTXITERCB iterCb,
-                                  void* userdata)
+ktxTexture2_IterateLoadLevelFacesEx(ktxTexture2* This, PFNKTXITERCB iterCb,
+                                    void* userdata, ktxLoadParams* params)
 {
     DECLARE_PROTECTED(ktxTexture);
-    ktxStream* stream = (ktxStream *)&prtctd->_stream;
-    ktxLevelIndexEntry* levelIndex;
-    ktx_size_t      dataSize = 0, uncompressedDataSize = 0;
-    KTX_error_code  result = KTX_SUCCESS;
-    ktx_uint8_t*    dataBuf = NULL;
-    ktx_uint8_t*    uncompressedDataBuf = NULL;
-    ktx_uint8_t*    pData;
-    ZSTD_DCtx*      dctx = NULL;
+    ktxLevelBuffer  buffers[2];
+    ktxLevelBuffer* current = &buffers[0];
+    ktxLevelBuffer* next = &buffers[1];
+    ktxLevelTranscoder* xcoder = NULL;
+    ktxWorker*      worker = NULL;
+    ktx_bool_t      transcode;
+    ktx_bool_t      viewable;
+    ktx_bool_t      readAhead;
+    KTX_error_code  result;
+
+    if (This == NULL || params == NULL)
+        return KTX_INVALID_VALUE;
 
-    if (This == NULL)
+    if (params->structSize != sizeof(struct ktxLoadParams))
         return KTX_INVALID_VALUE;
 
     if (This->classId != ktxTexture2_c)
         return KTX_INVALID_OPERATION;
 
-    if (This->supercompressionScheme != KTX_SS_NONE &&
+    transcode = params->transcode && ktxTexture2_NeedsTranscoding(This);
+    if (!transcode &&
+        This->supercompressionScheme != KTX_SS_NONE &&
         This->supercompressionScheme != KTX_SS_ZSTD &&
         This->supercompressionScheme != KTX_SS_ZLIB)
         return KTX_INVALID_OPERATION;
@@ -2168,168 +2817,171 @@ ktxTexture2_IterateLoadLevelFaces(ktxTexture2* This, PFNKTXITERCB iterCb,
     if (iterCb == NULL)
         return KTX_INVALID_VALUE;
 
-    if (prtctd->_stream.data.file == NULL)
+    if (prtctd->_stream.data.file == NULL || This->pData != NULL)
         // This Texture not created from a stream or images are already loaded.
         return KTX_INVALID_OPERATION;
 
-    levelIndex = This->_private->_levelIndex;
+    // Levels can be used in place when the source is mapped or in memory,
+    // except on big-endian where they are swapped.
+    viewable = !IS_BIG_ENDIAN
+               && ktxTexture2_viewSource(This,
+                                 ktxTexture2_levelFileOffset(This, 0),
+                                 This->_private->_levelIndex[0].byteLength)
+                  != NULL;
+    // Nothing to overlap with the callback if levels are used in place.
+    readAhead = params->readAhead && This->numLevels > 1
+                && prtctd->_stream.type != eStreamTypeCustom
+                && (!viewable || This->supercompressionScheme != KTX_SS_NONE
+                    || transcode);
+
+    if (transcode) {
+        result = ktxLevelTranscoder_create(This, params->transcodeFormat,
+                                           params->transcodeFlags,
+                                           params->threadCount, &xcoder);
+        if (result != KTX_SUCCESS)
+            return result;
+    }
 
-    // Allocate memory sufficient for the base level
-    dataSize = levelIndex[0].byteLength;
-    dataBuf = malloc(dataSize);
-    if (!dataBuf)
-        return KTX_OUT_OF_MEMORY;
-    if (This->supercompressionScheme == KTX_SS_ZSTD || This->supercompressionScheme == KTX_SS_ZLIB) {
-        uncompressedDataSize = levelIndex[0].uncompressedByteLength;
-        uncompressedDataBuf = malloc(uncompressedDataSize);
-        if (!uncompressedDataBuf) {
-            result = KTX_OUT_OF_MEMORY;
-            goto cleanup;
-        }
-        if (This->supercompressionScheme == KTX_SS_ZSTD) {
-            dctx = ZSTD_createDCtx();
-        }
-        pData = uncompressedDataBuf;
-    } else {
-        pData = dataBuf;
+    memset(buffers, 0, sizeof(buffers));
+    result = ktxLevelBuffer_construct(current, This, viewable,
+                                      params->decodeContext, 0, xcoder);
+    if (result == KTX_SUCCESS && readAhead) {
+        result = ktxLevelBuffer_construct(next, This, viewable,
+                                          params->decodeContext, 1, xcoder);
+        // Without a thread, iterate without reading ahead.
+        if (result == KTX_SUCCESS)
+            worker = ktxWorker_create();
+        readAhead = worker != NULL;
     }
+    if (result != KTX_SUCCESS)
+        goto cleanup;
+
+    result = ktxTexture2_readLevelInt(This, This->numLevels - 1, viewable,
+                                      current);
+    if (result != KTX_SUCCESS)
+        goto cleanup;
 
     for (ktx_int32_t level = This->numLevels - 1; level >= 0; --level)
     {
-        ktx_size_t   levelSize;
-        GLsizei      width, height, depth;
-
-        // Array textures have the same number of layers at each mip level.
-        width = MAX(1, This->baseWidth  >> level);
-        height = MAX(1, This->baseHeight >> level);
-        depth = MAX(1, This->baseDepth  >> level);
-
-        levelSize = levelIndex[level].byteLength;
-        if (dataSize < levelSize) {
-            // Levels cannot be larger than the base level
-            result = KTX_FILE_DATA_ERROR;
-            goto cleanup;
+        if (readAhead && level > 0) {
+            ktxReadAheadJob job;
+            ktxLevelBuffer* tmp;
+
+            job.texture = This;
+            job.viewable = viewable;
+            job.level = level - 1;
+            job.buffer = next;
+            ktxWorker_submit(worker, readAheadWorker, &job);
+            result = ktxTexture2_iterateLevelInt(This, level, current,
+                                                 iterCb, userdata);
+            ktxWorker_wait(worker);
+            if (result == KTX_SUCCESS)
+                result = job.result;
+            tmp = current; current = next; next = tmp;
+        } else {
+            result = ktxTexture2_iterateLevelInt(This, level, current,
+                                                 iterCb, userdata);
+            if (result == KTX_SUCCESS && level > 0)
+                result = ktxTexture2_readLevelInt(This, level - 1, viewable,
+                                                  current);
         }
-
-        // Use setpos so we skip any padding.
-        result = stream->setpos(stream,
-                                ktxTexture2_levelFileOffset(This, level));
         if (result != KTX_SUCCESS)
             goto cleanup;
-
-        result = stream->read(stream, dataBuf, levelSize);
-        if (result != KTX_SUCCESS)
-            goto cleanup;
-
-        if (This->supercompressionScheme == KTX_SS_ZSTD) {
-            levelSize =
-                ZSTD_decompressDCtx(dctx, uncompressedDataBuf,
-                                  uncompressedDataSize,
-                                  dataBuf,
-                                  levelSize);
-            if (ZSTD_isError(levelSize)) {
-                ZSTD_ErrorCode error = ZSTD_getErrorCode(levelSize);
-                switch(error) {
-                  case ZSTD_error_dstSize_tooSmall:
-                    return KTX_DECOMPRESS_LENGTH_ERROR; // inflatedDataCapacity too small.
-                  case ZSTD_error_checksum_wrong:
-                    return KTX_DECOMPRESS_CHECKSUM_ERROR;
-                  case ZSTD_error_memory_allocation:
-                    return KTX_OUT_OF_MEMORY;
-                  default:
-                    return KTX_FILE_DATA_ERROR;
-                }
-            }
-
-            // We don't fix up the texture's dataSize, levelIndex or
-            // _requiredAlignment because after this function completes there
-            // is no way to get at the texture's data.
-            //nindex[level].byteOffset = levelOffset;
-            //nindex[level].uncompressedByteLength = nindex[level].byteLength =
-                                                                //levelByteLength;
-        } else if (This->supercompressionScheme == KTX_SS_ZLIB) {
-            result = ktxUncompressZLIBInt(uncompressedDataBuf,
-                                            &uncompressedDataSize,
-                                            dataBuf,
-                                            levelSize);
-            if (result != KTX_SUCCESS)
-                return result;
-        }
-
-        if (levelIndex[level].uncompressedByteLength != levelSize)
-            return KTX_DECOMPRESS_LENGTH_ERROR;
-
-#if IS_BIG_ENDIAN
-        switch (prtctd->_typeSize) {
-          case 2:
-            _ktxSwapEndian16((ktx_uint16_t*)pData, levelSize / 2);
-            break;
-          case 4:
-            _ktxSwapEndian32((ktx_uint32_t*)pDest, levelSize / 4);
-            break;
-          case 8:
-            _ktxSwapEndian64((ktx_uint64_t*)pDest, levelSize / 8);
-            break;
-        }
-#endif
-
-        // With the exception of non-array cubemaps the entire level
-        // is passed at once because that is how OpenGL and Vulkan need them.
-        // Vulkan could take all the faces at once too but we iterate
-        // them separately for OpenGL.
-        if (This->isCubemap && !This->isArray) {
-            ktx_uint8_t* pFace = pData;
-            struct blockCount {
-                ktx_uint32_t x, y;
-            } blockCount;
-            ktx_size_t faceSize;
-
-            blockCount.x
-              = (uint32_t)ceilf((float)width / prtctd->_formatSize.blockWidth);
-            blockCount.y
-              = (uint32_t)ceilf((float)height / prtctd->_formatSize.blockHeight);
-            blockCount.x = MAX(prtctd->_formatSize.minBlocksX, blockCount.x);
-            blockCount.y = MAX(prtctd->_formatSize.minBlocksX, blockCount.y);
-            faceSize = blockCount.x * blockCount.y
-                       * prtctd->_formatSize.blockSizeInBits / 8;
-
-            for (ktx_uint32_t face = 0; face < This->numFaces; ++face) {
-                result = iterCb(level, face,
-                                width, height, depth,
-                                (ktx_uint32_t)faceSize, pFace, userdata);
-                pFace += faceSize;
-                if (result != KTX_SUCCESS)
-                    goto cleanup;
-            }
-        } else {
-            result = iterCb(level, 0,
-                             width, height, depth,
-                             (ktx_uint32_t)levelSize, pData, userdata);
-            if (result != KTX_SUCCESS)
-                goto cleanup;
-       }
     }
 
     // No further need for this.
-    stream->destruct(stream);
+    prtctd->_stream.destruct(&prtctd->_stream);
     This->_private->_firstLevelFileOffset = 0;
+    if (xcoder)
+        ktxLevelTranscoder_adoptFormat(xcoder);
 cleanup:
-    free(dataBuf);
-    if (uncompressedDataBuf) free(uncompressedDataBuf);
-    if (dctx) ZSTD_freeDCtx(dctx);
+    if (worker)
+        ktxWorker_destroy(worker);
+    ktxLevelBuffer_destruct(&buffers[0]);
+    ktxLevelBuffer_destruct(&buffers[1]);
+    if (xcoder)
+        ktxLevelTranscoder_destroy(xcoder);
 
     return result;
 }
 
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Iterate over the images in a ktxTexture2 object while loading the
+ *        image data.
+ *
+ * This operates similarly to ktxTexture_IterateLevelFaces() except that it
+ * loads the images from the ktxTexture2's source to a temporary buffer
+ * while iterating. If supercompressionScheme == KTX_SS_ZSTD or KTX_SS_ZLIB,
+ * it will inflate the data before passing it to the callback. The callback function
+ * must copy the image data if it wishes to preserve it as the temporary buffer
+ * is reused for each level and is freed when this function exits. When the
+ * source is in memory or a mapped file and is not supercompressed, the
+ * callback may instead be passed pointers into the source itself so it must
+ * not write to the image data.
+ *
+ * This function is helpful for reducing memory usage when uploading the data
+ * to a graphics API.
+ *
+ * Intended for use only when supercompressionScheme == KTX_SS_NONE,
+ * KTX_SS_ZSTD or KTX_SS_ZLIB. As there is no access to the ktxTexture's data on
+ * conclusion of this function, destroying the texture on completion is recommended.
+ *
+ * Equivalent to ktxTexture2_IterateLoadLevelFacesEx() without read-ahead.
+ *
+ * @param[in]     This     pointer to the ktxTexture2 object of interest.
+ * @param[in,out] iterCb   the address of a callback function which is called
+ *                         with the data for each image.
+ * @param[in,out] userdata the address of application-specific data which is
+ *                         passed to the callback along with the image data.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error. The
+ *          following are returned directly by this function. @p iterCb may
+ *          return these for other causes or may return additional errors.
+ *
+ * @exception KTX_FILE_DATA_ERROR   mip level sizes are increasing not
+ *                                  decreasing
+ * @exception KTX_INVALID_OPERATION the ktxTexture2 was not created from a
+ *                                  stream, i.e there is no data to load, or
+ *                                  this ktxTexture2's images have already
+ *                                  been loaded.
+ * @exception KTX_INVALID_OPERATION
+ *                          supercompressionScheme != KTX_SS_NONE,
+ *                          supercompressionScheme != KTX_SS_ZSTD, and
+ *                          supercompressionScheme != KTX_SS_ZLIB.
+ * @exception KTX_INVALID_VALUE     @p This is @c NULL or @p iterCb is @c NULL.
+ * @exception KTX_OUT_OF_MEMORY     not enough memory to allocate a block to
+ *                                  hold the base level image.
+ */
+KTX_error_code
+ktxTexture2_IterateLoadLevelFaces(ktxTexture2* This, PFNKTXITERCB iterCb,
+                                  void* userdata)
+{
+    ktxLoadParams params = {0};
+
+    params.structSize = sizeof(params);
+    return ktxTexture2_IterateLoadLevelFacesEx(This, iterCb, userdata,
+                                               &params);
+}
+
 KTX_error_code
 ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
                            ktx_uint8_t* pInflatedData,
-                           ktx_size_t inflatedDataCapacity);
+                           ktx_size_t inflatedDataCapacity,
+                           ktxLoadParams* params);
 
 KTX_error_code
 ktxTexture2_inflateZLIBInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
                            ktx_uint8_t* pInflatedData,
-                           ktx_size_t inflatedDataCapacity);
+                           ktx_size_t inflatedDataCapacity,
+                           ktxLoadParams* params);
+
+static KTX_error_code
+ktxTexture2_inflateFromStreamInt(ktxTexture2* This,
+                                 ktx_uint8_t* pInflatedData,
+                                 ktx_size_t inflatedDataCapacity,
+                                 ktxDecodeContext* ctx);
 
 /**
  * @memberof ktxTexture2
@@ -2346,6 +2998,13 @@ ktxTexture2_inflateZLIBInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
  * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
  * all be updated after successful inflation to reflect the inflated data.
  *
+ * If the texture was created with @c KTX_TEXTURE_CREATE_MAP_FILE_BIT or
+ * @c KTX_TEXTURE_CREATE_BORROW_DATA_BIT, the data is not supercompressed and
+ * @p pBuffer is @c NULL, no memory is allocated; @c pData is set to point to
+ * the image data within the mapped file or the caller's memory. Deflated
+ * data in a mapped file or in memory is always inflated directly from the
+ * source without an intermediate copy.
+ *
  * @param[in] This pointer to the ktxTexture object of interest.
  * @param[in] pBuffer pointer to the buffer in which to load the image data.
  * @param[in] bufSize size of the buffer pointed at by @p pBuffer.
@@ -2363,17 +3022,63 @@ KTX_error_code
 ktxTexture2_LoadImageData(ktxTexture2* This,
                           ktx_uint8_t* pBuffer, ktx_size_t bufSize)
 {
-    DECLARE_PROTECTED(ktxTexture);
-    DECLARE_PRIVATE(ktxTexture2);
+    ktxLoadParams params = {0};
+    params.structSize = sizeof(params);
+    params.threadCount = 1;
+
+    return ktxTexture2_LoadImageDataEx(This, pBuffer, bufSize, &params);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Load all the image data from the ktxTexture2's source with extended
+ *        parameters.
+ *
+ * Behaves as ktxTexture2_LoadImageData() except as modified by @p params.
+ *
+ * With a @c threadCount greater than 1, the mip levels of Zstd or ZLIB
+ * supercompressed textures are inflated concurrently, each directly into its
+ * final location. A Zstd level made of several frames, each recording its
+ * content size, is further split so that its frames are inflated
+ * concurrently. This is how large base levels should be deflated to benefit
+ * most from multiple threads.
+ *
+ * @param[in] This pointer to the ktxTexture object of interest.
+ * @param[in] pBuffer pointer to the buffer in which to load the image data.
+ * @param[in] bufSize size of the buffer pointed at by @p pBuffer.
+ * @param[in] params pointer to a ktxLoadParams struct.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p params is NULL.
+ * @exception KTX_INVALID_VALUE @c params->structSize is not the size of
+ *                              a ktxLoadParams struct.
+ *
+ * For other exceptions, see ktxTexture2_LoadImageData().
+ */
+KTX_error_code
+ktxTexture2_LoadImageDataEx(ktxTexture2* This,
+                            ktx_uint8_t* pBuffer, ktx_size_t bufSize,
+                            ktxLoadParams* params)
+{
     ktx_uint8_t*    pDest;
     ktx_uint8_t*    pDeflatedData = 0;
     ktx_uint8_t*    pReadBuf;
+    ktx_uint8_t*    pSourceView;
     KTX_error_code  result = KTX_SUCCESS;
-    ktx_size_t inflatedDataCapacity = ktxTexture2_GetDataSizeUncompressed(This);
+    ktx_size_t      inflatedDataCapacity;
 
-    if (This == NULL)
+    if (This == NULL || params == NULL)
         return KTX_INVALID_VALUE;
 
+    if (params->structSize != sizeof(struct ktxLoadParams))
+        return KTX_INVALID_VALUE;
+
+    DECLARE_PROTECTED(ktxTexture);
+    DECLARE_PRIVATE(ktxTexture2);
+    inflatedDataCapacity = ktxTexture2_GetDataSizeUncompressed(This);
+
     if (This->pData != NULL)
         return KTX_INVALID_OPERATION; // Data already loaded.
 
@@ -2381,10 +3086,19 @@ ktxTexture2_LoadImageData(ktxTexture2* This,
         // This Texture not created from a stream or images already loaded;
         return KTX_INVALID_OPERATION;
 
+    pSourceView = ktxTexture2_viewSource(This, private->_firstLevelFileOffset,
+                                         This->dataSize);
+
     if (pBuffer == NULL) {
-        This->pData = malloc(inflatedDataCapacity);
-        if (This->pData == NULL)
-            return KTX_OUT_OF_MEMORY;
+        if (pSourceView != NULL && private->_canViewSource
+            && This->supercompressionScheme == KTX_SS_NONE) {
+            This->pData = pSourceView;
+            private->_pDataIsView = KTX_TRUE;
+        } else {
+            This->pData = ktxMalloc(inflatedDataCapacity);
+            if (This->pData == NULL)
+                return KTX_OUT_OF_MEMORY;
+        }
         pDest = This->pData;
     } else if (bufSize < inflatedDataCapacity) {
         return KTX_INVALID_VALUE;
@@ -2392,45 +3106,72 @@ ktxTexture2_LoadImageData(ktxTexture2* This,
         pDest = pBuffer;
     }
 
-    if (This->supercompressionScheme == KTX_SS_ZSTD || This->supercompressionScheme == KTX_SS_ZLIB) {
-        // Create buffer to hold deflated data.
-        pDeflatedData = malloc(This->dataSize);
-        if (pDeflatedData == NULL)
-            return KTX_OUT_OF_MEMORY;
-        pReadBuf = pDeflatedData;
+    if (pSourceView == NULL && params->threadCount <= 1
+        && (This->supercompressionScheme == KTX_SS_ZSTD
+            || This->supercompressionScheme == KTX_SS_ZLIB)) {
+        // Inflate while reading so only a chunk of the deflated data is
+        // ever held in memory.
+        result = ktxTexture2_inflateFromStreamInt(This, pDest,
+                                                  inflatedDataCapacity,
+                                                  params->decodeContext);
+        if (result != KTX_SUCCESS)
+            goto cleanup;
     } else {
-        pReadBuf = pDest;
-    }
-
-    // Seek to data for first level as there may be padding between the
-    // metadata/sgd and the image data.
+        if (This->supercompressionScheme == KTX_SS_ZSTD || This->supercompressionScheme == KTX_SS_ZLIB) {
+            if (pSourceView != NULL) {
+                pReadBuf = pSourceView;
+            } else {
+                // Create buffer to hold deflated data.
+                if (params->decodeContext) {
+                    pReadBuf = ktxDecodeContext_getBuffer(
+                                                params->decodeContext,
+                                                KTX_DECODE_READ_BUFFER0,
+                                                This->dataSize);
+                } else {
+                    pDeflatedData = ktxMalloc(This->dataSize);
+                    pReadBuf = pDeflatedData;
+                }
+                if (pReadBuf == NULL) {
+                    result = KTX_OUT_OF_MEMORY;
+                    goto cleanup;
+                }
+            }
+        } else {
+            pReadBuf = pDest;
+        }
 
-    result = prtctd->_stream.setpos(&prtctd->_stream,
-                                    private->_firstLevelFileOffset);
-    if (result != KTX_SUCCESS)
-        return result;
+        if (pSourceView != NULL) {
+            if (pReadBuf != pSourceView)
+                memcpy(pReadBuf, pSourceView, This->dataSize);
+        } else {
+            // Seek to data for first level as there may be padding between
+            // the metadata/sgd and the image data.
 
-    result = prtctd->_stream.read(&prtctd->_stream, pReadBuf,
-                                  This->dataSize);
-    if (result != KTX_SUCCESS)
-        return result;
+            result = prtctd->_stream.setpos(&prtctd->_stream,
+                                            private->_firstLevelFileOffset);
+            if (result != KTX_SUCCESS)
+                goto cleanup;
 
-    if (This->supercompressionScheme == KTX_SS_ZSTD || This->supercompressionScheme == KTX_SS_ZLIB) {
-        assert(pDeflatedData != NULL);
-        if (This->supercompressionScheme == KTX_SS_ZSTD) {
-            result = ktxTexture2_inflateZstdInt(This, pDeflatedData, pDest,
-                                                inflatedDataCapacity);
-        } else if (This->supercompressionScheme == KTX_SS_ZLIB) {
-            result = ktxTexture2_inflateZLIBInt(This, pDeflatedData, pDest,
-                                                inflatedDataCapacity);
+            result = prtctd->_stream.read(&prtctd->_stream, pReadBuf,
+                                          This->dataSize);
+            if (result != KTX_SUCCESS)
+                goto cleanup;
         }
-        free(pDeflatedData);
-        if (result != KTX_SUCCESS) {
-            if (pBuffer == NULL) {
-                free(This->pData);
-                This->pData = 0;
+
+        if (This->supercompressionScheme == KTX_SS_ZSTD || This->supercompressionScheme == KTX_SS_ZLIB) {
+            if (This->supercompressionScheme == KTX_SS_ZSTD) {
+                result = ktxTexture2_inflateZstdInt(This, pReadBuf, pDest,
+                                                    inflatedDataCapacity,
+                                                    params);
+            } else if (This->supercompressionScheme == KTX_SS_ZLIB) {
+                result = ktxTexture2_inflateZLIBInt(This, pReadBuf, pDest,
+                                                    inflatedDataCapacity,
+                                                    params);
             }
-            return result;
+            ktxFree(pDeflatedData);
+            pDeflatedData = NULL;
+            if (result != KTX_SUCCESS)
+                goto cleanup;
         }
     }
 
@@ -2459,10 +3200,25 @@ ktxTexture2_LoadImageData(ktxTexture2* This,
         }
     }
 
-    // No further need for stream or file offset.
-    prtctd->_stream.destruct(&prtctd->_stream);
+    // No further need for stream, unless pData is a view of its data, or
+    // file offset.
+    if (!private->_pDataIsView)
+        prtctd->_stream.destruct(&prtctd->_stream);
     private->_firstLevelFileOffset = 0;
     return result;
+
+cleanup:
+    // Leave the texture without image data rather than with a partially
+    // loaded buffer.
+    ktxFree(pDeflatedData);
+    if (pBuffer == NULL) {
+        if (!private->_pDataIsView)
+            ktxFree(This->pData);
+        This->pData = NULL;
+        This->dataSize = 0;
+        private->_pDataIsView = KTX_FALSE;
+    }
+    return result;
 }
 
 /**
@@ -2478,36 +3234,235 @@ ktx_uint64_t ktxTexture2_levelDataOffset(ktxTexture2* This, ktx_uint32_t level)
     return This->_private->_levelIndex[level].byteOffset;
 }
 
+/*
+ * Inflation of Zstd and ZLIB supercompressed data.
+ *
+ * Each level is an independent stream with its own offset in the level
+ * index and its inflated size is recorded there too, so the final location
+ * of every level is known before any decompression. That lets levels be
+ * inflated in any order and concurrently. Zstd levels that consist of
+ * several frames, each recording its content size, are further split into
+ * one job per frame.
+ */
+
+typedef struct {
+    const ktx_uint8_t* pSrc;
+    ktx_size_t srcLength;
+    ktx_uint8_t* pDst;
+    ktx_size_t dstLength;  /*!< Expected inflated length. */
+    KTX_error_code result;
+} ktxInflateJob;
+
+typedef struct {
+    ktxSupercmpScheme scheme;
+    ktxInflateJob* jobs;
+    ktx_uint32_t numJobs;
+    ktxDecodeContext* ctx; /*!< Optional. Provides the dctx of threads 0
+                                and 1. */
+} ktxInflateWork;
+
+static KTX_error_code
+zstdErrorToKtx(size_t zstdResult)
+{
+    switch (ZSTD_getErrorCode(zstdResult)) {
+      case ZSTD_error_dstSize_tooSmall:
+        return KTX_DECOMPRESS_LENGTH_ERROR;
+      case ZSTD_error_checksum_wrong:
+        return KTX_DECOMPRESS_CHECKSUM_ERROR;
+      case ZSTD_error_memory_allocation:
+        return KTX_OUT_OF_MEMORY;
+      default:
+        return KTX_FILE_DATA_ERROR;
+    }
+}
+
+/*
+ * Thread function for ktxLaunchThreads. Jobs are sorted by decreasing size
+ * and dealt out round-robin.
+ */
+static void
+inflateWorker(ktx_uint32_t threadCount, ktx_uint32_t threadId, void* payload)
+{
+    ktxInflateWork* work = (ktxInflateWork*)payload;
+    ZSTD_DCtx* dctx = NULL;
+    ktx_bool_t borrowedDCtx = work->ctx != NULL
+                              && threadId < KTX_DECODE_NUM_SLOTS;
+
+    for (ktx_uint32_t i = threadId; i < work->numJobs; i += threadCount) {
+        ktxInflateJob* job = &work->jobs[i];
+        ktx_size_t inflatedLength;
+
+        if (work->scheme == KTX_SS_ZSTD) {
+            if (dctx == NULL) {
+                dctx = borrowedDCtx
+                     ? ktxDecodeContext_getDCtx(work->ctx, threadId)
+                     : ktxZSTD_createDCtx();
+                if (dctx == NULL) {
+                    job->result = KTX_OUT_OF_MEMORY;
+                    continue;
+                }
+            }
+            inflatedLength = ZSTD_decompressDCtx(dctx, job->pDst,
+                                                 job->dstLength,
+                                                 job->pSrc, job->srcLength);
+            if (ZSTD_isError(inflatedLength)) {
+                job->result = zstdErrorToKtx(inflatedLength);
+                continue;
+            }
+        } else {
+            inflatedLength = job->dstLength;
+            job->result = ktxUncompressZLIBInt(job->pDst, &inflatedLength,
+                                               job->pSrc, job->srcLength);
+            if (job->result != KTX_SUCCESS)
+                continue;
+        }
+        job->result = inflatedLength == job->dstLength
+                    ? KTX_SUCCESS : KTX_DECOMPRESS_LENGTH_ERROR;
+    }
+    if (dctx && !borrowedDCtx)
+        ZSTD_freeDCtx(dctx);
+}
+
+static int
+compareInflateJobs(const void* a, const void* b)
+{
+    ktx_size_t lengthA = ((const ktxInflateJob*)a)->dstLength;
+    ktx_size_t lengthB = ((const ktxInflateJob*)b)->dstLength;
+    return lengthA < lengthB ? 1 : (lengthA > lengthB ? -1 : 0);
+}
+
+/*
+ * Count the frames in a level of Zstd data. Returns 1 if the level
+ * cannot be split, i.e. there is a single frame or any frame does not
+ * record its content size or the sizes do not add up.
+ */
+static ktx_uint32_t
+countZstdFrames(const ktx_uint8_t* pSrc, ktx_size_t srcLength,
+                ktx_size_t inflatedLength)
+{
+    ktx_uint32_t numFrames = 0;
+    ktx_size_t total = 0;
+
+    while (srcLength > 0) {
+        size_t frameLength = ZSTD_findFrameCompressedSize(pSrc, srcLength);
+        unsigned long long contentSize
+                            = ZSTD_getFrameContentSize(pSrc, srcLength);
+        if (ZSTD_isError(frameLength)
+            || contentSize == ZSTD_CONTENTSIZE_UNKNOWN
+            || contentSize == ZSTD_CONTENTSIZE_ERROR)
+            return 1;
+        total += (ktx_size_t)contentSize;
+        pSrc += frameLength;
+        srcLength -= frameLength;
+        numFrames++;
+    }
+    return total == inflatedLength ? numFrames : 1;
+}
+
 /**
  * @memberof ktxTexture2 @private
  * @~English
- * @brief Inflate the data in a ktxTexture2 object using Zstandard.
+ * @brief Lay out the inflated levels of a supercompressed ktxTexture2.
+ *
+ * @param[in] This      pointer to the ktxTexture2 object of interest.
+ * @param[out] nindex   pointer to a level index to fill with the offsets and
+ *                      lengths of the inflated levels.
+ * @param[in] inflatedDataCapacity capacity of the buffer to inflate into.
+ * @param[out] pAlignment  pointer to a location in which to write the
+ *                         alignment of the inflated levels.
+ * @param[out] pDataSize   pointer to a location in which to write the size of
+ *                         the inflated data.
+ */
+static KTX_error_code
+ktxTexture2_layoutInflatedLevels(ktxTexture2* This, ktxLevelIndexEntry* nindex,
+                                 ktx_size_t inflatedDataCapacity,
+                                 ktx_uint32_t* pAlignment,
+                                 ktx_size_t* pDataSize)
+{
+    ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
+    uint64_t levelOffset = 0;
+    ktx_uint32_t uncompressedLevelAlignment =
+        ktxTexture2_calcPostInflationLevelAlignment(This);
+
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        ktx_size_t levelByteLength = cindex[level].uncompressedByteLength;
+
+        if (levelOffset + levelByteLength > inflatedDataCapacity)
+            return KTX_DECOMPRESS_LENGTH_ERROR;
+        nindex[level].byteOffset = levelOffset;
+        nindex[level].uncompressedByteLength = nindex[level].byteLength =
+                                                            levelByteLength;
+        levelOffset += _KTX_PADN(uncompressedLevelAlignment, levelByteLength);
+    }
+    *pAlignment = uncompressedLevelAlignment;
+    *pDataSize = levelOffset;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Update a ktxTexture2 object to describe its inflated data.
+ *
+ * The texture's levelIndex, dataSize, DFD and supercompressionScheme are
+ * updated.
+ *
+ * @param[in] This      pointer to the ktxTexture2 object of interest.
+ * @param[in] nindex    the level index of the inflated data.
+ * @param[in] alignment the alignment of the inflated levels.
+ * @param[in] dataSize  the size of the inflated data.
+ */
+static void
+ktxTexture2_setInflated(ktxTexture2* This, ktxLevelIndexEntry* nindex,
+                        ktx_uint32_t alignment, ktx_size_t dataSize)
+{
+    DECLARE_PROTECTED(ktxTexture);
+
+    This->dataSize = dataSize;
+    This->supercompressionScheme = KTX_SS_NONE;
+    memcpy(This->_private->_levelIndex, nindex,
+           This->numLevels * sizeof(ktxLevelIndexEntry));
+    This->_private->_requiredLevelAlignment = alignment;
+    // Set bytesPlane as we're now sized.
+    uint32_t* bdb = This->pDfd + 1;
+    // blockSizeInBits was set to the inflated size on file load.
+    bdb[KHR_DF_WORD_BYTESPLANE0] = prtctd->_formatSize.blockSizeInBits / 8;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Inflate the data in a ktxTexture2 object.
  *
  * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
  * all be updated after successful inflation to reflect the inflated data.
  *
- * @param[in] This                    pointer to the ktxTexture2 object of interest.
+ * @param[in] This          pointer to the ktxTexture2 object of interest.
  * @param[in] pDeflatedData pointer to a buffer containing the deflated data
- *                         of the entire texture.
- * @param[in,out] pInflatedData pointer to a buffer in which to write the inflated
- *                             data.
+ *                          of the entire texture.
+ * @param[in,out] pInflatedData pointer to a buffer in which to write the
+ *                          inflated data.
  * @param[in] inflatedDataCapacity capacity of the buffer pointed at by
- *                                @p pInflatedData.
+ *                                 @p pInflatedData.
+ * @param[in] params        pointer to a ktxLoadParams struct giving the
+ *                          number of threads, 0 or 1 inflates on the calling
+ *                          thread, and an optional ktxDecodeContext.
  */
-KTX_error_code
-ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
-                           ktx_uint8_t* pInflatedData,
-                           ktx_size_t inflatedDataCapacity)
+static KTX_error_code
+ktxTexture2_inflateInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
+                       ktx_uint8_t* pInflatedData,
+                       ktx_size_t inflatedDataCapacity,
+                       ktxLoadParams* params)
 {
-    DECLARE_PROTECTED(ktxTexture);
+    ktx_uint32_t threadCount = params->threadCount;
     ktx_uint32_t levelIndexByteLength =
                             This->numLevels * sizeof(ktxLevelIndexEntry);
-    uint64_t levelOffset = 0;
     ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
     ktxLevelIndexEntry* nindex;
     ktx_uint32_t uncompressedLevelAlignment;
-
-    ZSTD_DCtx* dctx;
+    ktx_size_t inflatedDataSize;
+    ktxInflateWork work;
+    KTX_error_code result = KTX_SUCCESS;
 
     if (pDeflatedData == NULL)
         return KTX_INVALID_VALUE;
@@ -2515,67 +3470,339 @@ ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
     if (pInflatedData == NULL)
         return KTX_INVALID_VALUE;
 
-    if (This->supercompressionScheme != KTX_SS_ZSTD)
-        return KTX_INVALID_OPERATION;
-
-    nindex = malloc(levelIndexByteLength);
+    nindex = ktxMalloc(levelIndexByteLength);
     if (nindex == NULL)
         return KTX_OUT_OF_MEMORY;
 
-    uncompressedLevelAlignment =
-        ktxTexture2_calcPostInflationLevelAlignment(This);
+    result = ktxTexture2_layoutInflatedLevels(This, nindex,
+                                              inflatedDataCapacity,
+                                              &uncompressedLevelAlignment,
+                                              &inflatedDataSize);
+    if (result != KTX_SUCCESS) {
+        ktxFree(nindex);
+        return result;
+    }
 
-    ktx_size_t inflatedByteLength = 0;
-    dctx = ZSTD_createDCtx();
+    // Count the jobs.
+    work.scheme = This->supercompressionScheme;
+    work.ctx = params->decodeContext;
+    work.numJobs = 0;
     for (int32_t level = This->numLevels - 1; level >= 0; level--) {
-        size_t levelByteLength =
-            ZSTD_decompressDCtx(dctx, pInflatedData + levelOffset,
-                              inflatedDataCapacity,
-                              &pDeflatedData[cindex[level].byteOffset],
-                              cindex[level].byteLength);
-        if (ZSTD_isError(levelByteLength)) {
-            ZSTD_ErrorCode error = ZSTD_getErrorCode(levelByteLength);
-            switch(error) {
-              case ZSTD_error_dstSize_tooSmall:
-                return KTX_DECOMPRESS_LENGTH_ERROR; // inflatedDataCapacity too small.
-              case ZSTD_error_checksum_wrong:
-                return KTX_DECOMPRESS_CHECKSUM_ERROR;
-              case ZSTD_error_memory_allocation:
-                return KTX_OUT_OF_MEMORY;
-              default:
-                return KTX_FILE_DATA_ERROR;
+        if (threadCount > 1 && work.scheme == KTX_SS_ZSTD)
+            work.numJobs += countZstdFrames(
+                                    &pDeflatedData[cindex[level].byteOffset],
+                                    cindex[level].byteLength,
+                                    nindex[level].byteLength);
+        else
+            work.numJobs++;
+    }
+
+    work.jobs = ktxMalloc(work.numJobs * sizeof(ktxInflateJob));
+    if (work.jobs == NULL) {
+        ktxFree(nindex);
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    ktxInflateJob* job = work.jobs;
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        const ktx_uint8_t* pSrc = &pDeflatedData[cindex[level].byteOffset];
+        ktx_size_t srcLength = cindex[level].byteLength;
+        ktx_uint8_t* pDst = pInflatedData + nindex[level].byteOffset;
+        ktx_uint32_t numFrames = 1;
+
+        if (threadCount > 1 && work.scheme == KTX_SS_ZSTD)
+            numFrames = countZstdFrames(pSrc, srcLength,
+                                        nindex[level].byteLength);
+        if (numFrames == 1) {
+            job->pSrc = pSrc;
+            job->srcLength = srcLength;
+            job->pDst = pDst;
+            job->dstLength = nindex[level].byteLength;
+            job++;
+        } else {
+            for (ktx_uint32_t frame = 0; frame < numFrames; frame++) {
+                job->pSrc = pSrc;
+                job->srcLength = ZSTD_findFrameCompressedSize(pSrc, srcLength);
+                job->pDst = pDst;
+                job->dstLength =
+                    (ktx_size_t)ZSTD_getFrameContentSize(pSrc, srcLength);
+                pSrc += job->srcLength;
+                srcLength -= job->srcLength;
+                pDst += job->dstLength;
+                job++;
             }
         }
+    }
 
-        if (This->_private->_levelIndex[level].uncompressedByteLength != levelByteLength)
-            return KTX_DECOMPRESS_LENGTH_ERROR;
+    if (threadCount > work.numJobs)
+        threadCount = work.numJobs;
+    if (threadCount > 1)
+        qsort(work.jobs, work.numJobs, sizeof(ktxInflateJob),
+              compareInflateJobs);
+    ktxLaunchThreads(threadCount, inflateWorker, &work);
 
-        nindex[level].byteOffset = levelOffset;
-        nindex[level].uncompressedByteLength = nindex[level].byteLength =
-                                                            levelByteLength;
-        ktx_size_t paddedLevelByteLength
-              = _KTX_PADN(uncompressedLevelAlignment, levelByteLength);
-        inflatedByteLength += paddedLevelByteLength;
-        levelOffset += paddedLevelByteLength;
-        inflatedDataCapacity -= paddedLevelByteLength;
+    for (ktx_uint32_t i = 0; i < work.numJobs; i++) {
+        if (work.jobs[i].result != KTX_SUCCESS) {
+            result = work.jobs[i].result;
+            break;
+        }
+    }
+    ktxFree(work.jobs);
+    if (result != KTX_SUCCESS) {
+        ktxFree(nindex);
+        return result;
     }
-    ZSTD_freeDCtx(dctx);
 
     // Now modify the texture.
+    ktxTexture2_setInflated(This, nindex, uncompressedLevelAlignment,
+                            inflatedDataSize);
+    ktxFree(nindex);
 
-    This->dataSize = inflatedByteLength;
-    This->supercompressionScheme = KTX_SS_NONE;
-    memcpy(cindex, nindex, levelIndexByteLength); // Update level index
-    free(nindex);
-    This->_private->_requiredLevelAlignment = uncompressedLevelAlignment;
-    // Set bytesPlane as we're now sized.
-    uint32_t* bdb = This->pDfd + 1;
-    // blockSizeInBits was set to the inflated size on file load.
-    bdb[KHR_DF_WORD_BYTESPLANE0] = prtctd->_formatSize.blockSizeInBits / 8;
+    return KTX_SUCCESS;
+}
 
+/*
+ * Size of the chunks in which deflated data is read when streaming. Bounds
+ * the extra memory needed to inflate from a stream.
+ */
+#define KTX_INFLATE_CHUNK_SIZE (128 * 1024)
+
+typedef struct {
+    ktxSupercmpScheme scheme;
+    ZSTD_DStream* zds;
+    ktx_uint8_t* pChunk;
+    ktx_size_t chunkSize;
+    ktx_bool_t borrowed; /*!< zds and pChunk belong to a ktxDecodeContext. */
+} ktxStreamInflater;
+
+static KTX_error_code
+ktxStreamInflater_construct(ktxStreamInflater* inflater,
+                            ktxSupercmpScheme scheme, ktx_size_t maxSrcLength,
+                            ktxDecodeContext* ctx)
+{
+    inflater->scheme = scheme;
+    inflater->zds = NULL;
+    // Levels can be empty but a zero-sized allocation may return NULL.
+    inflater->chunkSize = MAX(1, MIN(KTX_INFLATE_CHUNK_SIZE, maxSrcLength));
+    inflater->borrowed = ctx != NULL;
+    if (ctx) {
+        // A ZSTD_DStream is a ZSTD_DCtx.
+        inflater->pChunk = ktxDecodeContext_getBuffer(ctx,
+                                                      KTX_DECODE_READ_BUFFER0,
+                                                      inflater->chunkSize);
+        if (inflater->pChunk == NULL)
+            return KTX_OUT_OF_MEMORY;
+        if (scheme == KTX_SS_ZSTD) {
+            inflater->zds = ktxDecodeContext_getDCtx(ctx, 0);
+            if (inflater->zds == NULL)
+                return KTX_OUT_OF_MEMORY;
+        }
+        return KTX_SUCCESS;
+    }
+    inflater->pChunk = ktxMalloc(inflater->chunkSize);
+    if (inflater->pChunk == NULL)
+        return KTX_OUT_OF_MEMORY;
+    if (scheme == KTX_SS_ZSTD) {
+        inflater->zds = ktxZSTD_createDCtx();
+        if (inflater->zds == NULL) {
+            ktxFree(inflater->pChunk);
+            return KTX_OUT_OF_MEMORY;
+        }
+    }
     return KTX_SUCCESS;
 }
 
+static void
+ktxStreamInflater_destruct(ktxStreamInflater* inflater)
+{
+    if (inflater->borrowed)
+        return;
+    if (inflater->zds)
+        ZSTD_freeDStream(inflater->zds);
+    ktxFree(inflater->pChunk);
+}
+
+/*
+ * Read @p srcLength bytes of deflated data from the current position of
+ * @p stream, a chunk at a time, and inflate them into exactly
+ * @p dstLength bytes at @p pDst.
+ */
+static KTX_error_code
+ktxStreamInflater_inflate(ktxStreamInflater* inflater, ktxStream* stream,
+                          ktx_size_t srcLength,
+                          ktx_uint8_t* pDst, ktx_size_t dstLength)
+{
+    ZSTD_outBuffer out = { pDst, dstLength, 0 };
+    ktxZLIBInflater* zinflater = NULL;
+    ktx_size_t inflatedLength = 0;
+    size_t zstdResult = 0;
+    KTX_error_code result;
+
+    if (inflater->scheme == KTX_SS_ZSTD) {
+        ZSTD_DCtx_reset(inflater->zds, ZSTD_reset_session_only);
+    } else {
+        result = ktxZLIBInflater_create(pDst, dstLength, &zinflater);
+        if (result != KTX_SUCCESS)
+            return result;
+    }
+
+    while (srcLength > 0) {
+        ktx_size_t count = MIN(inflater->chunkSize, srcLength);
+
+        result = stream->read(stream, inflater->pChunk, count);
+        if (result != KTX_SUCCESS)
+            break;
+        srcLength -= count;
+
+        if (inflater->scheme == KTX_SS_ZSTD) {
+            ZSTD_inBuffer in = { inflater->pChunk, count, 0 };
+            while (in.pos < in.size) {
+                size_t prevInPos = in.pos, prevOutPos = out.pos;
+                zstdResult = ZSTD_decompressStream(inflater->zds, &out, &in);
+                if (ZSTD_isError(zstdResult)) {
+                    result = zstdErrorToKtx(zstdResult);
+                    break;
+                }
+                if (in.pos == prevInPos && out.pos == prevOutPos) {
+                    // Output full with input remaining.
+                    result = KTX_DECOMPRESS_LENGTH_ERROR;
+                    break;
+                }
+            }
+        } else {
+            result = ktxZLIBInflater_inflate(zinflater, inflater->pChunk,
+                                             count);
+        }
+        if (result != KTX_SUCCESS)
+            break;
+    }
+
+    if (inflater->scheme == KTX_SS_ZSTD) {
+        inflatedLength = out.pos;
+        if (result == KTX_SUCCESS && zstdResult != 0)
+            result = KTX_FILE_DATA_ERROR; // Truncated frame.
+    } else {
+        KTX_error_code endResult
+                = ktxZLIBInflater_destroy(zinflater, &inflatedLength);
+        if (result == KTX_SUCCESS)
+            result = endResult;
+    }
+    if (result == KTX_SUCCESS && inflatedLength != dstLength)
+        result = KTX_DECOMPRESS_LENGTH_ERROR;
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Inflate the data in a ktxTexture2 object while reading it from the
+ *        texture's stream.
+ *
+ * Each level is read in chunks of at most KTX_INFLATE_CHUNK_SIZE bytes and
+ * inflated directly into @p pInflatedData so the extra memory needed is one
+ * chunk, not the whole deflated payload.
+ *
+ * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
+ * all be updated after successful inflation to reflect the inflated data.
+ *
+ * @param[in] This          pointer to the ktxTexture2 object of interest.
+ * @param[in,out] pInflatedData pointer to a buffer in which to write the
+ *                          inflated data.
+ * @param[in] inflatedDataCapacity capacity of the buffer pointed at by
+ *                                 @p pInflatedData.
+ * @param[in] ctx           optional ktxDecodeContext providing the chunk
+ *                          buffer and Zstandard context.
+ */
+static KTX_error_code
+ktxTexture2_inflateFromStreamInt(ktxTexture2* This,
+                                 ktx_uint8_t* pInflatedData,
+                                 ktx_size_t inflatedDataCapacity,
+                                 ktxDecodeContext* ctx)
+{
+    DECLARE_PROTECTED(ktxTexture);
+    ktx_uint32_t levelIndexByteLength =
+                            This->numLevels * sizeof(ktxLevelIndexEntry);
+    ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
+    ktxLevelIndexEntry* nindex;
+    ktx_uint32_t uncompressedLevelAlignment;
+    ktx_size_t inflatedDataSize;
+    ktx_size_t maxSrcLength = 0;
+    ktxStreamInflater inflater;
+    KTX_error_code result;
+
+    nindex = ktxMalloc(levelIndexByteLength);
+    if (nindex == NULL)
+        return KTX_OUT_OF_MEMORY;
+
+    result = ktxTexture2_layoutInflatedLevels(This, nindex,
+                                              inflatedDataCapacity,
+                                              &uncompressedLevelAlignment,
+                                              &inflatedDataSize);
+    if (result != KTX_SUCCESS)
+        goto cleanup;
+
+    for (ktx_uint32_t level = 0; level < This->numLevels; level++)
+        maxSrcLength = MAX(maxSrcLength, cindex[level].byteLength);
+    result = ktxStreamInflater_construct(&inflater,
+                                         This->supercompressionScheme,
+                                         maxSrcLength, ctx);
+    if (result != KTX_SUCCESS)
+        goto cleanup;
+
+    // Levels are in file order, smallest first.
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        result = prtctd->_stream.setpos(&prtctd->_stream,
+                                     ktxTexture2_levelFileOffset(This, level));
+        if (result != KTX_SUCCESS)
+            break;
+        result = ktxStreamInflater_inflate(&inflater, &prtctd->_stream,
+                                     cindex[level].byteLength,
+                                     pInflatedData + nindex[level].byteOffset,
+                                     nindex[level].byteLength);
+        if (result != KTX_SUCCESS)
+            break;
+    }
+    ktxStreamInflater_destruct(&inflater);
+
+    if (result == KTX_SUCCESS)
+        ktxTexture2_setInflated(This, nindex, uncompressedLevelAlignment,
+                                inflatedDataSize);
+cleanup:
+    ktxFree(nindex);
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Inflate the data in a ktxTexture2 object using Zstandard.
+ *
+ * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
+ * all be updated after successful inflation to reflect the inflated data.
+ *
+ * @param[in] This                    pointer to the ktxTexture2 object of interest.
+ * @param[in] pDeflatedData pointer to a buffer containing the deflated data
+ *                         of the entire texture.
+ * @param[in,out] pInflatedData pointer to a buffer in which to write the inflated
+ *                             data.
+ * @param[in] inflatedDataCapacity capacity of the buffer pointed at by
+ *                                @p pInflatedData.
+ * @param[in] params    pointer to a ktxLoadParams struct giving the number
+ *                      of threads and an optional ktxDecodeContext.
+ */
+KTX_error_code
+ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
+                           ktx_uint8_t* pInflatedData,
+                           ktx_size_t inflatedDataCapacity,
+                           ktxLoadParams* params)
+{
+    if (This->supercompressionScheme != KTX_SS_ZSTD)
+        return KTX_INVALID_OPERATION;
+
+    return ktxTexture2_inflateInt(This, pDeflatedData, pInflatedData,
+                                  inflatedDataCapacity, params);
+}
+
 /**
  * @memberof ktxTexture2 @private
  * @~English
@@ -2591,72 +3818,182 @@ ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
  *                              inflated data.
  * @param[in] inflatedDataCapacity capacity of the buffer pointed at by
  *                                @p pInflatedData.
+ * @param[in] params    pointer to a ktxLoadParams struct giving the number
+ *                      of threads and an optional ktxDecodeContext.
  */
 KTX_error_code
 ktxTexture2_inflateZLIBInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
                            ktx_uint8_t* pInflatedData,
-                           ktx_size_t inflatedDataCapacity)
+                           ktx_size_t inflatedDataCapacity,
+                           ktxLoadParams* params)
 {
-    DECLARE_PROTECTED(ktxTexture);
-    ktx_uint32_t levelIndexByteLength =
-                            This->numLevels * sizeof(ktxLevelIndexEntry);
-    uint64_t levelOffset = 0;
-    ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
-    ktxLevelIndexEntry* nindex;
-    ktx_uint32_t uncompressedLevelAlignment;
+    if (This->supercompressionScheme != KTX_SS_ZLIB)
+        return KTX_INVALID_OPERATION;
 
-    if (pDeflatedData == NULL)
+    return ktxTexture2_inflateInt(This, pDeflatedData, pInflatedData,
+                                  inflatedDataCapacity, params);
+}
+
+/*
+ * Inflate one Zstd or ZLIB supercompressed level held in memory into
+ * exactly @p dstLength bytes at @p pDst.
+ */
+static KTX_error_code
+inflateLevelFromMemory(ktxSupercmpScheme scheme,
+                       const ktx_uint8_t* pSrc, ktx_size_t srcLength,
+                       ktx_uint8_t* pDst, ktx_size_t dstLength)
+{
+    ktxInflateJob job;
+    ktxInflateWork work;
+
+    job.pSrc = pSrc;
+    job.srcLength = srcLength;
+    job.pDst = pDst;
+    job.dstLength = dstLength;
+    work.scheme = scheme;
+    work.jobs = &job;
+    work.numJobs = 1;
+    work.ctx = NULL;
+    inflateWorker(1, 0, &work);
+    return job.result;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Load the image data of a single mip level from the ktxTexture2's
+ *        source.
+ *
+ * Reads only the bytes of @p level, inflating them if supercompressionScheme
+ * is KTX_SS_ZSTD or KTX_SS_ZLIB, into @p pBuffer. Levels can be loaded in any
+ * order and any number of times. Unlike ktxTexture2_LoadImageData() and
+ * ktxTexture2_IterateLoadLevelFaces() this neither modifies the texture nor
+ * closes its source, so a streaming renderer can load the small levels
+ * immediately and the large ones later, or never.
+ *
+ * If the image data has already been loaded, the level is copied from
+ * @c pData, being inflated first if @c pData is still supercompressed,
+ * e.g. after ktxTexture2_DeflateZstd().
+ *
+ * The images of the level are written in the same order and with the same
+ * layout as in @c pData. The required buffer size is the level's
+ * uncompressed byte length which is the size of an image, as returned by
+ * ktxTexture_GetImageSize(), multiplied by the number of layers, faces and
+ * depth slices in the level. For KTX_SS_BASIS_LZ textures the level's
+ * supercompressed data is returned as is.
+ *
+ * @param[in] This    pointer to the ktxTexture2 object of interest.
+ * @param[in] level   the mip level to load.
+ * @param[in] pBuffer pointer to the buffer in which to load the level.
+ * @param[in] bufSize size of the buffer pointed at by @p pBuffer.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p pBuffer is NULL.
+ * @exception KTX_INVALID_VALUE @p level is greater than or equal to the
+ *                              number of levels in the texture.
+ * @exception KTX_INVALID_VALUE @p bufSize is less than the size of the level.
+ * @exception KTX_INVALID_OPERATION
+ *                              The ktxTexture was not created from a KTX
+ *                              source and has no image data.
+ * @exception KTX_DECOMPRESS_LENGTH_ERROR
+ *                              The level inflated to a different size than
+ *                              recorded in the level index.
+ * @exception KTX_OUT_OF_MEMORY Insufficient memory for inflating the data.
+ */
+KTX_error_code
+ktxTexture2_LoadLevel(ktxTexture2* This, ktx_uint32_t level,
+                      ktx_uint8_t* pBuffer, ktx_size_t bufSize)
+{
+    ktxLevelIndexEntry* levelIndex;
+    ktx_size_t levelByteLength;
+    ktx_uint8_t* pSrc;
+    KTX_error_code result = KTX_SUCCESS;
+
+    if (This == NULL || pBuffer == NULL)
         return KTX_INVALID_VALUE;
 
-    if (pInflatedData == NULL)
+    if (level >= This->numLevels)
         return KTX_INVALID_VALUE;
 
-    if (This->supercompressionScheme != KTX_SS_ZLIB)
-        return KTX_INVALID_OPERATION;
+    DECLARE_PROTECTED(ktxTexture);
+    levelIndex = This->_private->_levelIndex;
+    levelByteLength = This->supercompressionScheme == KTX_SS_BASIS_LZ
+                    ? levelIndex[level].byteLength
+                    : levelIndex[level].uncompressedByteLength;
+    if (bufSize < levelByteLength)
+        return KTX_INVALID_VALUE;
 
-    nindex = malloc(levelIndexByteLength);
-    if (nindex == NULL)
-        return KTX_OUT_OF_MEMORY;
+    if (This->pData != NULL) {
+        pSrc = This->pData + levelIndex[level].byteOffset;
+        // Loaded data is already in native byte order, as is data deflated
+        // in memory by the Deflate functions.
+        if (This->supercompressionScheme == KTX_SS_ZSTD
+            || This->supercompressionScheme == KTX_SS_ZLIB)
+            return inflateLevelFromMemory(This->supercompressionScheme,
+                                          pSrc, levelIndex[level].byteLength,
+                                          pBuffer, levelByteLength);
+        memcpy(pBuffer, pSrc, levelByteLength);
+        return KTX_SUCCESS;
+    }
 
-    uncompressedLevelAlignment =
-        ktxTexture2_calcPostInflationLevelAlignment(This);
+    if (prtctd->_stream.data.file == NULL)
+        return KTX_INVALID_OPERATION;
 
-    ktx_size_t inflatedByteLength = 0;
-    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
-        size_t levelByteLength = inflatedDataCapacity;
-        KTX_error_code result = ktxUncompressZLIBInt(pInflatedData + levelOffset,
-                                                    &levelByteLength,
-                                                    &pDeflatedData[cindex[level].byteOffset],
-                                                    cindex[level].byteLength);
+    pSrc = ktxTexture2_viewSource(This, ktxTexture2_levelFileOffset(This, level),
+                                  levelIndex[level].byteLength);
+    if (pSrc == NULL) {
+        result = prtctd->_stream.setpos(&prtctd->_stream,
+                                     ktxTexture2_levelFileOffset(This, level));
         if (result != KTX_SUCCESS)
             return result;
+    }
 
-        if (This->_private->_levelIndex[level].uncompressedByteLength != levelByteLength)
-            return KTX_DECOMPRESS_LENGTH_ERROR;
+    if (This->supercompressionScheme == KTX_SS_ZSTD
+        || This->supercompressionScheme == KTX_SS_ZLIB) {
+        if (pSrc != NULL) {
+            result = inflateLevelFromMemory(This->supercompressionScheme,
+                                            pSrc, levelIndex[level].byteLength,
+                                            pBuffer, levelByteLength);
+        } else {
+            ktxStreamInflater inflater;
 
-        nindex[level].byteOffset = levelOffset;
-        nindex[level].uncompressedByteLength = nindex[level].byteLength =
-                                                            levelByteLength;
-        ktx_size_t paddedLevelByteLength
-              = _KTX_PADN(uncompressedLevelAlignment, levelByteLength);
-        inflatedByteLength += paddedLevelByteLength;
-        levelOffset += paddedLevelByteLength;
-        inflatedDataCapacity -= paddedLevelByteLength;
+            result = ktxStreamInflater_construct(&inflater,
+                                              This->supercompressionScheme,
+                                              levelIndex[level].byteLength,
+                                              NULL);
+            if (result != KTX_SUCCESS)
+                return result;
+            result = ktxStreamInflater_inflate(&inflater, &prtctd->_stream,
+                                               levelIndex[level].byteLength,
+                                               pBuffer, levelByteLength);
+            ktxStreamInflater_destruct(&inflater);
+        }
+    } else if (pSrc != NULL) {
+        memcpy(pBuffer, pSrc, levelByteLength);
+    } else {
+        result = prtctd->_stream.read(&prtctd->_stream, pBuffer,
+                                      levelByteLength);
     }
 
-    // Now modify the texture.
-
-    This->dataSize = inflatedByteLength;
-    This->supercompressionScheme = KTX_SS_NONE;
-    memcpy(cindex, nindex, levelIndexByteLength); // Update level index
-    free(nindex);
-    This->_private->_requiredLevelAlignment = uncompressedLevelAlignment;
-    // Set bytesPlane as we're now sized.
-    uint32_t* bdb = This->pDfd + 1;
-    // blockSizeInBits was set to the inflated size on file load.
-    bdb[KHR_DF_WORD_BYTESPLANE0] = prtctd->_formatSize.blockSizeInBits / 8;
+#if IS_BIG_ENDIAN
+    if (result == KTX_SUCCESS
+        && This->supercompressionScheme != KTX_SS_BASIS_LZ) {
+        switch (prtctd->_typeSize) {
+          case 2:
+            _ktxSwapEndian16((ktx_uint16_t*)pBuffer, levelByteLength / 2);
+            break;
+          case 4:
+            _ktxSwapEndian32((ktx_uint32_t*)pBuffer, levelByteLength / 4);
+            break;
+          case 8:
+            _ktxSwapEndian64((ktx_uint64_t*)pBuffer, levelByteLength / 8);
+            break;
+        }
+    }
+#endif
 
-    return KTX_SUCCESS;
+    return result;
 }
 
 #if !KTX_FEATURE_WRITE
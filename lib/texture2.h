@@ -37,6 +37,14 @@ typedef struct ktxTexture2_private {
     ktx_uint64_t _firstLevelFileOffset; /*!< Always 0, unless the texture was
                                          created from a stream and the image
                                          data is not yet loaded. */
+    ktx_bool_t _canViewSource; /*!< The source outlives the texture's
+                                    stream so pData may point into it. */
+    ktx_bool_t _pDataIsView; /*!< pData points into the source held by
+                                  the texture's stream rather than to memory
+                                  owned by the texture. */
+    ktx_uint32_t* _pDataRefCount; /*!< Number of textures sharing pData, if
+                                       it is shared by
+                                       ktxTexture2_CreateSharedCopy(). */
     // Must be last so it can grow.
     ktxLevelIndexEntry _levelIndex[1]; /*!< Offsets in this index are from the
                                         start of the image data. Use
@@ -50,6 +58,9 @@ KTX_error_code
 ktxTexture2_LoadImageData(ktxTexture2* This,
                           ktx_uint8_t* pBuffer, ktx_size_t bufSize);
 
+void ktxTexture2_freeData(ktxTexture2* This);
+KTX_error_code ktxTexture2_ownData(ktxTexture2* This);
+
 KTX_error_code
 ktxTexture2_constructCopy(ktxTexture2* This, ktxTexture2* orig);
 KTX_error_code
@@ -63,6 +74,25 @@ ktx_uint32_t ktxTexture2_calcRequiredLevelAlignment(ktxTexture2* This);
 ktx_uint64_t ktxTexture2_levelFileOffset(ktxTexture2* This, ktx_uint32_t level);
 ktx_uint64_t ktxTexture2_levelDataOffset(ktxTexture2* This, ktx_uint32_t level);
 
+/* Transcoding a level at a time, implemented in basis_transcode.cpp. */
+typedef struct ktxLevelTranscoder ktxLevelTranscoder;
+
+KTX_error_code
+ktxLevelTranscoder_create(ktxTexture2* This,
+                          ktx_transcode_fmt_e outputFormat,
+                          ktx_transcode_flags transcodeFlags,
+                          ktx_uint32_t threadCount,
+                          ktxLevelTranscoder** pXcoder);
+void ktxLevelTranscoder_destroy(ktxLevelTranscoder* xcoder);
+ktxTexture2* ktxLevelTranscoder_getPrototype(ktxLevelTranscoder* xcoder);
+ktx_size_t ktxLevelTranscoder_getMaxLevelSize(ktxLevelTranscoder* xcoder);
+KTX_error_code
+ktxLevelTranscoder_transcode(ktxLevelTranscoder* xcoder, ktx_uint32_t level,
+                             const ktx_uint8_t* pLevelData,
+                             ktx_size_t levelDataSize,
+                             ktx_uint8_t* pDest, ktx_size_t* pLevelSize);
+void ktxLevelTranscoder_adoptFormat(ktxLevelTranscoder* xcoder);
+
 #ifdef __cplusplus
 }
 #endif
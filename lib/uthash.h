@@ -47,8 +47,8 @@ typedef unsigned int uint32_t;
 #define UTHASH_VERSION 1.9.1
 
 #define uthash_fatal(msg) exit(-1)        /* fatal error (out of memory,etc) */
-#define uthash_malloc(sz) malloc(sz)      /* malloc fcn                      */
-#define uthash_free(ptr) free(ptr)        /* free fcn                        */
+#define uthash_malloc(sz) ktxMalloc(sz)   /* malloc fcn                      */
+#define uthash_free(ptr) ktxFree(ptr)     /* free fcn                        */
 
 #define uthash_noexpand_fyi(tbl)          /* can be defined to log noexpand  */
 #define uthash_expand_fyi(tbl)            /* can be defined to log expands   */
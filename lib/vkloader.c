@@ -126,13 +126,13 @@ ktxVulkanDeviceInfo_CreateEx(VkInstance instance,
                              const ktxVulkanFunctions* pFuncs)
 {
     ktxVulkanDeviceInfo* newvdi;
-    newvdi = (ktxVulkanDeviceInfo*)malloc(sizeof(ktxVulkanDeviceInfo));
+    newvdi = (ktxVulkanDeviceInfo*)ktxMalloc(sizeof(ktxVulkanDeviceInfo));
     if (newvdi != NULL) {
         if (ktxVulkanDeviceInfo_ConstructEx(newvdi, instance, physicalDevice,
                                             device, queue, cmdPool, pAllocator,
                                             pFuncs) != KTX_SUCCESS)
         {
-            free(newvdi);
+            ktxFree(newvdi);
             newvdi = 0;
         }
     }
@@ -378,7 +378,7 @@ ktxVulkanDeviceInfo_Destroy(ktxVulkanDeviceInfo* This)
 {
     assert(This != NULL);
     ktxVulkanDeviceInfo_Destruct(This);
-    free(This);
+    ktxFree(This);
 }
 
 /* Get appropriate memory type index for a memory allocation. */
@@ -723,6 +723,293 @@ linearTilingPadCallback(int miplevel, int face,
     return KTX_SUCCESS;
 }
 
+//======================================================================
+//  Upload helpers
+//======================================================================
+
+/**
+ * @internal
+ * @~English
+ * @brief Describe the Vulkan image to create for a texture.
+ *
+ * Checks the physical device supports the image then fills in the fields
+ * of @p vkTexture describing it.
+ *
+ * @param[in] This          pointer to the texture to be uploaded.
+ * @param[in] vdi           pointer to the Vulkan device information.
+ * @param[in] vkFormat      format of the image.
+ * @param[in] tiling        tiling of the image.
+ * @param[in,out] pUsageFlags intended usage of the image. Augmented with
+ *                          the transfer usages uploading needs.
+ * @param[in] finalLayout   the final layout of the image.
+ * @param[out] vkTexture    pointer to the ktxVulkanTexture to describe the
+ *                          image in.
+ * @param[out] pImageType   the type of image to create.
+ * @param[out] pCreateFlags the flags to create the image with.
+ * @param[out] pBlitFilter  the filter to use for generating mipmaps.
+ *
+ * @return  KTX_SUCCESS on success, KTX_INVALID_OPERATION if the device does
+ *          not support the image.
+ */
+static KTX_error_code
+describeImage(ktxTexture* This, ktxVulkanDeviceInfo* vdi, VkFormat vkFormat,
+              VkImageTiling tiling, VkImageUsageFlags* pUsageFlags,
+              VkImageLayout finalLayout, ktxVulkanTexture* vkTexture,
+              VkImageType* pImageType, VkImageCreateFlags* pCreateFlags,
+              VkFilter* pBlitFilter)
+{
+    VkImageViewType          viewType;
+    VkImageFormatProperties  imageFormatProperties;
+    VkResult                 vResult;
+    ktx_uint32_t             numImageLayers, numImageLevels;
+
+    /* _ktxCheckHeader should have caught this. */
+    assert(This->numFaces == 6 ? This->numDimensions == 2 : VK_TRUE);
+
+    *pCreateFlags = 0;
+    *pBlitFilter = VK_FILTER_LINEAR;
+    numImageLayers = This->numLayers;
+    if (This->isCubemap) {
+        numImageLayers *= 6;
+        *pCreateFlags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+    }
+
+    assert(This->numDimensions >= 1 && This->numDimensions <= 3);
+    switch (This->numDimensions) {
+      case 1:
+        *pImageType = VK_IMAGE_TYPE_1D;
+        viewType = This->isArray ?
+                        VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
+        break;
+      case 2:
+      default: // To keep compilers happy.
+        *pImageType = VK_IMAGE_TYPE_2D;
+        if (This->isCubemap)
+            viewType = This->isArray ?
+                        VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+        else
+            viewType = This->isArray ?
+                        VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+        break;
+      case 3:
+        *pImageType = VK_IMAGE_TYPE_3D;
+        /* 3D array textures not supported in Vulkan. Attempts to create or
+         * load them should have been trapped long before this.
+         */
+        assert(!This->isArray);
+        viewType = VK_IMAGE_VIEW_TYPE_3D;
+        break;
+    }
+
+    /* Get device properties for the requested image format */
+    if (tiling == VK_IMAGE_TILING_OPTIMAL) {
+        // Ensure we can copy from staging buffer to image.
+        *pUsageFlags |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    }
+    if (This->generateMipmaps) {
+        // Ensure we can blit between levels.
+        *pUsageFlags |= (VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+    }
+    vResult = vdi->vkFuncs.vkGetPhysicalDeviceImageFormatProperties(vdi->physicalDevice,
+                                                      vkFormat,
+                                                      *pImageType,
+                                                      tiling,
+                                                      *pUsageFlags,
+                                                      *pCreateFlags,
+                                                      &imageFormatProperties);
+    if (vResult == VK_ERROR_FORMAT_NOT_SUPPORTED) {
+        return KTX_INVALID_OPERATION;
+    }
+    if (This->numLayers > imageFormatProperties.maxArrayLayers) {
+        return KTX_INVALID_OPERATION;
+    }
+
+    if (This->generateMipmaps) {
+        uint32_t max_dim;
+        VkFormatProperties    formatProperties;
+        VkFormatFeatureFlags  formatFeatureFlags;
+        VkFormatFeatureFlags  neededFeatures
+            = VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT;
+        vdi->vkFuncs.vkGetPhysicalDeviceFormatProperties(vdi->physicalDevice,
+                                            vkFormat,
+                                            &formatProperties);
+        assert(vResult == VK_SUCCESS);
+        if (tiling == VK_IMAGE_TILING_OPTIMAL)
+            formatFeatureFlags = formatProperties.optimalTilingFeatures;
+        else
+            formatFeatureFlags = formatProperties.linearTilingFeatures;
+
+        if ((formatFeatureFlags & neededFeatures) != neededFeatures)
+            return KTX_INVALID_OPERATION;
+
+        if (formatFeatureFlags & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+            *pBlitFilter = VK_FILTER_LINEAR;
+        else
+            *pBlitFilter = VK_FILTER_NEAREST; // XXX INVALID_OP?
+
+        max_dim = MAX(MAX(This->baseWidth, This->baseHeight), This->baseDepth);
+        numImageLevels = (uint32_t)floor(log2(max_dim)) + 1;
+    } else {
+        numImageLevels = This->numLevels;
+    }
+
+    if (numImageLevels > imageFormatProperties.maxMipLevels) {
+        return KTX_INVALID_OPERATION;
+    }
+
+    vkTexture->width = This->baseWidth;
+    vkTexture->height = This->baseHeight;
+    vkTexture->depth = This->baseDepth;
+    vkTexture->imageLayout = finalLayout;
+    vkTexture->imageFormat = vkFormat;
+    // numImageLevels ensures enough levels for generateMipmaps.
+    vkTexture->levelCount = numImageLevels;
+    vkTexture->layerCount = numImageLayers;
+    vkTexture->viewType = viewType;
+    vkTexture->vkDestroyImage = vdi->vkFuncs.vkDestroyImage;
+    vkTexture->vkFreeMemory = vdi->vkFuncs.vkFreeMemory;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Create a host-visible buffer for staging image data and map it.
+ *
+ * @param[in] vdi          pointer to the Vulkan device information.
+ * @param[in] size         size of the buffer.
+ * @param[out] pBuffer     the created buffer.
+ * @param[out] pMemory     the memory bound to the buffer.
+ * @param[out] pMemorySize the size of @p pMemory, which may be larger than
+ *                         @p size.
+ * @param[out] ppMapped    pointer to the mapped memory.
+ *
+ * @return  KTX_SUCCESS on success, KTX_OUT_OF_MEMORY if the memory could
+ *          not be allocated.
+ */
+static KTX_error_code
+createStagingBuffer(ktxVulkanDeviceInfo* vdi, VkDeviceSize size,
+                    VkBuffer* pBuffer, VkDeviceMemory* pMemory,
+                    VkDeviceSize* pMemorySize, ktx_uint8_t** ppMapped)
+{
+    VkBufferCreateInfo bufferCreateInfo = {
+      .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+      .pNext = NULL
+    };
+    VkMemoryAllocateInfo memAllocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = NULL,
+        .allocationSize = 0,
+        .memoryTypeIndex = 0
+    };
+    VkMemoryRequirements memReqs;
+    VkResult vResult;
+
+    bufferCreateInfo.size = size;
+    // This buffer is used as a transfer source for the buffer copy
+    bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkCreateBuffer(vdi->device, &bufferCreateInfo,
+                                   vdi->pAllocator, pBuffer));
+
+    // Get memory requirements for the staging buffer (alignment,
+    // memory type bits)
+    vdi->vkFuncs.vkGetBufferMemoryRequirements(vdi->device, *pBuffer, &memReqs);
+
+    memAllocInfo.allocationSize = memReqs.size;
+    // Get memory type index for a host visible buffer
+    memAllocInfo.memoryTypeIndex = ktxVulkanDeviceInfo_getMemoryType(
+            vdi,
+            memReqs.memoryTypeBits,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+          | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+
+    vResult = vdi->vkFuncs.vkAllocateMemory(vdi->device, &memAllocInfo,
+                              vdi->pAllocator, pMemory);
+    if (vResult != VK_SUCCESS) {
+        vdi->vkFuncs.vkDestroyBuffer(vdi->device, *pBuffer, vdi->pAllocator);
+        return KTX_OUT_OF_MEMORY;
+    }
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkBindBufferMemory(vdi->device, *pBuffer,
+                                       *pMemory, 0));
+
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkMapMemory(vdi->device, *pMemory, 0,
+                                memReqs.size, 0,
+                                (void **)ppMapped));
+    *pMemorySize = memReqs.size;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Create the optimally tiled image described by a ktxVulkanTexture
+ *        and bind device-local memory to it.
+ *
+ * @param[in] vdi          pointer to the Vulkan device information.
+ * @param[in,out] vkTexture pointer to the description of the image. The
+ *                          handles of the image and its memory are written
+ *                          to it.
+ * @param[in] imageType    the type of image to create.
+ * @param[in] createFlags  the flags to create the image with.
+ * @param[in] usageFlags   the usage of the image.
+ */
+static void
+createOptimalImage(ktxVulkanDeviceInfo* vdi, ktxVulkanTexture* vkTexture,
+                   VkImageType imageType, VkImageCreateFlags createFlags,
+                   VkImageUsageFlags usageFlags)
+{
+    VkImageCreateInfo imageCreateInfo = {
+         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+         .pNext = NULL
+    };
+    VkMemoryAllocateInfo memAllocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = NULL,
+        .allocationSize = 0,
+        .memoryTypeIndex = 0
+    };
+    VkMemoryRequirements memReqs;
+
+    imageCreateInfo.imageType = imageType;
+    imageCreateInfo.flags = createFlags;
+    imageCreateInfo.format = vkTexture->imageFormat;
+    imageCreateInfo.mipLevels = vkTexture->levelCount;
+    imageCreateInfo.arrayLayers = vkTexture->layerCount;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = usageFlags;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageCreateInfo.extent.width = vkTexture->width;
+    imageCreateInfo.extent.height = vkTexture->height;
+    imageCreateInfo.extent.depth = vkTexture->depth;
+
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkCreateImage(vdi->device, &imageCreateInfo,
+                                  vdi->pAllocator, &vkTexture->image));
+
+    vdi->vkFuncs.vkGetImageMemoryRequirements(vdi->device, vkTexture->image, &memReqs);
+
+    memAllocInfo.allocationSize = memReqs.size;
+
+    memAllocInfo.memoryTypeIndex = ktxVulkanDeviceInfo_getMemoryType(
+                                      vdi, memReqs.memoryTypeBits,
+                                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkAllocateMemory(vdi->device, &memAllocInfo,
+                                     vdi->pAllocator,
+                                     &vkTexture->deviceMemory));
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkBindImageMemory(vdi->device, vkTexture->image,
+                                      vkTexture->deviceMemory, 0));
+}
+
 /**
  * @memberof ktxTexture
  * @~English
@@ -791,12 +1078,10 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
                       VkImageLayout finalLayout)
 {
     KTX_error_code           kResult;
-    VkFilter                 blitFilter = VK_FILTER_LINEAR;
+    VkFilter                 blitFilter;
     VkFormat                 vkFormat;
     VkImageType              imageType;
-    VkImageViewType          viewType;
-    VkImageCreateFlags       createFlags = 0;
-    VkImageFormatProperties  imageFormatProperties;
+    VkImageCreateFlags       createFlags;
     VkResult                 vResult;
     VkCommandBufferBeginInfo cmdBufBeginInfo = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -813,7 +1098,6 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         .memoryTypeIndex = 0
     };
     VkMemoryRequirements     memReqs;
-    ktx_uint32_t             numImageLayers, numImageLevels;
     ktx_uint32_t elementSize = ktxTexture_GetElementSize(This);
     ktx_bool_t               canUseFasterPath;
 
@@ -826,102 +1110,16 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         return KTX_INVALID_OPERATION;
     }
 
-    /* _ktxCheckHeader should have caught this. */
-    assert(This->numFaces == 6 ? This->numDimensions == 2 : VK_TRUE);
-
-    numImageLayers = This->numLayers;
-    if (This->isCubemap) {
-        numImageLayers *= 6;
-        createFlags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
-    }
-
-    assert(This->numDimensions >= 1 && This->numDimensions <= 3);
-    switch (This->numDimensions) {
-      case 1:
-        imageType = VK_IMAGE_TYPE_1D;
-        viewType = This->isArray ?
-                        VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
-        break;
-      case 2:
-      default: // To keep compilers happy.
-        imageType = VK_IMAGE_TYPE_2D;
-        if (This->isCubemap)
-            viewType = This->isArray ?
-                        VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
-        else
-            viewType = This->isArray ?
-                        VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
-        break;
-      case 3:
-        imageType = VK_IMAGE_TYPE_3D;
-        /* 3D array textures not supported in Vulkan. Attempts to create or
-         * load them should have been trapped long before this.
-         */
-        assert(!This->isArray);
-        viewType = VK_IMAGE_VIEW_TYPE_3D;
-        break;
-    }
-
     vkFormat = ktxTexture_GetVkFormat(This);
     if (vkFormat == VK_FORMAT_UNDEFINED) {
         return KTX_INVALID_OPERATION;
     }
 
-    /* Get device properties for the requested image format */
-    if (tiling == VK_IMAGE_TILING_OPTIMAL) {
-        // Ensure we can copy from staging buffer to image.
-        usageFlags |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-    }
-    if (This->generateMipmaps) {
-        // Ensure we can blit between levels.
-        usageFlags |= (VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
-    }
-    vResult = vdi->vkFuncs.vkGetPhysicalDeviceImageFormatProperties(vdi->physicalDevice,
-                                                      vkFormat,
-                                                      imageType,
-                                                      tiling,
-                                                      usageFlags,
-                                                      createFlags,
-                                                      &imageFormatProperties);
-    if (vResult == VK_ERROR_FORMAT_NOT_SUPPORTED) {
-        return KTX_INVALID_OPERATION;
-    }
-    if (This->numLayers > imageFormatProperties.maxArrayLayers) {
-        return KTX_INVALID_OPERATION;
-    }
-
-    if (This->generateMipmaps) {
-        uint32_t max_dim;
-        VkFormatProperties    formatProperties;
-        VkFormatFeatureFlags  formatFeatureFlags;
-        VkFormatFeatureFlags  neededFeatures
-            = VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT;
-        vdi->vkFuncs.vkGetPhysicalDeviceFormatProperties(vdi->physicalDevice,
-                                            vkFormat,
-                                            &formatProperties);
-        assert(vResult == VK_SUCCESS);
-        if (tiling == VK_IMAGE_TILING_OPTIMAL)
-            formatFeatureFlags = formatProperties.optimalTilingFeatures;
-        else
-            formatFeatureFlags = formatProperties.linearTilingFeatures;
-
-        if ((formatFeatureFlags & neededFeatures) != neededFeatures)
-            return KTX_INVALID_OPERATION;
-
-        if (formatFeatureFlags & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
-            blitFilter = VK_FILTER_LINEAR;
-        else
-            blitFilter = VK_FILTER_NEAREST; // XXX INVALID_OP?
-
-        max_dim = MAX(MAX(This->baseWidth, This->baseHeight), This->baseDepth);
-        numImageLevels = (uint32_t)floor(log2(max_dim)) + 1;
-    } else {
-        numImageLevels = This->numLevels;
-    }
-
-    if (numImageLevels > imageFormatProperties.maxMipLevels) {
-        return KTX_INVALID_OPERATION;
-    }
+    kResult = describeImage(This, vdi, vkFormat, tiling, &usageFlags,
+                            finalLayout, vkTexture, &imageType,
+                            &createFlags, &blitFilter);
+    if (kResult != KTX_SUCCESS)
+        return kResult;
 
     if (This->classId == ktxTexture2_c) {
         canUseFasterPath = KTX_TRUE;
@@ -950,17 +1148,6 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
             canUseFasterPath = KTX_FALSE;
     }
 
-    vkTexture->width = This->baseWidth;
-    vkTexture->height = This->baseHeight;
-    vkTexture->depth = This->baseDepth;
-    vkTexture->imageLayout = finalLayout;
-    vkTexture->imageFormat = vkFormat;
-    vkTexture->levelCount = numImageLevels;
-    vkTexture->layerCount = numImageLayers;
-    vkTexture->viewType = viewType;
-    vkTexture->vkDestroyImage = vdi->vkFuncs.vkDestroyImage;
-    vkTexture->vkFreeMemory = vdi->vkFuncs.vkFreeMemory;
-
     VK_CHECK_RESULT(
             vdi->vkFuncs.vkBeginCommandBuffer(vdi->cmdBuffer, &cmdBufBeginInfo)
             );
@@ -970,12 +1157,9 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         // Create a host-visible staging buffer that contains the raw image data
         VkBuffer stagingBuffer;
         VkDeviceMemory stagingMemory;
+        VkDeviceSize stagingMemorySize;
         VkBufferImageCopy* copyRegions;
-        VkDeviceSize textureSize;
-        VkBufferCreateInfo bufferCreateInfo = {
-          .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-          .pNext = NULL
-        };
+        VkDeviceSize stagingSize;
         VkImageSubresourceRange subresourceRange;
         VkFence copyFence;
         VkFenceCreateInfo fenceCreateInfo = {
@@ -992,8 +1176,7 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         user_cbdata_optimal cbData;
 
 
-        textureSize = ktxTexture_GetDataSizeUncompressed(This);
-        bufferCreateInfo.size = textureSize;
+        stagingSize = ktxTexture_GetDataSizeUncompressed(This);
         if (canUseFasterPath) {
             /*
              * Because all array layers and faces are the same size they can
@@ -1015,48 +1198,21 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
              * above. A bit ad-hoc but it's only a small amount of
              * memory.
              */
-            bufferCreateInfo.size += numCopyRegions * elementSize * 4;
+            stagingSize += numCopyRegions * elementSize * 4;
         }
-        copyRegions = (VkBufferImageCopy*)malloc(sizeof(VkBufferImageCopy)
+        copyRegions = (VkBufferImageCopy*)ktxMalloc(sizeof(VkBufferImageCopy)
                                                    * numCopyRegions);
         if (copyRegions == NULL) {
             return KTX_OUT_OF_MEMORY;
         }
 
-        // This buffer is used as a transfer source for the buffer copy
-        bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-        VK_CHECK_RESULT(
-                vdi->vkFuncs.vkCreateBuffer(vdi->device, &bufferCreateInfo,
-                                       vdi->pAllocator, &stagingBuffer));
-
-        // Get memory requirements for the staging buffer (alignment,
-        // memory type bits)
-        vdi->vkFuncs.vkGetBufferMemoryRequirements(vdi->device, stagingBuffer, &memReqs);
-
-        memAllocInfo.allocationSize = memReqs.size;
-        // Get memory type index for a host visible buffer
-        memAllocInfo.memoryTypeIndex = ktxVulkanDeviceInfo_getMemoryType(
-                vdi,
-                memReqs.memoryTypeBits,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-              | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        );
-
-        vResult = vdi->vkFuncs.vkAllocateMemory(vdi->device, &memAllocInfo,
-                                  vdi->pAllocator, &stagingMemory);
-        if (vResult != VK_SUCCESS) {
-            return KTX_OUT_OF_MEMORY;
+        kResult = createStagingBuffer(vdi, stagingSize, &stagingBuffer,
+                                      &stagingMemory, &stagingMemorySize,
+                                      &pMappedStagingBuffer);
+        if (kResult != KTX_SUCCESS) {
+            ktxFree(copyRegions);
+            return kResult;
         }
-        VK_CHECK_RESULT(
-                vdi->vkFuncs.vkBindBufferMemory(vdi->device, stagingBuffer,
-                                           stagingMemory, 0));
-
-        VK_CHECK_RESULT(
-                vdi->vkFuncs.vkMapMemory(vdi->device, stagingMemory, 0,
-                                    memReqs.size, 0,
-                                    (void **)&pMappedStagingBuffer));
 
         cbData.offset = 0;
         cbData.region = copyRegions;
@@ -1075,7 +1231,7 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
             if (This->pData) {
                 // Image data has already been loaded. Copy to staging
                 // buffer.
-                assert(This->dataSize <= memAllocInfo.allocationSize);
+                assert(This->dataSize <= stagingMemorySize);
                 memcpy(pMappedStagingBuffer, This->pData, This->dataSize);
             } else {
                 /* Load the image data directly into the staging buffer. */
@@ -1084,7 +1240,7 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
                  * when building for arm64. */
                 kResult = ktxTexture_LoadImageData(This,
                                       pMappedStagingBuffer,
-                                      (ktx_size_t)memAllocInfo.allocationSize);
+                                      (ktx_size_t)stagingMemorySize);
                 if (kResult != KTX_SUCCESS)
                     return kResult;
             }
@@ -1105,7 +1261,7 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
                                             optimalTilingPadCallback,
                                             &cbData);
             } else {
-                kResult = ktxTexture_IterateLoadLevelFaces(
+                kResult = ktxTexture_iterateLoadLevelFacesReadAhead(
                                             This,
                                             optimalTilingPadCallback,
                                             &cbData);
@@ -1116,45 +1272,13 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         vdi->vkFuncs.vkUnmapMemory(vdi->device, stagingMemory);
 
         // Create optimal tiled target image
-        imageCreateInfo.imageType = imageType;
-        imageCreateInfo.flags = createFlags;
-        imageCreateInfo.format = vkFormat;
-        // numImageLevels ensures enough levels for generateMipmaps.
-        imageCreateInfo.mipLevels = numImageLevels;
-        imageCreateInfo.arrayLayers = numImageLayers;
-        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-        imageCreateInfo.usage = usageFlags;
-        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageCreateInfo.extent.width = vkTexture->width;
-        imageCreateInfo.extent.height = vkTexture->height;
-        imageCreateInfo.extent.depth = vkTexture->depth;
-
-        VK_CHECK_RESULT(
-                vdi->vkFuncs.vkCreateImage(vdi->device, &imageCreateInfo,
-                                      vdi->pAllocator, &vkTexture->image));
-
-        vdi->vkFuncs.vkGetImageMemoryRequirements(vdi->device, vkTexture->image, &memReqs);
-
-        memAllocInfo.allocationSize = memReqs.size;
-
-        memAllocInfo.memoryTypeIndex = ktxVulkanDeviceInfo_getMemoryType(
-                                          vdi, memReqs.memoryTypeBits,
-                                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        VK_CHECK_RESULT(
-                vdi->vkFuncs.vkAllocateMemory(vdi->device, &memAllocInfo,
-                                         vdi->pAllocator,
-                                         &vkTexture->deviceMemory));
-        VK_CHECK_RESULT(
-                vdi->vkFuncs.vkBindImageMemory(vdi->device, vkTexture->image,
-                                          vkTexture->deviceMemory, 0));
+        createOptimalImage(vdi, vkTexture, imageType, createFlags, usageFlags);
 
         subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
         subresourceRange.baseMipLevel = 0;
         subresourceRange.levelCount = This->numLevels;
         subresourceRange.baseArrayLayer = 0;
-        subresourceRange.layerCount = numImageLayers;
+        subresourceRange.layerCount = vkTexture->layerCount;
 
         // Image barrier to transition, possibly only the base level, image
         // layout to TRANSFER_DST_OPTIMAL so it can be used as the copy
@@ -1174,7 +1298,7 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
             numCopyRegions, copyRegions
             );
 
-        free(copyRegions);
+        ktxFree(copyRegions);
 
         if (This->generateMipmaps) {
             generateMipmaps(vkTexture, vdi,
@@ -1237,9 +1361,8 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         imageCreateInfo.extent.width = vkTexture->width;
         imageCreateInfo.extent.height = vkTexture->height;
         imageCreateInfo.extent.depth = vkTexture->depth;
-        // numImageLevels ensures enough levels for generateMipmaps.
-        imageCreateInfo.mipLevels = numImageLevels;
-        imageCreateInfo.arrayLayers = numImageLayers;
+        imageCreateInfo.mipLevels = vkTexture->levelCount;
+        imageCreateInfo.arrayLayers = vkTexture->layerCount;
         imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         imageCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;
         imageCreateInfo.usage = usageFlags;
@@ -1287,9 +1410,9 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
 
         // Iterate over images to copy texture data into mapped image memory.
         if (ktxTexture_isActiveStream(This)) {
-            kResult = ktxTexture_IterateLoadLevelFaces(This,
-                                                       callback,
-                                                       &cbData);
+            kResult = ktxTexture_iterateLoadLevelFacesReadAhead(This,
+                                                                callback,
+                                                                &cbData);
         } else {
             kResult = ktxTexture_IterateLevelFaces(This,
                                                    callback,
@@ -1311,9 +1434,9 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
             VkImageSubresourceRange subresourceRange;
             subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             subresourceRange.baseMipLevel = 0;
-            subresourceRange.levelCount = numImageLevels;
+            subresourceRange.levelCount = vkTexture->levelCount;
             subresourceRange.baseArrayLayer = 0;
-            subresourceRange.layerCount = numImageLayers;
+            subresourceRange.layerCount = vkTexture->layerCount;
 
            // Transition image layout to finalLayout.
             setImageLayout(
@@ -1440,6 +1563,301 @@ ktxTexture2_VkUpload(ktxTexture2* This, ktxVulkanDeviceInfo* vdi,
                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 }
 
+/** @memberof ktxTexture2
+ * @~English
+ * @brief Transcode a Basis Universal compressed ktxTexture2 object while
+ *        uploading it to a Vulkan image object.
+ *
+ * Creates a VkImage with format determined by @p fmt and
+ * @p transcodeFlags, as ktxTexture2_TranscodeBasis() would, and loads it
+ * with the transcoded images. Each level is transcoded directly into the
+ * staging buffer instead of into a new copy of the texture's image data
+ * that is then copied to the staging buffer. The copy of a level from the
+ * staging buffer to the image is submitted to @c vdi->queue as soon as the
+ * level has been transcoded so that copying level <i>N</i> on the device
+ * overlaps transcoding of level <i>N</i>+1 on the host. Level 0 is
+ * transcoded first so that only the copy of the smallest level is not
+ * overlapped.
+ *
+ * The image is always created with VK_IMAGE_TILING_OPTIMAL. Use
+ * ktxTexture2_TranscodeBasis() followed by ktxTexture2_VkUploadEx() for
+ * a linear tiled image.
+ *
+ * The texture itself is not modified other than having its image data
+ * loaded, if it was not already. In particular its format remains the
+ * Basis Universal one.
+ *
+ * A command buffer is allocated from @c vdi->cmdPool for each level and
+ * freed before return, in addition to the use of @c vdi->cmdBuffer for
+ * the final layout transition or mipmap generation.
+ *
+ * @param[in] This          pointer to the ktxTexture2 object to upload.
+ * @param[in] vdi           pointer to a ktxVulkanDeviceInfo structure
+ *                          providing information about the Vulkan device
+ *                          onto which to load the texture.
+ * @param[in,out] vkTexture pointer to a ktxVulkanTexture structure into which
+ *                          the function writes information about the created
+ *                          VkImage.
+ * @param[in] fmt           the format to transcode to. See
+ *                          ktxTexture2_TranscodeBasis().
+ * @param[in] transcodeFlags flags for the transcoding. See
+ *                          ktxTexture2_TranscodeBasis().
+ * @param[in] usageFlags    flags indicating the intended usage of the image.
+ * @param[in] finalLayout   the layout in which the image will be left at
+ *                          return.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This, @p vdi or @p vkTexture is @c NULL.
+ * @exception KTX_INVALID_OPERATION The texture's images are not in a Basis
+ *                                  Universal format, the target format
+ *                                  is not supported by the physical device
+ *                                  or the requested tiling and usage flags
+ *                                  or the array layer or mip level count
+ *                                  is not supported for the target format.
+ * @exception KTX_OUT_OF_MEMORY Sufficient memory could not be allocated
+ *                              on either the CPU or the Vulkan device.
+ *
+ * For other exceptions, see ktxTexture2_TranscodeBasis().
+ */
+KTX_error_code
+ktxTexture2_VkUploadTranscodedEx(ktxTexture2* This, ktxVulkanDeviceInfo* vdi,
+                                 ktxVulkanTexture* vkTexture,
+                                 ktx_transcode_fmt_e fmt,
+                                 ktx_transcode_flags transcodeFlags,
+                                 VkImageUsageFlags usageFlags,
+                                 VkImageLayout finalLayout)
+{
+    KTX_error_code           result;
+    ktxLevelTranscoder*      xcoder;
+    ktxTexture2*             prototype;
+    VkFilter                 blitFilter;
+    VkImageType              imageType;
+    VkImageCreateFlags       createFlags;
+    VkBuffer                 stagingBuffer;
+    VkDeviceMemory           stagingMemory;
+    VkDeviceSize             stagingMemorySize;
+    ktx_uint8_t*             pMappedStagingBuffer;
+    VkCommandBuffer*         levelCmdBuffers;
+    VkCommandBufferAllocateInfo cmdBufInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .pNext = NULL
+    };
+    VkCommandBufferBeginInfo cmdBufBeginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = NULL
+    };
+    VkSubmitInfo             submitInfo = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = NULL
+    };
+    VkFenceCreateInfo        fenceCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = VK_FLAGS_NONE
+    };
+    VkFence                  copyFence;
+    VkFence                  nullFence = { VK_NULL_HANDLE };
+    VkImageSubresourceRange  subresourceRange;
+    ktx_uint32_t             level;
+
+    if (!vdi || !This || !vkTexture) {
+        return KTX_INVALID_VALUE;
+    }
+
+    if (!This->pData) {
+        if (!ktxTexture_isActiveStream(ktxTexture(This)))
+            return KTX_INVALID_OPERATION;
+        // Inflates any Zstd or ZLIB supercompression too.
+        result = ktxTexture2_LoadImageData(This, NULL, 0);
+        if (result != KTX_SUCCESS)
+            return result;
+    }
+
+    result = ktxLevelTranscoder_create(This, fmt, transcodeFlags, 0,
+                                       &xcoder);
+    if (result != KTX_SUCCESS)
+        return result;
+    prototype = ktxLevelTranscoder_getPrototype(xcoder);
+
+    result = describeImage(ktxTexture(This), vdi, prototype->vkFormat,
+                           VK_IMAGE_TILING_OPTIMAL, &usageFlags, finalLayout,
+                           vkTexture, &imageType, &createFlags, &blitFilter);
+    if (result != KTX_SUCCESS)
+        goto cleanup_xcoder;
+
+    levelCmdBuffers = ktxMalloc(sizeof(VkCommandBuffer) * This->numLevels);
+    if (!levelCmdBuffers) {
+        result = KTX_OUT_OF_MEMORY;
+        goto cleanup_xcoder;
+    }
+
+    // The prototype's levels are laid out, and aligned, as the transcoded
+    // levels would be in a KTX file so the buffer offsets of each level
+    // can be taken from its level index.
+    result = createStagingBuffer(vdi,
+                       ktxTexture_calcDataSizeTexture(ktxTexture(prototype)),
+                       &stagingBuffer, &stagingMemory,
+                       &stagingMemorySize, &pMappedStagingBuffer);
+    if (result != KTX_SUCCESS)
+        goto cleanup_cmdbuffers;
+
+    cmdBufInfo.commandPool = vdi->cmdPool;
+    cmdBufInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cmdBufInfo.commandBufferCount = This->numLevels;
+    if (vdi->vkFuncs.vkAllocateCommandBuffers(vdi->device, &cmdBufInfo,
+                                              levelCmdBuffers) != VK_SUCCESS) {
+        result = KTX_OUT_OF_MEMORY;
+        goto cleanup_staging;
+    }
+
+    createOptimalImage(vdi, vkTexture, imageType, createFlags, usageFlags);
+
+    subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    subresourceRange.baseMipLevel = 0;
+    subresourceRange.levelCount = This->numLevels;
+    subresourceRange.baseArrayLayer = 0;
+    subresourceRange.layerCount = vkTexture->layerCount;
+
+    submitInfo.commandBufferCount = 1;
+    for (level = 0; level < This->numLevels; level++) {
+        ktx_size_t bufferOffset = ktxTexture2_levelDataOffset(prototype, level);
+        ktx_size_t levelSize;
+        VkBufferImageCopy copyRegion;
+
+        // Level 0 is last in the buffer so there is always room after
+        // bufferOffset for the largest level, as the transcoder requires.
+        assert(bufferOffset + ktxLevelTranscoder_getMaxLevelSize(xcoder)
+               <= stagingMemorySize);
+        result = ktxLevelTranscoder_transcode(xcoder, level,
+                           This->pData + ktxTexture2_levelDataOffset(This, level),
+                           This->_private->_levelIndex[level].byteLength,
+                           pMappedStagingBuffer + bufferOffset, &levelSize);
+        if (result != KTX_SUCCESS) {
+            // Copies of preceding levels may still be reading the buffer.
+            VK_CHECK_RESULT(vdi->vkFuncs.vkQueueWaitIdle(vdi->queue));
+            vkTexture->vkDestroyImage(vdi->device, vkTexture->image,
+                                      vdi->pAllocator);
+            vkTexture->vkFreeMemory(vdi->device, vkTexture->deviceMemory,
+                                    vdi->pAllocator);
+            goto cleanup_level_cmdbuffers;
+        }
+
+        VK_CHECK_RESULT(
+                vdi->vkFuncs.vkBeginCommandBuffer(levelCmdBuffers[level],
+                                                  &cmdBufBeginInfo));
+        if (level == 0) {
+            // Image barrier to transition, possibly only the base level,
+            // image layout to TRANSFER_DST_OPTIMAL so it can be used as
+            // the copy destination. Later submissions are ordered after it.
+            setImageLayout(
+                vdi->vkFuncs,
+                levelCmdBuffers[level],
+                vkTexture->image,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                subresourceRange);
+        }
+
+        copyRegion.bufferOffset = bufferOffset;
+        copyRegion.bufferRowLength = 0;
+        copyRegion.bufferImageHeight = 0;
+        copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copyRegion.imageSubresource.mipLevel = level;
+        copyRegion.imageSubresource.baseArrayLayer = 0;
+        copyRegion.imageSubresource.layerCount = vkTexture->layerCount;
+        copyRegion.imageOffset.x = 0;
+        copyRegion.imageOffset.y = 0;
+        copyRegion.imageOffset.z = 0;
+        copyRegion.imageExtent.width = MAX(1, This->baseWidth >> level);
+        copyRegion.imageExtent.height = MAX(1, This->baseHeight >> level);
+        copyRegion.imageExtent.depth = MAX(1, This->baseDepth >> level);
+
+        vdi->vkFuncs.vkCmdCopyBufferToImage(
+            levelCmdBuffers[level], stagingBuffer,
+            vkTexture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &copyRegion
+            );
+        VK_CHECK_RESULT(
+                vdi->vkFuncs.vkEndCommandBuffer(levelCmdBuffers[level]));
+
+        // The staging memory is host coherent and the submission makes the
+        // writes above available to the copy. Don't wait for it.
+        submitInfo.pCommandBuffers = &levelCmdBuffers[level];
+        VK_CHECK_RESULT(
+                vdi->vkFuncs.vkQueueSubmit(vdi->queue, 1, &submitInfo,
+                                           nullFence));
+    }
+
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkBeginCommandBuffer(vdi->cmdBuffer, &cmdBufBeginInfo));
+    if (This->generateMipmaps) {
+        generateMipmaps(vkTexture, vdi,
+                        blitFilter, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    } else {
+        // Transition image layout to finalLayout after all mip levels
+        // have been copied.
+        setImageLayout(
+            vdi->vkFuncs,
+            vdi->cmdBuffer,
+            vkTexture->image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            finalLayout,
+            subresourceRange);
+    }
+    VK_CHECK_RESULT(vdi->vkFuncs.vkEndCommandBuffer(vdi->cmdBuffer));
+
+    // The fence is signalled only after the copies submitted earlier have
+    // also finished, so the staging buffer can then be released.
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkCreateFence(vdi->device, &fenceCreateInfo,
+                                       vdi->pAllocator, &copyFence));
+    submitInfo.pCommandBuffers = &vdi->cmdBuffer;
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkQueueSubmit(vdi->queue, 1, &submitInfo, copyFence));
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkWaitForFences(vdi->device, 1, &copyFence,
+                                         VK_TRUE, DEFAULT_FENCE_TIMEOUT));
+    vdi->vkFuncs.vkDestroyFence(vdi->device, copyFence, vdi->pAllocator);
+
+cleanup_level_cmdbuffers:
+    vdi->vkFuncs.vkFreeCommandBuffers(vdi->device, vdi->cmdPool,
+                                      This->numLevels, levelCmdBuffers);
+cleanup_staging:
+    vdi->vkFuncs.vkUnmapMemory(vdi->device, stagingMemory);
+    vdi->vkFuncs.vkFreeMemory(vdi->device, stagingMemory, vdi->pAllocator);
+    vdi->vkFuncs.vkDestroyBuffer(vdi->device, stagingBuffer, vdi->pAllocator);
+cleanup_cmdbuffers:
+    ktxFree(levelCmdBuffers);
+cleanup_xcoder:
+    ktxLevelTranscoder_destroy(xcoder);
+    return result;
+}
+
+/** @memberof ktxTexture2
+ * @~English
+ * @brief Transcode a Basis Universal compressed ktxTexture2 object while
+ *        uploading it to a Vulkan image object.
+ *
+ * Calls ktxTexture2_VkUploadTranscodedEx() with the most commonly used
+ * options: VK_IMAGE_USAGE_SAMPLED_BIT and
+ * VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+ *
+ * @sa ktxTexture2_VkUploadTranscodedEx() for details and use that for
+ *     complete control.
+ */
+KTX_error_code
+ktxTexture2_VkUploadTranscoded(ktxTexture2* This, ktxVulkanDeviceInfo* vdi,
+                               ktxVulkanTexture* vkTexture,
+                               ktx_transcode_fmt_e fmt,
+                               ktx_transcode_flags transcodeFlags)
+{
+    return ktxTexture2_VkUploadTranscodedEx(This, vdi, vkTexture,
+                                  fmt, transcodeFlags,
+                                  VK_IMAGE_USAGE_SAMPLED_BIT,
+                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
 /** @memberof ktxTexture1
  * @~English
  * @brief Return the VkFormat enum of a ktxTexture1 object.
@@ -315,7 +315,7 @@ ktxTexture1_WriteToStream(ktxTexture1* This, ktxStream* dststr)
 
         result = dststr->write(dststr, pKvd, 1, header.bytesOfKeyValueData);
         if (This->kvDataHead != NULL)
-            free(pKvd);
+            ktxFree(pKvd);
         if (result != KTX_SUCCESS)
             return result;
     }
@@ -563,7 +563,7 @@ ktxTexture1_WriteKTX2ToStream(ktxTexture1* This, ktxStream* dststr)
     header.levelCount = This->generateMipmaps ? 0 : This->numLevels;
 
     levelIndexSize = sizeof(ktxLevelIndexEntry) * This->numLevels;
-    levelIndex = (ktxLevelIndexEntry*) malloc(levelIndexSize);
+    levelIndex = (ktxLevelIndexEntry*) ktxMalloc(levelIndexSize);
 
     offset = sizeof(header) + levelIndexSize;
 
@@ -675,7 +675,7 @@ ktxTexture1_WriteKTX2ToStream(ktxTexture1* This, ktxStream* dststr)
         assert(pKvd != NULL);
 
         result = dststr->write(dststr, pKvd, 1, kvdLen);
-        free(pKvd);
+        ktxFree(pKvd);
         if (result != KTX_SUCCESS) {
              return result;
         }
@@ -785,7 +785,7 @@ ktxTexture1_WriteKTX2ToStream(ktxTexture1* This, ktxStream* dststr)
 
 cleanup:
     free(dfd);
-    free(levelIndex);
+    ktxFree(levelIndex);
     return result;
 }
 
@@ -37,6 +37,7 @@
 #include "filestream.h"
 #include "memstream.h"
 #include "texture2.h"
+#include "ktxthread.h"
 
 #include "dfdutils/dfd.h"
 #include "vkformat_enum.h"
@@ -134,7 +135,7 @@ appendLibId(ktxHashList* head, ktxHashListEntry* writerEntry)
     // sizeof(libIdIntro) includes space for its terminating NUL which we will
     // overwrite so no need for +1 after strlen.
     libIdLen = sizeof(libIdIntro) + (ktx_uint32_t)strlen(libVer);
-    char* libId = malloc(libIdLen);
+    char* libId = ktxMalloc(libIdLen);
     if (!libId)
         return KTX_OUT_OF_MEMORY;
     strncpy(libId, libIdIntro, libIdLen);
@@ -143,6 +144,7 @@ appendLibId(ktxHashList* head, ktxHashListEntry* writerEntry)
 
     if (strnstr(id, libId, idLen) != NULL) {
         // This lib id is already in the writer value.
+        ktxFree(libId);
         return KTX_SUCCESS;
     }
 
@@ -155,11 +157,15 @@ appendLibId(ktxHashList* head, ktxHashListEntry* writerEntry)
     }
 
     size_t fullIdLen = idLen + strlen(libId) + 1;
-    if (fullIdLen > UINT_MAX)
+    if (fullIdLen > UINT_MAX) {
+        ktxFree(libId);
         return KTX_INVALID_OPERATION;
-    char* fullId = malloc(fullIdLen);
-    if (!fullId)
+    }
+    char* fullId = ktxMalloc(fullIdLen);
+    if (!fullId) {
+        ktxFree(libId);
         return KTX_OUT_OF_MEMORY;
+    }
     strncpy(fullId, id, idLen);
     strncpy(&fullId[idLen], libId, libIdLen);
     assert(fullId[fullIdLen-1] == '\0');
@@ -167,8 +173,8 @@ appendLibId(ktxHashList* head, ktxHashListEntry* writerEntry)
     ktxHashList_DeleteEntry(head, writerEntry);
     result = ktxHashList_AddKVPair(head, KTX_WRITER_KEY,
                                    (ktx_uint32_t)fullIdLen, fullId);
-    free(libId);
-    free(fullId);
+    ktxFree(libId);
+    ktxFree(fullId);
     return result;
 }
 
@@ -222,6 +228,11 @@ ktxTexture2_setImageFromStream(ktxTexture2* This, ktx_uint32_t level,
     // additional check of the internal calculations.
     assert (imageByteOffset + srcSize <= This->dataSize);
 
+    // The data may be shared with a copy or be a view of the source.
+    result = ktxTexture2_ownData(This);
+    if (result != KTX_SUCCESS)
+        return result;
+
     /* Can copy whole image at once */
     src->read(src, This->pData + imageByteOffset, srcSize);
     return KTX_SUCCESS;
@@ -322,51 +333,186 @@ ktxTexture2_SetImageFromMemory(ktxTexture2* This, ktx_uint32_t level,
 ktx_bool_t __disableWriterMetadata__ = KTX_FALSE;
 #endif
 
+/*
+ * Smallest amount of data given to each Zstandard worker when a level is
+ * split between workers. Smaller jobs lose too much ratio.
+ */
+#define KTX_ZSTD_MIN_JOB_SIZE (1024 * 1024)
+
+/*
+ * Largest window decoders accept without raising ZSTD_d_windowLogMax.
+ */
+#define KTX_ZSTD_MAX_WINDOW_LOG 27
+
+typedef struct {
+    const ktx_uint8_t* pSrc;
+    ktx_size_t srcLength;
+    ktx_uint8_t* pDst;
+    ktx_size_t dstCapacity;
+    ktx_size_t dstLength;
+    KTX_error_code result;
+} ktxDeflateJob;
+
+typedef struct {
+    const ktxZstdParams* params;
+    ktxDeflateJob** jobs;
+    ktx_uint32_t numJobs;
+} ktxDeflateWork;
+
+/*
+ * Map a Zstandard compression error to a KTX error code.
+ */
+static KTX_error_code
+zstdCompressErrorToKtx(size_t code)
+{
+    ZSTD_ErrorCode error = ZSTD_getErrorCode(code);
+    switch(error) {
+      case ZSTD_error_parameter_unsupported:
+      case ZSTD_error_parameter_outOfBound:
+        return KTX_INVALID_VALUE;
+      case ZSTD_error_dstSize_tooSmall:
+#ifdef DEBUG
+        assert(false && "Deflate dstSize too small.");
+#endif
+        return KTX_OUT_OF_MEMORY;
+      case ZSTD_error_workSpace_tooSmall:
+#ifdef DEBUG
+        assert(false && "Deflate workspace too small.");
+#endif
+        return KTX_OUT_OF_MEMORY;
+      case ZSTD_error_memory_allocation:
+        return KTX_OUT_OF_MEMORY;
+      default:
+        // The remaining errors look like they should only
+        // occur during decompression but just in case.
+        return KTX_INVALID_OPERATION;
+    }
+}
+
+/*
+ * Create a compression context set up according to @p params. @p nbWorkers
+ * Zstandard workers split the input into jobs of @p jobSize bytes. Where
+ * Zstandard is built without thread support they are silently not used.
+ */
+static KTX_error_code
+createZstdCCtx(const ktxZstdParams* params, ktx_uint32_t nbWorkers,
+               ktx_size_t jobSize, ZSTD_CCtx** pCctx)
+{
+    ZSTD_CCtx* cctx = ktxZSTD_createCCtx();
+    size_t code;
+
+    if (cctx == NULL)
+        return KTX_OUT_OF_MEMORY;
+
+    code = ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel,
+                                  (int)params->compressionLevel);
+    if (!ZSTD_isError(code) && params->windowLog)
+        code = ZSTD_CCtx_setParameter(cctx, ZSTD_c_windowLog,
+                                      (int)params->windowLog);
+    if (!ZSTD_isError(code) && params->longDistanceMatching)
+        code = ZSTD_CCtx_setParameter(cctx,
+                                      ZSTD_c_enableLongDistanceMatching, 1);
+    if (!ZSTD_isError(code) && params->strategy)
+        code = ZSTD_CCtx_setParameter(cctx, ZSTD_c_strategy,
+                                      (int)params->strategy);
+    if (ZSTD_isError(code)) {
+        ZSTD_freeCCtx(cctx);
+        return zstdCompressErrorToKtx(code);
+    }
+    if (nbWorkers > 1
+        && !ZSTD_isError(ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers,
+                                                (int)nbWorkers))) {
+        (void)ZSTD_CCtx_setParameter(cctx, ZSTD_c_jobSize, (int)jobSize);
+    }
+    *pCctx = cctx;
+    return KTX_SUCCESS;
+}
+
+static void
+deflateZstdJob(ZSTD_CCtx* cctx, ktxDeflateJob* job)
+{
+    size_t length = ZSTD_compress2(cctx, job->pDst, job->dstCapacity,
+                                   job->pSrc, job->srcLength);
+    if (ZSTD_isError(length)) {
+        job->result = zstdCompressErrorToKtx(length);
+    } else {
+        job->dstLength = length;
+        job->result = KTX_SUCCESS;
+    }
+}
+
+/*
+ * Deflate the levels in @p payload, a ktxDeflateWork, on @p threadCount
+ * threads, each using its own single-threaded context.
+ */
+static void
+deflateZstdWorker(ktx_uint32_t threadCount, ktx_uint32_t threadId,
+                  void* payload)
+{
+    ktxDeflateWork* work = (ktxDeflateWork*)payload;
+    ZSTD_CCtx* cctx = NULL;
+    KTX_error_code result;
+
+    result = createZstdCCtx(work->params, 0, 0, &cctx);
+    for (ktx_uint32_t i = threadId; i < work->numJobs; i += threadCount) {
+        if (result != KTX_SUCCESS)
+            work->jobs[i]->result = result;
+        else
+            deflateZstdJob(cctx, work->jobs[i]);
+    }
+    if (cctx)
+        ZSTD_freeCCtx(cctx);
+}
+
 /**
- * @memberof ktxTexture2
+ * @internal
  * @~English
- * @brief Write a ktxTexture object to a ktxStream in KTX format.
+ * @brief Layout of the parts of a KTX file that precede the level data.
+ */
+typedef struct {
+    KTX_header2 header;
+    ktx_uint8_t* pKvd;              /*!< Serialized metadata. */
+    ktx_uint32_t align8PadLen;      /*!< Padding before the SGD. */
+    ktx_uint32_t initialLevelPadLen;/*!< Padding before the first level. */
+    ktx_uint32_t levelAlignment;    /*!< Alignment of each level. */
+    ktx_uint64_t dataOffset;        /*!< File offset of the first level. */
+} ktxPreamble;
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Work out the layout of the parts of a KTX file that precede the
+ *        level data.
  *
- * @param[in] This      pointer to the target ktxTexture object.
- * @param[in] dststr    destination ktxStream.
+ * Checks the metadata, adds the library's id to the KTXwriter item and
+ * serializes the metadata. When @p deflateScheme is not KTX_SS_NONE the
+ * layout is for data deflated with that scheme.
  *
- * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ * @param[in] This          pointer to the target ktxTexture object.
+ * @param[in] deflateScheme KTX_SS_NONE, KTX_SS_ZSTD or KTX_SS_ZLIB.
+ * @param[out] preamble     pointer to the layout to fill in. On success the
+ *                          caller must free @c preamble->pKvd with ktxFree().
  *
- * @exception KTX_INVALID_VALUE @p This or @p dststr is NULL.
- * @exception KTX_INVALID_OPERATION
- *                              The ktxTexture does not contain any image data.
- * @exception KTX_INVALID_OPERATION
- *                              Both kvDataHead and kvData are set in the
- *                              ktxTexture
- * @exception KTX_INVALID_OPERATION
- *                              The length of the already set writerId metadata
- *                              plus the library's version id exceeds the
- *                              maximum allowed.
- * @exception KTX_FILE_OVERFLOW The file exceeded the maximum size supported by
- *                              the system.
- * @exception KTX_FILE_WRITE_ERROR
- *                              An error occurred while writing the file.
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
  */
-KTX_error_code
-ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
+static KTX_error_code
+ktxTexture2_layoutPreamble(ktxTexture2* This, ktxSupercmpScheme deflateScheme,
+                           ktxPreamble* preamble)
 {
     DECLARE_PRIVATE(ktxTexture2);
     KTX_header2 header = { .identifier = KTX2_IDENTIFIER_REF };
     KTX_error_code result;
     ktx_uint32_t kvdLen;
-    ktx_uint8_t* pKvd;
+    ktx_uint8_t* pKvd = NULL;
     ktx_uint32_t align8PadLen = 0;
     ktx_uint64_t sgdLen;
     ktx_uint32_t initialLevelPadLen;
     ktx_uint32_t levelIndexSize;
+    ktx_uint32_t levelAlignment;
     ktx_uint64_t baseOffset;
 
-    if (!dststr) {
-        return KTX_INVALID_VALUE;
-    }
-
-    if (This->pData == NULL)
-        return KTX_INVALID_OPERATION;
+    levelAlignment = deflateScheme != KTX_SS_NONE
+                   ? 1 : private->_requiredLevelAlignment;
 
     header.vkFormat = This->vkFormat;
     header.typeSize = This->_protected->_typeSize;
@@ -378,7 +524,9 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
     header.faceCount = This->numFaces;
     assert (This->generateMipmaps? This->numLevels == 1 : This->numLevels >= 1);
     header.levelCount = This->generateMipmaps ? 0 : This->numLevels;
-    header.supercompressionScheme = This->supercompressionScheme;
+    header.supercompressionScheme = deflateScheme != KTX_SS_NONE
+                                  ? deflateScheme
+                                  : This->supercompressionScheme;
 
     levelIndexSize = sizeof(ktxLevelIndexEntry) * This->numLevels;
 
@@ -435,7 +583,9 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
 #endif
 
     ktxHashList_Sort(&This->kvDataHead); // KTX2 requires sorted metadata.
-    ktxHashList_Serialize(&This->kvDataHead, &kvdLen, &pKvd);
+    result = ktxHashList_Serialize(&This->kvDataHead, &kvdLen, &pKvd);
+    if (result != KTX_SUCCESS)
+        return result;
     header.keyValueData.byteOffset = kvdLen != 0 ? (uint32_t)baseOffset : 0;
     header.keyValueData.byteLength = kvdLen;
     baseOffset += kvdLen;
@@ -450,91 +600,285 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
     header.supercompressionGlobalData.byteLength = sgdLen;
     baseOffset += sgdLen;
 
-    initialLevelPadLen = _KTX_PADN_LEN(This->_private->_requiredLevelAlignment,
-                                       baseOffset);
+    initialLevelPadLen = _KTX_PADN_LEN(levelAlignment, baseOffset);
     baseOffset += initialLevelPadLen;
 
-    // write header and indices
-    result = dststr->write(dststr, &header, sizeof(header), 1);
+    preamble->header = header;
+    preamble->pKvd = pKvd;
+    preamble->align8PadLen = align8PadLen;
+    preamble->initialLevelPadLen = initialLevelPadLen;
+    preamble->levelAlignment = levelAlignment;
+    preamble->dataOffset = baseOffset;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Calculate the size of the KTX file ktxTexture2_WriteToStream()
+ *        would write.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[out] pSize    pointer to location to write the size.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+static KTX_error_code
+ktxTexture2_calcFileSize(ktxTexture2* This, ktx_size_t* pSize)
+{
+    DECLARE_PRIVATE(ktxTexture2);
+    ktxPreamble preamble;
+    ktx_uint64_t size;
+    KTX_error_code result;
+
+    result = ktxTexture2_layoutPreamble(This, KTX_SS_NONE, &preamble);
     if (result != KTX_SUCCESS)
         return result;
-
-    // Create a copy of the level index with file-adjusted offsets and write it.
-    ktxLevelIndexEntry* levelIndex
-                            = (ktxLevelIndexEntry*)malloc(levelIndexSize);
-    if (!levelIndex)
-        return KTX_OUT_OF_MEMORY;
-    for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
-        levelIndex[level].byteLength = private->_levelIndex[level].byteLength;
-        levelIndex[level].uncompressedByteLength
-                         = private->_levelIndex[level].uncompressedByteLength;
-        levelIndex[level].byteOffset = private->_levelIndex[level].byteOffset;
-        levelIndex[level].byteOffset += baseOffset;
+    ktxFree(preamble.pKvd);
+
+    size = preamble.dataOffset;
+    for (ktx_int32_t level = This->numLevels - 1; level >= 0; level--) {
+        size += private->_levelIndex[level].byteLength;
+        if (level > 0) // No padding at end.
+            size += _KTX_PADN_LEN(preamble.levelAlignment,
+                                  private->_levelIndex[level].byteLength);
     }
-    result = dststr->write(dststr, levelIndex, levelIndexSize, 1);
-    free(levelIndex);
+    *pSize = (ktx_size_t)size;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Write the parts of a KTX file that precede the level data.
+ *
+ * The header, level index, DFD, metadata, supercompression global data and
+ * the padding before the first level are gathered into one buffer and
+ * written with a single call. When @p deflateScheme is not KTX_SS_NONE the
+ * header and DFD are written for data deflated with that scheme and the
+ * level index is written with placeholder entries.
+ *
+ * @param[in] This          pointer to the target ktxTexture object.
+ * @param[in] dststr        destination ktxStream.
+ * @param[in] deflateScheme KTX_SS_NONE, KTX_SS_ZSTD or KTX_SS_ZLIB.
+ * @param[out] pLevelIndex  pointer to location to write the address of the
+ *                          level index as written, with file offsets. The
+ *                          caller must free it with ktxFree().
+ * @param[out] pDataOffset  pointer to location to write the file offset of
+ *                          the first level's data.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+static KTX_error_code
+ktxTexture2_writePreamble(ktxTexture2* This, ktxStream* dststr,
+                          ktxSupercmpScheme deflateScheme,
+                          ktxLevelIndexEntry** pLevelIndex,
+                          ktx_uint64_t* pDataOffset)
+{
+    DECLARE_PRIVATE(ktxTexture2);
+    ktxPreamble preamble;
+    const KTX_header2* header = &preamble.header;
+    KTX_error_code result;
+    ktx_uint32_t levelIndexSize;
+    ktxLevelIndexEntry* levelIndex;
+    ktx_uint8_t* buf;
+
+    result = ktxTexture2_layoutPreamble(This, deflateScheme, &preamble);
     if (result != KTX_SUCCESS)
         return result;
 
-   // write data format descriptor
-   result = dststr->write(dststr, This->pDfd, 1, *This->pDfd);
+    levelIndexSize = sizeof(ktxLevelIndexEntry) * This->numLevels;
+    // Zeroed so all padding is already in place.
+    buf = ktxMalloc((size_t)preamble.dataOffset);
+    if (!buf) {
+        ktxFree(preamble.pKvd);
+        return KTX_OUT_OF_MEMORY;
+    }
+    memset(buf, 0, (size_t)preamble.dataOffset);
 
-   // write keyValueData
-    if (kvdLen != 0) {
-        assert(pKvd != NULL);
+    memcpy(buf, header, sizeof(KTX_header2));
 
-        result = dststr->write(dststr, pKvd, 1, kvdLen);
-        free(pKvd);
-        if (result != KTX_SUCCESS) {
-             return result;
+    // Make the level index with file-adjusted offsets.
+    levelIndex = (ktxLevelIndexEntry*)&buf[sizeof(KTX_header2)];
+    if (deflateScheme == KTX_SS_NONE) {
+        for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
+            levelIndex[level].byteLength
+                         = private->_levelIndex[level].byteLength;
+            levelIndex[level].uncompressedByteLength
+                         = private->_levelIndex[level].uncompressedByteLength;
+            levelIndex[level].byteOffset
+                         = private->_levelIndex[level].byteOffset;
+            levelIndex[level].byteOffset += preamble.dataOffset;
         }
     }
+    // else placeholders until the levels have been deflated.
+
+    memcpy(&buf[header->dataFormatDescriptor.byteOffset], This->pDfd,
+           header->dataFormatDescriptor.byteLength);
+    if (deflateScheme != KTX_SS_NONE) {
+        // Deflated data is unsized so clear bytesPlane in the written DFD.
+        uint32_t* bdb
+              = (uint32_t*)&buf[header->dataFormatDescriptor.byteOffset] + 1;
+        bdb[KHR_DF_WORD_BYTESPLANE0] = 0; /* bytesPlane3..0 = 0 */
+    }
+
+    if (header->keyValueData.byteLength != 0) {
+        memcpy(&buf[header->keyValueData.byteOffset], preamble.pKvd,
+               header->keyValueData.byteLength);
+    }
+    ktxFree(preamble.pKvd);
+
+    if (header->supercompressionGlobalData.byteLength != 0) {
+        memcpy(&buf[header->supercompressionGlobalData.byteOffset],
+               private->_supercompressionGlobalData,
+               (size_t)header->supercompressionGlobalData.byteLength);
+    }
+
+    result = dststr->write(dststr, buf, 1, (size_t)preamble.dataOffset);
+    if (result == KTX_SUCCESS) {
+        *pLevelIndex = ktxMalloc(levelIndexSize);
+        if (*pLevelIndex)
+            memcpy(*pLevelIndex, levelIndex, levelIndexSize);
+        else
+            result = KTX_OUT_OF_MEMORY;
+        *pDataOffset = preamble.dataOffset;
+    }
+    ktxFree(buf);
+    return result;
+}
 
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Write a ktxTexture object to a ktxStream in KTX format, optionally
+ *        deflating each level as it is written.
+ *
+ * When @p deflateScheme is not KTX_SS_NONE, the level index is first written
+ * with placeholder entries. Each level is then deflated into a buffer big
+ * enough for the largest level and written, after which the stream is
+ * rewound to rewrite the level index. At most one deflated level is held in
+ * memory.
+ *
+ * @param[in] This              pointer to the target ktxTexture object.
+ * @param[in] dststr            destination ktxStream.
+ * @param[in] deflateScheme     KTX_SS_NONE, KTX_SS_ZSTD or KTX_SS_ZLIB.
+ * @param[in] compressionLevel  compression level to use with
+ *                              @p deflateScheme.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+static KTX_error_code
+ktxTexture2_writeToStream(ktxTexture2* This, ktxStream* dststr,
+                          ktxSupercmpScheme deflateScheme,
+                          ktx_uint32_t compressionLevel)
+{
+    DECLARE_PRIVATE(ktxTexture2);
+    KTX_error_code result;
+    ktx_uint32_t levelAlignment;
+    ktx_uint64_t baseOffset;
+    ktx_off_t startPos = 0;
+    ktxLevelIndexEntry* levelIndex = NULL;
+    ktx_uint8_t* cmpBuf = NULL;
+    ktx_size_t cmpBufCapacity = 0;
+    ZSTD_CCtx* cctx = NULL;
     char padding[32] = { 0 };
-    // write supercompressionGlobalData & sgdPadding
-    if (private->_sgdByteLength != 0) {
-        if (align8PadLen) {
-            result = dststr->write(dststr, padding, 1, align8PadLen);
-            if (result != KTX_SUCCESS) {
-                 return result;
-            }
-        }
 
-        result = dststr->write(dststr, private->_supercompressionGlobalData,
-                               1, private->_sgdByteLength);
-        if (result != KTX_SUCCESS) {
-            return result;
-        }
+    if (!dststr) {
+        return KTX_INVALID_VALUE;
     }
 
-    if (initialLevelPadLen) {
-        result = dststr->write(dststr, padding, 1, initialLevelPadLen);
-        if (result != KTX_SUCCESS) {
-             return result;
+    if (This->pData == NULL)
+        return KTX_INVALID_OPERATION;
+
+    if (deflateScheme != KTX_SS_NONE) {
+        if (This->supercompressionScheme != KTX_SS_NONE)
+            return KTX_INVALID_OPERATION;
+        // The level index is rewritten at the end so the stream must
+        // be seekable.
+        result = dststr->getpos(dststr, &startPos);
+        if (result != KTX_SUCCESS)
+            return result;
+        levelAlignment = 1;
+
+        for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
+            cmpBufCapacity = MAX(cmpBufCapacity,
+                                 private->_levelIndex[level].byteLength);
+        }
+        if (deflateScheme == KTX_SS_ZSTD) {
+            ktxZstdParams params = {0};
+            params.structSize = sizeof(params);
+            params.compressionLevel = compressionLevel;
+            result = createZstdCCtx(&params, 0, 0, &cctx);
+            if (result != KTX_SUCCESS)
+                return result;
+            cmpBufCapacity = ZSTD_compressBound(cmpBufCapacity);
+        } else {
+            cmpBufCapacity = ktxCompressZLIBBounds(cmpBufCapacity);
+        }
+        cmpBuf = ktxMalloc(cmpBufCapacity);
+        if (!cmpBuf) {
+            result = KTX_OUT_OF_MEMORY;
+            goto cleanup;
         }
+    } else {
+        levelAlignment = private->_requiredLevelAlignment;
     }
 
+    result = ktxTexture2_writePreamble(This, dststr, deflateScheme,
+                                       &levelIndex, &baseOffset);
+    if (result != KTX_SUCCESS)
+        goto cleanup;
+
     // write the image data
+    ktx_uint64_t dataOffset = baseOffset;
     for (ktx_int32_t level = This->numLevels-1; level >= 0 && result == KTX_SUCCESS; --level)
     {
         ktx_uint64_t srcLevelOffset, levelSize;
+        const ktx_uint8_t* pLevel;
 #define DUMP_IMAGE 0
 #if defined(DEBUG) || DUMP_IMAGE
         ktx_size_t pos;
 #endif
 
+        srcLevelOffset = ktxTexture2_levelDataOffset(This, level);
+        levelSize = private->_levelIndex[level].byteLength;
+        pLevel = This->pData + srcLevelOffset;
+
+        if (deflateScheme == KTX_SS_ZSTD) {
+            size_t cmpLength = ZSTD_compress2(cctx, cmpBuf, cmpBufCapacity,
+                                              pLevel, levelSize);
+            if (ZSTD_isError(cmpLength)) {
+                result = zstdCompressErrorToKtx(cmpLength);
+                break;
+            }
+            levelSize = cmpLength;
+            pLevel = cmpBuf;
+        } else if (deflateScheme == KTX_SS_ZLIB) {
+            ktx_size_t cmpLength = cmpBufCapacity;
+            result = ktxCompressZLIBInt(cmpBuf, &cmpLength, pLevel, levelSize,
+                                        compressionLevel);
+            if (result != KTX_SUCCESS)
+                break;
+            levelSize = cmpLength;
+            pLevel = cmpBuf;
+        }
+        if (deflateScheme != KTX_SS_NONE) {
+            levelIndex[level].byteOffset = dataOffset;
+            levelIndex[level].byteLength = levelSize;
+            levelIndex[level].uncompressedByteLength
+                                    = private->_levelIndex[level].byteLength;
+            dataOffset += levelSize;
+        }
+
 #if defined(DEBUG)
         result = dststr->getpos(dststr, (ktx_off_t*)&pos);
         // Could fail if stdout is a pipe
         if (result == KTX_SUCCESS)
-            assert(pos == private->_levelIndex[level].byteOffset + baseOffset);
+            assert(pos == levelIndex[level].byteOffset + startPos);
         else
             assert(result == KTX_FILE_ISPIPE);
 #endif
 
-        srcLevelOffset = ktxTexture2_levelDataOffset(This, level);
-        levelSize = private->_levelIndex[level].byteLength;
-
 #if DUMP_IMAGE
         if (!This->isCompressed) {
             for (layer = 0; layer < This->numLayers; layer++) {
@@ -556,20 +900,68 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
         fprintf(stdout, "\n");
 #endif
         // Write entire level.
-        result = dststr->write(dststr, This->pData + srcLevelOffset,
-                               levelSize, 1);
+        result = dststr->write(dststr, pLevel, levelSize, 1);
         if (result == KTX_SUCCESS && level > 0) { // No padding at end.
-            ktx_uint32_t levelPadLen
-                       = _KTX_PADN_LEN(This->_private->_requiredLevelAlignment,
-                                       levelSize);
+            ktx_uint32_t levelPadLen = _KTX_PADN_LEN(levelAlignment,
+                                                     levelSize);
             if (levelPadLen != 0)
               result = dststr->write(dststr, padding, 1, levelPadLen);
         }
     }
 
+    if (result == KTX_SUCCESS && deflateScheme != KTX_SS_NONE) {
+        // Go back and fill in the level index.
+        ktx_off_t endPos;
+        result = dststr->getpos(dststr, &endPos);
+        if (result == KTX_SUCCESS)
+            result = dststr->setpos(dststr, startPos + sizeof(KTX_header2));
+        if (result == KTX_SUCCESS)
+            result = dststr->write(dststr, levelIndex,
+                                   sizeof(ktxLevelIndexEntry),
+                                   This->numLevels);
+        if (result == KTX_SUCCESS)
+            result = dststr->setpos(dststr, endPos);
+    }
+
+cleanup:
+    if (cctx)
+        ZSTD_freeCCtx(cctx);
+    ktxFree(cmpBuf);
+    ktxFree(levelIndex);
     return result;
 }
 
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Write a ktxTexture object to a ktxStream in KTX format.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dststr    destination ktxStream.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p dststr is NULL.
+ * @exception KTX_INVALID_OPERATION
+ *                              The ktxTexture does not contain any image data.
+ * @exception KTX_INVALID_OPERATION
+ *                              Both kvDataHead and kvData are set in the
+ *                              ktxTexture
+ * @exception KTX_INVALID_OPERATION
+ *                              The length of the already set writerId metadata
+ *                              plus the library's version id exceeds the
+ *                              maximum allowed.
+ * @exception KTX_FILE_OVERFLOW The file exceeded the maximum size supported by
+ *                              the system.
+ * @exception KTX_FILE_WRITE_ERROR
+ *                              An error occurred while writing the file.
+ */
+KTX_error_code
+ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
+{
+    return ktxTexture2_writeToStream(This, dststr, KTX_SS_NONE, 0);
+}
+
 /**
  * @memberof ktxTexture2
  * @~English
@@ -721,7 +1113,14 @@ ktxTexture2_WriteToMemory(ktxTexture2* This,
 
     *ppDstBytes = NULL;
 
-    result = ktxMemStream_construct(&dststr, KTX_FALSE);
+    if (This->pData == NULL)
+        return KTX_INVALID_OPERATION;
+
+    // Allocate exactly what is needed so the stream never has to grow.
+    result = ktxTexture2_calcFileSize(This, &strSize);
+    if (result != KTX_SUCCESS)
+        return result;
+    result = ktxMemStream_construct_sized(&dststr, strSize, KTX_FALSE);
     if (result != KTX_SUCCESS)
         return result;
 
@@ -747,113 +1146,328 @@ ktxTexture2_WriteToMemory(ktxTexture2* This,
 /**
  * @memberof ktxTexture2
  * @~English
- * @brief Deflate the data in a ktxTexture2 object using Zstandard.
+ * @brief Write a ktxTexture object to a ktxStream in KTX format,
+ *        supercompressing each level as it is written.
  *
- * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
- * all be updated after successful deflation to reflect the deflated data.
+ * The written file is the same as if ktxTexture2_DeflateZstd() or
+ * ktxTexture2_DeflateZLIB() had been called before
+ * ktxTexture2_WriteToStream() but the texture is not modified and only one
+ * deflated level is held in memory at a time. The level index is written
+ * last so @p dststr must be seekable.
  *
- * @param[in] This pointer to the ktxTexture2 object of interest.
- * @param[in] compressionLevel set speed vs compression ratio trade-off. Values
- *            between 1 and 22 are accepted. The lower the level the faster. Values
- *            above 20 should be used with caution as they require more memory.
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dststr    destination ktxStream.
+ * @param[in] scheme    supercompression scheme to use, KTX_SS_ZSTD or
+ *                      KTX_SS_ZLIB.
+ * @param[in] compressionLevel speed vs compression ratio trade-off for
+ *                      @p scheme. See ktxTexture2_DeflateZstd() and
+ *                      ktxTexture2_DeflateZLIB() for the accepted values.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p dststr is NULL or @p scheme
+ *                              is not KTX_SS_ZSTD or KTX_SS_ZLIB.
+ * @exception KTX_INVALID_OPERATION
+ *                              The ktxTexture does not contain any image data
+ *                              or is already supercompressed.
+ * @exception KTX_FILE_ISPIPE   @p dststr is not seekable.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory to carry out deflation.
+ * @exception KTX_FILE_OVERFLOW The file exceeded the maximum size supported by
+ *                              the system.
+ * @exception KTX_FILE_WRITE_ERROR
+ *                              An error occurred while writing the file.
  */
 KTX_error_code
-ktxTexture2_DeflateZstd(ktxTexture2* This, ktx_uint32_t compressionLevel)
+ktxTexture2_WriteDeflatedToStream(ktxTexture2* This, ktxStream* dststr,
+                                  ktxSupercmpScheme scheme,
+                                  ktx_uint32_t compressionLevel)
 {
-    ktx_uint32_t levelIndexByteLength =
-                            This->numLevels * sizeof(ktxLevelIndexEntry);
-    ktx_uint8_t* workBuf;
-    ktx_uint8_t* cmpData;
-    ktx_size_t dstRemainingByteLength = 0;
-    ktx_size_t byteLengthCmp = 0;
-    ktx_size_t levelOffset = 0;
-    ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
-    ktxLevelIndexEntry* nindex;
-    ktx_uint8_t* pCmpDst;
-
-    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    if (!This)
+        return KTX_INVALID_VALUE;
+    if (scheme != KTX_SS_ZSTD && scheme != KTX_SS_ZLIB)
+        return KTX_INVALID_VALUE;
 
-    if (This->supercompressionScheme != KTX_SS_NONE)
-        return KTX_INVALID_OPERATION;
+    return ktxTexture2_writeToStream(This, dststr, scheme, compressionLevel);
+}
 
-    // On rare occasions the deflated data can be a few bytes larger than
-    // the source data. Calculating the dst buffer size using
-    // ZSTD_compressBound provides a suitable size plus compression is said
-    // to run faster when the dst buffer is >= compressBound.
-    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
-        dstRemainingByteLength += ZSTD_compressBound(cindex[level].byteLength);
-    }
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Write a ktxTexture object to a stdio stream in KTX format,
+ *        supercompressing each level as it is written.
+ *
+ * See ktxTexture2_WriteDeflatedToStream() for details. @p dstsstr must be
+ * seekable.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dstsstr   destination stdio stream.
+ * @param[in] scheme    supercompression scheme to use, KTX_SS_ZSTD or
+ *                      KTX_SS_ZLIB.
+ * @param[in] compressionLevel speed vs compression ratio trade-off for
+ *                      @p scheme.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+KTX_error_code
+ktxTexture2_WriteDeflatedToStdioStream(ktxTexture2* This, FILE* dstsstr,
+                                       ktxSupercmpScheme scheme,
+                                       ktx_uint32_t compressionLevel)
+{
+    ktxStream stream;
+    KTX_error_code result = KTX_SUCCESS;
 
-    workBuf = malloc(dstRemainingByteLength + levelIndexByteLength);
-    if (workBuf == NULL)
-        return KTX_OUT_OF_MEMORY;
-    nindex = (ktxLevelIndexEntry*)workBuf;
-    pCmpDst = &workBuf[levelIndexByteLength];
+    if (!This)
+        return KTX_INVALID_VALUE;
+
+    result = ktxFileStream_construct(&stream, dstsstr, KTX_FALSE);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    return ktxTexture2_WriteDeflatedToStream(This, &stream, scheme,
+                                             compressionLevel);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Write a ktxTexture object to a named file in KTX format,
+ *        supercompressing each level as it is written.
+ *
+ * See ktxTexture2_WriteDeflatedToStream() for details.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dstname   destination file name.
+ * @param[in] scheme    supercompression scheme to use, KTX_SS_ZSTD or
+ *                      KTX_SS_ZLIB.
+ * @param[in] compressionLevel speed vs compression ratio trade-off for
+ *                      @p scheme.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+KTX_error_code
+ktxTexture2_WriteDeflatedToNamedFile(ktxTexture2* This,
+                                     const char* const dstname,
+                                     ktxSupercmpScheme scheme,
+                                     ktx_uint32_t compressionLevel)
+{
+    KTX_error_code result;
+    FILE* dst;
+
+    if (!This)
+        return KTX_INVALID_VALUE;
+
+    dst = fopen(dstname, "wb");
+    if (dst) {
+        result = ktxTexture2_WriteDeflatedToStdioStream(This, dst, scheme,
+                                                        compressionLevel);
+        fclose(dst);
+    } else
+        result = KTX_FILE_OPEN_FAILED;
+
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Make deflated levels the texture's data.
+ *
+ * On entry each entry of @p nindex gives the offset and length of a
+ * deflated level within @p cmpData. Levels must be in the same order as in
+ * the texture but may have gaps between them. The levels are packed down
+ * in place and @p cmpData is shrunk to fit. It then becomes the texture's
+ * data so compressed levels are never copied to a second buffer.
+ *
+ * @param[in] This      pointer to the ktxTexture2 object of interest.
+ * @param[in] cmpData   buffer holding the deflated levels. Ownership
+ *                      passes to the texture.
+ * @param[in,out] nindex level index for the deflated data. Updated with
+ *                       the packed offsets.
+ * @param[in] scheme    the supercompression scheme used.
+ */
+static void
+ktxTexture2_setDeflated(ktxTexture2* This, ktx_uint8_t* cmpData,
+                        ktxLevelIndexEntry* nindex, ktxSupercmpScheme scheme)
+{
+    ktx_size_t levelOffset = 0;
+    ktx_uint8_t* shrunk;
 
     for (int32_t level = This->numLevels - 1; level >= 0; level--) {
-        size_t levelByteLengthCmp =
-            ZSTD_compressCCtx(cctx, pCmpDst + levelOffset,
-                              dstRemainingByteLength,
-                              &This->pData[cindex[level].byteOffset],
-                              cindex[level].byteLength,
-                              compressionLevel);
-        if (ZSTD_isError(levelByteLengthCmp)) {
-            free(workBuf);
-            ZSTD_ErrorCode error = ZSTD_getErrorCode(levelByteLengthCmp);
-            switch(error) {
-              case ZSTD_error_parameter_outOfBound:
-                return KTX_INVALID_VALUE;
-              case ZSTD_error_dstSize_tooSmall:
-#ifdef DEBUG
-                assert(false && "Deflate dstSize too small.");
-#else
-                return KTX_OUT_OF_MEMORY;
-#endif
-              case ZSTD_error_workSpace_tooSmall:
-#ifdef DEBUG
-                assert(false && "Deflate workspace too small.");
-#else
-                return KTX_OUT_OF_MEMORY;
-#endif
-              case ZSTD_error_memory_allocation:
-                return KTX_OUT_OF_MEMORY;
-              default:
-                // The remaining errors look like they should only
-                // occur during decompression but just in case.
-#ifdef DEBUG
-                assert(true);
-#else
-                return KTX_INVALID_OPERATION;
-#endif
-            }
+        assert(nindex[level].byteOffset >= levelOffset);
+        if (nindex[level].byteOffset != levelOffset) {
+            memmove(&cmpData[levelOffset], &cmpData[nindex[level].byteOffset],
+                    nindex[level].byteLength);
+            nindex[level].byteOffset = levelOffset;
         }
-        nindex[level].byteOffset = levelOffset;
-        nindex[level].uncompressedByteLength = cindex[level].byteLength;
-        nindex[level].byteLength = levelByteLengthCmp;
-        byteLengthCmp += levelByteLengthCmp;
-        levelOffset += levelByteLengthCmp;
-        dstRemainingByteLength -= levelByteLengthCmp;
+        levelOffset += nindex[level].byteLength;
     }
-    ZSTD_freeCCtx(cctx);
+    // Shrinking normally happens in place. If it fails the larger buffer
+    // is still valid.
+    shrunk = ktxRealloc(cmpData, MAX(1, levelOffset));
+    if (shrunk != NULL)
+        cmpData = shrunk;
 
-    // Move the compressed data into a correctly sized buffer.
-    cmpData = malloc(byteLengthCmp);
-    if (cmpData == NULL) {
-        free(workBuf);
-        return KTX_OUT_OF_MEMORY;
-    }
     // Now modify the texture.
-    memcpy(cmpData, pCmpDst, byteLengthCmp); // Copy data to sized buffer.
-    memcpy(cindex, nindex, levelIndexByteLength); // Update level index
-    free(workBuf);
-    free(This->pData);
+    memcpy(This->_private->_levelIndex, nindex,
+           This->numLevels * sizeof(ktxLevelIndexEntry));
+    ktxTexture2_freeData(This);
     This->pData = cmpData;
-    This->dataSize = byteLengthCmp;
-    This->supercompressionScheme = KTX_SS_ZSTD;
+    This->dataSize = levelOffset;
+    This->supercompressionScheme = scheme;
     This->_private->_requiredLevelAlignment = 1;
     // Clear bytesPlane to indicate we're now unsized.
     uint32_t* bdb = This->pDfd + 1;
     bdb[KHR_DF_WORD_BYTESPLANE0] = 0; /* bytesPlane3..0 = 0 */
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Deflate the data in a ktxTexture2 object using Zstandard.
+ *
+ * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
+ * all be updated after successful deflation to reflect the deflated data.
+ *
+ * @param[in] This pointer to the ktxTexture2 object of interest.
+ * @param[in] compressionLevel set speed vs compression ratio trade-off. Values
+ *            between 1 and 22 are accepted. The lower the level the faster. Values
+ *            above 20 should be used with caution as they require more memory.
+ */
+KTX_error_code
+ktxTexture2_DeflateZstd(ktxTexture2* This, ktx_uint32_t compressionLevel)
+{
+    ktxZstdParams params = {0};
+    params.structSize = sizeof(params);
+    params.compressionLevel = compressionLevel;
+
+    return ktxTexture2_DeflateZstdEx(This, &params);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Deflate the data in a ktxTexture2 object using Zstandard with
+ *        extended parameters.
+ *
+ * Each level is compressed as a separate Zstandard frame so the result is
+ * the same format as from ktxTexture2_DeflateZstd(). With more than one
+ * thread, levels of at least 2 MiB are each compressed by
+ * @c params->threadCount Zstandard workers, one after the other. The rest
+ * are then compressed in parallel, one level per thread at a time.
+ * Splitting a level between workers costs a little compression ratio.
+ *
+ * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
+ * all be updated after successful deflation to reflect the deflated data.
+ *
+ * @param[in] This      pointer to the ktxTexture2 object of interest.
+ * @param[in] params    pointer to Zstandard parameters.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p params is @c NULL, its @c structSize is
+ *                              wrong or one of the parameters is out of
+ *                              range.
+ * @exception KTX_INVALID_OPERATION The texture is already supercompressed.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory to carry out deflation.
+ */
+KTX_error_code
+ktxTexture2_DeflateZstdEx(ktxTexture2* This, const ktxZstdParams* params)
+{
+    ktx_uint32_t levelIndexByteLength =
+                            This->numLevels * sizeof(ktxLevelIndexEntry);
+    ktx_uint8_t* workBuf;
+    ktx_uint8_t* cmpData;
+    ktx_size_t cmpDataCapacity = 0;
+    ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
+    ktxLevelIndexEntry* nindex;
+    ktxDeflateJob* jobs;
+    ktxDeflateWork work;
+    ktx_uint32_t threadCount;
+    KTX_error_code result = KTX_SUCCESS;
+
+    if (params == NULL || params->structSize != sizeof(ktxZstdParams))
+        return KTX_INVALID_VALUE;
+    if (params->windowLog > KTX_ZSTD_MAX_WINDOW_LOG)
+        return KTX_INVALID_VALUE;
+    if (This->supercompressionScheme != KTX_SS_NONE)
+        return KTX_INVALID_OPERATION;
+
+    threadCount = MAX(1, params->threadCount);
+
+    // On rare occasions the deflated data can be a few bytes larger than
+    // the source data. Calculating the dst buffer size using
+    // ZSTD_compressBound provides a suitable size plus compression is said
+    // to run faster when the dst buffer is >= compressBound.
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        cmpDataCapacity += ZSTD_compressBound(cindex[level].byteLength);
+    }
+
+    workBuf = ktxMalloc(levelIndexByteLength
+                        + This->numLevels * (sizeof(ktxDeflateJob)
+                                             + sizeof(ktxDeflateJob*)));
+    if (workBuf == NULL)
+        return KTX_OUT_OF_MEMORY;
+    cmpData = ktxMalloc(cmpDataCapacity);
+    if (cmpData == NULL) {
+        ktxFree(workBuf);
+        return KTX_OUT_OF_MEMORY;
+    }
+    nindex = (ktxLevelIndexEntry*)workBuf;
+    jobs = (ktxDeflateJob*)&workBuf[levelIndexByteLength];
+    work.jobs = (ktxDeflateJob**)&jobs[This->numLevels];
+    work.numJobs = 0;
+    work.params = params;
+
+    // Give each level its own destination so they can be compressed in
+    // any order. Large levels are compressed right away by several
+    // Zstandard workers. The rest are queued for the worker threads.
+    ktx_uint8_t* pDst = cmpData;
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        ktxDeflateJob* job = &jobs[level];
+
+        job->pSrc = &This->pData[cindex[level].byteOffset];
+        job->srcLength = cindex[level].byteLength;
+        job->pDst = pDst;
+        job->dstCapacity = ZSTD_compressBound(job->srcLength);
+        job->dstLength = 0;
+        job->result = KTX_SUCCESS;
+        pDst += job->dstCapacity;
+
+        if (threadCount > 1
+            && job->srcLength >= 2 * KTX_ZSTD_MIN_JOB_SIZE) {
+            ktx_size_t jobSize = MAX(KTX_ZSTD_MIN_JOB_SIZE,
+                            (job->srcLength + threadCount - 1) / threadCount);
+            ZSTD_CCtx* cctx;
+            result = createZstdCCtx(params, threadCount, jobSize, &cctx);
+            if (result != KTX_SUCCESS)
+                break;
+            deflateZstdJob(cctx, job);
+            ZSTD_freeCCtx(cctx);
+        } else {
+            work.jobs[work.numJobs++] = job;
+        }
+    }
+    if (result == KTX_SUCCESS && work.numJobs > 0) {
+        ktxLaunchThreads(MIN(threadCount, work.numJobs), deflateZstdWorker,
+                         &work);
+    }
+    for (ktx_uint32_t level = 0;
+         result == KTX_SUCCESS && level < This->numLevels; level++) {
+        result = jobs[level].result;
+    }
+    if (result != KTX_SUCCESS) {
+        ktxFree(cmpData);
+        ktxFree(workBuf);
+        return result;
+    }
+
+    for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
+        nindex[level].byteOffset = jobs[level].pDst - cmpData;
+        nindex[level].byteLength = jobs[level].dstLength;
+        nindex[level].uncompressedByteLength = cindex[level].byteLength;
+    }
+    ktxTexture2_setDeflated(This, cmpData, nindex, KTX_SS_ZSTD);
+    ktxFree(workBuf);
 
     return KTX_SUCCESS;
 }
@@ -875,14 +1489,11 @@ ktxTexture2_DeflateZLIB(ktxTexture2* This, ktx_uint32_t compressionLevel)
 {
     ktx_uint32_t levelIndexByteLength =
                             This->numLevels * sizeof(ktxLevelIndexEntry);
-    ktx_uint8_t* workBuf;
     ktx_uint8_t* cmpData;
     ktx_size_t dstRemainingByteLength = 0;
-    ktx_size_t byteLengthCmp = 0;
     ktx_size_t levelOffset = 0;
     ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
     ktxLevelIndexEntry* nindex;
-    ktx_uint8_t* pCmpDst;
 
     if (This->supercompressionScheme != KTX_SS_NONE)
         return KTX_INVALID_OPERATION;
@@ -894,51 +1505,661 @@ ktxTexture2_DeflateZLIB(ktxTexture2* This, ktx_uint32_t compressionLevel)
         dstRemainingByteLength += ktxCompressZLIBBounds(cindex[level].byteLength);
     }
 
-    workBuf = malloc(dstRemainingByteLength + levelIndexByteLength);
-    if (workBuf == NULL)
+    nindex = ktxMalloc(levelIndexByteLength);
+    if (nindex == NULL)
         return KTX_OUT_OF_MEMORY;
-    nindex = (ktxLevelIndexEntry*)workBuf;
-    pCmpDst = &workBuf[levelIndexByteLength];
+    cmpData = ktxMalloc(dstRemainingByteLength);
+    if (cmpData == NULL) {
+        ktxFree(nindex);
+        return KTX_OUT_OF_MEMORY;
+    }
 
     for (int32_t level = This->numLevels - 1; level >= 0; level--) {
         size_t levelByteLengthCmp = dstRemainingByteLength;
-        KTX_error_code result = ktxCompressZLIBInt(pCmpDst + levelOffset,
+        KTX_error_code result = ktxCompressZLIBInt(cmpData + levelOffset,
                                                     &levelByteLengthCmp,
                                                     &This->pData[cindex[level].byteOffset],
                                                     cindex[level].byteLength,
                                                     compressionLevel);
-        if (result != KTX_SUCCESS)
+        if (result != KTX_SUCCESS) {
+            ktxFree(cmpData);
+            ktxFree(nindex);
             return result;
+        }
 
         nindex[level].byteOffset = levelOffset;
         nindex[level].uncompressedByteLength = cindex[level].byteLength;
         nindex[level].byteLength = levelByteLengthCmp;
-        byteLengthCmp += levelByteLengthCmp;
         levelOffset += levelByteLengthCmp;
         dstRemainingByteLength -= levelByteLengthCmp;
     }
 
-    // Move the compressed data into a correctly sized buffer.
-    cmpData = malloc(byteLengthCmp);
-    if (cmpData == NULL) {
-        free(workBuf);
+    ktxTexture2_setDeflated(This, cmpData, nindex, KTX_SS_ZLIB);
+    ktxFree(nindex);
+
+    return KTX_SUCCESS;
+}
+
+/*
+ * Schemes and levels tried by ktxTexture2_DeflateAuto(), fastest first.
+ */
+static const struct {
+    ktxSupercmpScheme scheme;
+    ktx_uint32_t compressionLevel;
+} deflateAutoCandidates[] = {
+    { KTX_SS_ZSTD, 1 },
+    { KTX_SS_ZSTD, 3 },
+    { KTX_SS_ZSTD, 6 },
+    { KTX_SS_ZSTD, 9 },
+    { KTX_SS_ZSTD, 15 },
+    { KTX_SS_ZSTD, 19 },
+    { KTX_SS_ZLIB, 6 },
+    { KTX_SS_ZLIB, 9 },
+};
+
+#define KTX_DEFLATE_AUTO_NUM_CANDIDATES \
+    (sizeof(deflateAutoCandidates) / sizeof(deflateAutoCandidates[0]))
+
+/*
+ * Number of times each candidate is inflated when timing it. The fastest
+ * run is used to filter out interruptions.
+ */
+#define KTX_DEFLATE_AUTO_TIMING_RUNS 3
+
+typedef struct {
+    ktxSupercmpScheme scheme;
+    ktx_uint32_t compressionLevel;
+    ktx_uint8_t* cmpData;
+    ktxLevelIndexEntry* nindex;
+    ktx_size_t cmpDataSize;
+    double inflateSeconds;
+    KTX_error_code result;
+} ktxDeflateCandidate;
+
+typedef struct {
+    ktxTexture2* texture;
+    ktxDeflateCandidate* candidates;
+} ktxDeflateAutoWork;
+
+/*
+ * Deflate every level of @p texture with the scheme and level of
+ * @p candidate into a new buffer, packed in file order.
+ */
+static void
+deflateCandidate(ktxTexture2* texture, ktxDeflateCandidate* candidate)
+{
+    ktxLevelIndexEntry* cindex = texture->_private->_levelIndex;
+    ktx_size_t capacity = 0;
+    ktx_size_t offset = 0;
+    ZSTD_CCtx* cctx = NULL;
+    KTX_error_code result = KTX_SUCCESS;
+
+    for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+        capacity += candidate->scheme == KTX_SS_ZSTD
+                  ? ZSTD_compressBound(cindex[level].byteLength)
+                  : ktxCompressZLIBBounds(cindex[level].byteLength);
+    }
+    candidate->cmpData = ktxMalloc(capacity);
+    candidate->nindex = ktxMalloc(texture->numLevels
+                                  * sizeof(ktxLevelIndexEntry));
+    if (candidate->cmpData == NULL || candidate->nindex == NULL) {
+        candidate->result = KTX_OUT_OF_MEMORY;
+        return;
+    }
+    if (candidate->scheme == KTX_SS_ZSTD) {
+        ktxZstdParams params = {0};
+        params.structSize = sizeof(params);
+        params.compressionLevel = candidate->compressionLevel;
+        result = createZstdCCtx(&params, 0, 0, &cctx);
+    }
+
+    for (int32_t level = texture->numLevels - 1;
+         result == KTX_SUCCESS && level >= 0; level--) {
+        const ktx_uint8_t* pSrc = &texture->pData[cindex[level].byteOffset];
+        ktx_size_t length = capacity - offset;
+
+        if (candidate->scheme == KTX_SS_ZSTD) {
+            length = ZSTD_compress2(cctx, &candidate->cmpData[offset], length,
+                                    pSrc, cindex[level].byteLength);
+            if (ZSTD_isError(length))
+                result = zstdCompressErrorToKtx(length);
+        } else {
+            result = ktxCompressZLIBInt(&candidate->cmpData[offset], &length,
+                                        pSrc, cindex[level].byteLength,
+                                        candidate->compressionLevel);
+        }
+        candidate->nindex[level].byteOffset = offset;
+        candidate->nindex[level].byteLength = length;
+        candidate->nindex[level].uncompressedByteLength
+                                                = cindex[level].byteLength;
+        offset += length;
+    }
+    if (cctx)
+        ZSTD_freeCCtx(cctx);
+
+    if (result == KTX_SUCCESS) {
+        // Only the compressed data is kept while candidates are compared.
+        ktx_uint8_t* shrunk = ktxRealloc(candidate->cmpData, MAX(1, offset));
+        if (shrunk != NULL)
+            candidate->cmpData = shrunk;
+        candidate->cmpDataSize = offset;
+    }
+    candidate->result = result;
+}
+
+/*
+ * Deflate the candidates in @p payload, a ktxDeflateAutoWork, on
+ * @p threadCount threads.
+ */
+static void
+deflateAutoWorker(ktx_uint32_t threadCount, ktx_uint32_t threadId,
+                  void* payload)
+{
+    ktxDeflateAutoWork* work = (ktxDeflateAutoWork*)payload;
+
+    for (ktx_uint32_t i = threadId; i < KTX_DEFLATE_AUTO_NUM_CANDIDATES;
+         i += threadCount) {
+        deflateCandidate(work->texture, &work->candidates[i]);
+    }
+}
+
+/*
+ * Measure how long inflating all levels of @p candidate takes on this
+ * host. @p scratch must hold the largest level.
+ */
+static KTX_error_code
+timeCandidateInflate(ktxTexture2* texture, ktxDeflateCandidate* candidate,
+                     ZSTD_DCtx* dctx, ktx_uint8_t* scratch)
+{
+    ktxLevelIndexEntry* nindex = candidate->nindex;
+
+    candidate->inflateSeconds = 0;
+    for (ktx_uint32_t run = 0; run < KTX_DEFLATE_AUTO_TIMING_RUNS; run++) {
+        double start = ktxGetSeconds();
+        double seconds;
+        for (int32_t level = texture->numLevels - 1; level >= 0; level--) {
+            const ktx_uint8_t* pSrc = &candidate->cmpData[nindex[level].byteOffset];
+            ktx_size_t length = nindex[level].uncompressedByteLength;
+
+            if (candidate->scheme == KTX_SS_ZSTD) {
+                length = ZSTD_decompressDCtx(dctx, scratch, length, pSrc,
+                                             nindex[level].byteLength);
+                if (ZSTD_isError(length))
+                    return KTX_DECOMPRESS_CHECKSUM_ERROR;
+            } else {
+                KTX_error_code result;
+                result = ktxUncompressZLIBInt(scratch, &length, pSrc,
+                                              nindex[level].byteLength);
+                if (result != KTX_SUCCESS)
+                    return result;
+            }
+            if (length != nindex[level].uncompressedByteLength)
+                return KTX_DECOMPRESS_LENGTH_ERROR;
+        }
+        seconds = ktxGetSeconds() - start;
+        if (run == 0 || seconds < candidate->inflateSeconds)
+            candidate->inflateSeconds = seconds;
+    }
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Deflate the data in a ktxTexture2 object with the Zstandard or
+ *        ZLIB level giving the smallest result that inflates within a
+ *        budget.
+ *
+ * Several Zstandard levels and ZLIB levels are tried. The candidates are
+ * compressed in parallel on @c params->threadCount threads. Each result is
+ * then inflated on the calling thread, with nothing else running, to
+ * measure how fast this host inflates it. The smallest result meeting both
+ * @c params->minInflateMBps and @c params->maxInflateMs is kept. If none
+ * does, the one that inflates fastest is kept.
+ *
+ * The deflated data of every candidate is held in memory until the
+ * choice is made.
+ *
+ * The texture's levelIndex, dataSize, DFD and supercompressionScheme will
+ * all be updated after successful deflation to reflect the deflated data.
+ *
+ * @param[in] This      pointer to the ktxTexture2 object of interest.
+ * @param[in] params    pointer to the budget and thread count.
+ * @param[out] pResult  pointer to a struct in which to return what was
+ *                      chosen and its measurements. Can be @c NULL.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p params is @c NULL, its @c structSize is
+ *                              wrong or a budget is negative.
+ * @exception KTX_INVALID_OPERATION The texture is already supercompressed
+ *                                  or has no image data.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory to carry out deflation.
+ */
+KTX_error_code
+ktxTexture2_DeflateAuto(ktxTexture2* This, const ktxDeflateAutoParams* params,
+                        ktxDeflateAutoResult* pResult)
+{
+    ktxDeflateCandidate candidates[KTX_DEFLATE_AUTO_NUM_CANDIDATES];
+    ktxDeflateAutoWork work;
+    ktxDeflateCandidate* chosen = NULL;
+    ktx_bool_t chosenInBudget = KTX_FALSE;
+    ktx_size_t maxLevelLength = 0;
+    ktx_size_t inflatedSize = 0;
+    ktx_uint8_t* scratch = NULL;
+    ZSTD_DCtx* dctx = NULL;
+    KTX_error_code result = KTX_SUCCESS;
+
+    if (params == NULL || params->structSize != sizeof(ktxDeflateAutoParams))
+        return KTX_INVALID_VALUE;
+    if (params->minInflateMBps < 0 || params->maxInflateMs < 0)
+        return KTX_INVALID_VALUE;
+    if (This->supercompressionScheme != KTX_SS_NONE || This->pData == NULL)
+        return KTX_INVALID_OPERATION;
+
+    memset(candidates, 0, sizeof(candidates));
+    for (ktx_uint32_t i = 0; i < KTX_DEFLATE_AUTO_NUM_CANDIDATES; i++) {
+        candidates[i].scheme = deflateAutoCandidates[i].scheme;
+        candidates[i].compressionLevel
+                            = deflateAutoCandidates[i].compressionLevel;
+    }
+    for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
+        ktx_size_t length = This->_private->_levelIndex[level].byteLength;
+        maxLevelLength = MAX(maxLevelLength, length);
+        inflatedSize += length;
+    }
+
+    work.texture = This;
+    work.candidates = candidates;
+    ktxLaunchThreads(MIN(MAX(1, params->threadCount),
+                         KTX_DEFLATE_AUTO_NUM_CANDIDATES),
+                     deflateAutoWorker, &work);
+
+    scratch = ktxMalloc(MAX(1, maxLevelLength));
+    dctx = ktxZSTD_createDCtx();
+    if (scratch == NULL || dctx == NULL)
+        result = KTX_OUT_OF_MEMORY;
+
+    for (ktx_uint32_t i = 0;
+         result == KTX_SUCCESS && i < KTX_DEFLATE_AUTO_NUM_CANDIDATES; i++) {
+        ktxDeflateCandidate* candidate = &candidates[i];
+        double seconds, mbps;
+        ktx_bool_t inBudget;
+
+        result = candidate->result;
+        if (result == KTX_SUCCESS)
+            result = timeCandidateInflate(This, candidate, dctx, scratch);
+        if (result != KTX_SUCCESS)
+            break;
+
+        seconds = MAX(candidate->inflateSeconds, 1e-9);
+        mbps = inflatedSize / 1e6 / seconds;
+        inBudget = (params->minInflateMBps == 0
+                    || mbps >= params->minInflateMBps)
+                && (params->maxInflateMs == 0
+                    || seconds * 1000 <= params->maxInflateMs);
+        if (chosen == NULL
+            || (inBudget && !chosenInBudget)
+            || (inBudget && candidate->cmpDataSize < chosen->cmpDataSize)
+            || (!inBudget && !chosenInBudget
+                && candidate->inflateSeconds < chosen->inflateSeconds)) {
+            chosen = candidate;
+            chosenInBudget = inBudget;
+        }
+    }
+    ktxFree(scratch);
+    if (dctx)
+        ZSTD_freeDCtx(dctx);
+
+    if (result == KTX_SUCCESS) {
+        if (pResult) {
+            double seconds = MAX(chosen->inflateSeconds, 1e-9);
+            pResult->scheme = chosen->scheme;
+            pResult->compressionLevel = chosen->compressionLevel;
+            pResult->dataSize = chosen->cmpDataSize;
+            pResult->inflateMBps = (float)(inflatedSize / 1e6 / seconds);
+            pResult->inflateMs = (float)(chosen->inflateSeconds * 1000);
+            pResult->withinBudget = chosenInBudget;
+        }
+        ktxTexture2_setDeflated(This, chosen->cmpData, chosen->nindex,
+                                chosen->scheme);
+        chosen->cmpData = NULL;
+    }
+    for (ktx_uint32_t i = 0; i < KTX_DEFLATE_AUTO_NUM_CANDIDATES; i++) {
+        ktxFree(candidates[i].cmpData);
+        ktxFree(candidates[i].nindex);
+    }
+    return result;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief State of a KTX 2 file being written one image at a time.
+ */
+struct ktxTexture2Writer {
+    ktxTexture2* texture;   /*!< Describes the file. Has no image storage. */
+    ktxStream stream;       /*!< Destination. */
+    ktx_off_t startPos;     /*!< Stream position of the start of the file. */
+    ktx_uint64_t dataOffset;/*!< File offset of the first level. */
+    ktx_uint64_t fileSize;  /*!< Size of the complete file. */
+    ktx_uint64_t pos;       /*!< Current file offset. */
+    ktx_uint64_t end;       /*!< File offset of the end of written data. */
+    ktx_bool_t started;     /*!< KTX_TRUE once the preamble is written. */
+};
+
+/**
+ * @memberof ktxTexture2Writer
+ * @~English
+ * @brief Create a writer for a KTX 2 file to be written to a ktxStream one
+ *        image at a time.
+ *
+ * Images can be given in any order with
+ * ktxTexture2Writer_SetImageFromMemory(). Each is written to the stream
+ * straight away so only the caller's copy of the image need be held in
+ * memory. Metadata can be added with ktxTexture2Writer_AddKVPair() until the
+ * first image is set. Call ktxTexture2Writer_Finish() once all images are
+ * set.
+ *
+ * Images given in file order, i.e. smallest level first then layer then
+ * face or depth slice, are written sequentially. Other orders need
+ * @p dststr to be seekable.
+ *
+ * @param[in] createInfo pointer to a ktxTextureCreateInfo struct describing
+ *                       the texture.
+ * @param[in] dststr     destination ktxStream. It is copied so need not
+ *                       outlive this call but what it refers to must
+ *                       outlive the writer.
+ * @param[in,out] newWriter pointer to a location in which to write the
+ *                       address of the new writer.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p createInfo, @p dststr or @p newWriter is
+ *                              @c NULL.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the writer.
+ * @exception ...               See ktxTexture2_Create() for exceptions
+ *                              caused by @p createInfo.
+ */
+KTX_error_code
+ktxTexture2Writer_CreateForStream(ktxTextureCreateInfo* createInfo,
+                                  ktxStream* dststr,
+                                  ktxTexture2Writer** newWriter)
+{
+    ktxTexture2Writer* writer;
+    ktxLevelIndexEntry* levelIndex;
+    KTX_error_code result;
+
+    if (createInfo == NULL || dststr == NULL || newWriter == NULL)
+        return KTX_INVALID_VALUE;
+
+    writer = (ktxTexture2Writer*)ktxMalloc(sizeof(ktxTexture2Writer));
+    if (writer == NULL)
         return KTX_OUT_OF_MEMORY;
+    memset(writer, 0, sizeof(ktxTexture2Writer));
+
+    result = ktxTexture2_Create(createInfo, KTX_TEXTURE_CREATE_NO_STORAGE,
+                                &writer->texture);
+    if (result != KTX_SUCCESS) {
+        ktxFree(writer);
+        return result;
     }
-    // Now modify the texture.
-    memcpy(cmpData, pCmpDst, byteLengthCmp); // Copy data to sized buffer.
-    memcpy(cindex, nindex, levelIndexByteLength); // Update level index
-    free(workBuf);
-    free(This->pData);
-    This->pData = cmpData;
-    This->dataSize = byteLengthCmp;
-    This->supercompressionScheme = KTX_SS_ZLIB;
-    This->_private->_requiredLevelAlignment = 1;
-    // Clear bytesPlane to indicate we're now unsized.
-    uint32_t* bdb = This->pDfd + 1;
-    bdb[KHR_DF_WORD_BYTESPLANE0] = 0; /* bytesPlane3..0 = 0 */
+    writer->stream = *dststr;
+    // A pipe is fine so long as images are set in file order.
+    result = dststr->getpos(dststr, &writer->startPos);
+    if (result == KTX_FILE_ISPIPE)
+        writer->startPos = 0;
+    else if (result != KTX_SUCCESS) {
+        ktxTexture2Writer_Destroy(writer);
+        return result;
+    }
+    // Level 0 is last in the file.
+    levelIndex = writer->texture->_private->_levelIndex;
+    writer->fileSize = levelIndex[0].byteOffset + levelIndex[0].byteLength;
+    *newWriter = writer;
+    return KTX_SUCCESS;
+}
 
+/**
+ * @memberof ktxTexture2Writer
+ * @~English
+ * @brief Create a writer for a KTX 2 file to be written to a stdio stream
+ *        one image at a time.
+ *
+ * See ktxTexture2Writer_CreateForStream() for details.
+ *
+ * @param[in] createInfo pointer to a ktxTextureCreateInfo struct describing
+ *                       the texture.
+ * @param[in] dstsstr    destination stdio stream. It must stay open until
+ *                       the writer is destroyed.
+ * @param[in,out] newWriter pointer to a location in which to write the
+ *                       address of the new writer.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+KTX_error_code
+ktxTexture2Writer_CreateForStdioStream(ktxTextureCreateInfo* createInfo,
+                                       FILE* dstsstr,
+                                       ktxTexture2Writer** newWriter)
+{
+    ktxStream stream;
+    KTX_error_code result;
+
+    result = ktxFileStream_construct(&stream, dstsstr, KTX_FALSE);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    return ktxTexture2Writer_CreateForStream(createInfo, &stream, newWriter);
+}
+
+/**
+ * @memberof ktxTexture2Writer
+ * @~English
+ * @brief Destroy a writer.
+ *
+ * Does not close the destination. If ktxTexture2Writer_Finish() has not
+ * been called the written file is incomplete.
+ *
+ * @param[in] This pointer to the writer to destroy.
+ */
+void
+ktxTexture2Writer_Destroy(ktxTexture2Writer* This)
+{
+    if (This == NULL)
+        return;
+    ktxTexture_Destroy(ktxTexture(This->texture));
+    ktxFree(This);
+}
+
+/**
+ * @memberof ktxTexture2Writer
+ * @~English
+ * @brief Add a key-value pair to the metadata of the file being written.
+ *
+ * @param[in] This      pointer to the writer.
+ * @param[in] key       pointer to the UTF8 NUL-terminated string to be used
+ *                      as the key.
+ * @param[in] valueLen  the number of bytes of data in @p value.
+ * @param[in] value     pointer to the bytes of data constituting the value.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This, @p key or @p value is @c NULL.
+ * @exception KTX_INVALID_OPERATION An image has already been set so the
+ *                                  metadata has been written.
+ */
+KTX_error_code
+ktxTexture2Writer_AddKVPair(ktxTexture2Writer* This, const char* key,
+                            unsigned int valueLen, const void* value)
+{
+    if (This == NULL)
+        return KTX_INVALID_VALUE;
+    if (This->started)
+        return KTX_INVALID_OPERATION;
+
+    return ktxHashList_AddKVPair(&This->texture->kvDataHead, key,
+                                 valueLen, value);
+}
+
+/**
+ * @memberof ktxTexture2Writer @private
+ * @~English
+ * @brief Write the file preamble if not already written.
+ */
+static KTX_error_code
+ktxTexture2Writer_start(ktxTexture2Writer* This)
+{
+    ktxLevelIndexEntry* levelIndex;
+    KTX_error_code result;
+
+    if (This->started)
+        return KTX_SUCCESS;
+
+    result = ktxTexture2_writePreamble(This->texture, &This->stream,
+                                       KTX_SS_NONE, &levelIndex,
+                                       &This->dataOffset);
+    if (result != KTX_SUCCESS)
+        return result;
+    // Sizes are known up front so the level index is already final.
+    ktxFree(levelIndex);
+    This->fileSize += This->dataOffset;
+    This->pos = This->end = This->dataOffset;
+    This->started = KTX_TRUE;
     return KTX_SUCCESS;
 }
 
+/**
+ * @memberof ktxTexture2Writer @private
+ * @~English
+ * @brief Move to file offset @p offset.
+ *
+ * Streams cannot be positioned beyond their end so any gap between the
+ * data written so far and @p offset is filled with zeros.
+ */
+static KTX_error_code
+ktxTexture2Writer_seek(ktxTexture2Writer* This, ktx_uint64_t offset)
+{
+    static const ktx_uint8_t zeros[4096] = { 0 };
+    ktxStream* stream = &This->stream;
+    KTX_error_code result = KTX_SUCCESS;
+
+    if (This->pos == offset)
+        return KTX_SUCCESS;
+
+    if (offset > This->end) {
+        if (This->pos != This->end)
+            result = stream->setpos(stream, This->startPos + This->end);
+        This->pos = This->end;
+        while (result == KTX_SUCCESS && This->pos < offset) {
+            ktx_size_t count = (ktx_size_t)MIN(offset - This->pos,
+                                               sizeof(zeros));
+            result = stream->write(stream, zeros, 1, count);
+            if (result == KTX_SUCCESS)
+                This->pos += count;
+        }
+        This->end = MAX(This->end, This->pos);
+    } else {
+        result = stream->setpos(stream, This->startPos + offset);
+        if (result == KTX_SUCCESS)
+            This->pos = offset;
+    }
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2Writer
+ * @~English
+ * @brief Write the image for level, layer, faceSlice from an image in
+ *        memory.
+ *
+ * Uncompressed images are expected to have their rows tightly packed. The
+ * image is written to the destination before this returns. Setting the
+ * same image twice overwrites it if the destination is seekable.
+ *
+ * @param[in] This      pointer to the writer.
+ * @param[in] level     mip level of the image to set.
+ * @param[in] layer     array layer of the image to set.
+ * @param[in] faceSlice cube map face or depth slice of the image to set.
+ * @param[in] src       pointer to the image source in memory.
+ * @param[in] srcSize   size of the source image in bytes.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p src is @c NULL.
+ * @exception KTX_INVALID_VALUE @p srcSize != the expected image size for the
+ *                              specified level, layer & faceSlice.
+ * @exception KTX_INVALID_OPERATION
+ *                              @p level, @p layer or @p faceSlice is out of
+ *                              range.
+ * @exception KTX_FILE_ISPIPE   The destination is not seekable and the
+ *                              image is not the next in file order.
+ * @exception KTX_FILE_WRITE_ERROR
+ *                              An error occurred while writing the file.
+ */
+KTX_error_code
+ktxTexture2Writer_SetImageFromMemory(ktxTexture2Writer* This,
+                                     ktx_uint32_t level, ktx_uint32_t layer,
+                                     ktx_uint32_t faceSlice,
+                                     const ktx_uint8_t* src,
+                                     ktx_size_t srcSize)
+{
+    ktx_size_t imageByteOffset;
+    KTX_error_code result;
+
+    if (This == NULL || src == NULL)
+        return KTX_INVALID_VALUE;
+
+    result = ktxTexture_GetImageOffset(ktxTexture(This->texture),
+                                       level, layer, faceSlice,
+                                       &imageByteOffset);
+    if (result != KTX_SUCCESS)
+        return result;
+    if (srcSize != ktxTexture_GetImageSize(ktxTexture(This->texture), level))
+        return KTX_INVALID_VALUE;
+
+    result = ktxTexture2Writer_start(This);
+    if (result == KTX_SUCCESS)
+        result = ktxTexture2Writer_seek(This,
+                                        This->dataOffset + imageByteOffset);
+    if (result == KTX_SUCCESS)
+        result = This->stream.write(&This->stream, src, 1, srcSize);
+    if (result == KTX_SUCCESS) {
+        This->pos += srcSize;
+        This->end = MAX(This->end, This->pos);
+    }
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2Writer
+ * @~English
+ * @brief Complete the file being written.
+ *
+ * Writes the preamble if no image has been set and fills any images that
+ * were not set with zeros. On return the destination is positioned at the
+ * end of the file.
+ *
+ * @param[in] This      pointer to the writer.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This is @c NULL.
+ * @exception KTX_FILE_WRITE_ERROR
+ *                              An error occurred while writing the file.
+ */
+KTX_error_code
+ktxTexture2Writer_Finish(ktxTexture2Writer* This)
+{
+    KTX_error_code result;
+
+    if (This == NULL)
+        return KTX_INVALID_VALUE;
+
+    result = ktxTexture2Writer_start(This);
+    if (result == KTX_SUCCESS)
+        result = ktxTexture2Writer_seek(This, This->fileSize);
+    return result;
+}
+
 /** @} */
 
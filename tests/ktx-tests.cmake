@@ -0,0 +1,116 @@
+# -*- tab-width: 4; -*-
+# vi: set sw=2 ts=4 expandtab:
+
+# Copyright 2026 The Khronos Group Inc.
+# SPDX-License-Identifier: Apache-2.0
+
+# Tests of ktx tool options not yet covered by the CTS.
+
+set( SRC_IMG_DIR "${CMAKE_CURRENT_SOURCE_DIR}/srcimages" )
+
+# Why are there <test> and matching <test>-exit-code tests
+#
+# See comment under the same title in ./ktx2check-tests.cmake.
+
+add_test( NAME ktx-create-supercompress-budget-zero
+    COMMAND ktxtools create --format R8G8B8_SRGB --supercompress-budget 0 rgb.ppm foo.ktx2
+    WORKING_DIRECTORY ${SRC_IMG_DIR}
+)
+set_tests_properties(
+    ktx-create-supercompress-budget-zero
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "Invalid supercompress-budget: \"0\". Value must be greater than 0."
+)
+add_test( NAME ktx-create-supercompress-budget-zero-exit-code
+    COMMAND ktxtools create --format R8G8B8_SRGB --supercompress-budget 0 rgb.ppm foo.ktx2
+    WORKING_DIRECTORY ${SRC_IMG_DIR}
+)
+set_tests_properties(
+    ktx-create-supercompress-budget-zero-exit-code
+PROPERTIES
+    WILL_FAIL TRUE
+)
+
+add_test( NAME ktx-create-supercompress-budget-zstd
+    COMMAND ktxtools create --format R8G8B8_SRGB --supercompress-budget 50 --zstd 5 rgb.ppm foo.ktx2
+    WORKING_DIRECTORY ${SRC_IMG_DIR}
+)
+set_tests_properties(
+    ktx-create-supercompress-budget-zstd
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "Conflicting options: supercompress-budget cannot be used with zstd or zlib."
+)
+add_test( NAME ktx-create-supercompress-budget-zstd-exit-code
+    COMMAND ktxtools create --format R8G8B8_SRGB --supercompress-budget 50 --zstd 5 rgb.ppm foo.ktx2
+    WORKING_DIRECTORY ${SRC_IMG_DIR}
+)
+set_tests_properties(
+    ktx-create-supercompress-budget-zstd-exit-code
+PROPERTIES
+    WILL_FAIL TRUE
+)
+
+add_test( NAME ktx-encode-basis-lz-supercompress-budget
+    COMMAND ktxtools encode --codec basis-lz --supercompress-budget 50 foo.ktx2 bar.ktx2
+    WORKING_DIRECTORY ${SRC_IMG_DIR}
+)
+set_tests_properties(
+    ktx-encode-basis-lz-supercompress-budget
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "Cannot encode to BasisLZ and supercompress with a budget."
+)
+add_test( NAME ktx-encode-basis-lz-supercompress-budget-exit-code
+    COMMAND ktxtools encode --codec basis-lz --supercompress-budget 50 foo.ktx2 bar.ktx2
+    WORKING_DIRECTORY ${SRC_IMG_DIR}
+)
+set_tests_properties(
+    ktx-encode-basis-lz-supercompress-budget-exit-code
+PROPERTIES
+    WILL_FAIL TRUE
+)
+
+# --threads is accepted without encoding only when it is used for the
+# supercompression budget.
+add_test( NAME ktx-create-threads-no-encode
+    COMMAND ktxtools create --format R8G8B8_SRGB --threads 2 rgb.ppm foo.ktx2
+    WORKING_DIRECTORY ${SRC_IMG_DIR}
+)
+set_tests_properties(
+    ktx-create-threads-no-encode
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "Invalid use of argument --threads that only applies to encoding."
+)
+
+# Check the output is supercompressed with one of the schemes the budget
+# chooses between. The level chosen depends on the machine so the output
+# cannot be compared with a reference file.
+function( budgettest test_name command args )
+    set( workfile ${CMAKE_CURRENT_BINARY_DIR}/ktx.${test_name}.ktx2 )
+    add_test( NAME ktx-${test_name}
+        COMMAND ${BASH_EXECUTABLE} -c "$<TARGET_FILE:ktxtools> ${command} ${args} ${workfile} && $<TARGET_FILE:ktxtools> info ${workfile} && rm ${workfile}"
+        WORKING_DIRECTORY ${SRC_IMG_DIR}
+    )
+    set_tests_properties(
+        ktx-${test_name}
+    PROPERTIES
+        PASS_REGULAR_EXPRESSION "supercompressionScheme: KTX_SS_(ZSTD|ZLIB)"
+        FAIL_REGULAR_EXPRESSION "fatal"
+    )
+endfunction()
+
+budgettest( create-supercompress-budget create
+    "--format R8G8B8_SRGB --supercompress-budget 50 rgb.ppm" )
+budgettest( create-supercompress-budget-threads create
+    "--format R8G8B8_SRGB --supercompress-budget 50 --threads 1 rgb.ppm" )
+
+set( workfile ${CMAKE_CURRENT_BINARY_DIR}/ktx.encode-uastc-supercompress-budget-threads )
+add_test( NAME ktx-encode-uastc-supercompress-budget-threads
+    COMMAND ${BASH_EXECUTABLE} -c "$<TARGET_FILE:ktxtools> create --format R8G8B8_SRGB rgb.ppm ${workfile}.in.ktx2 && $<TARGET_FILE:ktxtools> encode --codec uastc --supercompress-budget 50 --threads 1 ${workfile}.in.ktx2 ${workfile}.ktx2 && $<TARGET_FILE:ktxtools> info ${workfile}.ktx2 && rm ${workfile}.in.ktx2 ${workfile}.ktx2"
+    WORKING_DIRECTORY ${SRC_IMG_DIR}
+)
+set_tests_properties(
+    ktx-encode-uastc-supercompress-budget-threads
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "supercompressionScheme: KTX_SS_(ZSTD|ZLIB)"
+    FAIL_REGULAR_EXPRESSION "fatal"
+)
@@ -190,10 +190,12 @@ void Texture::loadFile() {
 
 void Texture::loadKTX() {
     KTX_error_code ec = KTX_SUCCESS;
+    // rawData is kept unchanged for the lifetime of the texture so the image
+    // data can be used in place instead of being copied.
     ec = ktxTexture2_CreateFromMemory(
             reinterpret_cast<const ktx_uint8_t*>(rawData.data()),
             rawData.size(),
-            KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+            KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT | KTX_TEXTURE_CREATE_BORROW_DATA_BIT,
             &handle);
     if (ec != KTX_SUCCESS)
         error(EXIT_CODE_ERROR, "ktxdiff error \"{}\": ktxTexture2_CreateFromNamedFile: {}\n", filepath, ktxErrorString(ec));
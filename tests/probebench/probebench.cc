@@ -0,0 +1,95 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2023 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Time reading the header information of a set of KTX files with
+ * ktxProbeHeaderFromNamedFile against ktxTexture_CreateFromNamedFile.
+ *
+ * Usage: probebench [-n <iterations>] <file>...
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "ktx.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double
+elapsedUs(Clock::time_point start, size_t count)
+{
+    std::chrono::duration<double, std::micro> d = Clock::now() - start;
+    return d.count() / count;
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::vector<const char*> files;
+    int iterations = 100;
+    size_t count;
+    size_t failures = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            iterations = atoi(argv[++i]);
+        else
+            files.push_back(argv[i]);
+    }
+    if (files.empty() || iterations <= 0) {
+        fprintf(stderr, "Usage: %s [-n <iterations>] <file>...\n", argv[0]);
+        return 1;
+    }
+    count = files.size() * iterations;
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (const char* file : files) {
+            ktxTexture* texture;
+            if (ktxTexture_CreateFromNamedFile(file, 0, &texture)
+                == KTX_SUCCESS)
+                ktxTexture_Destroy(texture);
+            else
+                failures++;
+        }
+    }
+    double createUs = elapsedUs(start, count);
+
+    // Look up the same metadata an asset indexer typically wants.
+    ktxProbeKey keys[2] = { };
+    keys[0].key = KTX_ORIENTATION_KEY;
+    keys[1].key = KTX_WRITER_KEY;
+    ktx_uint8_t kvdBuffer[4096];
+    ktxTextureInfo info = { };
+    info.structSize = sizeof(info);
+    info.keys = keys;
+    info.numKeys = 2;
+    info.kvdBuffer = kvdBuffer;
+    info.kvdBufferSize = sizeof(kvdBuffer);
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (const char* file : files) {
+            if (ktxProbeHeaderFromNamedFile(file, &info) != KTX_SUCCESS)
+                failures++;
+        }
+    }
+    double probeUs = elapsedUs(start, count);
+
+    printf("%zu files x %d iterations\n", files.size(), iterations);
+    printf("ktxTexture_CreateFromNamedFile: %10.2f us/file\n", createUs);
+    printf("ktxProbeHeaderFromNamedFile:    %10.2f us/file\n", probeUs);
+    if (probeUs > 0)
+        printf("speedup:                        %10.2fx\n", createUs / probeUs);
+    if (failures)
+        printf("%zu failures\n", failures);
+    return failures ? 1 : 0;
+}
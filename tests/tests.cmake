@@ -29,6 +29,10 @@ enable_testing()
 
 add_subdirectory(transcodetests)
 add_subdirectory(streamtests)
+add_subdirectory(probebench)
+if(KTX_FEATURE_VK_UPLOAD)
+    add_subdirectory(vkuploadtests)
+endif()
 
 add_executable( unittests
     unittests/image_unittests.cc
@@ -88,6 +92,13 @@ target_link_libraries(
     ${CMAKE_THREAD_LIBS_INIT}
 )
 
+set_target_properties(
+    texturetests
+    PROPERTIES
+        CXX_STANDARD 17
+        CXX_STANDARD_REQUIRED YES
+)
+
 gtest_discover_tests(unittests
     TEST_PREFIX unittest
     # With the 5s default we get periodic timeouts on Travis & GitHub CI.
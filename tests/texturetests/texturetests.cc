@@ -23,7 +23,13 @@
   #endif
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <new>
 #include <string>
+#include <thread>
 #include <limits.h>
 #include <stdint.h>
 #include <string.h>
@@ -33,9 +39,11 @@
 #include "texture.h"
 #include "texture1.h"
 #include "texture2.h"
+#include "basis_sgd.h"
 #include "gtest/gtest.h"
 #include "wthelper.h"
 #include "vk_format.h"
+#include "zstd.h"
 
 #define ROUNDING(x) \
         (3 - ((x + KTX_GL_UNPACK_ALIGNMENT-1) % KTX_GL_UNPACK_ALIGNMENT));
@@ -44,6 +52,49 @@
 extern ktx_bool_t __disableWriterMetadata__;
 #endif
 
+// Count uses of the global operator new while newCounting is set. On
+// platforms where the library's calls resolve to these, e.g. ELF, this
+// catches allocations that bypass ktxSetAllocator.
+static std::atomic<bool> newCounting(false);
+static std::atomic<int> newCount(0);
+
+#if defined(__GNUC__)
+  // Stops GCC inlining free() into callers of delete and then warning that
+  // it is given memory from operator new.
+  #define NOINLINE __attribute__((noinline))
+#else
+  #define NOINLINE
+#endif
+
+NOINLINE void* operator new(size_t size) {
+    if (newCounting)
+        newCount++;
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+NOINLINE void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
 namespace {
 
 // Recursive function to return the greatest common divisor of a and b.
@@ -516,6 +567,7 @@ class ktxTexture_KVDataTest : public ktxTexture1TestBase { };
 class ktxTexture1_IterateLoadLevelFacesTest : public ktxTexture1TestBase { };
 class ktxTexture1_IterateLevelFacesTest : public ktxTexture1TestBase { };
 class ktxTexture1_LoadImageDataTest : public ktxTexture1TestBase { };
+class ktxTexture1_ProbeHeaderTest : public ktxTexture1TestBase { };
 
 class ktxTexture1WriteTestRGBA8 : public ktxTexture1WriteTestBase<GLubyte, 4, GL_RGBA8> { };
 class ktxTexture1WriteTestRGB8 : public ktxTexture1WriteTestBase<GLubyte, 3, GL_RGB8> { };
@@ -526,6 +578,9 @@ class ktxTexture2_IterateLevelFacesTest : public ktxTexture2TestBase<GLubyte, 4,
 class ktxTexture2_IterateLevelsTest : public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8> { };
 class ktxTexture2_LoadImageDataTest : public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8> { };
 class ktxTexture2_CreateCopyTest: public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8> { };
+class ktxTexture2_ProbeHeaderTest: public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8> { };
+class ktxTexture2_DeflateTest: public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8> { };
+class ktxTexture2_WriterTest: public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8> { };
 
 /////////////////////////////////////////
 // ktxTexture_Create tests
@@ -767,6 +822,139 @@ TEST_F(ktxTexture_KVDataTest, SkipKVData) {
     }
 }
 
+/////////////////////////////////////////
+// ktxProbeHeader tests
+////////////////////////////////////////
+
+TEST_F(ktxTexture1_ProbeHeaderTest, ProbeMemory) {
+    ktxTextureInfo info = { };
+    ktxProbeKey key = { };
+
+    if (ktxMemFile != NULL) {
+        key.key = KTX_ORIENTATION_KEY;
+        info.structSize = sizeof(info);
+        info.keys = &key;
+        info.numKeys = 1;
+        ASSERT_EQ(ktxProbeHeaderFromMemory(ktxMemFile, ktxMemFileLen, &info),
+                  KTX_SUCCESS);
+        EXPECT_EQ(info.classId, ktxTexture1_c);
+        EXPECT_EQ(info.glInternalformat, texinfo.glInternalformat);
+        EXPECT_EQ(info.baseWidth, texinfo.baseWidth);
+        EXPECT_EQ(info.baseHeight, texinfo.baseHeight);
+        EXPECT_EQ(info.numLevels, (ktx_uint32_t)mipLevels);
+        EXPECT_EQ(info.numDimensions, 2U);
+        EXPECT_EQ(info.kvdByteLength, kvDataLen);
+        ASSERT_TRUE(key.value != NULL) << "Orientation not found";
+
+        char s, t;
+        EXPECT_EQ(sscanf((const char*)key.value, KTX_ORIENTATION2_FMT, &s, &t),
+                  2);
+        EXPECT_EQ(s,'r');
+        EXPECT_EQ(t, 'd');
+    }
+}
+
+TEST_F(ktxTexture2_ProbeHeaderTest, InvalidValueAndData) {
+    ktxTextureInfo info = { };
+    ktx_uint8_t notKtx[KTX2_HEADER_SIZE] = { };
+
+    if (ktxMemFile != NULL) {
+        EXPECT_EQ(ktxProbeHeaderFromMemory(ktxMemFile, ktxMemFileLen, &info),
+                  KTX_INVALID_VALUE);
+        info.structSize = sizeof(info);
+        EXPECT_EQ(ktxProbeHeaderFromMemory(NULL, 0, &info), KTX_INVALID_VALUE);
+        EXPECT_EQ(ktxProbeHeaderFromNamedFile(NULL, &info), KTX_INVALID_VALUE);
+        EXPECT_EQ(ktxProbeHeaderFromMemory(notKtx, sizeof(notKtx), &info),
+                  KTX_UNKNOWN_FILE_FORMAT);
+        EXPECT_EQ(ktxProbeHeaderFromMemory(ktxMemFile, 40, &info),
+                  KTX_FILE_UNEXPECTED_EOF);
+    }
+}
+
+TEST_F(ktxTexture2_ProbeHeaderTest, ProbeMatchesCreate) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktxTextureInfo info = { };
+    ktxProbeKey keys[2] = { };
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              0, &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+
+        keys[0].key = KTX_WRITER_KEY;
+        keys[1].key = "NotAKey";
+        info.structSize = sizeof(info);
+        info.keys = keys;
+        info.numKeys = 2;
+        ASSERT_EQ(ktxProbeHeaderFromMemory(ktxMemFile, ktxMemFileLen, &info),
+                  KTX_SUCCESS);
+        EXPECT_EQ(info.classId, ktxTexture2_c);
+        EXPECT_EQ(info.vkFormat, texture->vkFormat);
+        EXPECT_EQ(info.baseWidth, texture->baseWidth);
+        EXPECT_EQ(info.baseHeight, texture->baseHeight);
+        EXPECT_EQ(info.baseDepth, texture->baseDepth);
+        EXPECT_EQ(info.numLevels, texture->numLevels);
+        EXPECT_EQ(info.numLayers, texture->numLayers);
+        EXPECT_EQ(info.numFaces, texture->numFaces);
+        EXPECT_EQ(info.isCubemap, texture->isCubemap);
+        EXPECT_EQ(info.supercompressionScheme, KTX_SS_NONE);
+        EXPECT_EQ(info.colorModel, ktxTexture2_GetColorModel_e(texture));
+        EXPECT_EQ(info.transferFunction, ktxTexture2_GetOETF_e(texture));
+        for (ktx_uint32_t level = 0; level < info.numLevels; level++) {
+            EXPECT_EQ(info.levels[level].uncompressedByteLength,
+                      ktxTexture_GetImageSize(ktxTexture(texture), level)
+                      * texture->numFaces * texture->numLayers);
+        }
+
+        char* pWriter;
+        ktx_uint32_t writerLen;
+        ASSERT_EQ(ktxHashList_FindValue(&texture->kvDataHead, KTX_WRITER_KEY,
+                                        &writerLen, (void**)&pWriter),
+                  KTX_SUCCESS);
+        ASSERT_TRUE(keys[0].value != NULL) << "Writer not found";
+        EXPECT_EQ(keys[0].valueLen, writerLen);
+        EXPECT_EQ(memcmp(keys[0].value, pWriter, writerLen), 0);
+        EXPECT_TRUE(keys[1].value == NULL);
+        ktxTexture_Destroy(ktxTexture(texture));
+    }
+}
+
+TEST_F(ktxTexture2_ProbeHeaderTest, ProbeStdioStream) {
+    ktxTextureInfo info = { };
+    ktxProbeKey key = { };
+    ktx_uint8_t kvdBuffer[256];
+    FILE* file;
+
+    if (ktxMemFile != NULL) {
+        file = tmpfile();
+        ASSERT_TRUE(file != NULL);
+        ASSERT_EQ(fwrite(ktxMemFile, 1, ktxMemFileLen, file), ktxMemFileLen);
+
+        key.key = KTX_ORIENTATION_KEY;
+        info.structSize = sizeof(info);
+        info.keys = &key;
+        info.numKeys = 1;
+        // Without a big enough buffer the value is not returned.
+        info.kvdBuffer = kvdBuffer;
+        info.kvdBufferSize = 4;
+        rewind(file);
+        ASSERT_EQ(ktxProbeHeaderFromStdioStream(file, &info), KTX_SUCCESS);
+        EXPECT_EQ(info.numLevels, (ktx_uint32_t)mipLevels);
+        EXPECT_TRUE(key.value == NULL);
+        ASSERT_LE(info.kvdByteLength, sizeof(kvdBuffer));
+
+        info.kvdBufferSize = sizeof(kvdBuffer);
+        rewind(file);
+        ASSERT_EQ(ktxProbeHeaderFromStdioStream(file, &info), KTX_SUCCESS);
+        ASSERT_TRUE(key.value != NULL) << "Orientation not found";
+        EXPECT_TRUE(key.value >= kvdBuffer
+                    && key.value + key.valueLen <= kvdBuffer + sizeof(kvdBuffer));
+        fclose(file);
+    }
+}
+
 /////////////////////////////////////////
 // ktxTexture_IterateLoadLevelFaces tests
 ////////////////////////////////////////
@@ -831,6 +1019,183 @@ TEST_F(ktxTexture1_IterateLoadLevelFacesTest, IterateImages) {
     }
 }
 
+TEST_F(ktxTexture2_IterateLoadLevelFacesTest, IterateImages) {
+    ktxTexture* texture = 0;
+    KTX_error_code result;
+    ktxTexture2_IterateLoadLevelFacesTest* fixture = this;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                             0, &texture);
+        EXPECT_EQ(result, KTX_SUCCESS);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+
+        EXPECT_EQ(ktxTexture_IterateLoadLevelFaces(texture, iterCallback, fixture),
+                  KTX_SUCCESS);
+        EXPECT_EQ(iterCbCalls, mipLevels)
+                  << "No. of calls to iterCallback differs from number of mip levels";
+        if (texture)
+            ktxTexture_Destroy(texture);
+    }
+}
+
+// A custom ktxStream over memory that records whether it is used from a
+// thread other than the one that created it.
+struct ThreadCheckStream {
+    const ktx_uint8_t* data;
+    ktx_size_t size;
+    ktx_size_t pos;
+    std::thread::id owner;
+    bool usedOffThread;
+
+    static ThreadCheckStream* get(ktxStream* str) {
+        ThreadCheckStream* tcs
+            = static_cast<ThreadCheckStream*>(str->data.custom_ptr.address);
+        if (std::this_thread::get_id() != tcs->owner)
+            tcs->usedOffThread = true;
+        return tcs;
+    }
+    static KTX_error_code read(ktxStream* str, void* dst,
+                               const ktx_size_t count) {
+        ThreadCheckStream* tcs = get(str);
+        if (count > tcs->size - tcs->pos)
+            return KTX_FILE_UNEXPECTED_EOF;
+        memcpy(dst, tcs->data + tcs->pos, count);
+        tcs->pos += count;
+        return KTX_SUCCESS;
+    }
+    static KTX_error_code skip(ktxStream* str, const ktx_size_t count) {
+        ThreadCheckStream* tcs = get(str);
+        if (count > tcs->size - tcs->pos)
+            return KTX_FILE_UNEXPECTED_EOF;
+        tcs->pos += count;
+        return KTX_SUCCESS;
+    }
+    static KTX_error_code getpos(ktxStream* str, ktx_off_t* const offset) {
+        *offset = get(str)->pos;
+        return KTX_SUCCESS;
+    }
+    static KTX_error_code setpos(ktxStream* str, const ktx_off_t offset) {
+        ThreadCheckStream* tcs = get(str);
+        if ((ktx_size_t)offset > tcs->size)
+            return KTX_FILE_SEEK_ERROR;
+        tcs->pos = offset;
+        return KTX_SUCCESS;
+    }
+    static KTX_error_code getsize(ktxStream* str, ktx_size_t* const size) {
+        *size = get(str)->size;
+        return KTX_SUCCESS;
+    }
+    static void destruct(ktxStream*) { }
+
+    void init(ktxStream* stream, const ktx_uint8_t* bytes, ktx_size_t length) {
+        data = bytes;
+        size = length;
+        pos = 0;
+        owner = std::this_thread::get_id();
+        usedOffThread = false;
+        memset(stream, 0, sizeof(*stream));
+        stream->read = read;
+        stream->skip = skip;
+        stream->getpos = getpos;
+        stream->setpos = setpos;
+        stream->getsize = getsize;
+        stream->destruct = destruct;
+        stream->type = eStreamTypeCustom;
+        stream->data.custom_ptr.address = this;
+    }
+};
+
+TEST_F(ktxTexture2_IterateLoadLevelFacesTest, IterateCustomStreamReadAhead) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktx_uint8_t* deflatedFile;
+    ktx_size_t deflatedFileLen;
+    ktxTexture2_IterateLoadLevelFacesTest* fixture = this;
+    ktxLoadParams params = { };
+    ktxStream stream;
+    ThreadCheckStream tcs;
+    params.structSize = sizeof(params);
+    params.readAhead = KTX_TRUE;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_DeflateZstd(texture, 5), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &deflatedFile,
+                                            &deflatedFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        tcs.init(&stream, deflatedFile, deflatedFileLen);
+        result = ktxTexture2_CreateFromStream(&stream, 0, &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromStream failed: "
+                                     << ktxErrorString(result);
+        iterCbCalls = 0;
+        EXPECT_EQ(ktxTexture2_IterateLoadLevelFacesEx(texture, iterCallback,
+                                                      fixture, &params),
+                  KTX_SUCCESS);
+        EXPECT_EQ(iterCbCalls, mipLevels);
+        // Custom stream callbacks may only work on the calling thread.
+        EXPECT_FALSE(tcs.usedOffThread);
+        ktxTexture_Destroy(ktxTexture(texture));
+        free(deflatedFile);
+    }
+}
+
+TEST_F(ktxTexture2_IterateLoadLevelFacesTest, IterateImagesReadAhead) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktx_uint8_t* deflatedFile;
+    ktx_size_t deflatedFileLen;
+    ktxTexture2_IterateLoadLevelFacesTest* fixture = this;
+    ktxLoadParams params = { };
+    params.structSize = sizeof(params);
+    params.readAhead = KTX_TRUE;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_DeflateZstd(texture, 5), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &deflatedFile,
+                                            &deflatedFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        for (int zstd = 0; zstd < 2; zstd++) {
+            if (zstd)
+                result = ktxTexture2_CreateFromMemory(deflatedFile,
+                                                      deflatedFileLen,
+                                                      0, &texture);
+            else
+                result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                                      0, &texture);
+            ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                         << ktxErrorString(result);
+            params.structSize = 0;
+            EXPECT_EQ(ktxTexture2_IterateLoadLevelFacesEx(texture,
+                                                          iterCallback,
+                                                          fixture, &params),
+                      KTX_INVALID_VALUE);
+            params.structSize = sizeof(params);
+            iterCbCalls = 0;
+            EXPECT_EQ(ktxTexture2_IterateLoadLevelFacesEx(texture,
+                                                          iterCallback,
+                                                          fixture, &params),
+                      KTX_SUCCESS);
+            EXPECT_EQ(iterCbCalls, mipLevels)
+                  << "No. of calls to iterCallback differs from number of mip levels";
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+        free(deflatedFile);
+    }
+}
+
 /////////////////////////////////////////
 // ktxTexture_IterateLevelFaces tests
 ////////////////////////////////////////
@@ -1122,33 +1487,1143 @@ TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataInternal) {
     }
 }
 
-TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataExternal) {
-    ktxTexture* texture = 0;
+TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataExternal) {
+    ktxTexture* texture = 0;
+    KTX_error_code result;
+    ktx_uint8_t* buf;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                             0,
+                                             &texture);
+        EXPECT_EQ(result, KTX_SUCCESS);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        buf = new ktx_uint8_t[paddedImageDataSize];
+        EXPECT_EQ(ktxTexture_LoadImageData(texture, buf, paddedImageDataSize),
+                  KTX_SUCCESS);
+        EXPECT_EQ(paddedImageDataSize, ktxTexture_GetDataSize(texture));
+        EXPECT_EQ(helper.compareTexture2Images(buf), true);
+        if (texture)
+            ktxTexture_Destroy(texture);
+        delete[] buf;
+    }
+}
+
+TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataBorrowed) {
+    ktxTexture* texture = 0;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT
+                                       | KTX_TEXTURE_CREATE_BORROW_DATA_BIT,
+                                       &texture);
+        EXPECT_EQ(result, KTX_SUCCESS);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        ASSERT_TRUE(texture->pData != NULL) << "Image data not loaded";
+        EXPECT_TRUE(texture->pData > ktxMemFile
+                    && texture->pData + texture->dataSize
+                       <= ktxMemFile + ktxMemFileLen)
+                    << "pData does not point into the source";
+        EXPECT_EQ(paddedImageDataSize, ktxTexture_GetDataSize(texture));
+        EXPECT_EQ(helper.compareTexture2Images(ktxTexture_GetData(texture)), true);
+        if (texture)
+            ktxTexture_Destroy(texture);
+    }
+}
+
+TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataMappedFile) {
+    ktxTexture2* texture = 0;
+    ktxTexture2* copyTexture = 0;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        std::string filename = ::testing::TempDir() + "texturetest_map.ktx2";
+        FILE* file = fopen(filename.c_str(), "wb");
+        ASSERT_TRUE(file != NULL) << "Could not create " << filename;
+        EXPECT_EQ(fwrite(ktxMemFile, 1, ktxMemFileLen, file), ktxMemFileLen);
+        fclose(file);
+
+        result = ktxTexture2_CreateFromNamedFile(filename.c_str(),
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT
+                                       | KTX_TEXTURE_CREATE_MAP_FILE_BIT,
+                                       &texture);
+        EXPECT_EQ(result, KTX_SUCCESS);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromNamedFile failed: "
+                                     << ktxErrorString(result);
+        ASSERT_TRUE(texture->pData != NULL) << "Image data not loaded";
+        EXPECT_EQ(texture->_private->_pDataIsView, KTX_TRUE);
+        EXPECT_EQ(paddedImageDataSize, ktxTexture_GetDataSize(ktxTexture(texture)));
+        EXPECT_EQ(helper.compareTexture2Images(texture->pData), true);
+
+        // The copy must own its data.
+        result = ktxTexture2_CreateCopy(texture, &copyTexture);
+        EXPECT_EQ(result, KTX_SUCCESS);
+        ASSERT_TRUE(copyTexture != NULL) << "ktxTexture2_CreateCopy failed: "
+                                         << ktxErrorString(result);
+        EXPECT_EQ(copyTexture->_private->_pDataIsView, KTX_FALSE);
+        EXPECT_NE(copyTexture->pData, texture->pData);
+        EXPECT_EQ(memcmp(texture->pData, copyTexture->pData, texture->dataSize),
+                  0);
+
+        ktxTexture_Destroy(ktxTexture(texture));
+        ktxTexture_Destroy(ktxTexture(copyTexture));
+        remove(filename.c_str());
+    }
+}
+
+TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataMappedFileZstd) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktx_uint8_t* deflatedFile;
+    ktx_size_t deflatedFileLen;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_DeflateZstd(texture, 5), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &deflatedFile,
+                                            &deflatedFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        std::string filename = ::testing::TempDir() + "texturetest_mapzstd.ktx2";
+        FILE* file = fopen(filename.c_str(), "wb");
+        ASSERT_TRUE(file != NULL) << "Could not create " << filename;
+        EXPECT_EQ(fwrite(deflatedFile, 1, deflatedFileLen, file), deflatedFileLen);
+        fclose(file);
+        free(deflatedFile);
+
+        result = ktxTexture2_CreateFromNamedFile(filename.c_str(),
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT
+                                       | KTX_TEXTURE_CREATE_MAP_FILE_BIT,
+                                       &texture);
+        EXPECT_EQ(result, KTX_SUCCESS);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromNamedFile failed: "
+                                     << ktxErrorString(result);
+        ASSERT_TRUE(texture->pData != NULL) << "Image data not loaded";
+        EXPECT_EQ(texture->_private->_pDataIsView, KTX_FALSE);
+        EXPECT_EQ(texture->supercompressionScheme, KTX_SS_NONE);
+        EXPECT_EQ(helper.compareTexture2Images(texture->pData), true);
+
+        ktxTexture_Destroy(ktxTexture(texture));
+        remove(filename.c_str());
+    }
+}
+
+TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataExThreaded) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktx_uint8_t* deflatedFile;
+    ktx_size_t deflatedFileLen;
+    ktxLoadParams params = { };
+    params.structSize = sizeof(params);
+    params.threadCount = 4;
+
+    if (ktxMemFile != NULL) {
+        for (int zlib = 0; zlib < 2; zlib++) {
+            result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+            ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                         << ktxErrorString(result);
+            if (zlib)
+                result = ktxTexture2_DeflateZLIB(texture, 6);
+            else
+                result = ktxTexture2_DeflateZstd(texture, 5);
+            ASSERT_EQ(result, KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &deflatedFile,
+                                                &deflatedFileLen), KTX_SUCCESS);
+            ktxTexture_Destroy(ktxTexture(texture));
+
+            result = ktxTexture2_CreateFromMemory(deflatedFile, deflatedFileLen,
+                                                  0, &texture);
+            ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                         << ktxErrorString(result);
+            params.structSize = 0;
+            EXPECT_EQ(ktxTexture2_LoadImageDataEx(texture, NULL, 0, &params),
+                      KTX_INVALID_VALUE);
+            params.structSize = sizeof(params);
+            EXPECT_EQ(ktxTexture2_LoadImageDataEx(texture, NULL, 0, &params),
+                      KTX_SUCCESS);
+            EXPECT_EQ(texture->supercompressionScheme, KTX_SS_NONE);
+            EXPECT_EQ(helper.compareTexture2Images(texture->pData), true);
+
+            ktxTexture_Destroy(ktxTexture(texture));
+            free(deflatedFile);
+        }
+    }
+}
+
+// Rewrite each level of a Zstd supercompressed KTX2 file image as several
+// concatenated Zstd frames, as other writers may produce.
+static std::vector<ktx_uint8_t>
+splitZstdLevels(const ktx_uint8_t* file, ktx_size_t fileLen,
+                ktx_uint32_t numFrames)
+{
+    const ktx_size_t levelIndexOffset = 80;
+    ktx_uint32_t numLevels;
+    ktx_uint64_t dataStart = fileLen;
+    std::vector<ktx_uint8_t> out;
+
+    memcpy(&numLevels, &file[40], sizeof(numLevels));
+    numLevels = MAX(1, numLevels);
+    for (ktx_uint32_t level = 0; level < numLevels; level++) {
+        ktxLevelIndexEntry entry;
+        memcpy(&entry, &file[levelIndexOffset + level * sizeof(entry)],
+               sizeof(entry));
+        dataStart = MIN(dataStart, entry.byteOffset);
+    }
+    out.assign(file, file + dataStart);
+    // Levels are stored smallest first.
+    for (ktx_int32_t level = numLevels - 1; level >= 0; level--) {
+        ktxLevelIndexEntry entry;
+        ktx_size_t entryOffset = levelIndexOffset + level * sizeof(entry);
+        memcpy(&entry, &out[entryOffset], sizeof(entry));
+
+        std::vector<ktx_uint8_t> inflated(entry.uncompressedByteLength);
+        size_t inflatedLength = ZSTD_decompress(inflated.data(),
+                                                inflated.size(),
+                                                &file[entry.byteOffset],
+                                                entry.byteLength);
+        EXPECT_EQ(inflatedLength, inflated.size());
+
+        entry.byteOffset = out.size();
+        ktx_size_t frameLength = (inflated.size() + numFrames - 1) / numFrames;
+        for (ktx_size_t offset = 0; offset < inflated.size();
+             offset += frameLength) {
+            ktx_size_t length = MIN(frameLength, inflated.size() - offset);
+            std::vector<ktx_uint8_t> frame(ZSTD_compressBound(length));
+            size_t frameSize = ZSTD_compress(frame.data(), frame.size(),
+                                             &inflated[offset], length, 3);
+            EXPECT_FALSE(ZSTD_isError(frameSize));
+            out.insert(out.end(), frame.begin(), frame.begin() + frameSize);
+        }
+        entry.byteLength = out.size() - entry.byteOffset;
+        memcpy(&out[entryOffset], &entry, sizeof(entry));
+    }
+    return out;
+}
+
+TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataExMultiFrameZstd) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktx_uint8_t* deflatedFile;
+    ktx_size_t deflatedFileLen;
+    ktxLoadParams params = { };
+    params.structSize = sizeof(params);
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_DeflateZstd(texture, 5), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &deflatedFile,
+                                            &deflatedFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+        std::vector<ktx_uint8_t> multiFrameFile
+                        = splitZstdLevels(deflatedFile, deflatedFileLen, 3);
+        free(deflatedFile);
+
+        // 1 thread inflates each level in one go, 4 splits them by frame.
+        for (ktx_uint32_t threadCount = 1; threadCount <= 4; threadCount += 3) {
+            result = ktxTexture2_CreateFromMemory(multiFrameFile.data(),
+                                                  multiFrameFile.size(),
+                                                  0, &texture);
+            ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                         << ktxErrorString(result);
+            params.threadCount = threadCount;
+            EXPECT_EQ(ktxTexture2_LoadImageDataEx(texture, NULL, 0, &params),
+                      KTX_SUCCESS);
+            EXPECT_EQ(texture->supercompressionScheme, KTX_SS_NONE);
+            EXPECT_EQ(helper.compareTexture2Images(texture->pData), true);
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+    }
+}
+
+TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataStreamedInflate) {
+    ktxTexture2* texture = 0;
+    ktxTexture2* loaded = 0;
+    KTX_error_code result;
+    ktx_uint8_t* deflatedFile;
+    ktx_size_t deflatedFileLen;
+    ktxTextureCreateInfo bigCreateInfo = texinfo;
+    std::vector<ktx_uint8_t> image;
+    ktx_uint32_t seed = 1;
+
+    // Large and noisy enough for the deflated level to span several of the
+    // chunks in which it is read.
+    bigCreateInfo.baseWidth = bigCreateInfo.baseHeight = 512;
+    bigCreateInfo.numLevels = 1;
+    bigCreateInfo.generateMipmaps = KTX_FALSE;
+    image.resize(512 * 512 * 4);
+    for (size_t i = 0; i < image.size(); i++) {
+        seed = seed * 1664525 + 1013904223;
+        image[i] = (ktx_uint8_t)(seed >> 24);
+    }
+
+    for (int zlib = 0; zlib < 2; zlib++) {
+        result = ktxTexture2_Create(&bigCreateInfo,
+                                    KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_Create failed: "
+                                     << ktxErrorString(result);
+        memcpy(texture->pData, image.data(), image.size());
+        if (zlib)
+            result = ktxTexture2_DeflateZLIB(texture, 6);
+        else
+            result = ktxTexture2_DeflateZstd(texture, 5);
+        ASSERT_EQ(result, KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &deflatedFile,
+                                            &deflatedFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        result = ktxTexture2_CreateFromMemory(deflatedFile, deflatedFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &loaded);
+        EXPECT_EQ(result, KTX_SUCCESS);
+        ASSERT_TRUE(loaded != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                    << ktxErrorString(result);
+        EXPECT_EQ(loaded->supercompressionScheme, KTX_SS_NONE);
+        ASSERT_EQ(loaded->dataSize, image.size());
+        EXPECT_EQ(memcmp(loaded->pData, image.data(), image.size()), 0);
+        ktxTexture_Destroy(ktxTexture(loaded));
+
+        // Truncated data must be reported, not read past.
+        deflatedFile[deflatedFileLen - 10] ^= 0xff;
+        result = ktxTexture2_CreateFromMemory(deflatedFile, deflatedFileLen - 1,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &loaded);
+        EXPECT_NE(result, KTX_SUCCESS);
+        free(deflatedFile);
+    }
+}
+
+TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataUnderstatedInflatedLength) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktx_uint8_t* deflatedFile;
+    ktx_size_t deflatedFileLen;
+    ktxTextureCreateInfo noisyCreateInfo = texinfo;
+    ktx_uint32_t seed = 1;
+
+    // Larger than the 32 KiB window in which miniz inflates.
+    noisyCreateInfo.baseWidth = noisyCreateInfo.baseHeight = 256;
+    noisyCreateInfo.numLevels = 1;
+    noisyCreateInfo.generateMipmaps = KTX_FALSE;
+
+    for (int zlib = 0; zlib < 2; zlib++) {
+        result = ktxTexture2_Create(&noisyCreateInfo,
+                                    KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_Create failed: "
+                                     << ktxErrorString(result);
+        for (size_t i = 0; i < texture->dataSize; i++) {
+            seed = seed * 1664525 + 1013904223;
+            texture->pData[i] = (ktx_uint8_t)(seed >> 24);
+        }
+        if (zlib)
+            result = ktxTexture2_DeflateZLIB(texture, 6);
+        else
+            result = ktxTexture2_DeflateZstd(texture, 5);
+        ASSERT_EQ(result, KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &deflatedFile,
+                                            &deflatedFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        // Record half the real inflated length of the only level so the
+        // output fills while deflated data remains.
+        ktxLevelIndexEntry entry;
+        memcpy(&entry, &deflatedFile[80], sizeof(entry));
+        entry.uncompressedByteLength /= 2;
+        memcpy(&deflatedFile[80], &entry, sizeof(entry));
+
+        std::string filename = ::testing::TempDir()
+                             + "texturetest_understated.ktx2";
+        FILE* file = fopen(filename.c_str(), "wb");
+        ASSERT_TRUE(file != NULL) << "Could not create " << filename;
+        EXPECT_EQ(fwrite(deflatedFile, 1, deflatedFileLen, file),
+                  deflatedFileLen);
+        fclose(file);
+        free(deflatedFile);
+
+        // Inflates while reading from the file.
+        result = ktxTexture2_CreateFromNamedFile(filename.c_str(),
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        EXPECT_NE(result, KTX_SUCCESS);
+        if (texture)
+            ktxTexture_Destroy(ktxTexture(texture));
+        texture = 0;
+        remove(filename.c_str());
+    }
+}
+
+TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataDecodeContext) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktxDecodeContext* ctx = 0;
+    ktx_uint8_t* deflatedFile[2];
+    ktx_size_t deflatedFileLen[2];
+    ktxLoadParams params = { };
+    params.structSize = sizeof(params);
+
+    ASSERT_EQ(ktxDecodeContext_Create(&ctx), KTX_SUCCESS);
+    params.decodeContext = ctx;
+
+    if (ktxMemFile != NULL) {
+        for (int zlib = 0; zlib < 2; zlib++) {
+            result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+            ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                         << ktxErrorString(result);
+            if (zlib)
+                result = ktxTexture2_DeflateZLIB(texture, 6);
+            else
+                result = ktxTexture2_DeflateZstd(texture, 5);
+            ASSERT_EQ(result, KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &deflatedFile[zlib],
+                                                &deflatedFileLen[zlib]),
+                      KTX_SUCCESS);
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+
+        // Reuse the context across textures, schemes and thread counts.
+        for (int i = 0; i < 8; i++) {
+            int zlib = i & 1;
+            params.threadCount = (i & 2) ? 2 : 1;
+            result = ktxTexture2_CreateFromMemory(deflatedFile[zlib],
+                                                  deflatedFileLen[zlib],
+                                                  0, &texture);
+            ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                         << ktxErrorString(result);
+            if (i & 4) {
+                params.readAhead = KTX_TRUE;
+                iterCbCalls = 0;
+                EXPECT_EQ(ktxTexture2_IterateLoadLevelFacesEx(texture,
+                                                              iterCallback,
+                                                              this, &params),
+                          KTX_SUCCESS);
+                EXPECT_EQ(iterCbCalls, mipLevels);
+            } else {
+                EXPECT_EQ(ktxTexture2_LoadImageDataEx(texture, NULL, 0,
+                                                      &params),
+                          KTX_SUCCESS);
+                EXPECT_EQ(helper.compareTexture2Images(texture->pData), true);
+            }
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+        free(deflatedFile[0]);
+        free(deflatedFile[1]);
+    }
+    ktxDecodeContext_Destroy(ctx);
+}
+
+struct CountingAllocator {
+    int allocations;
+    int outstanding;
+};
+
+static void* countingMalloc(void* pUserData, ktx_size_t size) {
+    CountingAllocator* counts = (CountingAllocator*)pUserData;
+    void* ptr = malloc(size);
+    if (ptr) {
+        counts->allocations++;
+        counts->outstanding++;
+    }
+    return ptr;
+}
+
+static void* countingRealloc(void* pUserData, void* ptr, ktx_size_t size) {
+    CountingAllocator* counts = (CountingAllocator*)pUserData;
+    void* nptr = realloc(ptr, size);
+    if (nptr && !ptr) {
+        counts->allocations++;
+        counts->outstanding++;
+    }
+    return nptr;
+}
+
+static void countingFree(void* pUserData, void* ptr) {
+    CountingAllocator* counts = (CountingAllocator*)pUserData;
+    if (ptr)
+        counts->outstanding--;
+    free(ptr);
+}
+
+TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataCustomAllocator) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktx_uint8_t* deflatedFile;
+    ktx_size_t deflatedFileLen;
+    CountingAllocator counts = { 0, 0 };
+    ktxAllocator allocator = {
+        countingMalloc, countingRealloc, countingFree, &counts
+    };
+
+    if (ktxMemFile != NULL) {
+        ktxAllocator bad = allocator;
+        bad.pfnRealloc = NULL;
+        EXPECT_EQ(ktxSetAllocator(&bad), KTX_INVALID_VALUE);
+        ASSERT_EQ(ktxSetAllocator(&allocator), KTX_SUCCESS);
+
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        EXPECT_EQ(ktxTexture2_DeflateZstd(texture, 5), KTX_SUCCESS);
+        EXPECT_EQ(ktxTexture2_WriteToMemory(texture, &deflatedFile,
+                                            &deflatedFileLen),
+                  KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        result = ktxTexture2_CreateFromMemory(deflatedFile, deflatedFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        EXPECT_EQ(helper.compareTexture2Images(texture->pData), true);
+        ktxTexture_Destroy(ktxTexture(texture));
+        countingFree(&counts, deflatedFile);
+
+        EXPECT_EQ(ktxSetAllocator(NULL), KTX_SUCCESS);
+        EXPECT_GT(counts.allocations, 0);
+        EXPECT_EQ(counts.outstanding, 0);
+    }
+}
+
+TEST_F(ktxTexture2_LoadImageDataTest, LoadLevel) {
+    ktxTexture2* loaded = 0;
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktx_uint8_t* deflatedFile;
+    ktx_size_t deflatedFileLen;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &loaded);
+        ASSERT_TRUE(loaded != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                    << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_DeflateZstd(loaded, 5), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(loaded, &deflatedFile,
+                                            &deflatedFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(loaded));
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &loaded);
+        ASSERT_TRUE(loaded != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                    << ktxErrorString(result);
+
+        for (int zstd = 0; zstd < 2; zstd++) {
+            if (zstd)
+                result = ktxTexture2_CreateFromMemory(deflatedFile,
+                                                      deflatedFileLen,
+                                                      0, &texture);
+            else
+                result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                                      0, &texture);
+            ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                         << ktxErrorString(result);
+
+            // Load the smallest level first as a streaming renderer would.
+            for (ktx_uint32_t level = texture->numLevels; level-- > 0; ) {
+                ktx_size_t levelSize = ktxTexture_GetImageSize(
+                                                    ktxTexture(loaded), level)
+                                     * loaded->numFaces
+                                     * (loaded->isArray ? loaded->numLayers : 1);
+                ktx_size_t offset;
+                std::vector<ktx_uint8_t> levelData(levelSize);
+
+                EXPECT_EQ(ktxTexture2_LoadLevel(texture, level,
+                                                levelData.data(),
+                                                levelSize - 1),
+                          KTX_INVALID_VALUE);
+                ASSERT_EQ(ktxTexture2_LoadLevel(texture, level,
+                                                levelData.data(), levelSize),
+                          KTX_SUCCESS);
+                ASSERT_EQ(ktxTexture_GetImageOffset(ktxTexture(loaded), level,
+                                                    0, 0, &offset),
+                          KTX_SUCCESS);
+                EXPECT_EQ(memcmp(levelData.data(), loaded->pData + offset,
+                                 levelSize), 0) << "level " << level;
+            }
+            EXPECT_EQ(ktxTexture2_LoadLevel(texture, texture->numLevels,
+                                            deflatedFile, deflatedFileLen),
+                      KTX_INVALID_VALUE);
+            EXPECT_TRUE(texture->pData == NULL);
+            EXPECT_EQ(texture->supercompressionScheme,
+                      zstd ? KTX_SS_ZSTD : KTX_SS_NONE);
+
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+        ktxTexture_Destroy(ktxTexture(loaded));
+        free(deflatedFile);
+    }
+}
+
+TEST_F(ktxTexture2_LoadImageDataTest, LoadLevelFromDeflatedData) {
+    ktxTexture2* loaded = 0;
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &loaded);
+        ASSERT_TRUE(loaded != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                    << ktxErrorString(result);
+
+        for (int zlib = 0; zlib < 2; zlib++) {
+            result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+            ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                         << ktxErrorString(result);
+            // pData is loaded but holds the deflated levels.
+            if (zlib)
+                result = ktxTexture2_DeflateZLIB(texture, 6);
+            else
+                result = ktxTexture2_DeflateZstd(texture, 5);
+            ASSERT_EQ(result, KTX_SUCCESS);
+            ASSERT_TRUE(texture->pData != NULL);
+
+            for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+                ktx_size_t levelSize = ktxTexture_GetImageSize(
+                                                    ktxTexture(loaded), level)
+                                     * loaded->numFaces
+                                     * (loaded->isArray ? loaded->numLayers : 1);
+                ktx_size_t offset;
+                std::vector<ktx_uint8_t> levelData(levelSize);
+
+                ASSERT_EQ(ktxTexture2_LoadLevel(texture, level,
+                                                levelData.data(), levelSize),
+                          KTX_SUCCESS);
+                ASSERT_EQ(ktxTexture_GetImageOffset(ktxTexture(loaded), level,
+                                                    0, 0, &offset),
+                          KTX_SUCCESS);
+                EXPECT_EQ(memcmp(levelData.data(), loaded->pData + offset,
+                                 levelSize), 0) << "level " << level;
+            }
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+        ktxTexture_Destroy(ktxTexture(loaded));
+    }
+}
+
+TEST_F(ktxTexture2_LoadImageDataTest, LoadImageDataMaxBaseDimension) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktx_uint8_t* deflatedFile;
+    ktx_size_t deflatedFileLen;
+    ktx_uint32_t log2MaxDimension = 0;
+
+    while ((2 << log2MaxDimension) < pixelSize)
+        log2MaxDimension++;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_DeflateZstd(texture, 5), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &deflatedFile,
+                                            &deflatedFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        for (int zstd = 0; zstd < 2; zstd++) {
+            ktxTextureCreateFlags flags = KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT
+                  | KTX_TEXTURE_CREATE_BORROW_DATA_BIT
+                  | KTX_TEXTURE_CREATE_MAX_BASE_DIMENSION(log2MaxDimension);
+            if (zstd)
+                result = ktxTexture2_CreateFromMemory(deflatedFile,
+                                                      deflatedFileLen,
+                                                      flags, &texture);
+            else
+                result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                                      flags, &texture);
+            EXPECT_EQ(result, KTX_SUCCESS);
+            ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                         << ktxErrorString(result);
+            ASSERT_TRUE(texture->pData != NULL) << "Image data not loaded";
+            EXPECT_EQ(texture->baseWidth, (ktx_uint32_t)pixelSize / 2);
+            EXPECT_EQ(texture->baseHeight, (ktx_uint32_t)pixelSize / 2);
+            EXPECT_EQ(texture->numLevels, mipLevels - 1);
+            for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+                ktx_size_t offset;
+                ASSERT_EQ(ktxTexture_GetImageOffset(ktxTexture(texture), level,
+                                                    0, 0, &offset),
+                          KTX_SUCCESS);
+                EXPECT_EQ(memcmp(texture->pData + offset,
+                                 images[level + 1].data,
+                                 images[level + 1].size), 0)
+                          << "level " << level;
+            }
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+        free(deflatedFile);
+    }
+}
+
+/////////////////////////////////////////////
+// ktxTexture2_CreateCopyTest
+////////////////////////////////////////////
+
+TEST_F(ktxTexture2_DeflateTest, DeflateZstdExInvalidValue) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktxZstdParams params = { };
+
+    result = ktxTexture2_Create(&texinfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                &texture);
+    ASSERT_TRUE(texture != NULL) << "ktxTexture2_Create failed: "
+                                 << ktxErrorString(result);
+    params.compressionLevel = 5;
+    EXPECT_EQ(ktxTexture2_DeflateZstdEx(texture, NULL), KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2_DeflateZstdEx(texture, &params), KTX_INVALID_VALUE);
+    params.structSize = sizeof(params);
+    params.windowLog = 28;
+    EXPECT_EQ(ktxTexture2_DeflateZstdEx(texture, &params), KTX_INVALID_VALUE);
+    params.windowLog = 0;
+    params.strategy = 10;
+    EXPECT_EQ(ktxTexture2_DeflateZstdEx(texture, &params), KTX_INVALID_VALUE);
+    EXPECT_EQ(texture->supercompressionScheme, KTX_SS_NONE);
+    params.strategy = 0;
+    EXPECT_EQ(ktxTexture2_DeflateZstdEx(texture, &params), KTX_SUCCESS);
+    EXPECT_EQ(ktxTexture2_DeflateZstdEx(texture, &params),
+              KTX_INVALID_OPERATION);
+    ktxTexture_Destroy(ktxTexture(texture));
+}
+
+TEST_F(ktxTexture2_DeflateTest, DeflateZstdExThreaded) {
+    ktxTexture2* texture = 0;
+    ktxTexture2* loaded = 0;
+    KTX_error_code result;
+    ktx_uint8_t* deflatedFile;
+    ktx_size_t deflatedFileLen;
+    ktxTextureCreateInfo bigCreateInfo = texinfo;
+    std::vector<ktx_uint8_t> data;
+    ktx_uint32_t seed = 1;
+
+    // Big enough for level 0 to be split between Zstandard workers while
+    // the smaller levels are compressed in parallel.
+    bigCreateInfo.baseWidth = bigCreateInfo.baseHeight = 1024;
+    bigCreateInfo.numLevels = 11;
+    bigCreateInfo.generateMipmaps = KTX_FALSE;
+
+    for (ktx_uint32_t threadCount = 1; threadCount <= 4; threadCount += 3) {
+        ktxZstdParams params = { };
+        params.structSize = sizeof(params);
+        params.compressionLevel = 3;
+        params.threadCount = threadCount;
+        params.longDistanceMatching = threadCount > 1;
+
+        result = ktxTexture2_Create(&bigCreateInfo,
+                                    KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_Create failed: "
+                                     << ktxErrorString(result);
+        if (data.empty()) {
+            data.resize(texture->dataSize);
+            for (size_t i = 0; i < data.size(); i++) {
+                seed = seed * 1664525 + 1013904223;
+                data[i] = (ktx_uint8_t)((i >> 4) ^ (seed >> 30));
+            }
+        }
+        memcpy(texture->pData, data.data(), data.size());
+        ASSERT_EQ(ktxTexture2_DeflateZstdEx(texture, &params), KTX_SUCCESS);
+        EXPECT_EQ(texture->supercompressionScheme, KTX_SS_ZSTD);
+        EXPECT_LT(texture->dataSize, data.size());
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &deflatedFile,
+                                            &deflatedFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        result = ktxTexture2_CreateFromMemory(deflatedFile, deflatedFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &loaded);
+        ASSERT_TRUE(loaded != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                    << ktxErrorString(result);
+        ASSERT_EQ(loaded->dataSize, data.size());
+        EXPECT_EQ(memcmp(loaded->pData, data.data(), data.size()), 0);
+        ktxTexture_Destroy(ktxTexture(loaded));
+        free(deflatedFile);
+    }
+}
+
+TEST_F(ktxTexture2_DeflateTest, DeflateAuto) {
+    ktxTexture2* texture = 0;
+    ktxTexture2* loaded = 0;
+    KTX_error_code result;
+    ktx_uint8_t* deflatedFile;
+    ktx_size_t deflatedFileLen;
+    ktx_size_t smallest = 0;
+    std::vector<ktx_uint8_t> data;
+
+    // An unlimited budget keeps the smallest candidate. An impossible one
+    // keeps the fastest and says the budget was not met.
+    for (float minMBps : { 0.0f, 1e12f }) {
+        ktxDeflateAutoParams params = { };
+        ktxDeflateAutoResult choice;
+        params.structSize = sizeof(params);
+        params.minInflateMBps = minMBps;
+        params.threadCount = 2;
+
+        result = ktxTexture2_Create(&texinfo,
+                                    KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_Create failed: "
+                                     << ktxErrorString(result);
+        if (data.empty()) {
+            data.resize(texture->dataSize);
+            for (size_t i = 0; i < data.size(); i++)
+                data[i] = (ktx_uint8_t)((i >> 3) * 7);
+        }
+        memcpy(texture->pData, data.data(), data.size());
+        ASSERT_EQ(ktxTexture2_DeflateAuto(texture, &params, &choice),
+                  KTX_SUCCESS);
+        EXPECT_EQ(texture->supercompressionScheme, choice.scheme);
+        EXPECT_EQ(texture->dataSize, choice.dataSize);
+        EXPECT_GT(choice.inflateMBps, 0.0f);
+        if (minMBps == 0.0f) {
+            EXPECT_TRUE(choice.withinBudget);
+            smallest = choice.dataSize;
+        } else {
+            EXPECT_FALSE(choice.withinBudget);
+            EXPECT_GE(choice.dataSize, smallest);
+        }
+        EXPECT_EQ(ktxTexture2_DeflateAuto(texture, &params, NULL),
+                  KTX_INVALID_OPERATION);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &deflatedFile,
+                                            &deflatedFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        result = ktxTexture2_CreateFromMemory(deflatedFile, deflatedFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &loaded);
+        ASSERT_TRUE(loaded != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                    << ktxErrorString(result);
+        ASSERT_EQ(loaded->dataSize, data.size());
+        EXPECT_EQ(memcmp(loaded->pData, data.data(), data.size()), 0);
+        ktxTexture_Destroy(ktxTexture(loaded));
+        free(deflatedFile);
+    }
+}
+
+struct PeakAllocator {
+    size_t current;
+    size_t peak;
+};
+
+// Each block is prefixed by its size so frees can be accounted.
+static const size_t peakHeaderSize = 16;
+
+static void* peakMalloc(void* pUserData, ktx_size_t size) {
+    PeakAllocator* pa = (PeakAllocator*)pUserData;
+    char* block = (char*)malloc(size + peakHeaderSize);
+    if (!block)
+        return NULL;
+    *(size_t*)block = size;
+    pa->current += size;
+    pa->peak = MAX(pa->peak, pa->current);
+    return block + peakHeaderSize;
+}
+
+static void peakFree(void* pUserData, void* ptr) {
+    PeakAllocator* pa = (PeakAllocator*)pUserData;
+    if (!ptr)
+        return;
+    char* block = (char*)ptr - peakHeaderSize;
+    pa->current -= *(size_t*)block;
+    free(block);
+}
+
+static void* peakRealloc(void* pUserData, void* ptr, ktx_size_t size) {
+    PeakAllocator* pa = (PeakAllocator*)pUserData;
+    if (!ptr)
+        return peakMalloc(pUserData, size);
+    char* block = (char*)ptr - peakHeaderSize;
+    size_t oldSize = *(size_t*)block;
+    block = (char*)realloc(block, size + peakHeaderSize);
+    if (!block)
+        return NULL;
+    *(size_t*)block = size;
+    pa->current = pa->current - oldSize + size;
+    pa->peak = MAX(pa->peak, pa->current);
+    return block + peakHeaderSize;
+}
+
+TEST_F(ktxTexture2_DeflateTest, DeflatePeakMemory) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktxTextureCreateInfo bigCreateInfo = texinfo;
+    PeakAllocator pa = { 0, 0 };
+    ktxAllocator allocator = { peakMalloc, peakRealloc, peakFree, &pa };
+    ktx_uint32_t seed = 1;
+
+    bigCreateInfo.baseWidth = bigCreateInfo.baseHeight = 512;
+    bigCreateInfo.numLevels = 10;
+    bigCreateInfo.generateMipmaps = KTX_FALSE;
+
+    ASSERT_EQ(ktxSetAllocator(&allocator), KTX_SUCCESS);
+    for (int zlib = 0; zlib < 2; zlib++) {
+        result = ktxTexture2_Create(&bigCreateInfo,
+                                    KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_Create failed: "
+                                     << ktxErrorString(result);
+        // Incompressible so the deflated data is as big as the original.
+        for (size_t i = 0; i < texture->dataSize; i++) {
+            seed = seed * 1664525 + 1013904223;
+            texture->pData[i] = (ktx_uint8_t)(seed >> 24);
+        }
+        ktx_size_t dataSize = texture->dataSize;
+        size_t before = pa.current;
+        pa.peak = before;
+        if (zlib)
+            result = ktxTexture2_DeflateZLIB(texture, 6);
+        else
+            result = ktxTexture2_DeflateZstd(texture, 1);
+        EXPECT_EQ(result, KTX_SUCCESS);
+        // Deflated levels must go straight into the texture's new data,
+        // not through a second full-size buffer. The extra headroom is
+        // for Zstandard's compression context.
+        EXPECT_LT(pa.peak - before, 2 * dataSize);
+        ktxTexture_Destroy(ktxTexture(texture));
+    }
+    EXPECT_EQ(ktxSetAllocator(NULL), KTX_SUCCESS);
+}
+
+TEST_F(ktxTexture2_DeflateTest, LoadTruncatedFreesData) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktxTextureCreateInfo bigCreateInfo = texinfo;
+    PeakAllocator pa = { 0, 0 };
+    ktxAllocator allocator = { peakMalloc, peakRealloc, peakFree, &pa };
+    ktxSupercmpScheme schemes[] = { KTX_SS_NONE, KTX_SS_ZSTD, KTX_SS_ZLIB };
+    ktx_uint8_t* file;
+    ktx_size_t fileLen;
+
+    bigCreateInfo.baseWidth = bigCreateInfo.baseHeight = 64;
+    bigCreateInfo.numLevels = 7;
+    bigCreateInfo.generateMipmaps = KTX_FALSE;
+
+    ASSERT_EQ(ktxSetAllocator(&allocator), KTX_SUCCESS);
+    for (ktxSupercmpScheme scheme : schemes) {
+        result = ktxTexture2_Create(&bigCreateInfo,
+                                    KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_Create failed: "
+                                     << ktxErrorString(result);
+        memset(texture->pData, 0x55, texture->dataSize);
+        if (scheme == KTX_SS_ZSTD) {
+            ASSERT_EQ(ktxTexture2_DeflateZstd(texture, 1), KTX_SUCCESS);
+        } else if (scheme == KTX_SS_ZLIB) {
+            ASSERT_EQ(ktxTexture2_DeflateZLIB(texture, 6), KTX_SUCCESS);
+        }
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &file, &fileLen),
+                  KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        // Both the inflate-while-reading and the read-then-inflate paths.
+        for (ktx_uint32_t threadCount = 1; threadCount <= 2; threadCount++) {
+            result = ktxTexture2_CreateFromMemory(file, fileLen - 8,
+                                             KTX_TEXTURE_CREATE_NO_FLAGS,
+                                             &texture);
+            ASSERT_EQ(result, KTX_SUCCESS);
+            ktxLoadParams params = { };
+            params.structSize = sizeof(params);
+            params.threadCount = threadCount;
+            size_t before = pa.current;
+            EXPECT_NE(ktxTexture2_LoadImageDataEx(texture, NULL, 0, &params),
+                      KTX_SUCCESS);
+            EXPECT_EQ(pa.current, before) << "scheme " << scheme
+                                          << ", threadCount " << threadCount;
+            EXPECT_TRUE(texture->pData == NULL);
+            EXPECT_EQ(texture->dataSize, 0U);
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+        ktxFree(file);
+    }
+    EXPECT_EQ(ktxSetAllocator(NULL), KTX_SUCCESS);
+}
+
+TEST_F(ktxTexture2_DeflateTest, WriteDeflatedToStdioStream) {
+    ktxTexture2* texture = 0;
+    KTX_error_code result;
+    ktxTextureCreateInfo bigCreateInfo = texinfo;
+    ktxSupercmpScheme schemes[] = { KTX_SS_ZSTD, KTX_SS_ZLIB };
+
+    bigCreateInfo.baseWidth = bigCreateInfo.baseHeight = 256;
+    bigCreateInfo.numLevels = 9;
+    bigCreateInfo.generateMipmaps = KTX_FALSE;
+
+    result = ktxTexture2_Create(&bigCreateInfo,
+                                KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture);
+    ASSERT_TRUE(texture != NULL) << "ktxTexture2_Create failed: "
+                                 << ktxErrorString(result);
+    for (size_t i = 0; i < texture->dataSize; i++)
+        texture->pData[i] = (ktx_uint8_t)((i >> 6) ^ (i * 7));
+
+    EXPECT_EQ(ktxTexture2_WriteDeflatedToStdioStream(texture, stdout,
+                                                     KTX_SS_BASIS_LZ, 1),
+              KTX_INVALID_VALUE);
+    for (ktxSupercmpScheme scheme : schemes) {
+        ktxTexture2* deflated = 0;
+        ktx_uint8_t* expected;
+        ktx_size_t expectedLen;
+        std::vector<ktx_uint8_t> written;
+        FILE* f = tmpfile();
+        ASSERT_TRUE(f != NULL);
+
+        // The output must match deflating the texture then writing it.
+        ASSERT_EQ(ktxTexture2_CreateCopy(texture, &deflated), KTX_SUCCESS);
+        if (scheme == KTX_SS_ZSTD)
+            result = ktxTexture2_DeflateZstd(deflated, 5);
+        else
+            result = ktxTexture2_DeflateZLIB(deflated, 5);
+        ASSERT_EQ(result, KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(deflated, &expected, &expectedLen),
+                  KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(deflated));
+
+        EXPECT_EQ(ktxTexture2_WriteDeflatedToStdioStream(texture, f,
+                                                         scheme, 5),
+                  KTX_SUCCESS);
+        EXPECT_EQ(texture->supercompressionScheme, KTX_SS_NONE);
+        written.resize((size_t)ftell(f));
+        rewind(f);
+        EXPECT_EQ(fread(written.data(), 1, written.size(), f), written.size());
+        fclose(f);
+        ASSERT_EQ(written.size(), expectedLen);
+        EXPECT_EQ(memcmp(written.data(), expected, expectedLen), 0);
+        free(expected);
+    }
+    ktxTexture_Destroy(ktxTexture(texture));
+}
+
+TEST_F(ktxTexture2_WriterTest, MatchesWriteToMemory) {
+    ktxTexture2* texture = 0;
+    ktxTexture2Writer* writer = 0;
+    KTX_error_code result;
+    ktxTextureCreateInfo arrayCreateInfo = texinfo;
+    ktx_uint8_t* expected;
+    ktx_size_t expectedLen;
+    std::vector<ktx_uint8_t> image;
+    std::vector<ktx_uint8_t> written;
+    const char orientation[] = "rd";
+
+    arrayCreateInfo.baseWidth = arrayCreateInfo.baseHeight = 32;
+    arrayCreateInfo.numLevels = 6;
+    arrayCreateInfo.numLayers = 3;
+    arrayCreateInfo.isArray = KTX_TRUE;
+    arrayCreateInfo.generateMipmaps = KTX_FALSE;
+
+    result = ktxTexture2_Create(&arrayCreateInfo,
+                                KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture);
+    ASSERT_TRUE(texture != NULL) << "ktxTexture2_Create failed: "
+                                 << ktxErrorString(result);
+    for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+        image.resize(ktxTexture_GetImageSize(ktxTexture(texture), level));
+        for (ktx_uint32_t layer = 0; layer < texture->numLayers; layer++) {
+            for (size_t i = 0; i < image.size(); i++)
+                image[i] = (ktx_uint8_t)(level * 31 + layer * 7 + i);
+            EXPECT_EQ(ktxTexture2_SetImageFromMemory(texture, level, layer, 0,
+                                                     image.data(),
+                                                     image.size()),
+                      KTX_SUCCESS);
+        }
+    }
+    ktxHashList_AddKVPair(&texture->kvDataHead, KTX_ORIENTATION_KEY,
+                          sizeof(orientation), orientation);
+    ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &expected, &expectedLen),
+              KTX_SUCCESS);
+    ktxTexture_Destroy(ktxTexture(texture));
+
+    FILE* f = tmpfile();
+    ASSERT_TRUE(f != NULL);
+    ASSERT_EQ(ktxTexture2Writer_CreateForStdioStream(&arrayCreateInfo, f,
+                                                     &writer),
+              KTX_SUCCESS);
+    EXPECT_EQ(ktxTexture2Writer_AddKVPair(writer, KTX_ORIENTATION_KEY,
+                                          sizeof(orientation), orientation),
+              KTX_SUCCESS);
+    // Largest level first, the reverse of file order, so the writer has
+    // to seek back.
+    for (ktx_uint32_t level = 0; level < arrayCreateInfo.numLevels; level++) {
+        ktx_uint32_t levelWidth = MAX(1, arrayCreateInfo.baseWidth >> level);
+        image.resize(levelWidth * levelWidth * 4);
+        for (ktx_int32_t layer = arrayCreateInfo.numLayers - 1;
+             layer >= 0; layer--) {
+            for (size_t i = 0; i < image.size(); i++)
+                image[i] = (ktx_uint8_t)(level * 31 + layer * 7 + i);
+            EXPECT_EQ(ktxTexture2Writer_SetImageFromMemory(writer, level,
+                                                           layer, 0,
+                                                           image.data(),
+                                                           image.size()),
+                      KTX_SUCCESS);
+        }
+    }
+    EXPECT_EQ(ktxTexture2Writer_SetImageFromMemory(writer, 0, 0, 0,
+                                                   image.data(), 1),
+              KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxTexture2Writer_SetImageFromMemory(writer, 0, 3, 0,
+                                                   image.data(), 1),
+              KTX_INVALID_OPERATION);
+    EXPECT_EQ(ktxTexture2Writer_AddKVPair(writer, KTX_ORIENTATION_KEY,
+                                          sizeof(orientation), orientation),
+              KTX_INVALID_OPERATION);
+    EXPECT_EQ(ktxTexture2Writer_Finish(writer), KTX_SUCCESS);
+    ktxTexture2Writer_Destroy(writer);
+
+    written.resize((size_t)ftell(f));
+    rewind(f);
+    EXPECT_EQ(fread(written.data(), 1, written.size(), f), written.size());
+    fclose(f);
+    ASSERT_EQ(written.size(), expectedLen);
+    EXPECT_EQ(memcmp(written.data(), expected, expectedLen), 0);
+    free(expected);
+}
+
+TEST_F(ktxTexture2_WriterTest, WriteToMemoryAllocatesExactSize) {
+    ktxTexture2* texture = 0;
     KTX_error_code result;
-    ktx_uint8_t* buf;
-
-    if (ktxMemFile != NULL) {
-        result = ktxTexture_CreateFromMemory(ktxMemFile, ktxMemFileLen,
-                                             0,
-                                             &texture);
-        EXPECT_EQ(result, KTX_SUCCESS);
-        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
-                                     << ktxErrorString(result);
-        buf = new ktx_uint8_t[paddedImageDataSize];
-        EXPECT_EQ(ktxTexture_LoadImageData(texture, buf, paddedImageDataSize),
-                  KTX_SUCCESS);
-        EXPECT_EQ(paddedImageDataSize, ktxTexture_GetDataSize(texture));
-        EXPECT_EQ(helper.compareTexture2Images(buf), true);
-        if (texture)
-            ktxTexture_Destroy(texture);
-        delete[] buf;
-    }
+    ktxTextureCreateInfo bigCreateInfo = texinfo;
+    PeakAllocator pa = { 0, 0 };
+    ktxAllocator allocator = { peakMalloc, peakRealloc, peakFree, &pa };
+    ktx_uint8_t* file;
+    ktx_size_t fileLen;
+
+    bigCreateInfo.baseWidth = bigCreateInfo.baseHeight = 256;
+    bigCreateInfo.numLevels = 9;
+    bigCreateInfo.generateMipmaps = KTX_FALSE;
+
+    ASSERT_EQ(ktxSetAllocator(&allocator), KTX_SUCCESS);
+    result = ktxTexture2_Create(&bigCreateInfo,
+                                KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture);
+    ASSERT_TRUE(texture != NULL) << "ktxTexture2_Create failed: "
+                                 << ktxErrorString(result);
+    memset(texture->pData, 0x55, texture->dataSize);
+    // The first write adds KTXwriter metadata to the texture.
+    ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &file, &fileLen),
+              KTX_SUCCESS);
+    ktxFree(file);
+    size_t before = pa.current;
+    pa.peak = before;
+    ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &file, &fileLen),
+              KTX_SUCCESS);
+    // The output buffer is allocated once at its final size. The headroom
+    // is for the much smaller temporaries used to write the preamble.
+    EXPECT_LT(pa.peak - before, fileLen + 4096);
+    EXPECT_EQ(pa.current - before, fileLen);
+    ktxFree(file);
+    ktxTexture_Destroy(ktxTexture(texture));
+    EXPECT_EQ(ktxSetAllocator(NULL), KTX_SUCCESS);
 }
 
-/////////////////////////////////////////////
-// ktxTexture2_CreateCopyTest
-////////////////////////////////////////////
-
 TEST_F(ktxTexture2_CreateCopyTest, CreateCopy) {
     ktxTexture2* texture = 0;
     ktxTexture2* copyTexture = 0;
@@ -1169,8 +2644,11 @@ TEST_F(ktxTexture2_CreateCopyTest, CreateCopy) {
         EXPECT_EQ(compareTexture(copyTexture), true);
         EXPECT_EQ(memcmp(texture->pData, copyTexture->pData, texture->dataSize),
                   0);
+        // The copy's metadata is copied so does not reference the
+        // original's key-value data block.
         EXPECT_EQ(memcmp(texture->_protected, copyTexture->_protected,
-                         sizeof(ktxTexture_protected)), 0);
+                         offsetof(ktxTexture_protected, _kvdBlock)), 0);
+        EXPECT_TRUE(copyTexture->_protected->_kvdBlock == NULL);
         ktx_size_t privateSize = sizeof(ktxTexture2_private)
                                + sizeof(ktxLevelIndexEntry)
                                * (texture->numLevels - 1);
@@ -1184,6 +2662,56 @@ TEST_F(ktxTexture2_CreateCopyTest, CreateCopy) {
     }
 }
 
+TEST_F(ktxTexture2_CreateCopyTest, CreateSharedCopy) {
+    ktxTexture2* texture = 0;
+    ktxTexture2* copyTexture = 0;
+    ktxTexture2* copy2Texture = 0;
+    KTX_error_code result;
+    CountingAllocator counts = { 0, 0 };
+    ktxAllocator allocator = {
+        countingMalloc, countingRealloc, countingFree, &counts
+    };
+
+    if (ktxMemFile != NULL) {
+        ASSERT_EQ(ktxSetAllocator(&allocator), KTX_SUCCESS);
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        std::vector<ktx_uint8_t> data(texture->pData,
+                                      texture->pData + texture->dataSize);
+
+        ASSERT_EQ(ktxTexture2_CreateSharedCopy(texture, &copyTexture),
+                  KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_CreateSharedCopy(copyTexture, &copy2Texture),
+                  KTX_SUCCESS);
+        EXPECT_EQ(compareTexture(copyTexture), true);
+        EXPECT_EQ(copyTexture->pData, texture->pData);
+        EXPECT_EQ(copy2Texture->pData, texture->pData);
+
+        // Writing an image gives the writer its own data.
+        ktx_size_t imageSize = ktxTexture_GetImageSize(ktxTexture(texture), 0);
+        std::vector<ktx_uint8_t> image(imageSize, 0x5a);
+        EXPECT_EQ(ktxTexture_SetImageFromMemory(ktxTexture(copyTexture),
+                                                0, 0, 0, image.data(),
+                                                imageSize), KTX_SUCCESS);
+        EXPECT_NE(copyTexture->pData, texture->pData);
+        EXPECT_EQ(memcmp(texture->pData, data.data(), data.size()), 0);
+        EXPECT_EQ(memcmp(copy2Texture->pData, data.data(), data.size()), 0);
+
+        // Replacing the data leaves the remaining sharer's data intact.
+        ktxTexture_Destroy(ktxTexture(texture));
+        EXPECT_EQ(ktxTexture2_DeflateZstd(copy2Texture, 1), KTX_SUCCESS);
+        EXPECT_EQ(ktxTexture2_DeflateZstd(copyTexture, 1), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(copyTexture));
+        ktxTexture_Destroy(ktxTexture(copy2Texture));
+
+        EXPECT_EQ(ktxSetAllocator(NULL), KTX_SUCCESS);
+        EXPECT_EQ(counts.outstanding, 0);
+    }
+}
+
 /////////////////////////////////////////////
 // TestCreateInfo for size and offset tests.
 ////////////////////////////////////////////
@@ -2299,6 +3827,736 @@ TEST_F(ktxTexture2_BasisCompressTest, Compress) {
     }
 }
 
+TEST_F(ktxTexture2_BasisCompressTest, MaxBaseDimension) {
+    ktxTexture2* texture;
+    ktx_uint8_t* basisFile;
+    ktx_size_t basisFileLen;
+    ktx_uint32_t sgdByteLength;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_CompressBasis(texture, 0), KTX_SUCCESS);
+        sgdByteLength = (ktx_uint32_t)texture->_private->_sgdByteLength;
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &basisFile,
+                                            &basisFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        result = ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                               KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT
+                               | KTX_TEXTURE_CREATE_MAX_BASE_DIMENSION(2),
+                               &texture);
+        EXPECT_EQ(result, KTX_SUCCESS);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        EXPECT_EQ(texture->baseWidth, 4U);
+        EXPECT_EQ(texture->numLevels, 3U);
+        EXPECT_EQ(texture->_private->_sgdByteLength,
+                  sgdByteLength - (helper.numLevels - 3)
+                                  * sizeof(ktxBasisLzEtc1sImageDesc));
+
+        result = ktxTexture2_TranscodeBasis(texture, KTX_TTF_RGBA32, 0);
+        EXPECT_EQ(result, KTX_SUCCESS);
+        EXPECT_EQ(texture->dataSize, (ktx_size_t)(4 * 4 + 2 * 2 + 1) * 4);
+        ktxTexture_Destroy(ktxTexture(texture));
+        free(basisFile);
+    }
+}
+
+// Runs the jobs in reverse order to check they do not depend on each other.
+static void KTX_APIENTRY
+reverseJobRunner(void* pUserData, ktx_uint32_t jobCount,
+                 PFNKTXJOB pfnJob, void* pJobData) {
+    *(ktx_uint32_t*)pUserData += jobCount;
+    for (ktx_uint32_t i = jobCount; i > 0; i--)
+        pfnJob(pJobData, i - 1);
+}
+
+TEST_F(ktxTexture2_BasisCompressTest, TranscodeBasisEx) {
+    ktxTexture2* texture;
+    KTX_error_code result;
+
+    if (ktxMemFile == NULL)
+        return;
+
+    for (bool uastc : { false, true }) {
+        ktx_uint8_t* basisFile;
+        ktx_size_t basisFileLen;
+        ktxBasisParams basisParams = { };
+        basisParams.structSize = sizeof(basisParams);
+        basisParams.uastc = uastc;
+
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_CompressBasisEx(texture, &basisParams),
+                  KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &basisFile,
+                                            &basisFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        std::vector<ktx_uint8_t> reference;
+        for (int mode = 0; mode < 3; mode++) {
+            ktxTranscodeParams params = { };
+            ktx_uint32_t jobsRun = 0;
+            params.structSize = sizeof(params);
+            if (mode == 1)
+                params.threadCount = 4;
+            if (mode == 2) {
+                params.pfnRunJobs = reverseJobRunner;
+                params.pUserData = &jobsRun;
+            }
+
+            result = ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+            ASSERT_TRUE(texture != NULL);
+            ASSERT_EQ(ktxTexture2_TranscodeBasisEx(texture, KTX_TTF_RGBA32, 0,
+                                                   mode ? &params : NULL),
+                      KTX_SUCCESS);
+            if (mode == 0)
+                reference.assign(texture->pData,
+                                 texture->pData + texture->dataSize);
+            ASSERT_EQ(texture->dataSize, reference.size());
+            EXPECT_EQ(memcmp(texture->pData, reference.data(),
+                             reference.size()), 0);
+            if (mode == 2) {
+                EXPECT_EQ(jobsRun, helper.numLevels);
+            }
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+        free(basisFile);
+    }
+}
+
+TEST_F(ktxTexture2_BasisCompressTest, TranscodeBasisLevelRange) {
+    ktxTexture2* texture;
+    ktxTexture2* full;
+    KTX_error_code result;
+
+    if (ktxMemFile == NULL || helper.numLevels < 2)
+        return;
+
+    for (bool uastc : { false, true }) {
+        ktx_uint8_t* basisFile;
+        ktx_size_t basisFileLen;
+        ktxBasisParams basisParams = { };
+        basisParams.structSize = sizeof(basisParams);
+        basisParams.uastc = uastc;
+
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_CompressBasisEx(texture, &basisParams),
+                  KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &basisFile,
+                                            &basisFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &full), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(full, KTX_TTF_RGBA32, 0),
+                  KTX_SUCCESS);
+
+        ktxTranscodeParams params = { };
+        params.structSize = sizeof(params);
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture), KTX_SUCCESS);
+        params.firstLevel = helper.numLevels;
+        EXPECT_EQ(ktxTexture2_TranscodeBasisEx(texture, KTX_TTF_RGBA32, 0,
+                                               &params),
+                  KTX_INVALID_VALUE);
+        params.firstLevel = 1;
+        params.numLevels = helper.numLevels;
+        EXPECT_EQ(ktxTexture2_TranscodeBasisEx(texture, KTX_TTF_RGBA32, 0,
+                                               &params),
+                  KTX_INVALID_VALUE);
+
+        // Transcode the mip tail, dropping the base level.
+        params.numLevels = 0;
+        ASSERT_EQ(ktxTexture2_TranscodeBasisEx(texture, KTX_TTF_RGBA32, 0,
+                                               &params),
+                  KTX_SUCCESS);
+        EXPECT_EQ(texture->numLevels, full->numLevels - 1);
+        EXPECT_EQ(texture->baseWidth, MAX(1u, full->baseWidth >> 1));
+        EXPECT_EQ(texture->baseHeight, MAX(1u, full->baseHeight >> 1));
+        EXPECT_LT(texture->dataSize, full->dataSize);
+        for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+            ktx_size_t offset, fullOffset;
+            ktx_size_t imageSize = ktxTexture_GetImageSize(ktxTexture(texture),
+                                                           level);
+            ASSERT_EQ(imageSize, ktxTexture_GetImageSize(ktxTexture(full),
+                                                         level + 1));
+            ktxTexture_GetImageOffset(ktxTexture(texture), level, 0, 0,
+                                      &offset);
+            ktxTexture_GetImageOffset(ktxTexture(full), level + 1, 0, 0,
+                                      &fullOffset);
+            EXPECT_EQ(memcmp(texture->pData + offset,
+                             full->pData + fullOffset, imageSize), 0);
+        }
+        ktxTexture_Destroy(ktxTexture(texture));
+        ktxTexture_Destroy(ktxTexture(full));
+        free(basisFile);
+    }
+}
+
+TEST_F(ktxTexture2_BasisCompressTest, TranscodeBasisToMemory) {
+    ktxTexture2* texture;
+    ktxTexture2* full;
+    KTX_error_code result;
+
+    if (ktxMemFile == NULL)
+        return;
+
+    for (bool uastc : { false, true }) {
+        ktx_uint8_t* basisFile;
+        ktx_size_t basisFileLen;
+        ktxBasisParams basisParams = { };
+        basisParams.structSize = sizeof(basisParams);
+        basisParams.uastc = uastc;
+
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_CompressBasisEx(texture, &basisParams),
+                  KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &basisFile,
+                                            &basisFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &full), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(full, KTX_TTF_RGBA32, 0),
+                  KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture), KTX_SUCCESS);
+        ktx_uint32_t supercompressionScheme = texture->supercompressionScheme;
+
+        // Tightly packed, as in the transcoded texture.
+        std::vector<ktx_uint8_t> dest(full->dataSize);
+        ktx_uint32_t vkFormat = 0;
+        ASSERT_EQ(ktxTexture2_TranscodeBasisToMemory(texture, KTX_TTF_RGBA32,
+                                                     0, NULL, dest.data(),
+                                                     dest.size(), NULL,
+                                                     &vkFormat),
+                  KTX_SUCCESS);
+        EXPECT_EQ(vkFormat, full->vkFormat);
+        EXPECT_EQ(memcmp(dest.data(), full->pData, full->dataSize), 0);
+        EXPECT_EQ(ktxTexture2_TranscodeBasisToMemory(texture, KTX_TTF_RGBA32,
+                                                     0, NULL, dest.data(),
+                                                     dest.size() - 4, NULL,
+                                                     NULL),
+                  KTX_INVALID_VALUE);
+
+        // Padded rows, with each level starting on a 256 byte boundary.
+        const ktx_uint32_t pixelSize = 4, padding = 64;
+        std::vector<ktxTranscodeLevelDest> levelDests(full->numLevels);
+        ktx_size_t destSize = 0;
+        for (ktx_uint32_t level = 0; level < full->numLevels; level++) {
+            ktx_uint32_t height = MAX(1u, full->baseHeight >> level);
+            ktx_uint32_t width = MAX(1u, full->baseWidth >> level);
+            levelDests[level].byteOffset = destSize;
+            levelDests[level].rowPitch = width * pixelSize + padding;
+            levelDests[level].imagePitch = 0;
+            destSize += _KTX_PADN(256, levelDests[level].rowPitch * height);
+        }
+        dest.assign(destSize, 0);
+        levelDests[0].rowPitch = 1;
+        EXPECT_EQ(ktxTexture2_TranscodeBasisToMemory(texture, KTX_TTF_RGBA32,
+                                                     0, NULL, dest.data(),
+                                                     dest.size(),
+                                                     levelDests.data(), NULL),
+                  KTX_INVALID_VALUE);
+        levelDests[0].rowPitch = full->baseWidth * pixelSize + padding;
+        ASSERT_EQ(ktxTexture2_TranscodeBasisToMemory(texture, KTX_TTF_RGBA32,
+                                                     0, NULL, dest.data(),
+                                                     dest.size(),
+                                                     levelDests.data(), NULL),
+                  KTX_SUCCESS);
+        for (ktx_uint32_t level = 0; level < full->numLevels; level++) {
+            ktx_uint32_t height = MAX(1u, full->baseHeight >> level);
+            ktx_uint32_t rowSize = MAX(1u, full->baseWidth >> level)
+                                   * pixelSize;
+            ktx_size_t offset;
+            ktxTexture_GetImageOffset(ktxTexture(full), level, 0, 0, &offset);
+            for (ktx_uint32_t row = 0; row < height; row++) {
+                EXPECT_EQ(memcmp(dest.data() + levelDests[level].byteOffset
+                                 + row * levelDests[level].rowPitch,
+                                 full->pData + offset + row * rowSize,
+                                 rowSize), 0)
+                    << "level " << level << " row " << row;
+            }
+        }
+        // The texture itself is left as it was.
+        EXPECT_EQ(texture->supercompressionScheme, supercompressionScheme);
+        EXPECT_NE(texture->vkFormat, full->vkFormat);
+
+        ktxTexture_Destroy(ktxTexture(texture));
+        ktxTexture_Destroy(ktxTexture(full));
+        free(basisFile);
+    }
+}
+
+// Keeps a copy of each level passed to it, indexed by level.
+static KTX_error_code
+collectLevels(int miplevel, int /*face*/, int /*width*/, int /*height*/,
+              int /*depth*/, ktx_uint64_t faceLodSize, void* pixels,
+              void* userdata)
+{
+    auto& levels = *static_cast<std::vector<std::vector<ktx_uint8_t>>*>(userdata);
+    ktx_uint8_t* pLevel = static_cast<ktx_uint8_t*>(pixels);
+    levels[miplevel].assign(pLevel, pLevel + faceLodSize);
+    return KTX_SUCCESS;
+}
+
+TEST_F(ktxTexture2_BasisCompressTest, IterateLoadLevelFacesTranscode) {
+    ktxTexture2* texture;
+    ktxTexture2* full;
+    KTX_error_code result;
+
+    if (ktxMemFile == NULL)
+        return;
+
+    for (bool uastc : { false, true }) {
+        ktx_uint8_t* basisFile;
+        ktx_size_t basisFileLen;
+        ktxBasisParams basisParams = { };
+        basisParams.structSize = sizeof(basisParams);
+        basisParams.uastc = uastc;
+
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_CompressBasisEx(texture, &basisParams),
+                  KTX_SUCCESS);
+        // Exercise inflating each level before transcoding it too.
+        if (uastc) {
+            ASSERT_EQ(ktxTexture2_DeflateZstd(texture, 5), KTX_SUCCESS);
+        }
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &basisFile,
+                                            &basisFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &full), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(full, KTX_TTF_RGBA32, 0),
+                  KTX_SUCCESS);
+
+        for (ktx_bool_t readAhead : { KTX_FALSE, KTX_TRUE }) {
+            std::vector<std::vector<ktx_uint8_t>> levels(full->numLevels);
+            ktxLoadParams params = { };
+            params.structSize = sizeof(params);
+            params.readAhead = readAhead;
+            params.threadCount = readAhead ? 2 : 0;
+
+            ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                                   0, &texture),
+                      KTX_SUCCESS);
+            if (!uastc) {
+                EXPECT_EQ(ktxTexture2_IterateLoadLevelFacesEx(texture,
+                                                              collectLevels,
+                                                              &levels,
+                                                              &params),
+                          KTX_INVALID_OPERATION);
+            }
+            params.transcode = KTX_TRUE;
+            params.transcodeFormat = KTX_TTF_RGBA32;
+            ASSERT_EQ(ktxTexture2_IterateLoadLevelFacesEx(texture,
+                                                          collectLevels,
+                                                          &levels, &params),
+                      KTX_SUCCESS);
+            EXPECT_EQ(texture->vkFormat, full->vkFormat);
+            EXPECT_EQ(texture->supercompressionScheme, KTX_SS_NONE);
+            EXPECT_TRUE(texture->pData == NULL);
+            for (ktx_uint32_t level = 0; level < full->numLevels; level++) {
+                ktx_size_t offset;
+                ktx_size_t levelSize
+                    = ktxTexture_GetImageSize(ktxTexture(full), level);
+                ktxTexture_GetImageOffset(ktxTexture(full), level, 0, 0,
+                                          &offset);
+                ASSERT_EQ(levels[level].size(), levelSize);
+                EXPECT_EQ(memcmp(levels[level].data(), full->pData + offset,
+                                 levelSize), 0) << "level " << level;
+            }
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+        ktxTexture_Destroy(ktxTexture(full));
+        free(basisFile);
+    }
+}
+
+// Records the size of the largest allocation.
+struct SizeRecordingAllocator {
+    ktx_size_t largest;
+};
+
+static void* sizeRecordingMalloc(void* pUserData, ktx_size_t size) {
+    SizeRecordingAllocator* sizes = (SizeRecordingAllocator*)pUserData;
+    sizes->largest = std::max(sizes->largest, size);
+    return malloc(size);
+}
+
+static void* sizeRecordingRealloc(void* pUserData, void* ptr, ktx_size_t size) {
+    SizeRecordingAllocator* sizes = (SizeRecordingAllocator*)pUserData;
+    sizes->largest = std::max(sizes->largest, size);
+    return realloc(ptr, size);
+}
+
+static void sizeRecordingFree(void*, void* ptr) {
+    free(ptr);
+}
+
+TEST_F(ktxTexture2_BasisCompressTest, TranscodeBasisCache) {
+    ktxTexture2* texture;
+    ktxTexture2* full;
+    KTX_error_code result;
+
+    if (ktxMemFile == NULL)
+        return;
+
+    std::filesystem::path cacheDir(::testing::TempDir());
+    cacheDir /= "texturetest_xcodecache";
+    std::filesystem::remove_all(cacheDir);
+    ASSERT_TRUE(std::filesystem::create_directories(cacheDir));
+    std::string cacheDirName = cacheDir.string();
+    auto countEntries = [&cacheDir]() {
+        return std::distance(std::filesystem::directory_iterator(cacheDir),
+                             std::filesystem::directory_iterator());
+    };
+
+    for (bool uastc : { false, true }) {
+        ktx_uint8_t* basisFile;
+        ktx_size_t basisFileLen;
+        ktxBasisParams basisParams = { };
+        basisParams.structSize = sizeof(basisParams);
+        basisParams.uastc = uastc;
+
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_CompressBasisEx(texture, &basisParams),
+                  KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &basisFile,
+                                            &basisFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &full), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(full, KTX_TTF_RGBA32, 0),
+                  KTX_SUCCESS);
+
+        ktxTranscodeParams params = { };
+        params.structSize = sizeof(params);
+        params.cacheDir = cacheDirName.c_str();
+        auto entries = countEntries();
+        std::vector<std::filesystem::path> oldEntries;
+        for (auto& entry : std::filesystem::directory_iterator(cacheDir))
+            oldEntries.push_back(entry.path());
+        // Miss, which adds an entry, then a hit, then a hit after the
+        // entry has been truncated, which falls back to transcoding.
+        for (int pass = 0; pass < 3; pass++) {
+            ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture), KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_TranscodeBasisEx(texture, KTX_TTF_RGBA32,
+                                                   0, &params),
+                      KTX_SUCCESS);
+            EXPECT_EQ(texture->vkFormat, full->vkFormat);
+            EXPECT_EQ(texture->supercompressionScheme, KTX_SS_NONE);
+            ASSERT_EQ(texture->dataSize, full->dataSize);
+            EXPECT_EQ(memcmp(texture->pData, full->pData, full->dataSize), 0)
+                << "pass " << pass;
+            EXPECT_EQ(countEntries(), entries + 1);
+            if (pass == 1) {
+                EXPECT_TRUE(texture->_private->_pDataIsView);
+                // The mapping is private so this must not reach the cache.
+                texture->pData[0] ^= 0xff;
+                for (auto& entry
+                     : std::filesystem::directory_iterator(cacheDir)) {
+                    std::filesystem::resize_file(entry.path(),
+                                                 entry.file_size() - 1);
+                }
+            } else {
+                EXPECT_FALSE(texture->_private->_pDataIsView);
+            }
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+
+        // A hit must not allocate storage for the transcoded images.
+        ASSERT_EQ(countEntries(), entries + 1);
+        std::filesystem::path entryPath;
+        for (auto& entry : std::filesystem::directory_iterator(cacheDir)) {
+            if (std::find(oldEntries.begin(), oldEntries.end(), entry.path())
+                == oldEntries.end())
+                entryPath = entry.path();
+        }
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture), KTX_SUCCESS);
+        SizeRecordingAllocator sizes = { 0 };
+        ktxAllocator allocator = {
+            sizeRecordingMalloc, sizeRecordingRealloc, sizeRecordingFree,
+            &sizes
+        };
+        ASSERT_EQ(ktxSetAllocator(&allocator), KTX_SUCCESS);
+        result = ktxTexture2_TranscodeBasisEx(texture, KTX_TTF_RGBA32, 0,
+                                              &params);
+        EXPECT_EQ(ktxSetAllocator(NULL), KTX_SUCCESS);
+        EXPECT_EQ(result, KTX_SUCCESS);
+        EXPECT_TRUE(texture->_private->_pDataIsView);
+        EXPECT_LT(sizes.largest, full->dataSize);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        // A temporary file left by a writer that died must not stop the
+        // entry being written.
+        std::filesystem::remove(entryPath);
+        std::filesystem::path stalePath = entryPath;
+        stalePath += ".tmp";
+        std::ofstream(stalePath.string()).put('x');
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture), KTX_SUCCESS);
+        EXPECT_EQ(ktxTexture2_TranscodeBasisEx(texture, KTX_TTF_RGBA32, 0,
+                                               &params),
+                  KTX_SUCCESS);
+        EXPECT_TRUE(std::filesystem::exists(entryPath));
+        ktxTexture_Destroy(ktxTexture(texture));
+        std::filesystem::remove(stalePath);
+        ktxTexture_Destroy(ktxTexture(full));
+
+        // A different level range is a different entry.
+        if (helper.numLevels > 1) {
+            params.firstLevel = 1;
+            ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture), KTX_SUCCESS);
+            EXPECT_EQ(ktxTexture2_TranscodeBasisEx(texture, KTX_TTF_RGBA32,
+                                                   0, &params),
+                      KTX_SUCCESS);
+            EXPECT_EQ(countEntries(), entries + 2);
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+        free(basisFile);
+    }
+    std::filesystem::remove_all(cacheDir);
+}
+
+TEST_F(ktxTexture2_BasisCompressTest, VideoTranscoder) {
+    ktxTexture2* texture;
+    ktxTexture2* full;
+    ktxVideoTranscoder* xcoder;
+    ktxTextureCreateInfo createInfo = { };
+    const ktx_uint32_t numFrames = 6;
+    ktx_uint8_t* basisFile;
+    ktx_size_t basisFileLen;
+
+    createInfo.vkFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    createInfo.baseWidth = 32;
+    createInfo.baseHeight = 32;
+    createInfo.baseDepth = 1;
+    createInfo.numDimensions = 2;
+    // The encoder requires the frames of a video to be the same size.
+    createInfo.numLevels = 1;
+    createInfo.numLayers = numFrames;
+    createInfo.numFaces = 1;
+    createInfo.isArray = KTX_TRUE;
+    ASSERT_EQ(ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                 &texture), KTX_SUCCESS);
+    // A gradient that moves a little each frame.
+    for (ktx_uint32_t frame = 0; frame < numFrames; frame++) {
+        ktx_size_t offset;
+        ktxTexture_GetImageOffset(ktxTexture(texture), 0, frame, 0, &offset);
+        ktx_uint8_t* pixel = texture->pData + offset;
+        for (ktx_uint32_t y = 0; y < createInfo.baseHeight; y++) {
+            for (ktx_uint32_t x = 0; x < createInfo.baseWidth; x++) {
+                *pixel++ = (ktx_uint8_t)((x + frame) * 8);
+                *pixel++ = (ktx_uint8_t)(y * 8);
+                *pixel++ = (ktx_uint8_t)((x + y) * 4);
+                *pixel++ = 255;
+            }
+        }
+    }
+    ktx_uint32_t animData[3] = { 1, 30, 0 };
+    ASSERT_EQ(ktxHashList_AddKVPair(&texture->kvDataHead, "KTXanimData",
+                                    sizeof(animData), animData), KTX_SUCCESS);
+    texture->isVideo = KTX_TRUE;
+    ASSERT_EQ(ktxTexture2_CompressBasis(texture, 0), KTX_SUCCESS);
+    ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &basisFile, &basisFileLen),
+              KTX_SUCCESS);
+    // Not a video texture once video frames are no longer wanted.
+    texture->isVideo = KTX_FALSE;
+    EXPECT_EQ(ktxVideoTranscoder_Create(texture, KTX_TTF_RGBA32, 0, &xcoder),
+              KTX_INVALID_OPERATION);
+    ktxTexture_Destroy(ktxTexture(texture));
+
+    ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &full), KTX_SUCCESS);
+    ASSERT_TRUE(full->isVideo);
+    const ktxBasisLzEtc1sImageDesc* imageDescs
+        = BGD_ETC1S_IMAGE_DESCS(full->_private->_supercompressionGlobalData);
+    bool hasPFrames = false;
+    for (ktx_uint32_t image = 0; image < numFrames; image++)
+        hasPFrames |= (imageDescs[image].imageFlags & ETC1S_P_FRAME) != 0;
+    EXPECT_TRUE(hasPFrames);
+    ASSERT_EQ(ktxTexture2_TranscodeBasis(full, KTX_TTF_RGBA32, 0),
+              KTX_SUCCESS);
+
+    // Not loading the image data checks the transcoder loads it.
+    ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen, 0,
+                                           &texture), KTX_SUCCESS);
+    ASSERT_EQ(ktxVideoTranscoder_Create(texture, KTX_TTF_RGBA32, 0, &xcoder),
+              KTX_SUCCESS);
+    EXPECT_EQ(ktxVideoTranscoder_GetVkFormat(xcoder), full->vkFormat);
+    EXPECT_EQ(texture->supercompressionScheme, KTX_SS_BASIS_LZ);
+
+    // In order, repeated, backwards and skipping ahead.
+    const ktx_uint32_t frames[] = { 0, 1, 2, 3, 4, 5, 5, 2, 0, 4, 1, 3 };
+    for (ktx_uint32_t level = 0; level < full->numLevels; level++) {
+        ktx_size_t frameSize = ktxVideoTranscoder_GetFrameSize(xcoder, level);
+        ASSERT_EQ(frameSize, ktxTexture_GetImageSize(ktxTexture(full), level));
+        std::vector<ktx_uint8_t> frameData(frameSize);
+        for (ktx_uint32_t frame : frames) {
+            ktx_size_t offset;
+            ASSERT_EQ(ktxVideoTranscoder_TranscodeFrame(xcoder, level, frame,
+                                                        frameData.data(),
+                                                        frameSize),
+                      KTX_SUCCESS);
+            ktxTexture_GetImageOffset(ktxTexture(full), level, frame, 0,
+                                      &offset);
+            EXPECT_EQ(memcmp(frameData.data(), full->pData + offset,
+                             frameSize), 0)
+                << "level " << level << " frame " << frame;
+        }
+        EXPECT_EQ(ktxVideoTranscoder_TranscodeFrame(xcoder, level, numFrames,
+                                                    frameData.data(),
+                                                    frameSize),
+                  KTX_INVALID_VALUE);
+        EXPECT_EQ(ktxVideoTranscoder_TranscodeFrame(xcoder, level, 0,
+                                                    frameData.data(),
+                                                    frameSize - 1),
+                  KTX_INVALID_VALUE);
+    }
+    std::vector<ktx_uint8_t> frameData(
+                                ktxVideoTranscoder_GetFrameSize(xcoder, 0));
+    EXPECT_EQ(ktxVideoTranscoder_TranscodeFrame(xcoder, full->numLevels, 0,
+                                                frameData.data(),
+                                                frameData.size()),
+              KTX_INVALID_VALUE);
+    ktxVideoTranscoder_Destroy(xcoder);
+    ktxTexture_Destroy(ktxTexture(texture));
+    ktxTexture_Destroy(ktxTexture(full));
+    free(basisFile);
+}
+
+TEST_F(ktxTexture2_BasisCompressTest, TranscodeCustomAllocator) {
+    ktxTexture2* texture;
+    ktxVideoTranscoder* xcoder;
+    ktxTextureCreateInfo createInfo = { };
+    const ktx_uint32_t numFrames = 4;
+    ktx_uint8_t* basisFile;
+    ktx_size_t basisFileLen;
+    CountingAllocator counts = { 0, 0 };
+    ktxAllocator allocator = {
+        countingMalloc, countingRealloc, countingFree, &counts
+    };
+
+    createInfo.vkFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    createInfo.baseWidth = 16;
+    createInfo.baseHeight = 16;
+    createInfo.baseDepth = 1;
+    createInfo.numDimensions = 2;
+    createInfo.numLevels = 1;
+    createInfo.numLayers = numFrames;
+    createInfo.numFaces = 1;
+    createInfo.isArray = KTX_TRUE;
+    ASSERT_EQ(ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                 &texture), KTX_SUCCESS);
+    for (ktx_size_t i = 0; i < texture->dataSize; i++)
+        texture->pData[i] = (ktx_uint8_t)(i * 7);
+    ktx_uint32_t animData[3] = { 1, 30, 0 };
+    ASSERT_EQ(ktxHashList_AddKVPair(&texture->kvDataHead, "KTXanimData",
+                                    sizeof(animData), animData), KTX_SUCCESS);
+    texture->isVideo = KTX_TRUE;
+    ASSERT_EQ(ktxTexture2_CompressBasis(texture, 0), KTX_SUCCESS);
+    ASSERT_EQ(ktxTexture2_WriteToMemory(texture, &basisFile, &basisFileLen),
+              KTX_SUCCESS);
+    ktxTexture_Destroy(ktxTexture(texture));
+
+    // Transcode once first so one-time transcoder initialization is done.
+    ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture), KTX_SUCCESS);
+    ASSERT_EQ(ktxTexture2_TranscodeBasis(texture, KTX_TTF_RGBA32, 0),
+              KTX_SUCCESS);
+    ktxTexture_Destroy(ktxTexture(texture));
+
+    std::vector<std::vector<ktx_uint8_t>> levels(1);
+    // So collectLevels does not allocate.
+    levels[0].reserve(16 * 16 * 4 * numFrames);
+    ktx_uint8_t frameData[16 * 16 * 4];
+    ktxLoadParams params = { };
+    params.structSize = sizeof(params);
+    params.threadCount = 2;
+    params.transcode = KTX_TRUE;
+    params.transcodeFormat = KTX_TTF_RGBA32;
+    KTX_error_code results[7];
+
+    // Nothing in this window may use operator new, not even gtest, so
+    // results are only checked after it.
+    ASSERT_EQ(ktxSetAllocator(&allocator), KTX_SUCCESS);
+    newCount = 0;
+    newCounting = true;
+    results[0] = ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &texture);
+    results[1] = ktxTexture2_TranscodeBasis(texture, KTX_TTF_RGBA32, 0);
+    ktxTexture_Destroy(ktxTexture(texture));
+    results[2] = ktxTexture2_CreateFromMemory(basisFile, basisFileLen, 0,
+                                              &texture);
+    results[3] = ktxVideoTranscoder_Create(texture, KTX_TTF_RGBA32, 0,
+                                           &xcoder);
+    results[4] = ktxVideoTranscoder_TranscodeFrame(xcoder, 0, numFrames - 1,
+                                                   frameData,
+                                                   sizeof(frameData));
+    ktxVideoTranscoder_Destroy(xcoder);
+    ktxTexture_Destroy(ktxTexture(texture));
+    results[5] = ktxTexture2_CreateFromMemory(basisFile, basisFileLen, 0,
+                                              &texture);
+    results[6] = ktxTexture2_IterateLoadLevelFacesEx(texture, collectLevels,
+                                                     &levels, &params);
+    ktxTexture_Destroy(ktxTexture(texture));
+    newCounting = false;
+    EXPECT_EQ(ktxSetAllocator(NULL), KTX_SUCCESS);
+
+    for (KTX_error_code result : results)
+        EXPECT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+    EXPECT_EQ(newCount, 0);
+    EXPECT_GT(counts.allocations, 0);
+    EXPECT_EQ(counts.outstanding, 0);
+    free(basisFile);
+}
+
 class ktxTexture2_GetNumComponentsTestR8 : public ktxTexture2TestBase<GLubyte, 1, GL_R8> { };
 class ktxTexture2_GetNumComponentsTestRG8 : public ktxTexture2TestBase<GLubyte, 2, GL_RG8> { };
 class ktxTexture2_GetNumComponentsTestRGB8 : public ktxTexture2TestBase<GLubyte, 3, GL_RGB8> { };
@@ -2619,6 +4877,70 @@ TEST_F(ktxTexture2_MetadataTest, EmptyValue) {
     }
 }
 
+TEST_F(ktxTexture2_MetadataTest, LoadedMetadataNotCopiedPerPair) {
+    ktxTexture2* texture;
+    KTX_error_code result;
+    const int numPairs = 32;
+    CountingAllocator counts = { 0, 0 };
+    ktxAllocator allocator = {
+        countingMalloc, countingRealloc, countingFree, &counts
+    };
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                              &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        for (int i = 0; i < numPairs; i++) {
+            std::string key = "MSCtestKey" + std::to_string(100 + i);
+            ASSERT_EQ(ktxHashList_AddKVPair(&texture->kvDataHead, key.c_str(),
+                                            (unsigned int)key.size() + 1,
+                                            key.c_str()), KTX_SUCCESS);
+        }
+        ktx_size_t newMemFileLen;
+        ktx_uint8_t* newMemFile;
+        ASSERT_EQ(ktxTexture_WriteToMemory(ktxTexture(texture), &newMemFile,
+                                           &newMemFileLen), KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        ASSERT_EQ(ktxSetAllocator(&allocator), KTX_SUCCESS);
+        result = ktxTexture2_CreateFromMemory(newMemFile, newMemFileLen,
+                                              KTX_TEXTURE_CREATE_NO_FLAGS,
+                                              &texture);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+        // Far fewer allocations than one per pair.
+        EXPECT_LT(counts.allocations, numPairs / 2);
+
+        ktxHashListEntry* entry;
+        ktx_uint32_t valueLen;
+        char* value;
+        ASSERT_EQ(ktxHashList_FindEntry(&texture->kvDataHead,
+                                        "MSCtestKey100", &entry), KTX_SUCCESS);
+        EXPECT_EQ(ktxHashList_DeleteEntry(&texture->kvDataHead, entry),
+                  KTX_SUCCESS);
+        // A deleted entry stays readable until the texture is destroyed.
+        ktxHashListEntry_GetValue(entry, &valueLen, (void**)&value);
+        EXPECT_STREQ(value, "MSCtestKey100");
+        EXPECT_EQ(ktxHashList_AddKVPair(&texture->kvDataHead, "MSCtestKey100",
+                                        4, "new"), KTX_SUCCESS);
+        EXPECT_EQ(ktxHashList_FindValue(&texture->kvDataHead, "MSCtestKey100",
+                                        &valueLen, (void**)&value),
+                  KTX_SUCCESS);
+        EXPECT_STREQ(value, "new");
+        EXPECT_EQ(ktxHashList_FindValue(&texture->kvDataHead, "MSCtestKey131",
+                                        &valueLen, (void**)&value),
+                  KTX_SUCCESS);
+        EXPECT_STREQ(value, "MSCtestKey131");
+        ktxTexture_Destroy(ktxTexture(texture));
+
+        EXPECT_EQ(ktxSetAllocator(NULL), KTX_SUCCESS);
+        EXPECT_EQ(counts.outstanding, 0);
+        free(newMemFile);
+    }
+}
+
 #if defined(TestNoMetadata)
 TEST_F(ktxTexture2_MetadataTest, NoMetadata) {
     ktxTexture2* texture;
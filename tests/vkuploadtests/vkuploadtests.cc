@@ -0,0 +1,538 @@
+// Copyright 2026 The Khronos Group Inc.
+// SPDX-License-Identifier: Apache-2.0
+
+// Tests of the Vulkan upload functions. They need a Vulkan driver. For CI
+// use Mesa's software driver, lavapipe, e.g. by setting VK_ICD_FILENAMES
+// to the path of its lvp_icd.*.json. The tests are skipped when no
+// Vulkan loader or device can be found unless KTX_VKUPLOADTESTS_REQUIRE_DEVICE
+// is set in the environment, in which case they fail. CI sets it so that a
+// missing driver cannot silently turn the tests into no-ops.
+
+#if defined(_WIN32)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#else
+  #include <dlfcn.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define VK_NO_PROTOTYPES
+#include "vulkan/vk_platform.h"
+#include "vulkan/vulkan_core.h"
+#include "ktx.h"
+#include "ktxvulkan.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+// The Vulkan functions the tests use, other than through libktx.
+struct VulkanFunctions {
+    PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
+    PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr;
+    PFN_vkCreateInstance vkCreateInstance;
+    PFN_vkDestroyInstance vkDestroyInstance;
+    PFN_vkEnumeratePhysicalDevices vkEnumeratePhysicalDevices;
+    PFN_vkGetPhysicalDeviceFeatures vkGetPhysicalDeviceFeatures;
+    PFN_vkGetPhysicalDeviceQueueFamilyProperties
+                                    vkGetPhysicalDeviceQueueFamilyProperties;
+    PFN_vkGetPhysicalDeviceMemoryProperties
+                                    vkGetPhysicalDeviceMemoryProperties;
+    PFN_vkGetPhysicalDeviceImageFormatProperties
+                                    vkGetPhysicalDeviceImageFormatProperties;
+    PFN_vkCreateDevice vkCreateDevice;
+    PFN_vkDestroyDevice vkDestroyDevice;
+    PFN_vkGetDeviceQueue vkGetDeviceQueue;
+    PFN_vkCreateCommandPool vkCreateCommandPool;
+    PFN_vkDestroyCommandPool vkDestroyCommandPool;
+    PFN_vkAllocateCommandBuffers vkAllocateCommandBuffers;
+    PFN_vkFreeCommandBuffers vkFreeCommandBuffers;
+    PFN_vkBeginCommandBuffer vkBeginCommandBuffer;
+    PFN_vkEndCommandBuffer vkEndCommandBuffer;
+    PFN_vkCmdCopyImageToBuffer vkCmdCopyImageToBuffer;
+    PFN_vkQueueSubmit vkQueueSubmit;
+    PFN_vkQueueWaitIdle vkQueueWaitIdle;
+    PFN_vkCreateBuffer vkCreateBuffer;
+    PFN_vkDestroyBuffer vkDestroyBuffer;
+    PFN_vkGetBufferMemoryRequirements vkGetBufferMemoryRequirements;
+    PFN_vkAllocateMemory vkAllocateMemory;
+    PFN_vkFreeMemory vkFreeMemory;
+    PFN_vkBindBufferMemory vkBindBufferMemory;
+    PFN_vkMapMemory vkMapMemory;
+    PFN_vkUnmapMemory vkUnmapMemory;
+};
+
+// Compare uploads by ktxTexture2_VkUploadTranscodedEx with uploads by
+// ktxTexture2_TranscodeBasis followed by ktxTexture_VkUploadEx. One device
+// is shared by all the tests.
+class ktxTexture2_VkUploadTranscodedTest : public ::testing::Test {
+  protected:
+    static void SetUpTestSuite();
+    static void TearDownTestSuite();
+
+    void SetUp() override {
+        if (vdi == nullptr) {
+            if (getenv("KTX_VKUPLOADTESTS_REQUIRE_DEVICE") != nullptr)
+                FAIL() << skipReason;
+            GTEST_SKIP() << skipReason;
+        }
+    }
+
+    static ktx_uint8_t* createBasisFile(bool uastc, ktx_size_t* pFileLen);
+    static bool isSupported(VkFormat format);
+    static void readImage(const ktxVulkanTexture& vkTexture,
+                          ktxTexture2* layout,
+                          std::vector<ktx_uint8_t>& pixels);
+    void checkUploads(bool uastc);
+
+    static void* library;
+    static std::string skipReason;
+    static VulkanFunctions vkf;
+    static VkInstance instance;
+    static VkPhysicalDevice physicalDevice;
+    static VkPhysicalDeviceFeatures enabledFeatures;
+    static VkDevice device;
+    static VkQueue queue;
+    static VkCommandPool cmdPool;
+    static ktxVulkanDeviceInfo* vdi;
+
+    static const VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT
+                                         | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+};
+
+void* ktxTexture2_VkUploadTranscodedTest::library;
+std::string ktxTexture2_VkUploadTranscodedTest::skipReason;
+VulkanFunctions ktxTexture2_VkUploadTranscodedTest::vkf;
+VkInstance ktxTexture2_VkUploadTranscodedTest::instance;
+VkPhysicalDevice ktxTexture2_VkUploadTranscodedTest::physicalDevice;
+VkPhysicalDeviceFeatures ktxTexture2_VkUploadTranscodedTest::enabledFeatures;
+VkDevice ktxTexture2_VkUploadTranscodedTest::device;
+VkQueue ktxTexture2_VkUploadTranscodedTest::queue;
+VkCommandPool ktxTexture2_VkUploadTranscodedTest::cmdPool;
+ktxVulkanDeviceInfo* ktxTexture2_VkUploadTranscodedTest::vdi;
+
+void
+ktxTexture2_VkUploadTranscodedTest::SetUpTestSuite()
+{
+#if defined(_WIN32)
+    HMODULE module = LoadLibraryA("vulkan-1.dll");
+    library = module;
+    if (module != NULL)
+        vkf.vkGetInstanceProcAddr = (PFN_vkGetInstanceProcAddr)
+                        (void*)GetProcAddress(module, "vkGetInstanceProcAddr");
+#else
+  #if defined(__APPLE__)
+    library = dlopen("libvulkan.1.dylib", RTLD_NOW | RTLD_LOCAL);
+  #else
+    library = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+  #endif
+    if (library != NULL)
+        vkf.vkGetInstanceProcAddr = (PFN_vkGetInstanceProcAddr)
+                                    dlsym(library, "vkGetInstanceProcAddr");
+#endif
+    if (vkf.vkGetInstanceProcAddr == nullptr) {
+        skipReason = "No Vulkan loader found.";
+        return;
+    }
+
+#define GET_INSTANCE_PROC(inst, name) \
+    vkf.name = (PFN_##name)vkf.vkGetInstanceProcAddr(inst, #name)
+
+    GET_INSTANCE_PROC(VK_NULL_HANDLE, vkCreateInstance);
+    VkApplicationInfo appInfo = { };
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "vkuploadtests";
+    appInfo.apiVersion = VK_API_VERSION_1_0;
+    VkInstanceCreateInfo instanceInfo = { };
+    instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.pApplicationInfo = &appInfo;
+    if (vkf.vkCreateInstance == nullptr
+        || vkf.vkCreateInstance(&instanceInfo, nullptr, &instance)
+           != VK_SUCCESS) {
+        instance = VK_NULL_HANDLE;
+        skipReason = "No Vulkan driver found.";
+        return;
+    }
+
+    GET_INSTANCE_PROC(instance, vkGetDeviceProcAddr);
+    GET_INSTANCE_PROC(instance, vkDestroyInstance);
+    GET_INSTANCE_PROC(instance, vkEnumeratePhysicalDevices);
+    GET_INSTANCE_PROC(instance, vkGetPhysicalDeviceFeatures);
+    GET_INSTANCE_PROC(instance, vkGetPhysicalDeviceQueueFamilyProperties);
+    GET_INSTANCE_PROC(instance, vkGetPhysicalDeviceMemoryProperties);
+    GET_INSTANCE_PROC(instance, vkGetPhysicalDeviceImageFormatProperties);
+    GET_INSTANCE_PROC(instance, vkCreateDevice);
+    GET_INSTANCE_PROC(instance, vkDestroyDevice);
+    GET_INSTANCE_PROC(instance, vkGetDeviceQueue);
+    GET_INSTANCE_PROC(instance, vkCreateCommandPool);
+    GET_INSTANCE_PROC(instance, vkDestroyCommandPool);
+    GET_INSTANCE_PROC(instance, vkAllocateCommandBuffers);
+    GET_INSTANCE_PROC(instance, vkFreeCommandBuffers);
+    GET_INSTANCE_PROC(instance, vkBeginCommandBuffer);
+    GET_INSTANCE_PROC(instance, vkEndCommandBuffer);
+    GET_INSTANCE_PROC(instance, vkCmdCopyImageToBuffer);
+    GET_INSTANCE_PROC(instance, vkQueueSubmit);
+    GET_INSTANCE_PROC(instance, vkQueueWaitIdle);
+    GET_INSTANCE_PROC(instance, vkCreateBuffer);
+    GET_INSTANCE_PROC(instance, vkDestroyBuffer);
+    GET_INSTANCE_PROC(instance, vkGetBufferMemoryRequirements);
+    GET_INSTANCE_PROC(instance, vkAllocateMemory);
+    GET_INSTANCE_PROC(instance, vkFreeMemory);
+    GET_INSTANCE_PROC(instance, vkBindBufferMemory);
+    GET_INSTANCE_PROC(instance, vkMapMemory);
+    GET_INSTANCE_PROC(instance, vkUnmapMemory);
+#undef GET_INSTANCE_PROC
+
+    uint32_t deviceCount = 1;
+    VkResult vkResult = vkf.vkEnumeratePhysicalDevices(instance, &deviceCount,
+                                                       &physicalDevice);
+    if ((vkResult != VK_SUCCESS && vkResult != VK_INCOMPLETE)
+        || deviceCount == 0) {
+        skipReason = "No Vulkan device found.";
+        return;
+    }
+
+    uint32_t familyCount;
+    vkf.vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice,
+                                                 &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkf.vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice,
+                                                 &familyCount,
+                                                 families.data());
+    uint32_t family = 0;
+    // Graphics for the blits used to generate mipmaps.
+    while (family < familyCount
+           && !(families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+        family++;
+    if (family == familyCount) {
+        skipReason = "No Vulkan graphics queue found.";
+        return;
+    }
+
+    // Enable whichever compressed formats the device has.
+    VkPhysicalDeviceFeatures features;
+    vkf.vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+    enabledFeatures = { };
+    enabledFeatures.textureCompressionBC = features.textureCompressionBC;
+    enabledFeatures.textureCompressionETC2 = features.textureCompressionETC2;
+    enabledFeatures.textureCompressionASTC_LDR
+                                        = features.textureCompressionASTC_LDR;
+
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo = { };
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = family;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+    VkDeviceCreateInfo deviceInfo = { };
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    deviceInfo.pEnabledFeatures = &enabledFeatures;
+    if (vkf.vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device)
+        != VK_SUCCESS) {
+        device = VK_NULL_HANDLE;
+        skipReason = "Vulkan device creation failed.";
+        return;
+    }
+    vkf.vkGetDeviceQueue(device, family, 0, &queue);
+
+    VkCommandPoolCreateInfo poolInfo = { };
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = family;
+    if (vkf.vkCreateCommandPool(device, &poolInfo, nullptr, &cmdPool)
+        != VK_SUCCESS) {
+        cmdPool = VK_NULL_HANDLE;
+        skipReason = "Vulkan command pool creation failed.";
+        return;
+    }
+
+    ktxVulkanFunctions ktxFuncs = { };
+    ktxFuncs.vkGetInstanceProcAddr = vkf.vkGetInstanceProcAddr;
+    ktxFuncs.vkGetDeviceProcAddr = vkf.vkGetDeviceProcAddr;
+    vdi = ktxVulkanDeviceInfo_CreateEx(instance, physicalDevice, device,
+                                       queue, cmdPool, nullptr, &ktxFuncs);
+    if (vdi == nullptr)
+        skipReason = "ktxVulkanDeviceInfo_CreateEx failed.";
+}
+
+void
+ktxTexture2_VkUploadTranscodedTest::TearDownTestSuite()
+{
+    if (vdi != nullptr)
+        ktxVulkanDeviceInfo_Destroy(vdi);
+    if (cmdPool != VK_NULL_HANDLE)
+        vkf.vkDestroyCommandPool(device, cmdPool, nullptr);
+    if (device != VK_NULL_HANDLE)
+        vkf.vkDestroyDevice(device, nullptr);
+    if (instance != VK_NULL_HANDLE)
+        vkf.vkDestroyInstance(instance, nullptr);
+#if defined(_WIN32)
+    if (library != NULL)
+        FreeLibrary((HMODULE)library);
+#else
+    if (library != NULL)
+        dlclose(library);
+#endif
+}
+
+// Create a Basis Universal compressed 2D texture with a full mip chain.
+ktx_uint8_t*
+ktxTexture2_VkUploadTranscodedTest::createBasisFile(bool uastc,
+                                                    ktx_size_t* pFileLen)
+{
+    ktxTexture2* texture;
+    ktxTextureCreateInfo createInfo = { };
+    createInfo.vkFormat = VK_FORMAT_R8G8B8A8_SRGB;
+    createInfo.baseWidth = 64;
+    createInfo.baseHeight = 32;
+    createInfo.baseDepth = 1;
+    createInfo.numDimensions = 2;
+    createInfo.numLevels = 7;
+    createInfo.numLayers = 1;
+    createInfo.numFaces = 1;
+    if (ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                           &texture) != KTX_SUCCESS)
+        return nullptr;
+    for (ktx_uint32_t level = 0; level < createInfo.numLevels; level++) {
+        ktx_size_t offset;
+        ktxTexture_GetImageOffset(ktxTexture(texture), level, 0, 0, &offset);
+        ktx_uint8_t* pixel = texture->pData + offset;
+        ktx_uint32_t width = std::max(createInfo.baseWidth >> level, 1u);
+        ktx_uint32_t height = std::max(createInfo.baseHeight >> level, 1u);
+        for (ktx_uint32_t y = 0; y < height; y++) {
+            for (ktx_uint32_t x = 0; x < width; x++) {
+                *pixel++ = (ktx_uint8_t)(x * 4 + level * 32);
+                *pixel++ = (ktx_uint8_t)(y * 8);
+                *pixel++ = (ktx_uint8_t)((x ^ y) * 4);
+                *pixel++ = (ktx_uint8_t)(255 - x * 2);
+            }
+        }
+    }
+
+    ktxBasisParams params = { };
+    params.structSize = sizeof(params);
+    params.uastc = uastc;
+    ktx_uint8_t* basisFile = nullptr;
+    if (ktxTexture2_CompressBasisEx(texture, &params) != KTX_SUCCESS
+        || ktxTexture_WriteToMemory(ktxTexture(texture), &basisFile,
+                                   pFileLen)
+           != KTX_SUCCESS)
+        basisFile = nullptr;
+    ktxTexture_Destroy(ktxTexture(texture));
+    return basisFile;
+}
+
+bool
+ktxTexture2_VkUploadTranscodedTest::isSupported(VkFormat format)
+{
+    if (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK
+        && format <= VK_FORMAT_BC7_SRGB_BLOCK
+        && !enabledFeatures.textureCompressionBC)
+        return false;
+    if (format >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+        && format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK
+        && !enabledFeatures.textureCompressionETC2)
+        return false;
+    if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK
+        && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK
+        && !enabledFeatures.textureCompressionASTC_LDR)
+        return false;
+    VkImageFormatProperties properties;
+    return vkf.vkGetPhysicalDeviceImageFormatProperties(physicalDevice,
+                            format, VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_OPTIMAL,
+                            usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT, 0,
+                            &properties) == VK_SUCCESS;
+}
+
+// Copy each level of the image into @p pixels laid out as in @p layout's
+// data.
+void
+ktxTexture2_VkUploadTranscodedTest::readImage(
+                                        const ktxVulkanTexture& vkTexture,
+                                        ktxTexture2* layout,
+                                        std::vector<ktx_uint8_t>& pixels)
+{
+    VkBufferCreateInfo bufferInfo = { };
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = layout->dataSize;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkBuffer buffer;
+    ASSERT_EQ(vkf.vkCreateBuffer(device, &bufferInfo, nullptr, &buffer),
+              VK_SUCCESS);
+
+    VkMemoryRequirements memReqs;
+    vkf.vkGetBufferMemoryRequirements(device, buffer, &memReqs);
+    VkPhysicalDeviceMemoryProperties memProps;
+    vkf.vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProps);
+    const VkMemoryPropertyFlags wanted = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                                       | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    VkMemoryAllocateInfo allocInfo = { };
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memReqs.size;
+    allocInfo.memoryTypeIndex = memProps.memoryTypeCount;
+    for (uint32_t i = 0; i < memProps.memoryTypeCount; i++) {
+        if ((memReqs.memoryTypeBits & (1u << i))
+            && (memProps.memoryTypes[i].propertyFlags & wanted) == wanted) {
+            allocInfo.memoryTypeIndex = i;
+            break;
+        }
+    }
+    ASSERT_LT(allocInfo.memoryTypeIndex, memProps.memoryTypeCount);
+    VkDeviceMemory memory;
+    ASSERT_EQ(vkf.vkAllocateMemory(device, &allocInfo, nullptr, &memory),
+              VK_SUCCESS);
+    ASSERT_EQ(vkf.vkBindBufferMemory(device, buffer, memory, 0), VK_SUCCESS);
+
+    std::vector<VkBufferImageCopy> copies(layout->numLevels);
+    for (ktx_uint32_t level = 0; level < layout->numLevels; level++) {
+        ktx_size_t offset;
+        ktxTexture_GetImageOffset(ktxTexture(layout), level, 0, 0, &offset);
+        VkBufferImageCopy& copy = copies[level];
+        copy = { };
+        copy.bufferOffset = offset;
+        copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy.imageSubresource.mipLevel = level;
+        copy.imageSubresource.layerCount = 1;
+        copy.imageExtent.width = std::max(vkTexture.width >> level, 1u);
+        copy.imageExtent.height = std::max(vkTexture.height >> level, 1u);
+        copy.imageExtent.depth = 1;
+    }
+
+    VkCommandBufferAllocateInfo cmdInfo = { };
+    cmdInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cmdInfo.commandPool = cmdPool;
+    cmdInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cmdInfo.commandBufferCount = 1;
+    VkCommandBuffer cmdBuffer;
+    ASSERT_EQ(vkf.vkAllocateCommandBuffers(device, &cmdInfo, &cmdBuffer),
+              VK_SUCCESS);
+    VkCommandBufferBeginInfo beginInfo = { };
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkf.vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+    vkf.vkCmdCopyImageToBuffer(cmdBuffer, vkTexture.image,
+                               vkTexture.imageLayout, buffer,
+                               (uint32_t)copies.size(), copies.data());
+    vkf.vkEndCommandBuffer(cmdBuffer);
+    VkSubmitInfo submitInfo = { };
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &cmdBuffer;
+    EXPECT_EQ(vkf.vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE),
+              VK_SUCCESS);
+    EXPECT_EQ(vkf.vkQueueWaitIdle(queue), VK_SUCCESS);
+    vkf.vkFreeCommandBuffers(device, cmdPool, 1, &cmdBuffer);
+
+    void* mapped;
+    pixels.assign(layout->dataSize, 0);
+    if (vkf.vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped)
+        == VK_SUCCESS) {
+        // Only the levels, not the padding between them, were written.
+        for (ktx_uint32_t level = 0; level < layout->numLevels; level++) {
+            ktx_size_t offset = copies[level].bufferOffset;
+            memcpy(pixels.data() + offset, (ktx_uint8_t*)mapped + offset,
+                   ktxTexture_GetImageSize(ktxTexture(layout), level));
+        }
+        vkf.vkUnmapMemory(device, memory);
+    } else {
+        ADD_FAILURE() << "vkMapMemory failed.";
+    }
+    vkf.vkDestroyBuffer(device, buffer, nullptr);
+    vkf.vkFreeMemory(device, memory, nullptr);
+}
+
+void
+ktxTexture2_VkUploadTranscodedTest::checkUploads(bool uastc)
+{
+    ktx_size_t basisFileLen;
+    ktx_uint8_t* basisFile = createBasisFile(uastc, &basisFileLen);
+    ASSERT_TRUE(basisFile != nullptr);
+
+    const ktx_transcode_fmt_e formats[] = {
+        KTX_TTF_RGBA32, KTX_TTF_BC1_RGB, KTX_TTF_BC3_RGBA, KTX_TTF_BC7_RGBA,
+        KTX_TTF_ETC2_RGBA, KTX_TTF_ASTC_4x4_RGBA
+    };
+    bool uploaded = false;
+    for (ktx_transcode_fmt_e format : formats) {
+        SCOPED_TRACE(ktxTranscodeFormatString(format));
+        ktxTexture2* transcoded;
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       &transcoded), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(transcoded, format, 0),
+                  KTX_SUCCESS);
+        if (!isSupported((VkFormat)transcoded->vkFormat)) {
+            ktxTexture_Destroy(ktxTexture(transcoded));
+            continue;
+        }
+
+        ktxVulkanTexture reference;
+        ASSERT_EQ(ktxTexture_VkUploadEx(ktxTexture(transcoded), vdi,
+                                        &reference, VK_IMAGE_TILING_OPTIMAL,
+                                        usage,
+                                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL),
+                  KTX_SUCCESS);
+
+        // Not loading the image data checks the upload loads it.
+        ktxTexture2* texture;
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(basisFile, basisFileLen, 0,
+                                               &texture), KTX_SUCCESS);
+        ktxVulkanTexture vkTexture;
+        ASSERT_EQ(ktxTexture2_VkUploadTranscodedEx(texture, vdi, &vkTexture,
+                                        format, 0, usage,
+                                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL),
+                  KTX_SUCCESS);
+        uploaded = true;
+        // The texture is not transcoded.
+        EXPECT_TRUE(ktxTexture2_NeedsTranscoding(texture));
+        EXPECT_EQ(vkTexture.imageFormat, reference.imageFormat);
+        EXPECT_EQ(vkTexture.imageLayout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        EXPECT_EQ(vkTexture.width, reference.width);
+        EXPECT_EQ(vkTexture.height, reference.height);
+        EXPECT_EQ(vkTexture.levelCount, reference.levelCount);
+        EXPECT_EQ(vkTexture.layerCount, reference.layerCount);
+
+        std::vector<ktx_uint8_t> expected, actual;
+        readImage(reference, transcoded, expected);
+        readImage(vkTexture, transcoded, actual);
+        for (ktx_uint32_t level = 0; level < transcoded->numLevels; level++) {
+            ktx_size_t offset;
+            ktx_size_t size = ktxTexture_GetImageSize(ktxTexture(transcoded),
+                                                      level);
+            ktxTexture_GetImageOffset(ktxTexture(transcoded), level, 0, 0,
+                                      &offset);
+            // Check the readback too.
+            EXPECT_EQ(memcmp(expected.data() + offset,
+                             transcoded->pData + offset, size), 0)
+                << "reference level " << level;
+            EXPECT_EQ(memcmp(actual.data() + offset,
+                             transcoded->pData + offset, size), 0)
+                << "level " << level;
+        }
+
+        ktxVulkanTexture_Destruct(&vkTexture, device, nullptr);
+        ktxVulkanTexture_Destruct(&reference, device, nullptr);
+        ktxTexture_Destroy(ktxTexture(texture));
+        ktxTexture_Destroy(ktxTexture(transcoded));
+    }
+    // RGBA32 must be supported for sampling.
+    EXPECT_TRUE(uploaded);
+    free(basisFile);
+}
+
+TEST_F(ktxTexture2_VkUploadTranscodedTest, ETC1S) {
+    checkUploads(false);
+}
+
+TEST_F(ktxTexture2_VkUploadTranscodedTest, UASTC) {
+    checkUploads(true);
+}
+
+}  // namespace
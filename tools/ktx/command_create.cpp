@@ -883,6 +883,9 @@ void CommandCreate::processOptions(cxxopts::Options& opts, cxxopts::ParseResult&
 
         if (options.zlib.has_value())
             fatal_usage("Cannot encode to BasisLZ and supercompress with ZLIB.");
+
+        if (options.supercompressBudget.has_value())
+            fatal_usage("Cannot encode to BasisLZ and supercompress with a budget.");
     }
 
     if (options.codec != EncodeCodec::NONE) {
@@ -1246,6 +1249,16 @@ void CommandCreate::compress(KTXTexture2& texture, const OptionsCompress& opts)
         if (ret != KTX_SUCCESS)
             fatal(rc::KTX_FAILURE, "ZLIB deflation failed. KTX Error: {}", ktxErrorString(ret));
     }
+
+    if (opts.supercompressBudget) {
+        ktxDeflateAutoParams params{};
+        params.structSize = sizeof(params);
+        params.minInflateMBps = *opts.supercompressBudget;
+        params.threadCount = options.basisOpts.threadCount;
+        const auto ret = ktxTexture2_DeflateAuto(texture, &params, nullptr);
+        if (ret != KTX_SUCCESS)
+            fatal(rc::KTX_FAILURE, "Supercompression failed. KTX Error: {}", ktxErrorString(ret));
+    }
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -133,6 +133,9 @@ void CommandEncode::processOptions(cxxopts::Options& opts, cxxopts::ParseResult&
 
         if (options.zlib.has_value())
             fatal_usage("Cannot encode to BasisLZ and supercompress with ZLIB.");
+
+        if (options.supercompressBudget.has_value())
+            fatal_usage("Cannot encode to BasisLZ and supercompress with a budget.");
     }
 
     const auto canCompare = options.codec == EncodeCodec::BasisLZ || options.codec == EncodeCodec::UASTC;
@@ -208,6 +211,16 @@ void CommandEncode::executeEncode() {
             fatal(rc::IO_FAILURE, "ZLIB deflation failed. KTX Error: {}", ktxErrorString(ret));
     }
 
+    if (options.supercompressBudget) {
+        ktxDeflateAutoParams params{};
+        params.structSize = sizeof(params);
+        params.minInflateMBps = *options.supercompressBudget;
+        params.threadCount = options.basisOpts.threadCount;
+        ret = ktxTexture2_DeflateAuto(texture, &params, nullptr);
+        if (ret != KTX_SUCCESS)
+            fatal(rc::IO_FAILURE, "Supercompression failed. KTX Error: {}", ktxErrorString(ret));
+    }
+
     // Save output file
     if (std::filesystem::path(options.outputFilepath).has_parent_path())
         std::filesystem::create_directories(std::filesystem::path(options.outputFilepath).parent_path());
@@ -58,6 +58,12 @@ Transcode a KTX2 file.
             r8 | rg8 | rgb8 | rgba8.
             etc-rgb is ETC1; etc-rgba, eac-r11 and eac-rg11 are ETC2.
         </dd>
+        <dt>--cache-dir &lt;dir&gt;</dt>
+        <dd>Directory of a transcode cache, created if it does not exist.
+            If it holds the result of transcoding the same input to the same
+            target, that result is used instead of transcoding again.
+            Otherwise the result is added to the cache.
+        </dd>
     </dl>
     @snippet{doc} ktx/compress_utils.h command options_compress
     @snippet{doc} ktx/command.h command options_generic
@@ -122,7 +128,11 @@ void CommandTranscode::OptionsTranscode::init(cxxopts::Options& opts) {
                    " etc-rgb | etc-rgba | eac-r11 | eac-rg11 | bc1 | bc3 | bc4 | bc5 | bc7 | astc |"
                    " r8 | rg8 | rgb8 | rgba8."
                    "\netc-rgb is ETC1; etc-rgba, eac-r11 and eac-rg11 are ETC2.",
-                   cxxopts::value<std::string>(), "<target>");
+                   cxxopts::value<std::string>(), "<target>")
+        ("cache-dir", "Directory of a transcode cache, created if it does not exist."
+                      " A cached result of transcoding the same input to the same target"
+                      " is used instead of transcoding again.",
+                      cxxopts::value<std::string>(), "<dir>");
 }
 
 void CommandTranscode::OptionsTranscode::process(cxxopts::Options&, cxxopts::ParseResult&, Reporter&) {
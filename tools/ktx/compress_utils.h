@@ -29,12 +29,21 @@ namespace ktx {
         Level range is [1,9].
         Lower levels give faster but worse compression.
     </dd>
+    <dt>--supercompress-budget &lt;rate&gt;</dt>
+    <dd>
+        Supercompress the data with the Zstandard or ZLIB level giving
+        the smallest file that still inflates at least &lt;rate&gt; million
+        bytes per second on this machine. If no level is fast enough,
+        the fastest one is used.
+        Cannot be used with ETC1S / BasisLZ format, --zstd or --zlib.
+    </dd>
 </dl>
 //! [command options_compress]
 */
 struct OptionsCompress {
     std::optional<uint32_t> zstd;
     std::optional<uint32_t> zlib;
+    std::optional<float> supercompressBudget;
 
     void init(cxxopts::Options& opts) {
         opts.add_options()
@@ -48,7 +57,11 @@ struct OptionsCompress {
                      " Cannot be used with ETC1S / BasisLZ format."
                      " Level range is [1,9]."
                      " Lower levels give faster but worse compression.",
-                cxxopts::value<uint32_t>(), "<level>");
+                cxxopts::value<uint32_t>(), "<level>")
+            ("supercompress-budget", "Supercompress the data with the Zstandard or ZLIB level giving the"
+                     " smallest file that still inflates at least <rate> million bytes per second on this machine."
+                     " Cannot be used with ETC1S / BasisLZ format, --zstd or --zlib.",
+                cxxopts::value<float>(), "<rate>");
     }
 
     void process(cxxopts::Options&, cxxopts::ParseResult& args, Reporter& report) {
@@ -64,6 +77,14 @@ struct OptionsCompress {
         }
         if (zstd.has_value() && zlib.has_value())
             report.fatal_usage("Conflicting options: zstd and zlib cannot be used at the same time.");
+        if (args["supercompress-budget"].count()) {
+            supercompressBudget = args["supercompress-budget"].as<float>();
+            if (!(*supercompressBudget > 0.0f))
+                report.fatal_usage("Invalid supercompress-budget: \"{}\". Value must be greater than 0.",
+                        supercompressBudget.value());
+            if (zstd.has_value() || zlib.has_value())
+                report.fatal_usage("Conflicting options: supercompress-budget cannot be used with zstd or zlib.");
+        }
     }
 };
 
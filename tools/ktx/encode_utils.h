@@ -176,7 +176,8 @@ enum class EncodeCodec {
         <dd>Explicitly set the number of threads to use during
             compression. By default, ETC1S / BasisLZ will use the number of
             threads reported by thread::hardware_concurrency or 1 if value
-            returned is 0.</dd>
+            returned is 0. Also sets the number of threads used to measure
+            inflate speeds for @b --supercompress-budget.</dd>
         <dt>--no-sse</dt>
         <dd>Forbid use of the SSE instruction set. Ignored if CPU does
             not support SSE. SSE can only be disabled on the basis-lz and
@@ -311,7 +312,8 @@ struct OptionsCodec {
                 "ETC1S / BasisLZ encoding, RDO is disabled (no selector RDO, no endpoint RDO) to provide better quality.")
             ("threads", "Sets the number of threads to use during encoding. By default, encoding "
                 "will use the number of threads reported by thread::hardware_concurrency or 1 if "
-                "value returned is 0.", cxxopts::value<uint32_t>(), "<count>")
+                "value returned is 0. Also sets the number of threads used to measure inflate speeds "
+                "for --supercompress-budget.", cxxopts::value<uint32_t>(), "<count>")
             ("no-sse", "Forbid use of the SSE instruction set. Ignored if CPU does "
                "not support SSE. SSE can only be disabled on the basis-lz and "
                "uastc compressors.");
@@ -505,7 +507,8 @@ struct OptionsCodec {
         }
 
         if (args["threads"].count()) {
-            validateCommonEncodeArg(report, "threads");
+            if (!args.count("supercompress-budget"))
+                validateCommonEncodeArg(report, "threads");
             basisOpts.threadCount = args["threads"].as<uint32_t>();
         } else {
             basisOpts.threadCount = std::thread::hardware_concurrency();
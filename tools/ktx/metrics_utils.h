@@ -15,6 +15,7 @@
 
 #include <basisu/encoder/basisu_enc.h>
 #include <basisu/encoder/basisu_ssim.h>
+#include <thread>
 
 // -------------------------------------------------------------------------------------------------
 
@@ -91,14 +92,20 @@ public:
         if (!opts.compare_ssim && !opts.compare_psnr)
             return;
 
-        KTXTexture2 texture{static_cast<ktxTexture2*>(malloc(sizeof(ktxTexture2)))};
-        ktxTexture2_constructCopy(texture, encodedTexture);
+        // Transcoding replaces the copy's data so sharing it avoids copying
+        // the encoded images.
+        KTXTexture2 texture{nullptr};
+        ktx_error_code_e ec = ktxTexture2_CreateSharedCopy(encodedTexture, texture.pHandle());
+        if (ec != KTX_SUCCESS)
+            report.fatal(rc::KTX_FAILURE, "Failed to copy KTX2 texture to calculate error metrics: {}", ktxErrorString(ec));
 
         const auto tSwizzleInfo = determineTranscodeSwizzle(texture, report);
 
-        ktx_error_code_e ec = KTX_SUCCESS;
         // Decode the encoded texture to observe the compression losses
-        ec = ktxTexture2_TranscodeBasis(texture, KTX_TTF_RGBA32, 0);
+        ktxTranscodeParams params{};
+        params.structSize = sizeof(params);
+        params.threadCount = std::max(1u, std::thread::hardware_concurrency());
+        ec = ktxTexture2_TranscodeBasisEx(texture, KTX_TTF_RGBA32, 0, &params);
         if (ec != KTX_SUCCESS)
             report.fatal(rc::KTX_FAILURE, "Failed to transcode KTX2 texture to calculate error metrics: {}", ktxErrorString(ec));
 
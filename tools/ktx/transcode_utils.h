@@ -11,8 +11,10 @@
 #include "dfdutils/dfd.h"
 #include <KHR/khr_df.h>
 
+#include <filesystem>
 #include <tuple>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <optional>
 
@@ -34,6 +36,7 @@ struct OptionsTranscodeTarget {
     std::string transcodeTargetName;
     uint32_t transcodeSwizzleComponents = 0;
     std::string transcodeSwizzle;
+    std::string transcodeCacheDir;
 
     void init(cxxopts::Options&) {}
 
@@ -68,6 +71,10 @@ struct OptionsTranscodeTarget {
             transcodeTargetName = argStr;
             transcodeSwizzleComponents = it->second.second;
         }
+
+        // Only the "transcode" command has a "cache-dir" argument.
+        if (args.count("cache-dir"))
+            transcodeCacheDir = args["cache-dir"].as<std::string>();
     }
 
     void validateTextureTranscode(const KTXTexture2& texture, Reporter& report) {
@@ -87,7 +94,17 @@ template <bool TRANSCODE_CMD>
 KTXTexture2 transcode(KTXTexture2&& texture, OptionsTranscodeTarget<TRANSCODE_CMD>& options, Reporter& report) {
     options.validateTextureTranscode(texture, report);
 
-    auto ret = ktxTexture2_TranscodeBasis(texture, options.transcodeTarget.value(), 0);
+    ktxTranscodeParams params{};
+    params.structSize = sizeof(params);
+    params.threadCount = std::max(1u, std::thread::hardware_concurrency());
+    if (!options.transcodeCacheDir.empty()) {
+        // The cache is only an optimization so failure to create it is
+        // not an error.
+        std::error_code ec;
+        std::filesystem::create_directories(options.transcodeCacheDir, ec);
+        params.cacheDir = options.transcodeCacheDir.c_str();
+    }
+    auto ret = ktxTexture2_TranscodeBasisEx(texture, options.transcodeTarget.value(), 0, &params);
     if (ret != KTX_SUCCESS)
         report.fatal(rc::INVALID_FILE, "Failed to transcode KTX2 texture: {}", ktxErrorString(ret));
 